@@ -0,0 +1,206 @@
+#include "block_token_reader.hpp"
+
+#include <cctype>
+#include <cstring>
+
+using can::BlockSource;
+using can::BlockTokenReader;
+using can::FileBlockSource;
+using can::MemoryBlockSource;
+
+static inline bool isSpace(int c) {
+    return std::isspace(static_cast<unsigned char>(c));
+}
+
+BlockTokenReader::BlockTokenReader(BlockSource& source) : _source(source) {}
+
+bool BlockTokenReader::start() {
+    for (Slot& slot : _slots) {
+        slot.block = NO_BLOCK;
+    }
+    _current = nullptr;
+    _nextSlot = 0;
+    _pos = 0;
+    _end = SIZE_MAX;
+    _blockLoads = 0;
+    _failed = false;
+    return _source.open();
+}
+
+bool BlockTokenReader::peekNextWord(std::size_t maxLength, char* charBuf, std::size_t* length) {
+    std::size_t pos = _skipSpace(_pos);
+    if (_charAt(pos) < 0) {
+        return false;
+    }
+
+    // copy up to maxLength-1 chars + null terminator, but measure the whole word
+    std::size_t wordLen = 0;
+    int c;
+    while ((c = _charAt(pos + wordLen)) >= 0 && !isSpace(c)) {
+        if (wordLen + 1 < maxLength) {
+            charBuf[wordLen] = static_cast<char>(c);
+        }
+        ++wordLen;
+    }
+    charBuf[wordLen < maxLength - 1 ? wordLen : maxLength - 1] = '\0';
+
+    if (length) {
+        *length = wordLen;
+    }
+    return true;
+}
+
+bool BlockTokenReader::peekNextSpan(const char** word, std::size_t* length) {
+    std::size_t pos = _skipSpace(_pos);
+    if (_charAt(pos) < 0) {
+        return false;
+    }
+
+    // in place, as long as the word and the character after it are in the same block
+    const Slot* slot = _current;
+    std::size_t offset = pos % BlockSource::BLOCK_SIZE;
+    std::size_t len = 0;
+    while (offset + len < slot->length && !isSpace(slot->data[offset + len])) {
+        ++len;
+    }
+    if (offset + len < slot->length) {
+        *word = reinterpret_cast<const char*>(slot->data) + offset;
+        *length = len;
+        return true;
+    }
+
+    // otherwise stitch it together, this is also where the terminator comes from
+    len = 0;
+    int c;
+    while (len + 1 < LOCAL_BUF_SIZE && (c = _charAt(pos + len)) >= 0 && !isSpace(c)) {
+        _stitch[len++] = static_cast<char>(c);
+    }
+    _stitch[len] = '\0';
+
+    *word = _stitch;
+    *length = len;
+    return true;
+}
+
+bool BlockTokenReader::moveWord(std::size_t stepSize) {
+    for (std::size_t i = 0; i < stepSize; ++i) {
+        _pos = _skipSpace(_pos);
+        if (_charAt(_pos) < 0) {
+            return false;
+        }
+
+        int c;
+        while ((c = _charAt(_pos)) >= 0 && !isSpace(c)) {
+            ++_pos;
+        }
+    }
+    return true;
+}
+
+bool BlockTokenReader::eatUntil(const char character) {
+    int c;
+    while ((c = _charAt(_pos)) >= 0) {
+        if (static_cast<char>(c) == character) {
+            return true;
+        }
+        ++_pos;
+    }
+    return false;
+}
+
+void BlockTokenReader::end() {
+    _source.close();
+}
+
+int BlockTokenReader::_charAt(std::size_t pos) {
+    if (pos >= _end) {
+        return -1;
+    }
+
+    std::size_t block = pos / BlockSource::BLOCK_SIZE;
+    if (_current == nullptr || _current->block != block) {
+        _current = _load(block);
+    }
+
+    std::size_t offset = pos % BlockSource::BLOCK_SIZE;
+    if (offset >= _current->length) {
+        return -1;
+    }
+    return _current->data[offset];
+}
+
+const BlockTokenReader::Slot* BlockTokenReader::_load(std::size_t block) {
+    for (const Slot& slot : _slots) {
+        if (slot.block == block) {
+            return &slot;
+        }
+    }
+
+    Slot& slot = _slots[_nextSlot];
+    _nextSlot = (_nextSlot + 1) % NUM_SLOTS;
+
+    slot.block = block;
+    slot.length = _source.readBlock(block, slot.data);
+    _blockLoads++;
+
+    if (slot.length == BlockSource::READ_ERROR) {
+        _failed = true;
+        slot.length = 0;
+    }
+
+    if (slot.length < BlockSource::BLOCK_SIZE) {
+        _end = block * BlockSource::BLOCK_SIZE + slot.length;
+    }
+    return &slot;
+}
+
+std::size_t BlockTokenReader::_skipSpace(std::size_t pos) {
+    int c;
+    while ((c = _charAt(pos)) >= 0 && isSpace(c)) {
+        ++pos;
+    }
+    return pos;
+}
+
+FileBlockSource::FileBlockSource(const std::string& path) : _path(path) {}
+
+FileBlockSource::~FileBlockSource() {
+    close();
+}
+
+bool FileBlockSource::open() {
+    close();
+    _file = std::fopen(_path.c_str(), "rb");
+    return _file != nullptr;
+}
+
+std::size_t FileBlockSource::readBlock(std::size_t index, uint8_t* buf) {
+    if (_file == nullptr) {
+        return READ_ERROR;
+    }
+    if (std::fseek(_file, static_cast<long>(index * BLOCK_SIZE), SEEK_SET) != 0) {
+        return READ_ERROR;
+    }
+    std::size_t read = std::fread(buf, 1, BLOCK_SIZE, _file);
+    if (read < BLOCK_SIZE && std::ferror(_file)) {
+        return READ_ERROR;
+    }
+    return read;
+}
+
+void FileBlockSource::close() {
+    if (_file != nullptr) {
+        std::fclose(_file);
+        _file = nullptr;
+    }
+}
+
+std::size_t MemoryBlockSource::readBlock(std::size_t index, uint8_t* buf) {
+    std::size_t start = index * BLOCK_SIZE;
+    if (start >= _size) {
+        return 0;
+    }
+    std::size_t length = _size - start < BLOCK_SIZE ? _size - start : BLOCK_SIZE;
+    std::memcpy(buf, _data + start, length);
+    return length;
+}
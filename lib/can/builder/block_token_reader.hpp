@@ -0,0 +1,124 @@
+#ifndef __BLOCK_TOKEN_READER_H__
+#define __BLOCK_TOKEN_READER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "token_reader.hpp"
+
+namespace can {
+
+/// @brief A file read in fixed-size blocks, sized to match an SD card sector
+class BlockSource {
+   public:
+    static constexpr std::size_t BLOCK_SIZE = 512;
+    /// @brief Returned by readBlock() when the storage fails, unlike a short block at the end
+    static constexpr std::size_t READ_ERROR = SIZE_MAX;
+
+    virtual ~BlockSource() = default;
+
+    /// @brief Prepare for reading
+    /// @return true on success
+    virtual bool open() = 0;
+
+    /// @brief Read one block
+    /// @param index The index of the block, the block starts at index * BLOCK_SIZE
+    /// @param buf Out: BLOCK_SIZE bytes
+    /// @return The number of bytes read, less than BLOCK_SIZE only for the last block of the file,
+    /// or READ_ERROR if it couldn't be read
+    virtual std::size_t readBlock(std::size_t index, uint8_t* buf) = 0;
+
+    virtual void close() = 0;
+};
+
+/// @brief Reads a token file through a BlockSource, keeping a small ring of blocks in memory.
+/// Words are scanned in memory, so peeking the same word repeatedly is free, and a word that
+/// crosses a block boundary only costs loading the next block into the ring.
+/// Spans point straight into the ring; the rare word that runs up to the edge of a block is
+/// stitched into a fixed side buffer instead, so it still comes back terminated without touching
+/// the heap. Stitched words are cut short at LOCAL_BUF_SIZE - 1 characters, like copied ones.
+class BlockTokenReader : public TokenReader {
+   public:
+    /// @brief Blocks kept in memory; two is enough for any word that fits in a block
+    static constexpr std::size_t NUM_SLOTS = 2;
+
+    explicit BlockTokenReader(BlockSource& source);
+
+    bool start() override;
+    bool peekNextWord(std::size_t maxLength, char* charBuf, std::size_t* length) override;
+    bool supportsSpans() const override { return true; }
+    bool peekNextSpan(const char** word, std::size_t* length) override;
+    bool moveWord(std::size_t stepSize = 1) override;
+    bool eatUntil(const char character) override;
+    void end() override;
+
+    /// @brief The number of blocks loaded from the source since start()
+    std::size_t blockLoads() const { return _blockLoads; }
+
+    /// @brief Whether a block failed to read since start(). The file reads as if it ended there,
+    /// so a caller that got to the end should check this before trusting what it read.
+    bool failed() const { return _failed; }
+
+   private:
+    static constexpr std::size_t NO_BLOCK = SIZE_MAX;
+
+    struct Slot {
+        std::size_t block = NO_BLOCK;
+        std::size_t length = 0;
+        uint8_t data[BlockSource::BLOCK_SIZE];
+    };
+
+    BlockSource& _source;
+    Slot _slots[NUM_SLOTS];
+    std::size_t _nextSlot = 0;
+    const Slot* _current = nullptr;  // the slot the last character came from
+
+    std::size_t _pos = 0;           // absolute cursor
+    std::size_t _end = SIZE_MAX;    // file length, once the last block has been seen
+    std::size_t _blockLoads = 0;
+    bool _failed = false;
+
+    char _stitch[LOCAL_BUF_SIZE];  // words that can't be handed out in place
+
+    /// @brief The character at an absolute position, or -1 past the end of the file
+    int _charAt(std::size_t pos);
+    const Slot* _load(std::size_t block);
+    std::size_t _skipSpace(std::size_t pos);
+};
+
+/// @brief A BlockSource over a regular file, for native builds and host tools
+class FileBlockSource : public BlockSource {
+   public:
+    explicit FileBlockSource(const std::string& path);
+    ~FileBlockSource() override;
+
+    bool open() override;
+    std::size_t readBlock(std::size_t index, uint8_t* buf) override;
+    void close() override;
+
+   private:
+    std::string _path;
+    std::FILE* _file = nullptr;
+};
+
+/// @brief A BlockSource over bytes already in memory, such as the config embedded in a log
+class MemoryBlockSource : public BlockSource {
+   public:
+    /// @param data The bytes, kept alive by the caller while the source is read
+    /// @param size The number of bytes
+    MemoryBlockSource(const uint8_t* data, std::size_t size) : _data(data), _size(size) {}
+
+    bool open() override { return true; }
+    std::size_t readBlock(std::size_t index, uint8_t* buf) override;
+    void close() override {}
+
+   private:
+    const uint8_t* _data;
+    std::size_t _size;
+};
+
+}  // namespace can
+
+#endif  // __BLOCK_TOKEN_READER_H__
@@ -4,5 +4,6 @@
 #include "token_reader.hpp"
 #include "tokenizer.hpp"
 #include "telem_builder.hpp"
+#include "config_image.hpp"
 
 #endif  // __BUILDER_H__
\ No newline at end of file
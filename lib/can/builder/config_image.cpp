@@ -0,0 +1,282 @@
+#include "config_image.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+#include "hash.hpp"
+#include "telemetry_debug.hpp"
+
+namespace can {
+
+using common::Result;
+
+static constexpr uint8_t SIGNAL_FLAG_SIGNED = 1 << 0;
+static constexpr uint8_t SIGNAL_FLAG_BIG_ENDIAN = 1 << 1;
+
+static constexpr std::size_t OPTIONS_SIZE = 24;
+static constexpr std::size_t MESSAGE_SIZE = 9;
+static constexpr std::size_t SIGNAL_SIZE = 20;
+
+// little-endian writers, so the image doesn't depend on the host
+static void putU8(std::vector<uint8_t>& out, uint8_t v) {
+    out.push_back(v);
+}
+
+static void putU16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+static void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    putU16(out, static_cast<uint16_t>(v));
+    putU16(out, static_cast<uint16_t>(v >> 16));
+}
+
+static void putF64(std::vector<uint8_t>& out, double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    putU32(out, static_cast<uint32_t>(bits));
+    putU32(out, static_cast<uint32_t>(bits >> 32));
+}
+
+static void setU32(std::vector<uint8_t>& out, std::size_t at, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out[at + i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+/// @brief Bounds-checked little-endian reads over a byte range
+class ImageCursor {
+   public:
+    ImageCursor(const uint8_t* data, std::size_t size) : _data(data), _size(size) {}
+
+    bool overrun() const { return _overrun; }
+    bool atEnd() const { return _pos == _size; }
+
+    uint8_t u8() { return static_cast<uint8_t>(_take(1)); }
+    uint16_t u16() { return static_cast<uint16_t>(_take(2)); }
+    uint32_t u32() { return static_cast<uint32_t>(_take(4)); }
+
+    double f64() {
+        uint64_t bits = _take(8);
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+
+   private:
+    const uint8_t* _data;
+    std::size_t _size;
+    std::size_t _pos = 0;
+    bool _overrun = false;
+
+    uint64_t _take(std::size_t n) {
+        if (_overrun || _size - _pos < n) {
+            _overrun = true;
+            return 0;
+        }
+        uint64_t v = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            v |= static_cast<uint64_t>(_data[_pos + i]) << (8 * i);
+        }
+        _pos += n;
+        return v;
+    }
+};
+
+bool ConfigImage::hashSource(BlockSource& source, uint32_t* hash) {
+    if (!source.open()) {
+        return false;
+    }
+
+    uint8_t block[BlockSource::BLOCK_SIZE];
+    uint32_t h = common::FNV1A_OFFSET_BASIS;
+    for (std::size_t index = 0;; ++index) {
+        std::size_t read = source.readBlock(index, block);
+        if (read == BlockSource::READ_ERROR) {
+            source.close();
+            return false;
+        }
+        h = common::fnv1a(block, read, h);
+        if (read < BlockSource::BLOCK_SIZE) {
+            break;
+        }
+    }
+
+    source.close();
+    *hash = h;
+    return true;
+}
+
+std::vector<uint8_t> ConfigImage::serialize(const CANBus& bus, const TelemetryOptions& options,
+                                            uint32_t sourceHash) {
+    // data buffer order, so loading reproduces the same offsets
+    std::vector<const CANMessage*> messages;
+    messages.reserve(bus.getMessages().size());
+    for (const auto& entry : bus.getMessages()) {
+        messages.push_back(entry.second);
+    }
+    std::sort(messages.begin(), messages.end(),
+              [](const CANMessage* a, const CANMessage* b) { return a->index < b->index; });
+
+    std::vector<uint8_t> image;
+    image.reserve(HEADER_SIZE + OPTIONS_SIZE + messages.size() * (MESSAGE_SIZE + 4 * SIGNAL_SIZE));
+
+    putU32(image, CONFIG_IMAGE_MAGIC);
+    putU16(image, CONFIG_IMAGE_VERSION);
+    putU16(image, 0);
+    putU32(image, sourceHash);
+    putU32(image, 0);  // payload hash, filled in below
+    putU32(image, 0);  // payload length, filled in below
+
+    putU16(image, options.logPeriodMs);
+    putU16(image, options.wirelessPeriodMs);
+    putU16(image, static_cast<uint16_t>(messages.size()));
+    putU16(image, options.logFlushPeriodMs);
+    putU32(image, options.logFlushBytes);
+    putU32(image, options.logPreallocateBytes);
+    putU16(image, options.logPackBlockBytes);
+    putU32(image, options.logRotateBytes);
+    putU16(image, options.logRotateMinutes);
+
+    for (const CANMessage* msg : messages) {
+        putU32(image, msg->id);
+        putU8(image, msg->length);
+        putU8(image, static_cast<uint8_t>(msg->type));
+        putU8(image, static_cast<uint8_t>(msg->logMode));
+        putU16(image, static_cast<uint16_t>(msg->signals.size()));
+
+        for (const CANSignal& sig : msg->signals) {
+            uint8_t flags = 0;
+            flags |= sig.isSigned() ? SIGNAL_FLAG_SIGNED : 0;
+            flags |= sig.endianness() == MSG_BIG_ENDIAN ? SIGNAL_FLAG_BIG_ENDIAN : 0;
+
+            putU16(image, sig.layout().startBit);
+            putU8(image, sig.layout().length);
+            putU8(image, flags);
+            putF64(image, sig.factor());
+            putF64(image, sig.offset());
+        }
+    }
+
+    std::size_t payloadLength = image.size() - HEADER_SIZE;
+    setU32(image, 12, common::fnv1a(image.data() + HEADER_SIZE, payloadLength));
+    setU32(image, 16, static_cast<uint32_t>(payloadLength));
+    return image;
+}
+
+ConfigImageStatus ConfigImage::check(const uint8_t* image, std::size_t size, uint32_t sourceHash) {
+    ImageCursor header(image, size);
+    uint32_t magic = header.u32();
+    uint16_t version = header.u16();
+    header.u16();
+    uint32_t imageSourceHash = header.u32();
+    uint32_t payloadHash = header.u32();
+    uint32_t payloadLength = header.u32();
+
+    if (header.overrun() || magic != CONFIG_IMAGE_MAGIC) {
+        return CIS_BAD_HEADER;
+    }
+    if (version != CONFIG_IMAGE_VERSION) {
+        return CIS_BAD_VERSION;
+    }
+    if (imageSourceHash != sourceHash) {
+        return CIS_STALE;
+    }
+    if (payloadLength != size - HEADER_SIZE ||
+        common::fnv1a(image + HEADER_SIZE, payloadLength) != payloadHash) {
+        return CIS_CORRUPT;
+    }
+    return CIS_OK;
+}
+
+Result<TelemetryOptions> ConfigImage::load(const uint8_t* image, std::size_t size,
+                                           uint32_t sourceHash, CANBus& bus) {
+    ConfigImageStatus status = check(image, size, sourceHash);
+    if (status != CIS_OK) {
+        return Result<TelemetryOptions>::errorResult(statusString(status));
+    }
+    if (!bus.getMessages().empty()) {
+        return Result<TelemetryOptions>::errorResult("config image needs an empty bus");
+    }
+
+    ImageCursor in(image + HEADER_SIZE, size - HEADER_SIZE);
+    TelemetryOptions options;
+    options.logPeriodMs = in.u16();
+    options.wirelessPeriodMs = in.u16();
+    uint16_t messageCount = in.u16();
+    options.logFlushPeriodMs = in.u16();
+    options.logFlushBytes = in.u32();
+    options.logPreallocateBytes = in.u32();
+    options.logPackBlockBytes = in.u16();
+    options.logRotateBytes = in.u32();
+    options.logRotateMinutes = in.u16();
+
+    // decode and validate everything first, the bus is only touched once the image is known good
+    std::vector<CANMessageDescription> descriptions(messageCount);
+    std::set<uint32_t> ids;
+    for (CANMessageDescription& desc : descriptions) {
+        desc.id = in.u32();
+        desc.length = in.u8();
+        uint8_t type = in.u8();
+        uint8_t logMode = in.u8();
+        uint16_t signalCount = in.u16();
+
+        if (in.overrun() || type > EXTENDED || logMode > MLM_EVENT ||
+            !isValidFrameLength(desc.length) || !ids.insert(desc.id).second) {
+            return Result<TelemetryOptions>::errorResult(statusString(CIS_CORRUPT));
+        }
+        desc.type = static_cast<FrameType>(type);
+        desc.logMode = static_cast<MessageLogMode>(logMode);
+
+        desc.signals.resize(signalCount);
+        for (CANSignalDescription& sig : desc.signals) {
+            sig.startBit = in.u16();
+            sig.length = in.u8();
+            uint8_t flags = in.u8();
+            sig.factor = in.f64();
+            sig.offset = in.f64();
+            sig.isSigned = (flags & SIGNAL_FLAG_SIGNED) != 0;
+            sig.endianness = (flags & SIGNAL_FLAG_BIG_ENDIAN) ? MSG_BIG_ENDIAN : MSG_LITTLE_ENDIAN;
+
+            if (in.overrun() || sig.length == 0 || sig.length > 64 ||
+                sig.startBit + sig.length > desc.length * 8) {
+                return Result<TelemetryOptions>::errorResult(statusString(CIS_CORRUPT));
+            }
+        }
+    }
+    if (!in.atEnd()) {
+        return Result<TelemetryOptions>::errorResult(statusString(CIS_CORRUPT));
+    }
+
+    // the image lists every message up front, so the bus can lay them all out in one go
+    for (const CANMessageDescription& desc : descriptions) {
+        bus.planMessage(desc.id, desc.length, desc.signals.size());
+    }
+    bus.reserve();
+    for (const CANMessageDescription& desc : descriptions) {
+        bus.addMessage(desc);
+    }
+
+    TELEM_DEBUG_PRINTLN("Loaded %d messages from config image", messageCount);
+    return Result<TelemetryOptions>::ok(options);
+}
+
+const char* ConfigImage::statusString(ConfigImageStatus status) {
+    switch (status) {
+        case CIS_OK:
+            return "config image ok";
+        case CIS_BAD_HEADER:
+            return "not a config image";
+        case CIS_BAD_VERSION:
+            return "config image version mismatch";
+        case CIS_STALE:
+            return "config image is out of date";
+        case CIS_CORRUPT:
+            return "config image is corrupt";
+    }
+    return "unknown config image status";
+}
+
+}  // namespace can
@@ -0,0 +1,86 @@
+#ifndef __CONFIG_IMAGE_H__
+#define __CONFIG_IMAGE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "block_token_reader.hpp"
+#include "can.hpp"
+#include "result.hpp"
+#include "telem_builder.hpp"
+
+namespace can {
+
+/// @brief "TLMC", read as a little-endian word
+static constexpr uint32_t CONFIG_IMAGE_MAGIC = 0x434D4C54;
+
+/// @brief Bumped whenever the layout of an image changes, old images are then rebuilt from text
+static constexpr uint16_t CONFIG_IMAGE_VERSION = 6;
+
+/// @brief Why an image can or can't be used
+enum ConfigImageStatus {
+    CIS_OK,           // the image matches the source and is intact
+    CIS_BAD_HEADER,   // too short, or not an image at all
+    CIS_BAD_VERSION,  // written by a different image version
+    CIS_STALE,        // built from a different .telem file
+    CIS_CORRUPT       // the payload doesn't match its hash, or doesn't describe a valid bus
+};
+
+/// @brief A compiled .telem file (.telemc): the validated bus layout, the global options, and a
+/// hash of the text it came from. Loading an image skips the tokenizer and builder entirely, so
+/// boot only has to hash the text to know whether the image is still good.
+///
+/// Layout, all little-endian:
+///   header  magic u32, version u16, reserved u16, source hash u32, payload hash u32,
+///           payload length u32
+///   payload logPeriodMs u16, wirelessPeriodMs u16, message count u16, logFlushPeriodMs u16,
+///           logFlushBytes u32, logPreallocateBytes u32, logPackBlockBytes u16, logRotateBytes u32,
+///           logRotateMinutes u16, then per message: id u32, length u8, type u8, log mode u8,
+///           signal count u16, then per signal: startBit u16, length u8, flags u8 (bit 0 signed,
+///           bit 1 big endian), factor f64, offset f64
+///
+/// Messages are stored in data buffer order, so a loaded bus has exactly the layout of the bus
+/// the image was made from.
+class ConfigImage {
+   public:
+    static constexpr std::size_t HEADER_SIZE = 20;
+
+    /// @brief Hashes a whole source, block by block
+    /// @param source The source, usually the .telem file
+    /// @param hash Out: the hash of the contents
+    /// @return false if the source couldn't be opened or read
+    static bool hashSource(BlockSource& source, uint32_t* hash);
+
+    /// @brief Serializes a built bus into an image
+    /// @param bus The bus, as built by a TelemBuilder
+    /// @param options The options the builder returned
+    /// @param sourceHash The hash of the text the bus was built from
+    /// @return The image
+    static std::vector<uint8_t> serialize(const CANBus& bus, const TelemetryOptions& options,
+                                          uint32_t sourceHash);
+
+    /// @brief Checks that an image is intact and was built from the given source
+    /// @param image The image
+    /// @param size The size of the image, in bytes
+    /// @param sourceHash The hash of the current .telem file
+    /// @return CIS_OK if the image can be loaded
+    static ConfigImageStatus check(const uint8_t* image, std::size_t size, uint32_t sourceHash);
+
+    /// @brief Loads an image into an empty bus. Everything is checked before the first message is
+    /// added, so on an error the bus is left untouched.
+    /// @param image The image
+    /// @param size The size of the image, in bytes
+    /// @param sourceHash The hash of the current .telem file
+    /// @param bus The bus to add the messages to
+    /// @return The options stored in the image
+    static common::Result<TelemetryOptions> load(const uint8_t* image, std::size_t size,
+                                                 uint32_t sourceHash, CANBus& bus);
+
+    /// @brief A printable reason for a status
+    static const char* statusString(ConfigImageStatus status);
+};
+
+}  // namespace can
+
+#endif  // __CONFIG_IMAGE_H__
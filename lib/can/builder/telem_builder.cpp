@@ -1,7 +1,6 @@
 #include "telem_builder.hpp"
 
 #include <cstring>
-#include <algorithm>
 
 #include "can.hpp"
 #include "option.hpp"
@@ -14,66 +13,236 @@ namespace can {
 using common::Option;
 using common::Result;
 
+// numeric fields accept integer literals too, so `2` and `2.0` mean the same factor
+static double numericValue(const Token& t) {
+    return t.type == TokenType::TT_INT ? static_cast<double>(t.data.intValue) : t.data.floatValue;
+}
+
 const __OptionDescriptor TelemBuilder::_optionTable[] = {
     {.name = "logPeriodMs",
      .type = OptionType::UINT16,
      .apply = [](TelemetryOptions& o,
-                 const TokenData& d) { o.logPeriodMs = static_cast<uint16_t>(d.intValue); }},
+                 const Token& t) { o.logPeriodMs = static_cast<uint16_t>(t.data.intValue); }},
     {.name = "wirelessPeriodMs",
      .type = OptionType::UINT16,
-     .apply = [](TelemetryOptions& o, const TokenData& d) {
-         o.wirelessPeriodMs = static_cast<uint16_t>(d.intValue);
+     .apply = [](TelemetryOptions& o, const Token& t) {
+         o.wirelessPeriodMs = static_cast<uint16_t>(t.data.intValue);
+     }},
+    {.name = "logFlushPeriodMs",
+     .type = OptionType::UINT16,
+     .apply = [](TelemetryOptions& o, const Token& t) {
+         o.logFlushPeriodMs = static_cast<uint16_t>(t.data.intValue);
+     }},
+    {.name = "logFlushBytes",
+     .type = OptionType::UINT32,
+     .apply = [](TelemetryOptions& o, const Token& t) {
+         o.logFlushBytes = static_cast<uint32_t>(t.data.intValue);
+     }},
+    {.name = "logPreallocateBytes",
+     .type = OptionType::UINT32,
+     .apply = [](TelemetryOptions& o, const Token& t) {
+         o.logPreallocateBytes = static_cast<uint32_t>(t.data.intValue);
+     }},
+    {.name = "logPackBlockBytes",
+     .type = OptionType::UINT16,
+     .apply = [](TelemetryOptions& o, const Token& t) {
+         o.logPackBlockBytes = static_cast<uint16_t>(t.data.intValue);
+     }},
+    {.name = "logRotateBytes",
+     .type = OptionType::UINT32,
+     .apply = [](TelemetryOptions& o, const Token& t) {
+         o.logRotateBytes = static_cast<uint32_t>(t.data.intValue);
+     }},
+    {.name = "logRotateMinutes",
+     .type = OptionType::UINT16,
+     .apply = [](TelemetryOptions& o, const Token& t) {
+         o.logRotateMinutes = static_cast<uint16_t>(t.data.intValue);
      }}};
 
 const __MessageFieldDescriptor TelemBuilder::_messageFieldTable[] = {
     {.type = OptionType::UINT32,
      .optional = false,
      .apply = [](CANMessageDescription& m,
-                 const TokenData& d) { m.id = static_cast<uint32_t>(d.uintValue); }},
+                 const Token& t) { m.id = static_cast<uint32_t>(t.data.uintValue); }},
     {.type = OptionType::UINT16,
      .optional = false,
-     .apply = [](CANMessageDescription& m, const TokenData& d) {
-         m.length = static_cast<uint8_t>(d.intValue);
+     .apply = [](CANMessageDescription& m, const Token& t) {
+         m.length = static_cast<uint8_t>(t.data.intValue);
      }}};
 
 const __SignalFieldDescriptor TelemBuilder::_signalFieldTable[] = {
     {.type = OptionType::UINT16,
      .optional = false,
      .apply = [](CANSignalDescription& s,
-                 const TokenData& d) { s.startBit = static_cast<uint8_t>(d.intValue); }},
+                 const Token& t) { s.startBit = static_cast<uint16_t>(t.data.intValue); }},
     {.type = OptionType::UINT16,
      .optional = false,
      .apply = [](CANSignalDescription& s,
-                 const TokenData& d) { s.length = static_cast<uint8_t>(d.intValue); }},
+                 const Token& t) { s.length = static_cast<uint8_t>(t.data.intValue); }},
     {.type = OptionType::DOUBLE,
      .optional = false,
-     .apply = [](CANSignalDescription& s, const TokenData& d) { s.factor = d.floatValue; }},
+     .apply = [](CANSignalDescription& s, const Token& t) { s.factor = numericValue(t); }},
     {.type = OptionType::DOUBLE,
      .optional = false,
-     .apply = [](CANSignalDescription& s, const TokenData& d) { s.offset = d.floatValue; }}};
+     .apply = [](CANSignalDescription& s, const Token& t) { s.offset = numericValue(t); }}};
+
+const char* buildErrorString(BuildError error) {
+    switch (error) {
+        case BE_NONE:
+            return "no error";
+        case BE_TOKENIZER_START:
+            return "failed to start tokenizer";
+        case BE_MALFORMED_OPTION:
+            return "malformed global option";
+        case BE_UNKNOWN_OPTION:
+            return "unknown option";
+        case BE_UNEXPECTED_TOKEN:
+            return "unexpected token at top level; expected '>' or EOF";
+        case BE_NO_BOARD:
+            return "no board defined";
+        case BE_BOARD_NAME:
+            return "expected board name after '>'";
+        case BE_BOARD_WITHOUT_MESSAGES:
+            return "board without any messages";
+        case BE_MESSAGE_NAME:
+            return "expected message name";
+        case BE_MESSAGE_HEADER_INCOMPLETE:
+            return "incomplete message header";
+        case BE_MESSAGE_ID_NOT_HEX:
+            return "expected hex ID in message header";
+        case BE_MESSAGE_SIZE_NOT_INT:
+            return "expected integer size in message header";
+        case BE_MESSAGE_LOG_MODE:
+            return "unknown log mode in message header; expected 'event' or 'snapshot'";
+        case BE_MESSAGE_WITHOUT_SIGNALS:
+            return "message without any signals";
+        case BE_MESSAGE_ID_RANGE:
+            return "message ID out of 0x000–0x7FF";
+        case BE_MESSAGE_LENGTH:
+            return "message size must be 0-8 bytes, or 12/16/20/24/32/48/64 bytes for CAN FD";
+        case BE_DUPLICATE_MESSAGE_ID:
+            return "duplicate message ID!";
+        case BE_SIGNAL_NAME:
+            return "expected signal name";
+        case BE_SIGNAL_TYPE:
+            return "expected signal dataType";
+        case BE_SIGNAL_INCOMPLETE:
+            return "incomplete signal definition";
+        case BE_SIGNAL_NOT_INT:
+            return "expected integer in signal field";
+        case BE_SIGNAL_NOT_NUMERIC:
+            return "expected numeric in signal field";
+        case BE_SIGNAL_LENGTH:
+            return "signal length must be 1-64 bits";
+        case BE_SIGNAL_OVERRUN:
+            return "signal overruns message payload";
+        case BE_SIGNAL_OVERLAP:
+            return "Overlapping Signals!";
+    }
+    return "unknown build error";
+}
 
 Result<TelemetryOptions> TelemBuilder::build(CANBus& bus) {
     TelemetryOptions opts;
 
+    // identifiers are only needed while parsing, hand them back (but keep the memory) after
+    IdentifierPool::Scope idScope(IdentifierPool::instance());
+
     if (!_tokenizer.start()) {
-        return Result<TelemetryOptions>::errorResult("failed to start tokenizer");
+        _error = BE_TOKENIZER_START;
+        return Result<TelemetryOptions>::errorResult(buildErrorString(_error));
+    }
+
+    _error = _build(bus, opts);
+    _tokenizer.end();
+
+    if (_error != BE_NONE) {
+        TELEM_DEBUG_PRINTLN("Build failed: %s", buildErrorString(_error));
+        return Result<TelemetryOptions>::errorResult(buildErrorString(_error));
+    }
+    return Result<TelemetryOptions>::ok(opts);
+}
+
+BuildError TelemBuilder::plan(CANBus& bus) {
+    IdentifierPool::Scope idScope(IdentifierPool::instance());
+
+    if (!_tokenizer.start()) {
+        return BE_TOKENIZER_START;
+    }
+
+    bool inMessage = false;
+    uint32_t id = 0;
+    uint8_t length = 0;
+    std::size_t signalCount = 0;
+    std::size_t maxSignalCount = 0;
+    std::size_t messageCount = 0;
+    while (true) {
+        Option<Token> p = _tokenizer.next();
+        if (!p.isSome()) {
+            break;  // EOF
+        }
+
+        TokenType type = p.value().type;
+        if (type == TokenType::TT_MESSAGE_PREFIX || type == TokenType::TT_BOARD_PREFIX) {
+            if (inMessage) {
+                bus.planMessage(id, length, signalCount);
+                ++messageCount;
+            }
+            inMessage = false;
+        }
+
+        if (type == TokenType::TT_MESSAGE_PREFIX) {
+            Option<Token> name = _tokenizer.next();
+            Option<Token> idTok = _tokenizer.next();
+            Option<Token> lengthTok = _tokenizer.next();
+            inMessage = name.isSome() && idTok.isSome() && lengthTok.isSome() &&
+                        idTok.value().type == TokenType::TT_HEX_INT &&
+                        lengthTok.value().type == TokenType::TT_INT;
+            if (inMessage) {
+                id = static_cast<uint32_t>(idTok.value().data.uintValue);
+                length = static_cast<uint8_t>(lengthTok.value().data.intValue);
+                signalCount = 0;
+            }
+        } else if (type == TokenType::TT_SIGNAL_PREFIX) {
+            ++signalCount;
+            if (signalCount > maxSignalCount) {
+                maxSignalCount = signalCount;
+            }
+        }
+
+        // the rest of the line doesn't change the layout
+        if (!_tokenizer.eatUntil('\n')) {
+            break;
+        }
+    }
+    if (inMessage) {
+        bus.planMessage(id, length, signalCount);
+        ++messageCount;
     }
+    _tokenizer.end();
+
+    TELEM_DEBUG_PRINTLN("Planned %d messages", static_cast<int>(messageCount));
+    bus.reserve();
+    _signals.reserve(maxSignalCount);
+    _signalNames.reserve(maxSignalCount);
+    return BE_NONE;
+}
 
+BuildError TelemBuilder::_build(CANBus& bus, TelemetryOptions& opts) {
     // Phase 1: global options
     while (true) {
         Option<Token> p = _tokenizer.peek();
         if (!p.isSome() || p.value().type != TokenType::TT_OPTION_PREFIX) {
             break;
         }
-        Result<bool> r = _parseGlobalOption(opts);
-        if (r.isError()) {
-            _tokenizer.end();
-            return Result<TelemetryOptions>::errorResult(r.error());
+        BuildError err = _parseGlobalOption(opts);
+        if (err != BE_NONE) {
+            return err;
         }
     }
 
     // Phase 2: boards
-    _messageIDSet.clear();
+    std::memset(_seenIds, 0, sizeof(_seenIds));
 
     bool sawBoard = false;
     while (true) {
@@ -81,69 +250,58 @@ Result<TelemetryOptions> TelemBuilder::build(CANBus& bus) {
         if (!p.isSome()) {
             break;  // EOF
         }
-        Token t = p.value();
-        if (t.type == TokenType::TT_BOARD_PREFIX) {
-            sawBoard = true;
-            Result<bool> br = _parseBoard(bus);
-            if (br.isError()) {
-                _tokenizer.end();
-                return Result<TelemetryOptions>::errorResult(br.error());
-            }
-        } else {
+        if (p.value().type != TokenType::TT_BOARD_PREFIX) {
             // any other prefix at top-level is invalid
-            _tokenizer.end();
-            return Result<TelemetryOptions>::errorResult(
-                "unexpected token at top level; expected '>' or EOF");
+            return BE_UNEXPECTED_TOKEN;
+        }
+        sawBoard = true;
+        BuildError err = _parseBoard(bus);
+        if (err != BE_NONE) {
+            return err;
         }
     }
 
-    if (!sawBoard) {
-        _tokenizer.end();
-        return Result<TelemetryOptions>::errorResult("no board defined");
-    }
-
-    _tokenizer.end();
-    return Result<TelemetryOptions>::ok(opts);
+    return sawBoard ? BE_NONE : BE_NO_BOARD;
 }
 
-Result<bool> TelemBuilder::_parseGlobalOption(TelemetryOptions& opts) {
+BuildError TelemBuilder::_parseGlobalOption(TelemetryOptions& opts) {
     _tokenizer.next();  // consume '!!'
 
     Option<Token> nameTok = _tokenizer.next();
     Option<Token> valTok = _tokenizer.next();
     if (!nameTok.isSome() || nameTok.value().type != TokenType::TT_IDENTIFIER || !valTok.isSome() ||
         valTok.value().type != TokenType::TT_INT) {
-        return Result<bool>::errorResult("malformed global option");
+        return BE_MALFORMED_OPTION;
     }
 
     const char* name = IdentifierPool::instance().get(nameTok.value().data.idHandle);
-
-    return _applyOptionByName(opts, std::string(name), valTok.value().data);
+    return _applyOptionByName(opts, name, valTok.value());
 }
 
-Result<bool> TelemBuilder::_applyOptionByName(TelemetryOptions& opts, const std::string& name,
-                                              const TokenData& data) {
+BuildError TelemBuilder::_applyOptionByName(TelemetryOptions& opts, const char* name,
+                                            const Token& value) {
     for (std::size_t i = 0; i < sizeof(_optionTable) / sizeof(_optionTable[0]); ++i) {
         const __OptionDescriptor& od = _optionTable[i];
-        if (name == od.name) {
-            od.apply(opts, data);
-            return Result<bool>::ok(true);
+        if (std::strcmp(name, od.name) == 0) {
+            od.apply(opts, value);
+            return BE_NONE;
         }
     }
-    return Result<bool>::errorResult(std::string("unknown option: ") + name);
+    TELEM_DEBUG_PRINTLN("Unknown option %s", name);
+    return BE_UNKNOWN_OPTION;
 }
 
-Result<bool> TelemBuilder::_parseBoard(CANBus& bus) {
+BuildError TelemBuilder::_parseBoard(CANBus& bus) {
     // consume '>'
     _tokenizer.next();
 
     // board name
     Option<Token> nm = _tokenizer.next();
     if (!nm.isSome() || nm.value().type != TokenType::TT_IDENTIFIER) {
-        return Result<bool>::errorResult("expected board name after '>'");
+        return BE_BOARD_NAME;
     }
-    const char* boardName = IdentifierPool::instance().get(nm.value().data.idHandle);
-    TELEM_DEBUG_PRINTLN("Parsing board %s...", boardName);
+    IdentifierPoolHandle boardName = nm.value().data.idHandle;
+    TELEM_DEBUG_PRINTLN("Parsing board %s...", IdentifierPool::instance().get(boardName));
 
     // now move until the next line
     _tokenizer.eatUntil('\n');
@@ -159,128 +317,157 @@ Result<bool> TelemBuilder::_parseBoard(CANBus& bus) {
         // consume '>>'
         _tokenizer.next();
 
-        Result<CANMessageDescription> mr = _parseMessage();
-        if (mr.isError()) {
-            return Result<bool>::errorResult(mr.error());
+        BuildError err = _parseMessage();
+        if (err == BE_NONE) {
+            err = _validateMessage();
         }
-        CANMessageDescription desc = mr.value();
-
-        Result<bool> vr = _validateMessage(desc);
-        if (vr.isError()) {
-            return vr;
+        if (err != BE_NONE) {
+            return err;
         }
 
-        bus.addMessage(desc);
-        if (_messageIDSet.find(desc.id) != _messageIDSet.end()) {
-            return Result<bool>::errorResult("duplicate message ID!");
+        // checked before the bus sees it, so a failed build never leaves a duplicate behind
+        uint32_t& word = _seenIds[_messageId / 32];
+        uint32_t bit = 1u << (_messageId % 32);
+        if (word & bit) {
+            return BE_DUPLICATE_MESSAGE_ID;
         }
+        word |= bit;
 
-        _messageIDSet.insert(desc.id);
+        CANMessage& message =
+            bus.addMessage(_messageId, _messageLength, STANDARD, _signals.data(), _signals.size());
+        message.logMode = _messageLogMode;
+        if (_listener) {
+            _notifyListener(boardName);
+        }
     }
 
-    if (!hasMsg) {
-        return Result<bool>::errorResult("board without any messages");
-    }
-    return Result<bool>::ok(true);
+    return hasMsg ? BE_NONE : BE_BOARD_WITHOUT_MESSAGES;
 }
 
-Result<CANMessageDescription> TelemBuilder::_parseMessage() {
-    CANMessageDescription msgDesc{};
-    msgDesc.signals.clear();
+void TelemBuilder::_notifyListener(IdentifierPoolHandle boardName) const {
+    // only listeners pay for a full description, and the pool may have moved while parsing, so
+    // names are only looked up now
+    IdentifierPool& pool = IdentifierPool::instance();
+    CANMessageDescription desc{};
+    desc.name = pool.get(_messageName);
+    desc.id = _messageId;
+    desc.length = _messageLength;
+    desc.type = STANDARD;
+    desc.logMode = _messageLogMode;
+    desc.signals = _signals;
+    for (std::size_t i = 0; i < desc.signals.size(); ++i) {
+        desc.signals[i].name = pool.get(_signalNames[i]);
+    }
+    _listener(pool.get(boardName), desc);
+}
 
+BuildError TelemBuilder::_parseMessage() {
     // consume message name
     Option<Token> n = _tokenizer.next();
     if (!n.isSome() || n.value().type != TokenType::TT_IDENTIFIER) {
-        return Result<CANMessageDescription>::errorResult("expected message name");
+        return BE_MESSAGE_NAME;
     }
-
-    const char* messageName = IdentifierPool::instance().get(n.value().data.idHandle);
-    TELEM_DEBUG_PRINTLN("Parsing message %s...", messageName);
+    _messageName = n.value().data.idHandle;
+    TELEM_DEBUG_PRINTLN("Parsing message %s...", IdentifierPool::instance().get(_messageName));
 
     // header fields via LUT
+    CANMessageDescription header{};
     for (std::size_t i = 0; i < sizeof(_messageFieldTable) / sizeof(_messageFieldTable[0]); ++i) {
         Option<Token> ft = _tokenizer.next();
         if (!ft.isSome()) {
-            return Result<CANMessageDescription>::errorResult("incomplete message header");
+            return BE_MESSAGE_HEADER_INCOMPLETE;
         }
         Token tok = ft.value();
         // type‐check
         if (_messageFieldTable[i].type == OptionType::UINT32 && tok.type != TokenType::TT_HEX_INT) {
-            return Result<CANMessageDescription>::errorResult("expected hex ID in message header");
+            return BE_MESSAGE_ID_NOT_HEX;
         }
         if (_messageFieldTable[i].type == OptionType::UINT16 && tok.type != TokenType::TT_INT) {
-            return Result<CANMessageDescription>::errorResult(
-                "expected integer size in message header");
+            return BE_MESSAGE_SIZE_NOT_INT;
+        }
+        _messageFieldTable[i].apply(header, tok);
+    }
+    _messageId = header.id;
+    _messageLength = header.length;
+
+    // optional log mode
+    _messageLogMode = MLM_SNAPSHOT;
+    bool restOfLine = true;
+    Option<Token> mode = _tokenizer.peek();
+    if (mode.isSome() && mode.value().type == TokenType::TT_IDENTIFIER) {
+        const char* m = IdentifierPool::instance().get(mode.value().data.idHandle);
+        if (std::strcmp(m, "event") == 0) {
+            _messageLogMode = MLM_EVENT;
+        } else if (std::strcmp(m, "snapshot") != 0) {
+            return BE_MESSAGE_LOG_MODE;
         }
-        _messageFieldTable[i].apply(msgDesc, tok.data);
+        _tokenizer.next();
+    } else if (!mode.isSome() || mode.value().type == TokenType::TT_SIGNAL_PREFIX) {
+        // already looking at the next line, keep it instead of lexing it again
+        restOfLine = false;
     }
-    msgDesc.type = STANDARD;
 
     // now move until the next line
-    _tokenizer.eatUntil('\n');
+    if (restOfLine) {
+        _tokenizer.eatUntil('\n');
+    }
 
-    // signals
-    std::size_t msgBits = static_cast<std::size_t>(msgDesc.length) * 8;
-    bool sawSig = false;
+    // signals, into scratch that keeps its capacity from one message to the next
+    _signals.clear();
+    _signalNames.clear();
+    std::size_t msgBits = static_cast<std::size_t>(_messageLength) * 8;
     while (true) {
         Option<Token> p = _tokenizer.peek();
         if (!p.isSome() || p.value().type != TokenType::TT_SIGNAL_PREFIX) {
             break;
         }
-        sawSig = true;
         // consume '>>>'
         _tokenizer.next();
 
-        Result<CANSignalDescription> sr = _parseSignal();
-        if (sr.isError()) {
-            return Result<CANMessageDescription>::errorResult(sr.error());
+        CANSignalDescription sig{};
+        BuildError err = _parseSignal(sig);
+        if (err == BE_NONE) {
+            err = _validateSignal(sig, msgBits);
         }
-        CANSignalDescription sig = sr.value();
-
-        Result<bool> vr = _validateSignal(sig, msgBits);
-        if (vr.isError()) {
-            return Result<CANMessageDescription>::errorResult(vr.error());
+        if (err != BE_NONE) {
+            return err;
         }
 
-        msgDesc.signals.push_back(sig);
+        _signals.push_back(sig);
     }
 
-    if (!sawSig) {
-        return Result<CANMessageDescription>::errorResult("message without any signals");
-    }
-    return Result<CANMessageDescription>::ok(msgDesc);
+    return _signals.empty() ? BE_MESSAGE_WITHOUT_SIGNALS : BE_NONE;
 }
 
-Result<CANSignalDescription> TelemBuilder::_parseSignal() {
+BuildError TelemBuilder::_parseSignal(CANSignalDescription& sigDesc) {
     // name
     Option<Token> n = _tokenizer.next();
     if (!n.isSome() || n.value().type != TokenType::TT_IDENTIFIER) {
-        return Result<CANSignalDescription>::errorResult("expected signal name");
+        return BE_SIGNAL_NAME;
     }
     // dataType
     Option<Token> dt = _tokenizer.next();
     if (!dt.isSome() || dt.value().type != TokenType::TT_IDENTIFIER) {
-        return Result<CANSignalDescription>::errorResult("expected signal dataType");
+        return BE_SIGNAL_TYPE;
     }
-    const char* dtype = IdentifierPool::instance().get(dt.value().data.idHandle);
 
-    CANSignalDescription sigDesc{};
+    _signalNames.push_back(n.value().data.idHandle);
     // numeric fields via LUT
     for (std::size_t i = 0; i < sizeof(_signalFieldTable) / sizeof(_signalFieldTable[0]); ++i) {
         Option<Token> ft = _tokenizer.next();
         if (!ft.isSome()) {
-            return Result<CANSignalDescription>::errorResult("incomplete signal definition");
+            return BE_SIGNAL_INCOMPLETE;
         }
         Token tok = ft.value();
         // type‐check
         if (_signalFieldTable[i].type == OptionType::UINT16 && tok.type != TokenType::TT_INT) {
-            return Result<CANSignalDescription>::errorResult("expected integer in signal field");
+            return BE_SIGNAL_NOT_INT;
         }
         if (_signalFieldTable[i].type == OptionType::DOUBLE &&
             !(tok.type == TokenType::TT_FLOAT || tok.type == TokenType::TT_INT)) {
-            return Result<CANSignalDescription>::errorResult("expected numeric in signal field");
+            return BE_SIGNAL_NOT_NUMERIC;
         }
-        _signalFieldTable[i].apply(sigDesc, tok.data);
+        _signalFieldTable[i].apply(sigDesc, tok);
     }
 
     // signedness override
@@ -303,45 +490,45 @@ Result<CANSignalDescription> TelemBuilder::_parseSignal() {
         }
     }
 
-    return Result<CANSignalDescription>::ok(sigDesc);
+    return BE_NONE;
 }
 
 // Validate individual signals
-Result<bool> TelemBuilder::_validateSignal(const CANSignalDescription& sig, size_t msgBits) {
+BuildError TelemBuilder::_validateSignal(const CANSignalDescription& sig, size_t msgBits) const {
+    if (sig.length == 0 || sig.length > 64) {
+        return BE_SIGNAL_LENGTH;
+    }
+
     if ((size_t)sig.startBit + (size_t)sig.length > msgBits) {
-        return Result<bool>::errorResult("signal overruns message payload");
+        return BE_SIGNAL_OVERRUN;
     }
 
-    return Result<bool>::ok(true);
+    return BE_NONE;
 }
 
-Result<bool> TelemBuilder::_validateMessage(const CANMessageDescription& message) {
-    if (message.id > 0x7FF) {
-        return Result<bool>::errorResult("message ID out of 0x000–0x7FF");
+BuildError TelemBuilder::_validateMessage() const {
+    if (_messageId > 0x7FF) {
+        return BE_MESSAGE_ID_RANGE;
     }
 
-    // check that non of the signals overlap
-    std::vector<CANSignalDescription> sortedSignals(message.signals);
-
-    std::sort(sortedSignals.begin(), sortedSignals.end(),
-              [](const CANSignalDescription& a, const CANSignalDescription& b) {
-                  return a.startBit < b.startBit;
-              });
-
-    uint8_t topBit = 0;
-    for (const CANSignalDescription& sig : sortedSignals) {
-        if (sig.startBit < topBit) {
-            return Result<bool>::errorResult("Overlapping Signals!");
-        }
-
-        topBit = sig.startBit + sig.length;
+    if (!isValidFrameLength(_messageLength)) {
+        return BE_MESSAGE_LENGTH;
     }
 
-    if (topBit > 64) {
-        return Result<bool>::errorResult("CAN Signal length is greater than 64!");
+    // check that none of the signals overlap, one bit per payload bit instead of sorting a copy.
+    // every signal already fits in the payload, so nothing here can overrun it
+    uint64_t used[CANFD_MAX_DATA_LENGTH * 8 / 64] = {};
+    for (const CANSignalDescription& sig : _signals) {
+        for (uint16_t bit = sig.startBit; bit < sig.startBit + sig.length; ++bit) {
+            uint64_t mask = 1ull << (bit % 64);
+            if (used[bit / 64] & mask) {
+                return BE_SIGNAL_OVERLAP;
+            }
+            used[bit / 64] |= mask;
+        }
     }
 
-    return Result<bool>::ok(true);
+    return BE_NONE;
 }
 
 }  // namespace can
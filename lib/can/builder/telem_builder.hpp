@@ -3,8 +3,6 @@
 #define __TELEM_BUILDER_H__
 
 #include <functional>
-#include <set>
-#include <string>
 #include <vector>
 
 #include "can.hpp"
@@ -18,16 +16,55 @@ namespace can {
 struct TelemetryOptions {
     uint16_t logPeriodMs = 100;
     uint16_t wirelessPeriodMs = 100;
+    uint16_t logFlushPeriodMs = 1000;  // how often the open log file is committed to the card
+    uint32_t logFlushBytes = 16384;    // or how much may be pending before it is
+    uint32_t logPreallocateBytes = 8u << 20;  // log file space allocated ahead of writes, 0 for none
+    uint16_t logPackBlockBytes = 4096;        // log bytes compressed at a time, 0 to not compress
+    uint32_t logRotateBytes = 256u << 20;     // size a log file is rotated at, 0 for no limit
+    uint16_t logRotateMinutes = 60;           // or its age, 0 for no limit
 };
 
 enum class OptionType { UINT16, UINT32, FLOAT, DOUBLE, BOOL };
 
+/// @brief Why a build failed. Parsing only deals in these codes, the text for the one that stopped
+/// the build is looked up once at the end.
+enum BuildError {
+    BE_NONE,
+    BE_TOKENIZER_START,
+    BE_MALFORMED_OPTION,
+    BE_UNKNOWN_OPTION,
+    BE_UNEXPECTED_TOKEN,
+    BE_NO_BOARD,
+    BE_BOARD_NAME,
+    BE_BOARD_WITHOUT_MESSAGES,
+    BE_MESSAGE_NAME,
+    BE_MESSAGE_HEADER_INCOMPLETE,
+    BE_MESSAGE_ID_NOT_HEX,
+    BE_MESSAGE_SIZE_NOT_INT,
+    BE_MESSAGE_LOG_MODE,
+    BE_MESSAGE_WITHOUT_SIGNALS,
+    BE_MESSAGE_ID_RANGE,
+    BE_MESSAGE_LENGTH,
+    BE_DUPLICATE_MESSAGE_ID,
+    BE_SIGNAL_NAME,
+    BE_SIGNAL_TYPE,
+    BE_SIGNAL_INCOMPLETE,
+    BE_SIGNAL_NOT_INT,
+    BE_SIGNAL_NOT_NUMERIC,
+    BE_SIGNAL_LENGTH,
+    BE_SIGNAL_OVERRUN,
+    BE_SIGNAL_OVERLAP,
+};
+
+/// @brief A readable description of a build error
+const char* buildErrorString(BuildError error);
+
 /// @brief An internal struct for parsing global options
 /// denoted with the `!!` prefix in telem
 struct __OptionDescriptor {
     const char* name;
     OptionType type;
-    std::function<void(TelemetryOptions&, const TokenData&)> apply;
+    void (*apply)(TelemetryOptions&, const Token&);
 };
 
 /// @brief An internal struct for parsing message fields
@@ -35,7 +72,7 @@ struct __OptionDescriptor {
 struct __MessageFieldDescriptor {
     OptionType type;
     bool optional;
-    std::function<void(CANMessageDescription&, const TokenData&)> apply;
+    void (*apply)(CANMessageDescription&, const Token&);
 };
 
 /// @brief An internal struct for parsing signal fields
@@ -43,39 +80,73 @@ struct __MessageFieldDescriptor {
 struct __SignalFieldDescriptor {
     OptionType type;
     bool optional;
-    std::function<void(CANSignalDescription&, const TokenData&)> apply;
+    void (*apply)(CANSignalDescription&, const Token&);
 };
 
-/// @brief A builder class for constructing a `CANBus` dbc from a .telem file
+/// @brief Called for every message as it is added to the bus, along with the name of its board.
+/// All names point into the identifier pool, and are only valid for the duration of the call.
+using MessageListener =
+    std::function<void(const char* boardName, const CANMessageDescription& message)>;
+
+/// @brief A builder class for constructing a `CANBus` dbc from a .telem file.
+/// Messages are streamed into the bus as soon as they validate. Once the identifier pool has grown
+/// to fit the file and the bus has been reserved, a build does not touch the heap at all.
 class TelemBuilder {
    public:
     /// @brief Base Ctor
     /// @param tokenizer The source of tokens from a telem config file
     explicit TelemBuilder(Tokenizer& tokenizer) : _tokenizer(tokenizer) {}
 
+    /// @brief The counting pass: skims the config for the ID, length and number of signals of
+    /// every message, plans them on the bus and reserves it, so build() can put every message
+    /// straight into its slot. The builder's own scratch is sized for the message with the most
+    /// signals, so build() doesn't grow it either. Only the first words of each line are read, and malformed lines
+    /// are skipped since build() is what reports them.
+    /// @param bus The bus to plan, which must still be empty
+    /// @return BE_TOKENIZER_START if the config could not be read, else BE_NONE
+    BuildError plan(CANBus& bus);
+
     /// @brief Builds a CAN bus DBC from the injected tokenizer
     /// @param bus The bus to add messages to, warning if it fails midway, only some mesages will be
     /// added
     /// @return A result of Telemetry Options, which are the global settings provided from the file
     Result<TelemetryOptions> build(CANBus& bus);
 
+    /// @brief Sets a listener that sees every message the builder adds, names included
+    /// @param listener The listener, or an empty function to remove it
+    void setMessageListener(MessageListener listener) { _listener = listener; }
+
+    /// @brief The error that stopped the last build, BE_NONE if it succeeded
+    BuildError lastError() const { return _error; }
+
    private:
     Tokenizer& _tokenizer;
+    MessageListener _listener;
 
     static const __OptionDescriptor _optionTable[];
     static const __MessageFieldDescriptor _messageFieldTable[];
     static const __SignalFieldDescriptor _signalFieldTable[];
 
-    Result<bool> _parseGlobalOption(TelemetryOptions& opts);
-    Result<bool> _applyOptionByName(TelemetryOptions& opts, const std::string& name,
-                                    const TokenData& data);
-    Result<bool> _parseBoard(CANBus& bus);
-    Result<CANMessageDescription> _parseMessage();
-    Result<CANSignalDescription> _parseSignal();
-    Result<bool> _validateMessage(const CANMessageDescription& msg);
-    Result<bool> _validateSignal(const CANSignalDescription& sig, size_t msgBits);
-
-    std::set<uint16_t> _messageIDSet;
+    BuildError _build(CANBus& bus, TelemetryOptions& opts);
+    BuildError _parseGlobalOption(TelemetryOptions& opts);
+    BuildError _applyOptionByName(TelemetryOptions& opts, const char* name, const Token& value);
+    BuildError _parseBoard(CANBus& bus);
+    BuildError _parseMessage();
+    BuildError _parseSignal(CANSignalDescription& sig);
+    BuildError _validateMessage() const;
+    BuildError _validateSignal(const CANSignalDescription& sig, size_t msgBits) const;
+    void _notifyListener(IdentifierPoolHandle boardName) const;
+
+    BuildError _error = BE_NONE;
+    uint32_t _seenIds[(0x7FF + 1) / 32];  // one bit per standard ID
+
+    // the message being parsed, reused from one message to the next
+    uint32_t _messageId = 0;
+    uint8_t _messageLength = 0;
+    MessageLogMode _messageLogMode = MLM_SNAPSHOT;
+    IdentifierPoolHandle _messageName{};
+    std::vector<CANSignalDescription> _signals;  // sized by plan() for the largest message
+    std::vector<IdentifierPoolHandle> _signalNames;
 };
 
 }  // namespace can
@@ -0,0 +1,297 @@
+#include "telem_codegen.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+
+#include "signal_layout.hpp"
+
+namespace can {
+
+using common::Result;
+
+// names the generated header already uses at each scope
+static const char* const TOP_LEVEL_NAMES[] = {
+    "SOURCE_HASH", "LOG_PERIOD_MS", "WIRELESS_PERIOD_MS", "LOG_FLUSH_PERIOD_MS", "LOG_FLUSH_BYTES",
+    "LOG_PREALLOCATE_BYTES", "LOG_PACK_BLOCK_BYTES", "LOG_ROTATE_BYTES", "LOG_ROTATE_MINUTES",
+    "MESSAGE_COUNT", "SIGNAL_COUNT", "MESSAGES", "SIGNALS", "MessageEntry", "SignalEntry"};
+static const char* const MESSAGE_NAMES[] = {"ID", "LENGTH", "EXTENDED", "INDEX"};
+
+static bool isReserved(const std::string& name, const char* const* names, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (name == names[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// printf into a string
+static void emit(std::string& out, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    va_list measure;
+    va_copy(measure, args);
+    int length = std::vsnprintf(nullptr, 0, fmt, measure);
+    va_end(measure);
+
+    std::size_t at = out.size();
+    out.resize(at + length + 1);
+    std::vsnprintf(&out[at], length + 1, fmt, args);
+    out.resize(at + length);
+    va_end(args);
+}
+
+// a double literal that reads back as exactly the same double
+static std::string doubleLiteral(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.15g", v);
+    if (std::strtod(buf, nullptr) != v) {
+        std::snprintf(buf, sizeof(buf), "%.17g", v);
+    }
+    std::string s(buf);
+    if (s.find_first_of(".e") == std::string::npos) {
+        s += ".0";
+    }
+    return s;
+}
+
+// the OR of every payload byte of the signal, shifted into place
+static std::string rawExpression(const SignalLayout& layout) {
+    std::string expr;
+    for (uint8_t i = 0; i < layout.byteCount; ++i) {
+        int shift = signalByteShift(layout, i);
+        if (i > 0) {
+            expr += " | ";
+        }
+        emit(expr, "static_cast<uint64_t>(payload[%u])", layout.firstByte + i);
+        if (shift > 0) {
+            emit(expr, " << %d", shift);
+        } else if (shift < 0) {
+            emit(expr, " >> %d", -shift);
+        }
+    }
+    return expr;
+}
+
+void TelemCodegen::addMessage(const char* boardName, const CANMessageDescription& message) {
+    Message msg;
+    msg.board = identifier(boardName);
+    msg.name = identifier(message.name);
+    msg.id = message.id;
+    msg.length = message.length;
+    msg.type = message.type;
+
+    if (isReserved(msg.board, TOP_LEVEL_NAMES, sizeof(TOP_LEVEL_NAMES) / sizeof(char*))) {
+        msg.board += "_";
+    }
+
+    for (const CANSignalDescription& sig : message.signals) {
+        Signal s;
+        s.name = identifier(sig.name);
+        s.desc = sig;
+        s.desc.name = nullptr;  // only valid during the builder's callback
+        if (isReserved(s.name, MESSAGE_NAMES, sizeof(MESSAGE_NAMES) / sizeof(char*))) {
+            s.name += "_";
+        }
+        msg.signals.push_back(s);
+    }
+
+    _messages.push_back(msg);
+}
+
+Result<std::string> TelemCodegen::generate(const TelemetryOptions& options, uint32_t sourceHash,
+                                           const std::string& ns) const {
+    if (_messages.empty()) {
+        return Result<std::string>::errorResult("no messages to generate");
+    }
+
+    // names have to be unique at every scope once they are C++ identifiers
+    std::set<std::string> messageNames;
+    std::size_t signalCount = 0;
+    for (const Message& msg : _messages) {
+        if (!messageNames.insert(msg.board + "::" + msg.name).second) {
+            return Result<std::string>::errorResult("duplicate message name: " + msg.board +
+                                                    "::" + msg.name);
+        }
+
+        std::set<std::string> signalNames;
+        for (const Signal& sig : msg.signals) {
+            if (!signalNames.insert(sig.name).second) {
+                return Result<std::string>::errorResult("duplicate signal name: " + msg.name +
+                                                        "::" + sig.name);
+            }
+            if (!std::isfinite(sig.desc.factor) || !std::isfinite(sig.desc.offset)) {
+                return Result<std::string>::errorResult("non-finite scale on signal " + sig.name);
+            }
+        }
+        signalCount += msg.signals.size();
+    }
+
+    std::string guard = "__";
+    for (char c : ns) {
+        guard += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    guard += "_CONFIG_H__";
+
+    std::string out;
+    out += "// Generated by telemc, do not edit. Regenerate it from the .telem file instead.\n";
+    emit(out, "#ifndef %s\n#define %s\n\n", guard.c_str(), guard.c_str());
+    out += "#include <stdint.h>\n\n";
+    emit(out, "namespace %s {\n\n", ns.c_str());
+
+    emit(out, "static constexpr uint32_t SOURCE_HASH = 0x%08X;\n", sourceHash);
+    emit(out, "static constexpr uint16_t LOG_PERIOD_MS = %u;\n", options.logPeriodMs);
+    emit(out, "static constexpr uint16_t WIRELESS_PERIOD_MS = %u;\n", options.wirelessPeriodMs);
+    emit(out, "static constexpr uint16_t LOG_FLUSH_PERIOD_MS = %u;\n", options.logFlushPeriodMs);
+    emit(out, "static constexpr uint32_t LOG_FLUSH_BYTES = %u;\n",
+         static_cast<unsigned>(options.logFlushBytes));
+    emit(out, "static constexpr uint32_t LOG_PREALLOCATE_BYTES = %u;\n",
+         static_cast<unsigned>(options.logPreallocateBytes));
+    emit(out, "static constexpr uint16_t LOG_PACK_BLOCK_BYTES = %u;\n", options.logPackBlockBytes);
+    emit(out, "static constexpr uint32_t LOG_ROTATE_BYTES = %u;\n",
+         static_cast<unsigned>(options.logRotateBytes));
+    emit(out, "static constexpr uint16_t LOG_ROTATE_MINUTES = %u;\n", options.logRotateMinutes);
+    emit(out, "static constexpr uint16_t MESSAGE_COUNT = %u;\n",
+         static_cast<unsigned>(_messages.size()));
+    emit(out, "static constexpr uint16_t SIGNAL_COUNT = %u;\n\n",
+         static_cast<unsigned>(signalCount));
+
+    out +=
+        "/// @brief A signal of the config, see can::SignalLayout for how bits are numbered\n"
+        "struct SignalEntry {\n"
+        "    uint16_t startBit;\n"
+        "    uint8_t length;\n"
+        "    bool isSigned;\n"
+        "    bool bigEndian;\n"
+        "    uint8_t firstByte;\n"
+        "    uint8_t byteCount;\n"
+        "    uint64_t mask;\n"
+        "    double factor;\n"
+        "    double offset;\n"
+        "};\n\n"
+        "/// @brief A message of the config, its signals are "
+        "SIGNALS[firstSignal, firstSignal + signalCount)\n"
+        "struct MessageEntry {\n"
+        "    uint32_t id;\n"
+        "    uint8_t length;\n"
+        "    bool extended;\n"
+        "    uint16_t firstSignal;\n"
+        "    uint16_t signalCount;\n"
+        "};\n\n";
+
+    // flat tables
+    out += "static constexpr SignalEntry SIGNALS[SIGNAL_COUNT] = {\n";
+    for (const Message& msg : _messages) {
+        for (const Signal& sig : msg.signals) {
+            const CANSignalDescription& d = sig.desc;
+            SignalLayout layout =
+                signalLayout(d.startBit, d.length, d.endianness == MSG_BIG_ENDIAN);
+            emit(out, "    {%u, %u, %s, %s, %u, %u, 0x%llXull, %s, %s},  // %s::%s::%s\n",
+                 d.startBit, d.length, d.isSigned ? "true" : "false",
+                 layout.bigEndian ? "true" : "false", layout.firstByte, layout.byteCount,
+                 static_cast<unsigned long long>(signalMask(layout.length)),
+                 doubleLiteral(d.factor).c_str(), doubleLiteral(d.offset).c_str(), msg.board.c_str(), msg.name.c_str(),
+                 sig.name.c_str());
+        }
+    }
+    out += "};\n\n";
+
+    out += "static constexpr MessageEntry MESSAGES[MESSAGE_COUNT] = {\n";
+    std::size_t firstSignal = 0;
+    for (const Message& msg : _messages) {
+        emit(out, "    {0x%03X, %u, %s, %u, %u},  // %s::%s\n", msg.id, msg.length,
+             msg.type == EXTENDED ? "true" : "false", static_cast<unsigned>(firstSignal),
+             static_cast<unsigned>(msg.signals.size()), msg.board.c_str(), msg.name.c_str());
+        firstSignal += msg.signals.size();
+    }
+    out += "};\n";
+
+    // one namespace per board, reopened if the board shows up again later in the file
+    for (std::size_t m = 0; m < _messages.size(); ++m) {
+        const Message& msg = _messages[m];
+        if (m == 0 || _messages[m - 1].board != msg.board) {
+            emit(out, "\nnamespace %s {\n", msg.board.c_str());
+        }
+
+        emit(out, "\n/// @brief 0x%03X, %u bytes\n", msg.id, msg.length);
+        emit(out, "struct %s {\n", msg.name.c_str());
+        emit(out, "    static constexpr uint32_t ID = 0x%03X;\n", msg.id);
+        emit(out, "    static constexpr uint8_t LENGTH = %u;\n", msg.length);
+        emit(out, "    static constexpr bool EXTENDED = %s;\n",
+             msg.type == EXTENDED ? "true" : "false");
+        emit(out, "    static constexpr uint16_t INDEX = %u;  // into MESSAGES\n",
+             static_cast<unsigned>(m));
+
+        for (const Signal& sig : msg.signals) {
+            const CANSignalDescription& d = sig.desc;
+            SignalLayout layout =
+                signalLayout(d.startBit, d.length, d.endianness == MSG_BIG_ENDIAN);
+
+            emit(out, "\n    /// @brief Bits %u-%u, %s %s endian\n", d.startBit,
+                 d.startBit + d.length - 1, d.isSigned ? "signed" : "unsigned",
+                 layout.bigEndian ? "big" : "little");
+            emit(out, "    struct %s {\n", sig.name.c_str());
+            emit(out, "        static constexpr uint16_t START_BIT = %u;\n", d.startBit);
+            emit(out, "        static constexpr uint8_t LENGTH = %u;\n", d.length);
+            emit(out, "        static constexpr bool IS_SIGNED = %s;\n",
+                 d.isSigned ? "true" : "false");
+            emit(out, "        static constexpr bool IS_BIG_ENDIAN = %s;\n",
+                 layout.bigEndian ? "true" : "false");
+            emit(out, "        static constexpr uint64_t MASK = 0x%llXull;\n",
+                 static_cast<unsigned long long>(signalMask(layout.length)));
+            emit(out, "        static constexpr double FACTOR = %s;\n",
+                 doubleLiteral(d.factor).c_str());
+            emit(out, "        static constexpr double OFFSET = %s;\n\n",
+                 doubleLiteral(d.offset).c_str());
+
+            out += "        /// @brief The raw bits of the signal, from the message payload\n";
+            out += "        static constexpr uint64_t raw(const uint8_t* payload) {\n";
+            out += "            return (" + rawExpression(layout) + ") & MASK;\n";
+            out += "        }\n\n";
+
+            out += "        /// @brief The scaled value of the signal, from the message payload\n";
+            out += "        static constexpr double decode(const uint8_t* payload) {\n";
+            if (!d.isSigned) {
+                out += "            return static_cast<double>(raw(payload)) * FACTOR + OFFSET;\n";
+            } else if (d.length == 64) {
+                out +=
+                    "            return static_cast<double>(static_cast<int64_t>(raw(payload))) * "
+                    "FACTOR + OFFSET;\n";
+            } else {
+                emit(out,
+                     "            return static_cast<double>(static_cast<int64_t>(raw(payload) << "
+                     "%u) >> %u) * FACTOR + OFFSET;\n",
+                     64 - d.length, 64 - d.length);
+            }
+            out += "        }\n";
+            out += "    };\n";
+        }
+        out += "};\n";
+
+        if (m + 1 == _messages.size() || _messages[m + 1].board != msg.board) {
+            emit(out, "\n}  // namespace %s\n", msg.board.c_str());
+        }
+    }
+
+    emit(out, "\n}  // namespace %s\n\n#endif  // %s\n", ns.c_str(), guard.c_str());
+    return Result<std::string>::ok(out);
+}
+
+std::string TelemCodegen::identifier(const char* name) {
+    std::string id = name ? name : "";
+    for (char& c : id) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+            c = '_';
+        }
+    }
+    if (id.empty() || std::isdigit(static_cast<unsigned char>(id[0]))) {
+        id.insert(id.begin(), '_');
+    }
+    return id;
+}
+
+}  // namespace can
@@ -0,0 +1,62 @@
+#ifndef __TELEM_CODEGEN_H__
+#define __TELEM_CODEGEN_H__
+
+#include <string>
+#include <vector>
+
+#include "can.hpp"
+#include "result.hpp"
+#include "telem_builder.hpp"
+
+namespace can {
+
+/// @brief Turns a built config into a C++ header of constexpr tables, so firmware can compile the
+/// config in instead of parsing it at boot.
+///
+/// Every message becomes a struct under a namespace for its board, and every signal a struct
+/// inside its message, with its shift and mask constants, its scale, and a `decode()` that reads
+/// it straight out of a payload with the shifts baked in. The flat `MESSAGES`/`SIGNALS` tables
+/// hold the same data for code that loops over the whole config.
+///
+/// Hook it up to a builder with
+/// `builder.setMessageListener([&](const char* b, const CANMessageDescription& m) {
+///     codegen.addMessage(b, m); });`
+class TelemCodegen {
+   public:
+    /// @brief Collects a message as the builder adds it to the bus
+    /// @param boardName The board the message belongs to
+    /// @param message The message, with its names filled in
+    void addMessage(const char* boardName, const CANMessageDescription& message);
+
+    /// @brief Writes the header
+    /// @param options The global options the builder returned
+    /// @param sourceHash The hash of the .telem text, so firmware can tell which config it has
+    /// @param ns The namespace to put everything in
+    /// @return The header, or an error if two messages or signals end up with the same name
+    common::Result<std::string> generate(const TelemetryOptions& options, uint32_t sourceHash,
+                                         const std::string& ns = "telem") const;
+
+    /// @brief Turns a config name into a usable C++ identifier
+    static std::string identifier(const char* name);
+
+   private:
+    struct Signal {
+        std::string name;
+        CANSignalDescription desc;
+    };
+
+    struct Message {
+        std::string board;
+        std::string name;
+        uint32_t id;
+        uint8_t length;
+        FrameType type;
+        std::vector<Signal> signals;
+    };
+
+    std::vector<Message> _messages;
+};
+
+}  // namespace can
+
+#endif  // __TELEM_CODEGEN_H__
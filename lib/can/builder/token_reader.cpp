@@ -43,6 +43,28 @@ bool MockTokenReader::peekNextWord(size_t maxLength, char* charBuf, size_t* leng
     return true;
 }
 
+bool MockTokenReader::peekNextSpan(const char** word, size_t* length) {
+    size_t pos = _pos;
+    size_t n = _content.size();
+
+    while (pos < n && std::isspace(static_cast<unsigned char>(_content[pos]))) {
+        ++pos;
+    }
+    if (pos >= n) {
+        return false;
+    }
+
+    // the word ends at whitespace or at the string's own terminator
+    size_t start = pos;
+    while (pos < n && !std::isspace(static_cast<unsigned char>(_content[pos]))) {
+        ++pos;
+    }
+
+    *word = _content.data() + start;
+    *length = pos - start;
+    return true;
+}
+
 bool MockTokenReader::moveWord(size_t stepSize) {
     size_t n = _content.size();
     for (size_t i = 0; i < stepSize; ++i) {
@@ -7,6 +7,10 @@
 
 namespace can {
 
+/// @brief Room for one word where it has to be copied, terminator included. Longer words are cut
+/// short to LOCAL_BUF_SIZE - 1 characters.
+static constexpr std::size_t LOCAL_BUF_SIZE = 128;
+
 /// @brief Abstract interface for streaming through a token file word-by-word.
 class TokenReader {
    public:
@@ -23,6 +27,16 @@ class TokenReader {
     /// @return true if a word was available
     virtual bool peekNextWord(std::size_t maxLength, char* charBuf, std::size_t* length) = 0;
 
+    /// @brief Whether peekNextSpan() is supported, i.e. the words already sit in memory.
+    virtual bool supportsSpans() const { return false; }
+
+    /// @brief Point at the next word in the reader's own storage (without copying or advancing).
+    /// The character just past the span is always readable, and is whitespace or '\0'.
+    /// @param word   out: the first character of the word, valid until the cursor moves
+    /// @param length out: the word length
+    /// @return true if a word was available, false at the end or if spans aren't supported
+    virtual bool peekNextSpan(const char** /*word*/, std::size_t* /*length*/) { return false; }
+
     /// @brief Advance the “cursor” by stepSize words (default 1).
     /// @return true if the move succeeded (didn’t run out)
     virtual bool moveWord(std::size_t stepSize = 1) = 0;
@@ -43,6 +57,8 @@ class MockTokenReader : public TokenReader {
 
     bool start() override;
     bool peekNextWord(std::size_t maxLength, char* charBuf, std::size_t* length) override;
+    bool supportsSpans() const override { return true; }
+    bool peekNextSpan(const char** word, std::size_t* length) override;
     bool moveWord(std::size_t stepSize = 1) override;
     bool eatUntil(const char character) override;
     void end() override;
@@ -1,15 +1,14 @@
 #include "tokenizer.hpp"
 
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 
 #include "can_debug.hpp"
+#include "hash.hpp"
 
 namespace can {
 
-// Local buffer size for peekNextWord
-static const std::size_t LOCAL_BUF_SIZE = 128;
-
 // Prefix table (longest first)
 struct PrefixEntry {
     const char* str;
@@ -26,58 +25,350 @@ static constexpr PrefixEntry prefixLUT[] = {
 
 static const std::size_t PREFIX_COUNT = sizeof(prefixLUT) / sizeof(prefixLUT[0]);
 
+static inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static inline char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Whether the word (after any sign) starts like inf, infinity or nan, which strtod accepts
+static bool looksNonFinite(const char* p, const char* end) {
+    static const char* const words[] = {"inf", "nan"};
+    for (const char* w : words) {
+        const char* q = p;
+        const char* c = w;
+        while (*c && q < end && lower(*q) == *c) {
+            ++q;
+            ++c;
+        }
+        if (*c == '\0') return true;
+    }
+    return false;
+}
+
+// Hand the word to strtod, only taking the result if it consumes all of it
+static bool parseFloat(const char* word, std::size_t len, Token* out) {
+    char* endptr = nullptr;
+    double dv = std::strtod(word, &endptr);
+    if (endptr != word + len) {
+        return false;
+    }
+    out->type = TT_FLOAT;
+    out->data.floatValue = dv;
+    return true;
+}
+
+// Exact powers of ten, every one of these is representable in a double
+static const double pow10LUT[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                  1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                  1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+static const int MAX_EXACT_POW10 = 22;
+static const uint64_t MAX_EXACT_MANTISSA = 1ull << 53;
+
+// Append a decimal digit, returning false (and leaving value alone) if it would overflow
+static inline bool appendDigit(uint64_t& value, char c) {
+    uint64_t d = static_cast<uint64_t>(c - '0');
+    if (value > (UINT64_MAX - d) / 10) {
+        return false;
+    }
+    value = value * 10 + d;
+    return true;
+}
+
+bool lexNumber(const char* word, std::size_t len, Token* out) {
+    const char* p = word;
+    const char* end = word + len;
+    if (p == end) {
+        return false;
+    }
+
+    // Hex integer? 0x... (unsigned, no sign allowed)
+    if (len > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        uint64_t v = 0;
+        bool overflow = false;
+        const char* q = p + 2;
+        for (; q < end; ++q) {
+            int h = hexValue(*q);
+            if (h < 0) break;
+            if (v > (UINT64_MAX >> 4)) overflow = true;
+            v = (v << 4) | static_cast<uint64_t>(h);
+        }
+        if (q == end) {
+            out->type = TT_HEX_INT;
+            out->data.uintValue = overflow ? UINT64_MAX : v;
+            return true;
+        }
+        // maybe a hex float, like 0x1.8p3
+        return parseFloat(word, len, out);
+    }
+
+    bool negative = false;
+    if (*p == '+' || *p == '-') {
+        negative = (*p == '-');
+        ++p;
+    }
+    if (p == end) {
+        return false;
+    }
+
+    // signed hex floats, inf and nan are rare enough to leave to strtod
+    if (p + 1 < end && p[0] == '0' && lower(p[1]) == 'x') {
+        return parseFloat(word, len, out);
+    }
+    if (!isDigit(*p) && *p != '.') {
+        // identifiers land here after looking at a single character
+        return looksNonFinite(p, end) && parseFloat(word, len, out);
+    }
+
+    // Integer part; digits that don't fit still count, they just make the value inexact
+    uint64_t mantissa = 0;
+    bool overflow = false;
+    const char* digits = p;
+    for (; p < end && isDigit(*p); ++p) {
+        overflow = !appendDigit(mantissa, *p) || overflow;
+    }
+    bool hasDigits = p > digits;
+
+    if (p == end) {
+        if (!hasDigits) return false;
+
+        // saturate like strtoll
+        const uint64_t limit = negative ? static_cast<uint64_t>(INT64_MAX) + 1 : INT64_MAX;
+        if (overflow || mantissa > limit) {
+            mantissa = limit;
+        }
+        out->type = TT_INT;
+        out->data.intValue = negative ? static_cast<int64_t>(0 - mantissa)
+                                      : static_cast<int64_t>(mantissa);
+        return true;
+    }
+
+    // Fraction
+    int scale = 0;
+    if (*p == '.') {
+        ++p;
+        const char* frac = p;
+        for (; p < end && isDigit(*p); ++p) {
+            overflow = !appendDigit(mantissa, *p) || overflow;
+            scale--;
+        }
+        hasDigits = hasDigits || p > frac;
+    }
+    if (!hasDigits) {
+        return false;
+    }
+
+    // Exponent
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExp = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            negativeExp = (*p == '-');
+            ++p;
+        }
+        const char* exp = p;
+        int e = 0;
+        for (; p < end && isDigit(*p); ++p) {
+            if (e < 10000) e = e * 10 + (*p - '0');
+        }
+        if (p == exp) return false;
+        scale += negativeExp ? -e : e;
+    }
+
+    if (p != end) {
+        return false;
+    }
+
+    // Fast path: an exact mantissa and an exact power of ten make a single, correctly rounded
+    // multiply or divide, which is what strtod would return
+    if (!overflow && mantissa <= MAX_EXACT_MANTISSA && scale >= -MAX_EXACT_POW10 &&
+        scale <= MAX_EXACT_POW10) {
+        double value = static_cast<double>(mantissa);
+        value = scale < 0 ? value / pow10LUT[-scale] : value * pow10LUT[scale];
+        out->type = TT_FLOAT;
+        out->data.floatValue = negative ? -value : value;
+        return true;
+    }
+
+    return parseFloat(word, len, out);
+}
+
 IdentifierPool::IdentifierPool() {}
 
+IdentifierPool::Scope::Scope(IdentifierPool& pool)
+    : _pool(pool), _entries(pool._entries.size()), _arenaBytes(pool._arena.size()) {}
+
+IdentifierPool::Scope::~Scope() {
+    _pool._truncate(_entries, _arenaBytes);
+}
+
 IdentifierPoolHandle IdentifierPool::intern(const char* src) {
-    _pool.emplace_back(src);
-    return IdentifierPoolHandle{_pool.size() - 1};
+    return intern(src, std::strlen(src));
+}
+
+IdentifierPoolHandle IdentifierPool::intern(const char* src, std::size_t len) {
+    uint32_t hash = common::fnv1a(src, len);
+
+    if (!_table.empty()) {
+        std::size_t mask = _table.size() - 1;
+        for (std::size_t slot = hash & mask; _table[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+            const Entry& e = _entries[_table[slot]];
+            if (e.hash == hash && e.length == len && std::memcmp(&_arena[e.offset], src, len) == 0) {
+                return IdentifierPoolHandle{e.offset};
+            }
+        }
+    }
+
+    // keep the load factor under 1/2
+    if ((_entries.size() + 1) * 2 > _table.size()) {
+        _rehash(_table.empty() ? MIN_TABLE_SIZE : _table.size() * 2);
+    }
+
+    uint32_t offset = static_cast<uint32_t>(_arena.size());
+    _arena.insert(_arena.end(), src, src + len);
+    _arena.push_back('\0');
+
+    _entries.push_back(Entry{hash, offset, static_cast<uint32_t>(len)});
+    _insertSlot(static_cast<uint32_t>(_entries.size() - 1));
+    return IdentifierPoolHandle{offset};
 }
 
 const char* IdentifierPool::get(IdentifierPoolHandle h) const {
-    if (h.index < _pool.size()) {
-        return _pool[h.index].c_str();
+    if (h.offset < _arena.size()) {
+        return &_arena[h.offset];
     }
-    CAN_DEBUG_PRINT_ERROR("Invalid IdentifierPoolHandle %zu", h.index);
+    CAN_DEBUG_PRINT_ERROR("Invalid IdentifierPoolHandle %zu", h.offset);
     return "";
 }
 
+std::size_t IdentifierPool::memoryUsage() const {
+    return _arena.capacity() * sizeof(char) + _entries.capacity() * sizeof(Entry) +
+           _table.capacity() * sizeof(uint32_t);
+}
+
+void IdentifierPool::reserve(std::size_t strings, std::size_t bytes) {
+    _arena.reserve(bytes);
+    _entries.reserve(strings);
+
+    std::size_t tableSize = MIN_TABLE_SIZE;
+    while (tableSize < strings * 2) {
+        tableSize *= 2;
+    }
+    if (tableSize > _table.size()) {
+        _rehash(tableSize);
+    }
+}
+
+void IdentifierPool::clear() {
+    _truncate(0, 0);
+}
+
+void IdentifierPool::release() {
+    std::vector<char>().swap(_arena);
+    std::vector<Entry>().swap(_entries);
+    std::vector<uint32_t>().swap(_table);
+}
+
+void IdentifierPool::_truncate(std::size_t entries, std::size_t arenaBytes) {
+    if (entries >= _entries.size()) {
+        return;
+    }
+
+    _entries.resize(entries);
+    _arena.resize(arenaBytes);
+    _rehash(_table.size());
+}
+
+void IdentifierPool::_rehash(std::size_t tableSize) {
+    _table.assign(tableSize, EMPTY_SLOT);
+    for (std::size_t i = 0; i < _entries.size(); ++i) {
+        _insertSlot(static_cast<uint32_t>(i));
+    }
+}
+
+void IdentifierPool::_insertSlot(uint32_t entryIndex) {
+    std::size_t mask = _table.size() - 1;
+    std::size_t slot = _entries[entryIndex].hash & mask;
+    while (_table[slot] != EMPTY_SLOT) {
+        slot = (slot + 1) & mask;
+    }
+    _table[slot] = entryIndex;
+}
+
 bool Tokenizer::start() {
+    _hasLookahead = false;
     return _reader.start();
 }
 
 void Tokenizer::end() {
+    _hasLookahead = false;
     _reader.end();
 }
 
 common::Option<Token> Tokenizer::next() {
     common::Option<Token> tk = peek();
     _reader.moveWord();
+    _hasLookahead = false;
     return tk;
 }
 
 common::Option<Token> Tokenizer::peek() {
+    if (_hasLookahead) {
+        return _lookahead;
+    }
+
     char buf[LOCAL_BUF_SIZE];
+    const char* word = nullptr;
     std::size_t len = 0;
 
     // Skip blanks & comments
     while (true) {
-        if (!_reader.peekNextWord(LOCAL_BUF_SIZE, buf, &len)) return common::Option<Token>::none();
-        if (len > 0 && buf[0] == '#') {
+        if (!_peekWord(buf, &word, &len)) return common::Option<Token>::none();
+        if (len > 0 && word[0] == '#') {
             _reader.eatUntil('\n');
             continue;
         }
         break;
     }
 
-    common::Option<Token> tk = _interpWord(buf, len);
-    return tk;
+    _lookahead = _interpWord(word, len);
+    _hasLookahead = true;
+    return _lookahead;
 }
 
 bool Tokenizer::eatUntil(const char character) {
+    _hasLookahead = false;
     return _reader.eatUntil(character);
 }
 
-common::Option<Token> Tokenizer::_interpWord(char* buf, std::size_t len) {
+bool Tokenizer::_peekWord(char* buf, const char** word, std::size_t* len) {
+    // in-memory readers hand out the word where it sits, no copy and no length limit
+    if (_reader.supportsSpans()) {
+        return _reader.peekNextSpan(word, len);
+    }
+
+    if (!_reader.peekNextWord(LOCAL_BUF_SIZE, buf, len)) {
+        return false;
+    }
+    if (*len >= LOCAL_BUF_SIZE) {
+        CAN_DEBUG_PRINT_ERRORLN("Word of %zu characters truncated to %zu", *len,
+                                LOCAL_BUF_SIZE - 1);
+        *len = LOCAL_BUF_SIZE - 1;
+    }
+    *word = buf;
+    return true;
+}
+
+common::Option<Token> Tokenizer::_interpWord(const char* buf, std::size_t len) {
     Token tk;
     // Try prefix match
     for (std::size_t i = 0; i < PREFIX_COUNT; ++i) {
@@ -89,34 +380,13 @@ common::Option<Token> Tokenizer::_interpWord(char* buf, std::size_t len) {
     }
 
     // Not a prefix: try numeric or identifier
-    char* endptr = nullptr;
-    // Hex integer? 0x...
-    if (len > 2 && buf[0] == '0' && (buf[1] == 'x' || buf[1] == 'X')) {
-        unsigned long long v = std::strtoull(buf, &endptr, 16);
-        if (endptr == buf + len) {
-            tk.type = TT_HEX_INT;
-            tk.data.uintValue = v;
-            return common::Option<Token>::some(tk);
-        }
-    }
-    // Decimal integer?
-    long long iv = std::strtoll(buf, &endptr, 10);
-    if (endptr == buf + len) {
-        tk.type = TT_INT;
-        tk.data.intValue = iv;
-        return common::Option<Token>::some(tk);
-    }
-    // Floating point?
-    double dv = std::strtod(buf, &endptr);
-    if (endptr == buf + len) {
-        tk.type = TT_FLOAT;
-        tk.data.floatValue = dv;
+    if (lexNumber(buf, len, &tk)) {
         return common::Option<Token>::some(tk);
     }
 
     // Fallback: identifier
     tk.type = TT_IDENTIFIER;
-    tk.data.idHandle = IdentifierPool::instance().intern(buf);
+    tk.data.idHandle = IdentifierPool::instance().intern(buf, len);
 
     return common::Option<Token>::some(tk);
 }
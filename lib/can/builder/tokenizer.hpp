@@ -3,10 +3,10 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <deque>
 #include <functional>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "can_debug.hpp"
 #include "option.hpp"
@@ -29,7 +29,7 @@ enum TokenType {
 
 /// @brief Handle representing an interned identifier.
 struct IdentifierPoolHandle {
-    std::size_t index;  // index into the pool
+    std::size_t offset;  // byte offset of the string in the pool's arena
 };
 
 /// @brief Token payload data.
@@ -48,8 +48,22 @@ struct Token {
     TokenData data;  // token-specific data
 };
 
-/// @brief Interns identifier strings to provide stable, pooled storage.
-/// Uses a small heap allocation (deque of strings).
+/// @brief Classify a word as a hex, decimal or floating-point literal in a single scan.
+/// Integers are parsed inline, saturating on overflow like strtoull/strtoll. Floats with up to
+/// 2^53 in digits and a scale within 10^±22 are exact with one multiply or divide; anything
+/// else shaped like a float (or a hex float, inf or nan) goes to strtod once. Either way the
+/// result is bit-for-bit what the old strtoull -> strtoll -> strtod chain produced.
+/// @param word The word; the character at word[len] must be readable (whitespace or '\0')
+/// @param len The length of the word
+/// @param out Out: type and data, only written when the word is a number
+/// @return true if the word is a number
+bool lexNumber(const char* word, std::size_t len, Token* out);
+
+/// @brief Interns identifier strings, storing each distinct string once.
+/// Strings live back to back (null-terminated) in one contiguous arena, and a hash table of
+/// offsets into it finds repeats, so interning `uint16` a thousand times costs one copy.
+/// Handles are offsets, so they stay valid as the arena grows, but pointers from get() are
+/// only valid until the next intern().
 class IdentifierPool {
    public:
     static IdentifierPool& instance() {
@@ -57,21 +71,73 @@ class IdentifierPool {
         return _idPool;
     }
 
+    /// @brief Rolls the pool back to how it was when the scope was opened, keeping capacity.
+    /// Every handle interned inside the scope is invalid once it closes.
+    class Scope {
+       public:
+        explicit Scope(IdentifierPool& pool);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+       private:
+        IdentifierPool& _pool;
+        std::size_t _entries;
+        std::size_t _arenaBytes;
+    };
+
     /// @brief Construct an empty identifier pool.
     IdentifierPool();
 
-    /// @brief Adds a copy of src into the pool.
+    /// @brief Adds src into the pool, unless an equal string is already there.
     /// @param src Null-terminated source string.
     /// @return Handle to the pooled string.
     IdentifierPoolHandle intern(const char* src);
 
+    /// @brief Adds the first len characters of src into the pool, unless already there.
+    /// @param src Source characters, need not be null-terminated.
+    /// @param len The number of characters.
+    /// @return Handle to the pooled string.
+    IdentifierPoolHandle intern(const char* src, std::size_t len);
+
     /// @brief Retrieve the string for a given handle.
     /// @param h Handle returned by intern().
-    /// @return Null-terminated string.
+    /// @return Null-terminated string, valid until the next intern().
     const char* get(IdentifierPoolHandle h) const;
 
+    /// @brief The number of distinct strings in the pool.
+    std::size_t size() const { return _entries.size(); }
+
+    /// @brief The bytes of heap the pool is holding on to, including unused capacity.
+    std::size_t memoryUsage() const;
+
+    /// @brief Make room for a number of strings and bytes of text up-front.
+    void reserve(std::size_t strings, std::size_t bytes);
+
+    /// @brief Forget every string, but keep the memory for the next build.
+    void clear();
+
+    /// @brief Forget every string and give the memory back.
+    void release();
+
    private:
-    std::deque<std::string> _pool;  // stored identifier strings
+    struct Entry {
+        uint32_t hash;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+    static constexpr std::size_t MIN_TABLE_SIZE = 64;
+
+    std::vector<char> _arena;      // the strings, each null-terminated
+    std::vector<Entry> _entries;   // one per distinct string, in the order they were added
+    std::vector<uint32_t> _table;  // open addressing, indices into _entries; power of two
+
+    void _truncate(std::size_t entries, std::size_t arenaBytes);
+    void _rehash(std::size_t tableSize);
+    void _insertSlot(uint32_t entryIndex);
 };
 
 /// @brief Tokenizer: turns whitespace-delimited words into Token objects.
@@ -92,6 +158,9 @@ class Tokenizer {
     /// @return Some(Token) if available, none() otherwise.
     common::Option<Token> next();
 
+    /// @brief Look at the next token without consuming it. The token is lexed once and cached
+    /// until the cursor moves, so peeking before next() costs nothing extra.
+    /// @return Some(Token) if available, none() otherwise.
     common::Option<Token> peek();
 
     /// @brief Skip the tokens until you encounter a character
@@ -101,7 +170,13 @@ class Tokenizer {
    private:
     TokenReader& _reader;  // word reader
 
-    common::Option<Token> _interpWord(char* buf, std::size_t len);
+    common::Option<Token> _lookahead;  // the token under the cursor, valid if _hasLookahead
+    bool _hasLookahead = false;
+
+    /// @brief Find the next word, as a span if the reader supports it, else copied into buf
+    /// @param buf LOCAL_BUF_SIZE bytes of scratch for readers that can only copy
+    bool _peekWord(char* buf, const char** word, std::size_t* len);
+    common::Option<Token> _interpWord(const char* buf, std::size_t len);
 };
 
 }  // namespace can
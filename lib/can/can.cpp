@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <can.hpp>
 #include <cstdlib>
 #include <cstring>
@@ -13,42 +14,197 @@ CANBus::~CANBus() {
     _driver.uninstall();
 }
 
+double CANSignal::factor() const {
+    return message.bus.signalScale(scaleIndex).factor;
+}
+
+double CANSignal::offset() const {
+    return message.bus.signalScale(scaleIndex).offset;
+}
+
+BitBufferHandle CANSignal::handle() const {
+    return BitBufferHandle(descriptor.layout.length,
+                           message.bufferHandle.offset + descriptor.layout.startBit);
+}
+
+MessageTable::const_iterator MessageTable::find(uint32_t id) const {
+    const_iterator it = std::lower_bound(
+        begin(), end(), id, [](const Entry& entry, uint32_t key) { return entry.first < key; });
+    return (it != end() && it->first == id) ? it : end();
+}
+
+bool MessageTable::insert(uint32_t id, CANMessage* message) {
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), id,
+                               [](const Entry& entry, uint32_t key) { return entry.first < key; });
+    if (it != _entries.end() && it->first == id) {
+        return false;
+    }
+    _entries.insert(it, Entry{id, message});
+    return true;
+}
+
 CANMessage& CANBus::addMessage(const CANMessageDescription& desc) {
+    CANMessage& msg =
+        addMessage(desc.id, desc.length, desc.type, desc.signals.data(), desc.signals.size());
+
+    msg.logMode = desc.logMode;
+    if (desc.onReceive) {
+        registerCallback(desc.id, desc.onReceive);
+    }
+    return msg;
+}
+
+// every message gets a slot of whole 64-bit words, classic frames take exactly one and FD frames
+// take up to eight, keeping each slot word aligned in the buffer
+static size_t messageSlotBits(uint8_t length) {
+    size_t slotBytes = length > CAN_MAX_DATA_LENGTH ? length : CAN_MAX_DATA_LENGTH;
+    return ((slotBytes * 8 + 63) / 64) * 64;
+}
+
+CANMessage& CANBus::addMessage(uint32_t id, uint8_t length, FrameType type,
+                               const CANSignalDescription* signals, size_t signalCount) {
     if (_isInitialized) {
         CAN_DEBUG_PRINT_ERROR("Cannot add messages after initialization.");
     }
 
-    BitBufferHandle messageHandle(desc.length * 8, _nextBitOffset);
-    _nextBitOffset += 64;
+    if (!isValidFrameLength(length)) {
+        CAN_DEBUG_PRINT_ERRORLN("Message 0x%x has an invalid length of %d bytes.", id, length);
+    }
 
-    // construct on the heap using the ctor without trailing-_ names
-    std::unique_ptr<CANMessage> msgPtr =
-        std::unique_ptr<CANMessage>(new CANMessage(*this,         // bus
-                                                   desc.id,       // id
-                                                   desc.length,   // length
-                                                   desc.type,     // type
-                                                   messageHandle  // bufferHandle
-                                                   ));
-    auto& msg = *msgPtr;  // stable reference
+    MessageTable::const_iterator existing = _messages.find(id);
+    if (existing != _messages.end()) {
+        CAN_DEBUG_PRINT_ERRORLN("Message 0x%x was already added.", id);
+        return *existing->second;
+    }
 
-    msg.signals.reserve(desc.signals.size());
-    for (auto const& sd : desc.signals) {
-        BitBufferHandle h(sd.length, messageHandle.offset + sd.startBit);
-        msg.signals.emplace_back(msg,            // message
-                                 h,              // handle
-                                 sd.isSigned,    // isSigned
-                                 sd.endianness,  // endianness
-                                 sd.factor,      // factor
-                                 sd.offset       // offset
-        );
+    // a planned message already has its slots, anything else goes on the end
+    const Placement* placed = _findPlacement(id);
+    if (placed && (placed->length != length || placed->signalCount < signalCount)) {
+        CAN_DEBUG_PRINT_ERRORLN("Message 0x%x does not match its plan.", id);
+        placed = nullptr;
     }
 
-    if (desc.onReceive) {
-        registerCallback(desc.id, desc.onReceive);
+    size_t index;
+    size_t bitOffset;
+    CANMessage* storage;
+    SignalDescriptor* sigs;
+    uint16_t* scales;
+    if (placed) {
+        index = placed - _placements.data();
+        bitOffset = placed->bitOffset;
+        storage = &_messageSlots[index];
+        sigs = _signalSlots + placed->signalStart;
+        scales = _scaleSlots + placed->signalStart;
+    } else {
+        index = _rxTimestamps.size();
+        bitOffset = _nextBitOffset;
+        storage = _arena.allocateArray<CANMessage>(1);
+        sigs = _arena.allocateArray<SignalDescriptor>(signalCount);
+        scales = _arena.allocateArray<uint16_t>(signalCount);
+        _nextBitOffset += messageSlotBits(length);
+        _rxTimestamps.push_back(0);
+    }
+    BitBufferHandle messageHandle(length * 8, bitOffset);
+
+    CANMessage& msg = *new (storage) CANMessage(*this,          // bus
+                                                id,             // id
+                                                length,         // length
+                                                type,           // type
+                                                messageHandle,  // bufferHandle
+                                                index           // index
+    );
+
+    for (size_t i = 0; i < signalCount; ++i) {
+        const CANSignalDescription& sd = signals[i];
+        SignalDescriptor& desc = sigs[i];
+        desc.layout = signalLayout(sd.startBit, sd.length, sd.endianness == MSG_BIG_ENDIAN);
+        desc.flags = sd.isSigned ? SDF_SIGNED : 0;
+        desc.shape = static_cast<uint8_t>(classifySignal(desc.layout));
+        scales[i] = _internScale(sd.factor, sd.offset);
+    }
+    msg.signals = SignalSpan(&msg, sigs, scales, signalCount);
+
+    _messages.insert(id, &msg);
+    return msg;
+}
+
+void CANBus::reserve(size_t messages, size_t signals) {
+    // worst case padding in front of every message and every signal array
+    _arena.reserve(messages * (sizeof(CANMessage) + alignof(CANMessage) +
+                               alignof(SignalDescriptor) + alignof(uint16_t)) +
+                   signals * (sizeof(SignalDescriptor) + sizeof(uint16_t)));
+    _messages.reserve(messages);
+    _rxTimestamps.reserve(messages);
+    // worst case every signal has a scale of its own, initialize() trims the rest
+    _scales.reserve(_scales.size() + signals);
+}
+
+void CANBus::planMessage(uint32_t id, uint8_t length, size_t signalCount) {
+    if (_isReserved || !_messages.empty()) {
+        CAN_DEBUG_PRINT_ERRORLN("Cannot plan message 0x%x once messages are laid out.", id);
+        return;
+    }
+    _placements.push_back(Placement{id, length, signalCount, 0, 0});
+}
+
+void CANBus::reserve() {
+    if (_isReserved || !_messages.empty()) {
+        CAN_DEBUG_PRINT_ERRORLN("Cannot lay out messages once some have been added.");
+        return;
+    }
+    _isReserved = true;
+
+    // a duplicate ID keeps its first plan, the builder rejects the second one anyway
+    std::stable_sort(_placements.begin(), _placements.end(),
+                     [](const Placement& a, const Placement& b) { return a.id < b.id; });
+    _placements.erase(std::unique(_placements.begin(), _placements.end(),
+                                  [](const Placement& a, const Placement& b) {
+                                      return a.id == b.id;
+                                  }),
+                      _placements.end());
+
+    size_t signalCount = 0;
+    for (Placement& placement : _placements) {
+        placement.signalStart = signalCount;
+        placement.bitOffset = _nextBitOffset;
+        signalCount += placement.signalCount;
+        _nextBitOffset += messageSlotBits(placement.length);
+    }
+
+    size_t count = _placements.size();
+    _arena.reserve(count * sizeof(CANMessage) + alignof(CANMessage) +
+                   signalCount * sizeof(SignalDescriptor) + alignof(SignalDescriptor) +
+                   signalCount * sizeof(uint16_t) + alignof(uint16_t));
+    _messageSlots = _arena.allocateArray<CANMessage>(count);
+    _signalSlots = _arena.allocateArray<SignalDescriptor>(signalCount);
+    _scaleSlots = _arena.allocateArray<uint16_t>(signalCount);
+    _messages.reserve(count);
+    _rxTimestamps.assign(count, 0);
+    _scales.reserve(signalCount);
+
+    CAN_DEBUG_PRINTLN("Laid out %d messages and %d signals", static_cast<int>(count),
+                      static_cast<int>(signalCount));
+}
+
+uint16_t CANBus::_internScale(double factor, double offset) {
+    // configs only use a handful of distinct scales, so a linear scan stays short
+    for (size_t i = 0; i < _scales.size(); ++i) {
+        if (_scales[i].factor == factor && _scales[i].offset == offset) {
+            return static_cast<uint16_t>(i);
+        }
+    }
+    if (_scales.size() > UINT16_MAX) {
+        CAN_DEBUG_PRINT_ERRORLN("Out of signal scales, using the first one.");
+        return 0;
     }
+    _scales.push_back(SignalScale{factor, offset});
+    return static_cast<uint16_t>(_scales.size() - 1);
+}
 
-    auto it = _messages.emplace(desc.id, std::move(msgPtr)).first;
-    return *it->second;
+const CANBus::Placement* CANBus::_findPlacement(uint32_t id) const {
+    auto it = std::lower_bound(_placements.begin(), _placements.end(), id,
+                               [](const Placement& p, uint32_t key) { return p.id < key; });
+    return (_isReserved && it != _placements.end() && it->id == id) ? &*it : nullptr;
 }
 
 void CANBus::initialize() {
@@ -66,33 +222,157 @@ void CANBus::initialize() {
     CAN_DEBUG_PRINT("Allocating buffer of size %d for CAN!\n", totalBits);
     this->_buffer = BitBuffer(totalBits);
     this->_isInitialized = true;
+
+    // reserve() made room for a scale per signal, drop what wasn't needed
+    _scales.shrink_to_fit();
 }
 
-void CANBus::sendMessage(const CANMessage& message) {
+TxStatus CANBus::sendMessage(const CANMessage& message) {
+    if (!_isInitialized) {
+        CAN_DEBUG_PRINT_ERRORLN("Cannot send messages before initialization.");
+        return TXS_NOT_INITIALIZED;
+    }
+
     RawCANMessage rawMessage = getRawMessage(message);
-    this->_driver.sendMessage(rawMessage);
+    TxStatus status = _enqueue(rawMessage);
+    if (status == TXS_QUEUE_FULL) {
+        _reportTransmit(rawMessage.id, status);
+    }
+    return status;
+}
+
+void CANBus::addPeriodicMessage(const CANMessage& message, uint32_t periodMs, uint32_t phaseMs) {
+    if (periodMs == 0) {
+        CAN_DEBUG_PRINT_ERRORLN("Periodic message 0x%x needs a non-zero period.", message.id);
+        return;
+    }
+
+    _periodic.push_back(PeriodicEntry{message.id, periodMs, phaseMs, false});
+}
+
+void CANBus::serviceTransmit(uint32_t nowMs) {
+    if (!_isInitialized) {
+        return;
+    }
+
+    // 1) queue whatever periodic messages are due
+    for (PeriodicEntry& entry : _periodic) {
+        if (!entry.started) {
+            // the first service call anchors the schedule, nextDueMs holds the phase until then
+            entry.nextDueMs = nowMs + entry.nextDueMs;
+            entry.started = true;
+        }
+
+        if (static_cast<int32_t>(nowMs - entry.nextDueMs) < 0) {
+            continue;  // not due yet
+        }
+
+        auto it = _messages.find(entry.id);
+        if (it != _messages.end()) {
+            sendMessage(*it->second);
+        }
+
+        entry.nextDueMs += entry.periodMs;
+        if (static_cast<int32_t>(nowMs - entry.nextDueMs) >= 0) {
+            // we fell more than a period behind, don't try to catch up with a burst
+            entry.nextDueMs = nowMs + entry.periodMs;
+        }
+    }
+
+    // 2) drain the queue into the driver until it pushes back
+    std::unique_lock<std::mutex> lk(_txMutex);
+    while (!_txQueue.empty()) {
+        RawCANMessage frame = _txQueue.top().frame;
+        TxStatus status = _driver.sendMessage(frame);
+
+        if (status == TXS_BUSY) {
+            // hardware mailboxes are full, keep the frame for the next call
+            _txStats.busy++;
+            break;
+        }
+
+        _txQueue.pop();
+        if (status == TXS_SENT) {
+            _txStats.sent++;
+        } else {
+            _txStats.failed++;
+            CAN_DEBUG_PRINT_ERRORLN("Driver failed to send message 0x%x", frame.id);
+        }
+
+        lk.unlock();
+        _reportTransmit(frame.id, status);
+        lk.lock();
+    }
+}
+
+void CANBus::registerTransmitCallback(std::function<void(uint32_t, TxStatus)> callback) {
+    _txCallback = callback;
+}
+
+TxStats CANBus::transmitStats() const {
+    std::lock_guard<std::mutex> lk(_txMutex);
+    return _txStats;
+}
+
+size_t CANBus::pendingTransmits() const {
+    std::lock_guard<std::mutex> lk(_txMutex);
+    return _txQueue.size();
+}
+
+TxStatus CANBus::_enqueue(const RawCANMessage& raw) {
+    std::lock_guard<std::mutex> lk(_txMutex);
+
+    // a pending frame with the same ID is stale, just refresh its payload in place
+    TxEntry* pending = _txQueue.find([&raw](const TxEntry& e) { return e.frame.id == raw.id; });
+    if (pending) {
+        pending->frame = raw;
+        _txStats.coalesced++;
+        return TXS_QUEUED;
+    }
+
+    if (!_txQueue.push(TxEntry{raw})) {
+        _txStats.rejected++;
+        return TXS_QUEUE_FULL;
+    }
+
+    if (_txQueue.size() > _txStats.highWater) {
+        _txStats.highWater = _txQueue.size();
+    }
+    return TXS_QUEUED;
+}
+
+void CANBus::_reportTransmit(uint32_t id, TxStatus status) {
+    if (_txCallback) {
+        _txCallback(id, status);
+    }
 }
 
 void CANBus::update() {
     RawCANMessage rawMessage;
-    uint8_t numRx;
+    uint8_t numRx = 0;
 
     while (_driver.receiveMessage(&rawMessage)) {
         numRx++;
-        if (_messages.find(rawMessage.id) == _messages.end())
+        MessageTable::const_iterator it = _messages.find(rawMessage.id);
+        if (it == _messages.end())
             continue;  // we don't care about this message
 
-        std::unique_ptr<CANMessage>& message = _messages[rawMessage.id];
+        CANMessage* message = it->second;
 
         // CAN_DEBUG_PRINTLN("Storing message at offset %d", message->bufferHandle.offset);
 
-        // write it into the buffer
+        // write it into the buffer, never past the slot of the message
+        size_t length = rawMessage.length < message->length ? rawMessage.length : message->length;
         {
             std::lock_guard<std::mutex> lk(_bufferMutex);
-            BitBufferHandle handle(64, message->bufferHandle.offset);
-            _buffer.write(handle, rawMessage.data64);
+            BitBufferHandle handle(length * 8, message->bufferHandle.offset);
+            _buffer.write(handle, rawMessage.data, length);
+            _rxTimestamps[message->index] = rawMessage.timestampUs;
         }
 
+        if (message->logMode == MLM_EVENT && _frameListener) {
+            _frameListener(*message, rawMessage);
+        }
 
         if (numRx > 32) {
             CAN_DEBUG_PRINT_ERRORLN("Breaking early from update!");
@@ -100,6 +380,16 @@ void CANBus::update() {
     }
 }
 
+uint64_t CANBus::lastReceiveUs(const CANMessage& message) {
+    std::lock_guard<std::mutex> lk(_bufferMutex);
+    return _rxTimestamps[message.index];
+}
+
+void CANBus::setFrameListener(
+    std::function<void(const CANMessage&, const RawCANMessage&)> listener) {
+    _frameListener = listener;
+}
+
 void CANBus::registerCallback(uint32_t messageID, std::function<void(const CANMessage&)> callback) {
     _callbacks[messageID] = callback;
 }
@@ -121,23 +411,51 @@ void CANBus::printBus(std::ostream& stream) const {
 
         // Iterate signals within this message
         for (size_t idx = 0; idx < msg.signals.size(); ++idx) {
-            const CANSignal& sig = msg.signals[idx];
+            CANSignal sig = msg.signals[idx];
             // Access BitBufferHandle fields
-            size_t offset = sig.handle.offset;
-            size_t size = sig.handle.size;
+            size_t offset = sig.handle().offset;
+            size_t size = sig.handle().size;
 
             stream << "  Signal[" << idx << "]: "
                    << "offset=" << offset << ", width=" << size << " bits"
-                   << ", signed=" << std::boolalpha << sig.isSigned << std::noboolalpha
-                   << ", endianness=" << (sig.endianness == MSG_BIG_ENDIAN ? "big" : "little")
-                   << ", factor=" << sig.factor << ", offset=" << sig.offset << std::endl;
+                   << ", signed=" << std::boolalpha << sig.isSigned() << std::noboolalpha
+                   << ", endianness=" << (sig.endianness() == MSG_BIG_ENDIAN ? "big" : "little")
+                   << ", factor=" << sig.factor() << ", offset=" << sig.offset() << std::endl;
         }
     }
 
     stream << "*** BUS END ***" << std::endl;
 }
 
-const std::unordered_map<uint32_t, std::unique_ptr<CANMessage>>& CANBus::getMessages() const {
+size_t CANBus::decodeSignals(double* values, size_t capacity) {
+    if (!_isInitialized) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lk(_bufferMutex);
+    const uint8_t* buffer = _buffer.buffer();
+
+    size_t count = 0;
+    for (const auto& entry : _messages) {
+        const CANMessage& message = *entry.second;
+        const uint8_t* payload = buffer + message.payloadByte();
+        const SignalDescriptor* desc = message.signals.descriptors();
+        const uint16_t* scaleIndex = message.signals.scaleIndices();
+        for (size_t i = 0; i < message.signals.size(); ++i, ++desc, ++scaleIndex) {
+            if (count == capacity) {
+                return count;
+            }
+            uint64_t raw = desc->decode(payload);
+            double v = desc->isSigned() ? static_cast<double>(signExtend(raw, desc->layout.length))
+                                        : static_cast<double>(raw);
+            const SignalScale& scale = _scales[*scaleIndex];
+            values[count++] = v * scale.factor + scale.offset;
+        }
+    }
+    return count;
+}
+
+const MessageTable& CANBus::getMessages() const {
     return _messages;
 }
 
@@ -150,7 +468,7 @@ RawCANMessage CANBus::getRawMessage(const CANMessage& message) {
     // snapshot exactly `length` bytes out of our bit-buffer
     {
         std::lock_guard<std::mutex> lk(_bufferMutex);
-        uint8_t tmp[8] = {0};
+        uint8_t tmp[CANFD_MAX_DATA_LENGTH] = {0};
         _buffer.read(message.bufferHandle, tmp);
         std::memcpy(raw.data, tmp, raw.length);
     }
@@ -3,7 +3,9 @@
 
 #include <stdint.h>
 
+#include <arena.hpp>
 #include <bit_buffer.hpp>
+#include <fixed_priority_queue.hpp>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -12,6 +14,9 @@
 #include <vector>
 
 #include "can_debug.hpp"
+#include "signal_descriptor.hpp"
+#include "signal_kernel.hpp"
+#include "signal_layout.hpp"
 
 using namespace common;
 
@@ -19,17 +24,50 @@ namespace can {
 
 enum Endianness { MSG_LITTLE_ENDIAN, MSG_BIG_ENDIAN };
 enum FrameType { STANDARD, EXTENDED };
+
+/// @brief How a message makes it into the log
+enum MessageLogMode {
+    MLM_SNAPSHOT,  // sampled with the rest of the bus every log period
+    MLM_EVENT      // also logged frame by frame, as each one is received
+};
 enum CANBaudRate { CBR_100KBPS, CBR_125KBPS, CBR_250KBPS, CBR_500KBPS, CBR_1MBPS };
 
+/// @brief Largest payload of a classic CAN frame, in bytes
+static constexpr uint8_t CAN_MAX_DATA_LENGTH = 8;
+/// @brief Largest payload of a CAN FD frame, in bytes
+static constexpr uint8_t CANFD_MAX_DATA_LENGTH = 64;
+
+/// @brief Checks that a payload length can be encoded in a DLC, classic or FD
+/// (0-8, then 12, 16, 20, 24, 32, 48, 64 bytes)
+/// @param length The payload length, in bytes
+/// @return Whether the length is valid
+inline bool isValidFrameLength(uint8_t length) {
+    if (length <= CAN_MAX_DATA_LENGTH) return true;
+    switch (length) {
+        case 12:
+        case 16:
+        case 20:
+        case 24:
+        case 32:
+        case 48:
+        case 64:
+            return true;
+        default:
+            return false;
+    }
+}
+
 /// @brief A descripton of a CANSignal, used purely for interface purposes with the CAN Bus
 struct CANSignalDescription {
    public:
-    uint8_t startBit;
+    uint16_t startBit;
     uint8_t length;
     bool isSigned;
     Endianness endianness;
     double factor;
     double offset;
+    // Name from the config, only valid while the builder that filled it in is running
+    const char* name = nullptr;
 };
 
 /// @brief A description of a CANMessaged, used purely for interface purposes with the CAN Bus
@@ -42,6 +80,11 @@ struct CANMessageDescription {
 
     // Callback to be invoked when this message is received.
     std::function<void(const struct CANMessage&)> onReceive;
+
+    // Name from the config, only valid while the builder that filled it in is running
+    const char* name = nullptr;
+
+    MessageLogMode logMode;
 };
 
 // Forward declarations
@@ -50,16 +93,66 @@ class CANSignal;
 class CANMessage;
 struct RawCANMessage;
 
+/// @brief The messages of a bus sorted by ID, with the read side of a std::map<id, message*>
+class MessageTable {
+   public:
+    struct Entry {
+        uint32_t first;       // the message ID
+        CANMessage* second;   // the message
+    };
+    using const_iterator = const Entry*;
+
+    const_iterator begin() const { return _entries.data(); }
+    const_iterator end() const { return _entries.data() + _entries.size(); }
+    size_t size() const { return _entries.size(); }
+    bool empty() const { return _entries.empty(); }
+
+    /// @brief Binary search for a message
+    /// @param id The message ID
+    /// @return The entry, or end() if there is no such message
+    const_iterator find(uint32_t id) const;
+
+    /// @brief Inserts a message, keeping the table sorted
+    /// @return false if the ID is already taken
+    bool insert(uint32_t id, CANMessage* message);
+
+    void reserve(size_t count) { _entries.reserve(count); }
+
+   private:
+    std::vector<Entry> _entries;
+};
+
 /// @brief The type of driver to use for the CAN bus.
 enum DriverType { DT_POLLING, DT_INTERRUPT, DT_NONE };
 
+/// @brief The outcome of handing a message to the bus or to a driver for transmission
+enum TxStatus {
+    TXS_SENT,             // the driver accepted the frame into hardware
+    TXS_QUEUED,           // the bus accepted the frame into its transmit queue
+    TXS_QUEUE_FULL,       // the transmit queue is full, the frame was not accepted
+    TXS_BUSY,             // the driver has no free transmit slot, try again later
+    TXS_ERROR,            // the driver rejected the frame (bus-off, bad length...)
+    TXS_NOT_INITIALIZED,  // the bus has not been initialized yet
+};
+
+/// @brief Counters describing the health of the transmit path
+struct TxStats {
+    uint32_t sent = 0;       // frames accepted by the driver
+    uint32_t coalesced = 0;  // frames that replaced a pending frame with the same ID
+    uint32_t rejected = 0;   // frames refused because the queue was full
+    uint32_t failed = 0;     // frames dropped because the driver reported an error
+    uint32_t busy = 0;       // times the driver had no free transmit slot
+    size_t highWater = 0;    // the deepest the transmit queue has been
+};
+
 /// @brief The raw representation of a CAN Message, used for interfacing with lower-level drivers
 struct RawCANMessage {
+    uint64_t timestampUs;  // when the driver captured the frame, microseconds since boot
     uint32_t id;
-    uint8_t length;
+    uint8_t length;  // up to 8 for classic frames, up to 64 for FD frames
     union {
-        uint8_t data[8];
-        uint64_t data64;
+        uint8_t data[CANFD_MAX_DATA_LENGTH];
+        uint64_t data64;  // the first 8 bytes, the whole payload of a classic frame
     };
 };
 
@@ -72,7 +165,11 @@ class CANDriver {
 
     virtual void install(CANBaudRate baudRate) = 0;
     virtual void uninstall() = 0;
-    virtual void sendMessage(const RawCANMessage& message) = 0;
+
+    /// @brief Hands a frame to the hardware, must never block
+    /// @param message The frame to send
+    /// @return TXS_SENT if accepted, TXS_BUSY if there is no free slot, TXS_ERROR otherwise
+    virtual TxStatus sendMessage(const RawCANMessage& message) = 0;
     virtual bool receiveMessage(RawCANMessage* res) = 0;
 
     // message handling for interrupt-based drivers
@@ -89,8 +186,14 @@ class CANDriver {
 /// messages), the driver, and compactly storing CAN messages in memory
 class CANBus {
    public:
-    CANBus(CANDriver& driver, CANBaudRate baudRate)
-        : _driver(driver), _baudRate(baudRate), _nextBitOffset(0), _buffer(BitBuffer::empty()) {}
+    static constexpr size_t DEFAULT_TX_QUEUE_DEPTH = 16;
+
+    CANBus(CANDriver& driver, CANBaudRate baudRate, size_t txQueueDepth = DEFAULT_TX_QUEUE_DEPTH)
+        : _driver(driver),
+          _baudRate(baudRate),
+          _buffer(BitBuffer::empty()),
+          _nextBitOffset(0),
+          _txQueue(txQueueDepth) {}
 
     ~CANBus();
 
@@ -103,16 +206,77 @@ class CANBus {
     /// @brief Adds a message to the CAN bus using the provided description.
     /// Registers the onReceive callback (if provided) internally.
     /// @param description The description of the message.
-    /// @return The newly added CAN Message
+    /// @return The newly added CAN Message, or the existing one if the ID is already taken
     CANMessage& addMessage(const CANMessageDescription& description);
 
+    /// @brief Adds a message from a plain array of signals, which is how the builder streams
+    /// messages in without building a description. Heap-free once reserve() made room.
+    /// @param id The message ID
+    /// @param length The payload length, in bytes
+    /// @param type The frame type
+    /// @param signals The signals, copied into the bus
+    /// @param signalCount The number of signals
+    /// @return The newly added CAN Message, or the existing one if the ID is already taken
+    CANMessage& addMessage(uint32_t id, uint8_t length, FrameType type,
+                           const CANSignalDescription* signals, size_t signalCount);
+
+    /// @brief Preallocates room for messages and signals, so adding that many never touches
+    /// the heap. Messages and signal descriptors are carved out of one arena and never move.
+    /// @param messages The number of messages
+    /// @param signals The total number of signals across those messages
+    void reserve(size_t messages, size_t signals);
+
+    /// @brief Announces a message ahead of adding it, as found by a counting pass over the
+    /// config. Once every message is planned, reserve() lays them all out at once.
+    /// @param id The message ID
+    /// @param length The payload length, in bytes
+    /// @param signalCount The number of signals
+    void planMessage(uint32_t id, uint8_t length, size_t signalCount);
+
+    /// @brief Lays out every planned message in a single arena block: the messages back to back
+    /// in ID order, followed by all of their signal descriptors in the same order. Data buffer slots follow
+    /// ID order as well. Must be called before any message is added; adding a planned message
+    /// afterwards only constructs it in its slot. Messages that were not planned, or that differ
+    /// from their plan, are appended as usual.
+    void reserve();
+
     void initialize();
 
     void update();
 
-    /// @brief Sends a CAN message.
+    /// @brief Queues a CAN message for transmission, never blocks.
+    /// A message with the same ID that is still pending is replaced with the newer payload.
+    /// Pending messages go out lowest ID first, the same way they would win arbitration.
+    /// @param message The CAN message to send.
+    /// @return TXS_QUEUED on success, TXS_QUEUE_FULL if there is no room
+    TxStatus sendMessage(const CANMessage& message);
+
+    /// @brief Schedules a message to be queued every periodMs, driven by serviceTransmit().
+    /// Schedules should be added during setup, before the task calling serviceTransmit() starts.
     /// @param message The CAN message to send.
-    void sendMessage(const CANMessage& message);
+    /// @param periodMs The period of the message, in milliseconds
+    /// @param phaseMs The delay before the first transmission, used to stagger schedules
+    void addPeriodicMessage(const CANMessage& message, uint32_t periodMs, uint32_t phaseMs = 0);
+
+    /// @brief Queues any periodic messages that are due, then hands as many queued messages to
+    /// the driver as it will accept. Stops at the first busy response, so this never blocks.
+    /// @param nowMs The current time, in milliseconds
+    void serviceTransmit(uint32_t nowMs);
+
+    /// @brief Registers a callback that reports the final outcome of every queued frame
+    /// @param callback Called with the message ID and TXS_SENT, TXS_ERROR or TXS_QUEUE_FULL
+    void registerTransmitCallback(std::function<void(uint32_t, TxStatus)> callback);
+
+    /// @brief The counters of the transmit path
+    TxStats transmitStats() const;
+
+    /// @brief The number of frames waiting in the transmit queue
+    size_t pendingTransmits() const;
+
+    /// @brief Registers a callback that sees every frame received for an MLM_EVENT message, called
+    /// from update() right after the frame is stored. Should be set during setup.
+    /// @param listener Called with the message and the frame as the driver delivered it
+    void setFrameListener(std::function<void(const CANMessage&, const RawCANMessage&)> listener);
 
     /// @brief Registers a callback for a given message ID.
     /// When a message with this ID is received, the callback will be invoked.
@@ -139,19 +303,48 @@ class CANBus {
     template <typename T>
     T getSignalValue(const CANSignal& signal);
 
+    /// @brief Decodes every signal on the bus in one pass, messages in ID order and signals in the
+    /// order they were declared. Streams straight through each message's descriptors and scale
+    /// indices.
+    /// @param values Out: the physical values
+    /// @param capacity The room in values
+    /// @return The number of values written
+    size_t decodeSignals(double* values, size_t capacity);
+
+    /// @brief A scale from the bus's table, shared by every signal with the same factor and offset
+    const SignalScale& signalScale(uint16_t index) const { return _scales[index]; }
+
+    /// @brief The number of distinct scales on the bus
+    size_t scaleCount() const { return _scales.size(); }
+
     /// @brief Prints out all of the messages on the bus
     /// @param stream The stream to print it to
     void printBus(std::ostream& stream) const;
 
     /// @brief Returns a const reference to the messages on the CAN Bus
-    /// @return A const reference to all the CANMessages
-    const std::unordered_map<uint32_t, std::unique_ptr<CANMessage>>& getMessages() const;
+    /// @return A const reference to all the CANMessages, sorted by ID
+    const MessageTable& getMessages() const;
 
     const uint8_t* dataBuffer(std::size_t* size) const {
         *size = _buffer.byteSize();
         return _buffer.buffer();
     }
 
+    /// @brief The capture time of the last frame received for every message, indexed by
+    /// CANMessage::index (the same order as the messages appear in the data buffer).
+    /// Guarded by bufMutex(), like the data buffer. Zero until a message is first received.
+    /// @param count Out: the number of timestamps
+    /// @return The timestamps, in microseconds since boot
+    const uint64_t* rxTimestamps(std::size_t* count) const {
+        *count = _rxTimestamps.size();
+        return _rxTimestamps.data();
+    }
+
+    /// @brief The capture time of the last frame received for a message
+    /// @param message The message
+    /// @return The timestamp in microseconds since boot, zero if it was never received
+    uint64_t lastReceiveUs(const CANMessage& message);
+
     std::mutex& bufMutex() { return _bufferMutex; }
 
    private:
@@ -160,52 +353,156 @@ class CANBus {
     CANBaudRate _baudRate;
 
     // CAN DBC
-    std::unordered_map<uint32_t, std::unique_ptr<CANMessage>> _messages;
+    Arena _arena;  // every CANMessage and its signal arrays live here
+    MessageTable _messages;
+    std::vector<SignalScale> _scales;
+
+    /// @brief Where a planned message goes
+    struct Placement {
+        uint32_t id;
+        uint8_t length;
+        size_t signalCount;
+        size_t signalStart;  // into _signalSlots and _scaleSlots
+        size_t bitOffset;    // into the data buffer
+    };
+
+    std::vector<Placement> _placements;  // sorted by ID once reserved
+    CANMessage* _messageSlots = nullptr;  // one per placement, constructed as messages are added
+    SignalDescriptor* _signalSlots = nullptr;
+    uint16_t* _scaleSlots = nullptr;  // parallel to _signalSlots
+    bool _isReserved = false;
+
+    const Placement* _findPlacement(uint32_t id) const;
+    uint16_t _internScale(double factor, double offset);
 
     // Buffer management
     // holds the encoded values that are sent over can
     BitBuffer _buffer;
     std::mutex _bufferMutex;
     size_t _nextBitOffset;
+    std::vector<uint64_t> _rxTimestamps;
 
     bool _isInitialized = false;
 
+    std::function<void(const CANMessage&, const RawCANMessage&)> _frameListener;
+
     // Maps CAN message IDs to their registered callback functions.
     std::unordered_map<uint32_t, std::function<void(const CANMessage&)>> _callbacks;
 
+    // Transmit path
+    struct TxEntry {
+        RawCANMessage frame;
+    };
+
+    // _enqueue() keeps at most one pending frame per ID, so the ID alone orders them
+    struct TxBefore {
+        bool operator()(const TxEntry& a, const TxEntry& b) const {
+            return a.frame.id < b.frame.id;
+        }
+    };
+
+    struct PeriodicEntry {
+        uint32_t id;
+        uint32_t periodMs;
+        uint32_t nextDueMs;
+        bool started;
+    };
+
+    FixedPriorityQueue<TxEntry, TxBefore> _txQueue;
+    mutable std::mutex _txMutex;
+    TxStats _txStats;
+    std::vector<PeriodicEntry> _periodic;
+    std::function<void(uint32_t, TxStatus)> _txCallback;
+
+    TxStatus _enqueue(const RawCANMessage& raw);
+    void _reportTransmit(uint32_t id, TxStatus status);
+
     RawCANMessage getRawMessage(const CANMessage& message);
     bool writeRawMessage(const RawCANMessage raw);
 };
 
-/// @brief The actual representation of a CAN signal
-/// Tied to the CAN BitBuffer
+/// @brief A view of one signal, pairing the bus's packed descriptor and scale index with the
+/// message it belongs to. Cheap to copy, signals are handed out by value.
 class CANSignal {
    public:
     const CANMessage& message;  // non-owning back-ref
-    const BitBufferHandle handle;
-    const bool isSigned;
-    const Endianness endianness;
-    const double factor;
-    const double offset;
+    const SignalDescriptor& descriptor;
+    const uint16_t scaleIndex;  // into the bus's scale table
 
-    // ctor uses same names as members
-    CANSignal(const CANMessage& message, BitBufferHandle handle, bool isSigned,
-              Endianness endianness, double factor, double offset) noexcept
-        : message(message),
-          handle(handle),
-          isSigned(isSigned),
-          endianness(endianness),
-          factor(factor),
-          offset(offset) {}
+    CANSignal(const CANMessage& message, const SignalDescriptor& descriptor,
+              uint16_t scaleIndex) noexcept
+        : message(message), descriptor(descriptor), scaleIndex(scaleIndex) {}
 
     CANSignal() = delete;
     CANSignal& operator=(const CANSignal&) = delete;
 
+    bool isSigned() const { return descriptor.isSigned(); }
+    Endianness endianness() const {
+        return descriptor.layout.bigEndian ? MSG_BIG_ENDIAN : MSG_LITTLE_ENDIAN;
+    }
+    const SignalLayout& layout() const { return descriptor.layout; }
+    SignalShape shape() const { return static_cast<SignalShape>(descriptor.shape); }
+
+    double factor() const;
+    double offset() const;
+
+    /// @brief Where the signal sits in the bus's data buffer, in bits
+    BitBufferHandle handle() const;
+
     template <typename T>
-    void setValue(T value);
+    void setValue(T value) const;
 
     template <typename T>
-    T getValue();
+    T getValue() const;
+};
+
+/// @brief The signals of one message, stored by the bus as parallel arrays of packed descriptors
+/// and scale indices
+class SignalSpan {
+   public:
+    /// @brief Walks the arrays, handing out a view of each signal
+    class iterator {
+       public:
+        iterator(const CANMessage* message, const SignalDescriptor* at, const uint16_t* scale)
+            : _message(message), _at(at), _scale(scale) {}
+
+        CANSignal operator*() const { return CANSignal(*_message, *_at, *_scale); }
+        iterator& operator++() {
+            ++_at;
+            ++_scale;
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return _at == other._at; }
+        bool operator!=(const iterator& other) const { return _at != other._at; }
+
+       private:
+        const CANMessage* _message;
+        const SignalDescriptor* _at;
+        const uint16_t* _scale;
+    };
+
+    SignalSpan() : _message(nullptr), _data(nullptr), _scales(nullptr), _size(0) {}
+    SignalSpan(const CANMessage* message, const SignalDescriptor* data, const uint16_t* scales,
+               size_t size)
+        : _message(message), _data(data), _scales(scales), _size(size) {}
+
+    iterator begin() const { return iterator(_message, _data, _scales); }
+    iterator end() const { return iterator(_message, _data + _size, _scales + _size); }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    CANSignal operator[](size_t i) const { return CANSignal(*_message, _data[i], _scales[i]); }
+
+    /// @brief The packed descriptors themselves, for loops that don't need views
+    const SignalDescriptor* descriptors() const { return _data; }
+
+    /// @brief The scale index of every signal, parallel to descriptors()
+    const uint16_t* scaleIndices() const { return _scales; }
+
+   private:
+    const CANMessage* _message;
+    const SignalDescriptor* _data;
+    const uint16_t* _scales;
+    size_t _size;
 };
 
 /// @brief The actual representation of a CAN message
@@ -217,59 +514,72 @@ class CANMessage {
     const uint8_t length;
     const FrameType type;
     const BitBufferHandle bufferHandle;
-    std::vector<CANSignal> signals;  // mutable so we can fill it once
+    const size_t index;  // position of the message in the data buffer
+    SignalSpan signals;  // filled in once, right after construction
+    MessageLogMode logMode = MLM_SNAPSHOT;
 
     // ctor uses same names as members
     CANMessage(CANBus& bus, uint32_t id, uint8_t length, FrameType type,
-               BitBufferHandle bufferHandle) noexcept
-        : bus(bus), id(id), length(length), type(type), bufferHandle(bufferHandle), signals() {}
+               BitBufferHandle bufferHandle, size_t index) noexcept
+        : bus(bus),
+          id(id),
+          length(length),
+          type(type),
+          bufferHandle(bufferHandle),
+          index(index),
+          signals() {}
 
     CANMessage() = delete;
     CANMessage& operator=(const CANMessage&) = delete;
 
-    void sendMessage() { bus.sendMessage(*this); }
+    /// @brief Where the payload starts in the bus's data buffer, slots are byte aligned
+    size_t payloadByte() const { return bufferHandle.offset / 8; }
+
+    TxStatus sendMessage() { return bus.sendMessage(*this); }
 };
 
 template <typename T>
 void CANBus::setSignalValue(const CANSignal& signal, T value) {
-    // 1) scale down to raw integer
-    using RawType = typename std::conditional<signal.isSigned, int64_t, uint64_t>::type;
-    double normalized = (static_cast<double>(value) - signal.offset) / signal.factor;
-    RawType raw = static_cast<RawType>(normalized);
+    const SignalDescriptor& desc = signal.descriptor;
+    const SignalScale& scale = _scales[signal.scaleIndex];
+
+    // 1) scale down to raw integer, two's complement keeps negative values in the low bits
+    double normalized = (static_cast<double>(value) - scale.offset) / scale.factor;
+    uint64_t raw = desc.isSigned() ? static_cast<uint64_t>(static_cast<int64_t>(normalized))
+                                   : static_cast<uint64_t>(normalized);
 
-    // 2) write into the big buffer
+    // 2) write into the message's slot of the big buffer
     std::lock_guard<std::mutex> lk(_bufferMutex);
-    _buffer.write(signal.handle, raw);
+    insertSignal(_buffer.buffer() + signal.message.payloadByte(), desc.layout, raw);
 }
 
 template <typename T>
 T CANBus::getSignalValue(const CANSignal& signal) {
-    // 1) read the raw bits back out
-    using RawType = typename std::conditional<signal.isSigned, int64_t, uint64_t>::type;
-    RawType raw = 0;
+    const SignalDescriptor& desc = signal.descriptor;
+
+    // 1) read the raw bits back out with the decoder for the signal's shape
+    uint64_t raw;
     {
         std::lock_guard<std::mutex> lk(_bufferMutex);
-        _buffer.read(signal.handle, &raw);
+        raw = desc.decode(_buffer.buffer() + signal.message.payloadByte());
     }
 
     // 2) if signed, sign-extend
-    if (signal.isSigned) {
-        raw = static_cast<RawType>((static_cast<uint64_t>(raw) << (64 - signal.handle.size)) >>
-                                   (64 - signal.handle.size));
-    }
+    double v = desc.isSigned() ? static_cast<double>(signExtend(raw, desc.layout.length))
+                               : static_cast<double>(raw);
 
     // 3) apply factor + offset
-    double v = static_cast<double>(raw) * signal.factor + signal.offset;
-    return static_cast<T>(v);
+    const SignalScale& scale = _scales[signal.scaleIndex];
+    return static_cast<T>(v * scale.factor + scale.offset);
 }
 
 template <typename T>
-void CANSignal::setValue(T value) {
+void CANSignal::setValue(T value) const {
     message.bus.setSignalValue(*this, value);
 }
 
 template <typename T>
-T CANSignal::getValue() {
+T CANSignal::getValue() const {
     return message.bus.getSignalValue<T>(*this);
 }
 
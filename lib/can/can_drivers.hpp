@@ -3,5 +3,6 @@
 
 #include <drivers/can_driver_esp.hpp>
 #include <drivers/can_driver_mcp.hpp>
+#include <drivers/can_driver_virtual.hpp>
 
 #endif  // __CAN_DRIVERS_H__
\ No newline at end of file
@@ -7,7 +7,9 @@
 
 #include <driver/gpio.h>
 #include <driver/twai.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #include <array>
 #include <can.hpp>
@@ -31,33 +33,61 @@ class ESPCANDriver : public CANDriver {
 
         twai_driver_install(&_genConfig, &_timingConfig, &_filterConfig);
         twai_start();
+
+        // frames are pulled off the TWAI queue by a dedicated task the moment they arrive, so
+        // their timestamps don't depend on how often the bus is polled
+        xTaskCreatePinnedToCore(&ESPCANDriver::_rxTaskEntry, "CAN_RX", RX_TASK_STACK, this,
+                                configMAX_PRIORITIES - 1, &_rxTask, RX_TASK_CORE);
         CAN_DEBUG_PRINTLN("Installed ESP32 CAN driver!");
     }
 
     void uninstall() override {
+        if (_rxTask != nullptr) {
+            vTaskDelete(_rxTask);
+            _rxTask = nullptr;
+        }
         twai_stop();
         twai_driver_uninstall();
     }
 
-    void sendMessage(const RawCANMessage& msg) override {
-        twai_message_t tx;
+    TxStatus sendMessage(const RawCANMessage& msg) override {
+        if (msg.length > CAN_MAX_DATA_LENGTH) {
+            // the TWAI controller only speaks classic CAN
+            return TXS_ERROR;
+        }
+
+        twai_message_t tx = {};
         tx.identifier = msg.id;
         tx.data_length_code = msg.length;
         memcpy(tx.data, msg.data, msg.length);
-        twai_transmit(&tx, portMAX_DELAY);
+
+        // never wait for space, the bus keeps the frame queued and retries on the next service
+        switch (twai_transmit(&tx, 0)) {
+            case ESP_OK:
+                return TXS_SENT;
+            case ESP_ERR_TIMEOUT:
+            case ESP_FAIL:
+                return TXS_BUSY;
+            default:
+                // bus-off, stopped, or an invalid frame
+                return TXS_ERROR;
+        }
     }
 
     bool receiveMessage(RawCANMessage* out) override {
-        // if there's anything buffered, hand it out
         tick();
 
+        // if there's anything buffered, hand it out
+        bool hasMessage = false;
+        portENTER_CRITICAL(&_rxLock);
         if (_rxCount > 0) {
             *out = _rxBuf[_rxTail];
             _rxTail = (_rxTail + 1) % RX_BUFFER_SIZE;
             --_rxCount;
-            return true;
+            hasMessage = true;
         }
-        return false;
+        portEXIT_CRITICAL(&_rxLock);
+        return hasMessage;
     }
 
     void tick() {
@@ -75,57 +105,81 @@ class ESPCANDriver : public CANDriver {
             CAN_DEBUG_PRINTLN("TWAI was stopped—restarting");
         }
 
-        // drain all pending HW messages
-        while (status.msgs_to_rx > 0) {
-            if (status.rx_missed_count > 0) {
-                CAN_DEBUG_PRINT_ERRORLN("Missed %u CAN msgs due to full HW queue",
-                                        status.rx_missed_count);
-            }
-
-            twai_message_t hwMsg;
-            if (twai_receive(&hwMsg, (TickType_t)100) == ESP_OK) {
-                RawCANMessage raw;
-                raw.id = hwMsg.identifier;
-                raw.length = hwMsg.data_length_code;
-                memcpy(raw.data, hwMsg.data, hwMsg.data_length_code);
-
-                // enqueue into our circular buffer
-                if (_rxCount < RX_BUFFER_SIZE) {
-                    _rxBuf[_rxHead] = raw;
-                    _rxHead = (_rxHead + 1) % RX_BUFFER_SIZE;
-                    ++_rxCount;
-                } else {
-                    CAN_DEBUG_PRINT_ERRORLN("RX buffer full, dropping incoming message");
-                }
-
-                // CAN_DEBUG_PRINTLN("Tick: received id=%u len=%u", raw.id, raw.length);
-            } else {
-                CAN_DEBUG_PRINT_ERRORLN("Failed to read message from TWAI queue");
-            }
-
-            // refresh status for next iteration
-            twai_get_status_info(&status);
+        if (status.rx_missed_count != _rxMissed) {
+            CAN_DEBUG_PRINT_ERRORLN("Missed %u CAN msgs due to full HW queue",
+                                    status.rx_missed_count - _rxMissed);
+            _rxMissed = status.rx_missed_count;
         }
     }
 
     void clearTransmitQueue() override { twai_clear_transmit_queue(); }
     void clearReceiveQueue() override {
         twai_clear_receive_queue();
+        portENTER_CRITICAL(&_rxLock);
         _rxHead = _rxTail = _rxCount = 0;
+        portEXIT_CRITICAL(&_rxLock);
     }
 
    private:
     static constexpr size_t RX_BUFFER_SIZE = 64;
+    static constexpr uint32_t RX_TASK_STACK = 3072;
+    static constexpr BaseType_t RX_TASK_CORE = 1;
+    static constexpr uint32_t RX_WAIT_MS = 100;
+
     std::array<RawCANMessage, RX_BUFFER_SIZE> _rxBuf{};
     size_t _rxHead = 0;
     size_t _rxTail = 0;
     size_t _rxCount = 0;
+    uint32_t _rxMissed = 0;
+    portMUX_TYPE _rxLock = portMUX_INITIALIZER_UNLOCKED;
+    TaskHandle_t _rxTask = nullptr;
 
     twai_general_config_t _genConfig;
     twai_timing_config_t _timingConfig;
     twai_filter_config_t _filterConfig;
     CANBaudRate _baudRate;
 
+    static void _rxTaskEntry(void* param) { static_cast<ESPCANDriver*>(param)->_rxLoop(); }
+
+    void _rxLoop() {
+        for (;;) {
+            twai_message_t hwMsg;
+            esp_err_t err = twai_receive(&hwMsg, pdMS_TO_TICKS(RX_WAIT_MS));
+            if (err == ESP_ERR_TIMEOUT) {
+                continue;
+            }
+            if (err != ESP_OK) {
+                // the controller is stopped or recovering, tick() will restart it
+                vTaskDelay(1);
+                continue;
+            }
+
+            RawCANMessage raw;
+            raw.timestampUs = static_cast<uint64_t>(esp_timer_get_time());
+            raw.id = hwMsg.identifier;
+            // classic DLCs above 8 still mean 8 bytes
+            raw.length = hwMsg.data_length_code > CAN_MAX_DATA_LENGTH ? CAN_MAX_DATA_LENGTH
+                                                                      : hwMsg.data_length_code;
+            memcpy(raw.data, hwMsg.data, raw.length);
+
+            // enqueue into our circular buffer
+            bool dropped = false;
+            portENTER_CRITICAL(&_rxLock);
+            if (_rxCount < RX_BUFFER_SIZE) {
+                _rxBuf[_rxHead] = raw;
+                _rxHead = (_rxHead + 1) % RX_BUFFER_SIZE;
+                ++_rxCount;
+            } else {
+                dropped = true;
+            }
+            portEXIT_CRITICAL(&_rxLock);
+
+            if (dropped) {
+                CAN_DEBUG_PRINT_ERRORLN("RX buffer full, dropping incoming message");
+            }
+        }
+    }
+
     static twai_timing_config_t selectTiming(CANBaudRate br) {
         switch (br) {
             case CBR_100KBPS:
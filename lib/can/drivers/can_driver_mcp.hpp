@@ -7,16 +7,46 @@
 
 #include <SPI.h>
 #include <can.h>
+#include <esp_timer.h>
 #include <mcp2515.h>
 
+#include <drivers/mcp2515_spi.hpp>
+
 namespace can {
 
 static CAN_SPEED __speedLUT[] = {CAN_100KBPS, CAN_125KBPS, CAN_250KBPS, CAN_500KBPS, CAN_100KBPS};
 
+static constexpr uint32_t MCP_SPI_CLOCK = 10000000U;
+
+/// @brief Raw SPI access to an MCP2515, sharing the bus and settings with the MCP2515 library
+class ArduinoMCP2515Transport : public MCP2515Transport {
+   public:
+    ArduinoMCP2515Transport(SPIClass& spi, uint8_t csPin) : _spi(spi), _csPin(csPin) {}
+
+    void transfer(const uint8_t* tx, uint8_t* rx, size_t length) override {
+        _spi.beginTransaction(SPISettings(MCP_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+        digitalWrite(_csPin, LOW);
+        for (size_t i = 0; i < length; ++i) {
+            uint8_t in = _spi.transfer(tx[i]);
+            if (rx) rx[i] = in;
+        }
+        digitalWrite(_csPin, HIGH);
+        _spi.endTransaction();
+    }
+
+   private:
+    SPIClass& _spi;
+    uint8_t _csPin;
+};
+
 template <HWPin csPin, uint8_t spiBusNum>
 class MCPCanDriver : public CANDriver {
    public:
-    MCPCanDriver() : _spiBus(spiBusNum), _mcp(csPin, 10000000U, &_spiBus) {}
+    MCPCanDriver()
+        : _spiBus(spiBusNum),
+          _mcp(csPin, MCP_SPI_CLOCK, &_spiBus),
+          _transport(_spiBus, csPin),
+          _reader(_transport) {}
 
     DriverType getDriverType() { return DT_POLLING; }
 
@@ -24,37 +54,73 @@ class MCPCanDriver : public CANDriver {
         _mcp.reset();
         _mcp.setBitrate(__speedLUT[baudRate]);
         _mcp.setNormalMode();
+        clearReceiveQueue();
     }
 
     void uninstall() {
         // no-op
     }
 
-    void sendMessage(const RawCANMessage& message) {
+    TxStatus sendMessage(const RawCANMessage& message) {
+        if (message.length > CAN_MAX_DATA_LENGTH) {
+            // the MCP2515 only speaks classic CAN
+            return TXS_ERROR;
+        }
+
         can_frame frame;
         frame.can_id = message.id;
+        frame.can_dlc = message.length;
         memcpy(frame.data, message.data, 8);
-        _mcp.sendMessage(&frame);
+
+        switch (_mcp.sendMessage(&frame)) {
+            case MCP2515::ERROR_OK:
+                return TXS_SENT;
+            case MCP2515::ERROR_ALLTXBUSY:
+                return TXS_BUSY;
+            default:
+                return TXS_ERROR;
+        }
     }
 
+    /// @brief Hands out one frame per call, but empties both receive buffers with a single
+    /// READ STATUS and burst read whenever nothing is left over from the previous call
     bool receiveMessage(RawCANMessage* message) {
-        can_frame frame;
-        if (_mcp.readMessage(&frame) == MCP2515::ERROR_OK) {
-            message->id = frame.can_id;
-            message->length = frame.can_dlc;
-            memcpy(message->data, frame.data, 8);
-            return true;
+        if (_pendingIndex >= _pendingCount) {
+            _pendingCount = _reader.readAll(_pending);
+            _pendingIndex = 0;
+            if (_pendingCount == 0) {
+                return false;
+            }
+
+            // the same 64-bit clock the TWAI driver stamps with, micros() wraps after 71 minutes
+            uint64_t now = static_cast<uint64_t>(esp_timer_get_time());
+            for (size_t i = 0; i < _pendingCount; ++i) {
+                _pending[i].timestampUs = now;
+            }
         }
-        return false;
+
+        *message = _pending[_pendingIndex++];
+        return true;
+    }
+
+    void clearReceiveQueue() {
+        _pendingCount = 0;
+        _pendingIndex = 0;
     }
 
    private:
     SPIClass _spiBus;
     MCP2515 _mcp;
+    ArduinoMCP2515Transport _transport;
+    MCP2515BurstReader _reader;
+
+    RawCANMessage _pending[2];
+    size_t _pendingCount = 0;
+    size_t _pendingIndex = 0;
 };
 
 }  // namespace can
 
 #endif  // !__PLATFORM_NATIVE
 
-#endif  // __CAN_DRIVER_MCP_H__
\ No newline at end of file
+#endif  // __CAN_DRIVER_MCP_H__
@@ -0,0 +1,90 @@
+#ifndef __CAN_DRIVER_VIRTUAL_H__
+#define __CAN_DRIVER_VIRTUAL_H__
+
+#include <can.hpp>
+#include <deque>
+#include <vector>
+
+namespace can {
+
+/// @brief An in-memory driver with no hardware behind it, used for native tests and tools.
+/// Frames are injected into the receive side by hand, and transmitted frames are recorded.
+/// Unlike the hardware drivers, it carries CAN FD payloads of up to 64 bytes.
+class VirtualCANDriver : public CANDriver {
+   public:
+    /// @brief Ctor
+    /// @param txSlots How many frames can be "on the wire" before sendMessage reports busy,
+    /// mimicking hardware mailboxes. Call completeTransmissions() to free them.
+    explicit VirtualCANDriver(size_t txSlots = 3) : _txSlots(txSlots) {}
+
+    DriverType getDriverType() override { return DT_POLLING; }
+
+    void install(CANBaudRate baudRate) override {
+        _baudRate = baudRate;
+        _installed = true;
+    }
+
+    void uninstall() override { _installed = false; }
+
+    TxStatus sendMessage(const RawCANMessage& message) override {
+        if (!_installed || _failTransmit || !isValidFrameLength(message.length)) {
+            return TXS_ERROR;
+        }
+        if (_inFlight >= _txSlots) {
+            return TXS_BUSY;
+        }
+
+        _inFlight++;
+        _sent.push_back(message);
+        return TXS_SENT;
+    }
+
+    bool receiveMessage(RawCANMessage* res) override {
+        if (_rx.empty()) {
+            return false;
+        }
+
+        *res = _rx.front();
+        _rx.pop_front();
+        return true;
+    }
+
+    void clearTransmitQueue() override { _inFlight = 0; }
+    void clearReceiveQueue() override { _rx.clear(); }
+
+    /// @brief Queue a frame to be handed out by receiveMessage, stamped with the virtual clock
+    /// as a real controller would at capture
+    void inject(const RawCANMessage& message) {
+        _rx.push_back(message);
+        _rx.back().timestampUs = _nowUs;
+    }
+
+    /// @brief Set the virtual clock used to stamp injected frames
+    void setTimeUs(uint64_t nowUs) { _nowUs = nowUs; }
+
+    /// @brief Frees all transmit slots, as if every frame in flight made it onto the bus
+    void completeTransmissions() { _inFlight = 0; }
+
+    /// @brief Makes every following sendMessage fail, as if the controller went bus-off
+    void setTransmitFailure(bool fail) { _failTransmit = fail; }
+
+    /// @brief Every frame the driver has accepted, in order
+    const std::vector<RawCANMessage>& sent() const { return _sent; }
+    void clearSent() { _sent.clear(); }
+
+    bool installed() const { return _installed; }
+
+   private:
+    std::deque<RawCANMessage> _rx;
+    std::vector<RawCANMessage> _sent;
+    size_t _txSlots;
+    size_t _inFlight = 0;
+    uint64_t _nowUs = 0;
+    bool _installed = false;
+    bool _failTransmit = false;
+    CANBaudRate _baudRate = CBR_500KBPS;
+};
+
+}  // namespace can
+
+#endif  // __CAN_DRIVER_VIRTUAL_H__
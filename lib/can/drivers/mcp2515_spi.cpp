@@ -0,0 +1,172 @@
+#include "mcp2515_spi.hpp"
+
+#include <cstring>
+
+using namespace can;
+using namespace can::mcp2515;
+
+// SIDL bits
+static constexpr uint8_t SIDL_IDE = 0x08;
+static constexpr uint8_t SIDL_EID_MASK = 0x03;
+// DLC bits
+static constexpr uint8_t DLC_MASK = 0x0F;
+
+size_t MCP2515BurstReader::readAll(RawCANMessage* out) {
+    uint8_t status = _readStatus();
+    size_t count = 0;
+
+    // RXB0 first, which isn't always the older frame: once RXB0 is freed while RXB1 still holds
+    // one, the next frame lands in RXB0. The chip keeps no receive time to sort them by.
+    if (status & STATUS_RX0IF) {
+        _readRxBuffer(INSTR_READ_RX0, &out[count++]);
+    }
+    if (status & STATUS_RX1IF) {
+        _readRxBuffer(INSTR_READ_RX1, &out[count++]);
+    }
+
+    return count;
+}
+
+void MCP2515BurstReader::decodeRxBuffer(const uint8_t* regs, RawCANMessage* out) {
+    uint8_t sidh = regs[0];
+    uint8_t sidl = regs[1];
+    uint32_t sid = (static_cast<uint32_t>(sidh) << 3) | (sidl >> 5);
+
+    if (sidl & SIDL_IDE) {
+        out->id = (sid << 18) | (static_cast<uint32_t>(sidl & SIDL_EID_MASK) << 16) |
+                  (static_cast<uint32_t>(regs[2]) << 8) | regs[3];
+    } else {
+        out->id = sid;
+    }
+
+    // DLC values above 8 still mean 8 bytes on a classic bus
+    uint8_t length = regs[4] & DLC_MASK;
+    out->length = length > CAN_MAX_DATA_LENGTH ? CAN_MAX_DATA_LENGTH : length;
+    std::memcpy(out->data, regs + 5, CAN_MAX_DATA_LENGTH);
+}
+
+uint8_t MCP2515BurstReader::_readStatus() {
+    uint8_t tx[2] = {INSTR_READ_STATUS, 0};
+    uint8_t rx[2] = {0, 0};
+    _transport.transfer(tx, rx, sizeof(tx));
+    return rx[1];
+}
+
+void MCP2515BurstReader::_readRxBuffer(uint8_t instruction, RawCANMessage* out) {
+    uint8_t tx[1 + RX_BUFFER_SIZE] = {instruction};
+    uint8_t rx[1 + RX_BUFFER_SIZE] = {0};
+    _transport.transfer(tx, rx, sizeof(tx));
+    decodeRxBuffer(rx + 1, out);
+}
+
+MockMCP2515::MockMCP2515() {
+    _reset();
+}
+
+void MockMCP2515::transfer(const uint8_t* tx, uint8_t* rx, size_t length) {
+    _transactions++;
+    _bytes += length;
+
+    // a transaction longer than instruction + address + every register only wraps around
+    uint8_t scratch[2 + REGISTER_COUNT];
+    if (rx == nullptr) {
+        rx = scratch;
+        length = length < sizeof(scratch) ? length : sizeof(scratch);
+    }
+    if (length == 0) {
+        return;
+    }
+
+    // latch the header first, tx and rx may be the same buffer
+    uint8_t instruction = tx[0];
+    uint8_t address = length > 1 ? tx[1] : 0;
+    rx[0] = 0;
+
+    switch (instruction) {
+        case INSTR_RESET:
+            _reset();
+            break;
+        case INSTR_READ: {
+            if (length > 1) rx[1] = 0;
+            for (size_t i = 2; i < length; ++i) {
+                rx[i] = reg(address++);
+            }
+            break;
+        }
+        case INSTR_WRITE: {
+            for (size_t i = 2; i < length; ++i) {
+                _regs[address++ & (REGISTER_COUNT - 1)] = tx[i];
+            }
+            break;
+        }
+        case INSTR_BIT_MODIFY: {
+            if (length < 4) break;
+            uint8_t& target = _regs[tx[1] & (REGISTER_COUNT - 1)];
+            target = (target & ~tx[2]) | (tx[3] & tx[2]);
+            break;
+        }
+        case INSTR_READ_STATUS: {
+            // the status byte repeats for as long as CS is held
+            uint8_t status = reg(REG_CANINTF) & (CANINTF_RX0IF | CANINTF_RX1IF);
+            for (size_t i = 1; i < length; ++i) {
+                rx[i] = status;
+            }
+            break;
+        }
+        case INSTR_READ_RX0:
+        case INSTR_READ_RX1: {
+            address = instruction == INSTR_READ_RX0 ? REG_RXB0SIDH : REG_RXB1SIDH;
+            for (size_t i = 1; i < length; ++i) {
+                rx[i] = reg(address++);
+            }
+            // releasing CS after READ RX BUFFER clears the matching flag
+            _regs[REG_CANINTF] &= instruction == INSTR_READ_RX0 ? ~CANINTF_RX0IF : ~CANINTF_RX1IF;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+bool MockMCP2515::receiveFrame(const RawCANMessage& frame, bool extended) {
+    uint8_t& intf = _regs[REG_CANINTF];
+
+    if (!(intf & CANINTF_RX0IF)) {
+        _loadRxBuffer(REG_RXB0SIDH, frame, extended);
+        intf |= CANINTF_RX0IF;
+        return true;
+    }
+    if (!(intf & CANINTF_RX1IF)) {
+        _loadRxBuffer(REG_RXB1SIDH, frame, extended);
+        intf |= CANINTF_RX1IF;
+        return true;
+    }
+
+    _regs[REG_EFLG] |= EFLG_RX1OVR;
+    return false;
+}
+
+void MockMCP2515::_reset() {
+    std::memset(_regs, 0, sizeof(_regs));
+}
+
+void MockMCP2515::_loadRxBuffer(uint8_t sidh, const RawCANMessage& frame, bool extended) {
+    uint8_t* regs = &_regs[sidh];
+
+    if (extended) {
+        uint32_t sid = frame.id >> 18;
+        regs[0] = static_cast<uint8_t>(sid >> 3);
+        regs[1] = static_cast<uint8_t>((sid & 0x07) << 5) | SIDL_IDE |
+                  static_cast<uint8_t>((frame.id >> 16) & SIDL_EID_MASK);
+        regs[2] = static_cast<uint8_t>(frame.id >> 8);
+        regs[3] = static_cast<uint8_t>(frame.id);
+    } else {
+        regs[0] = static_cast<uint8_t>(frame.id >> 3);
+        regs[1] = static_cast<uint8_t>((frame.id & 0x07) << 5);
+        regs[2] = 0;
+        regs[3] = 0;
+    }
+
+    regs[4] = frame.length & DLC_MASK;
+    std::memcpy(regs + 5, frame.data, CAN_MAX_DATA_LENGTH);
+}
@@ -0,0 +1,125 @@
+#ifndef __MCP2515_SPI_H__
+#define __MCP2515_SPI_H__
+
+#include <can.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace can {
+
+/// @brief MCP2515 SPI instructions and registers, see the MCP2515 datasheet (DS20001801)
+namespace mcp2515 {
+
+enum Instruction : uint8_t {
+    INSTR_WRITE = 0x02,
+    INSTR_READ = 0x03,
+    INSTR_BIT_MODIFY = 0x05,
+    INSTR_READ_RX0 = 0x90,  // READ RX BUFFER starting at RXB0SIDH
+    INSTR_READ_RX1 = 0x94,  // READ RX BUFFER starting at RXB1SIDH
+    INSTR_READ_STATUS = 0xA0,
+    INSTR_RESET = 0xC0,
+};
+
+enum Register : uint8_t {
+    REG_CANINTF = 0x2C,
+    REG_EFLG = 0x2D,
+    REG_RXB0SIDH = 0x61,
+    REG_RXB1SIDH = 0x71,
+};
+
+enum InterruptFlag : uint8_t {
+    CANINTF_RX0IF = 0x01,
+    CANINTF_RX1IF = 0x02,
+};
+
+enum ErrorFlag : uint8_t {
+    EFLG_RX0OVR = 0x40,
+    EFLG_RX1OVR = 0x80,
+};
+
+// READ STATUS reports RX0IF and RX1IF in its two lowest bits
+constexpr uint8_t STATUS_RX0IF = 0x01;
+constexpr uint8_t STATUS_RX1IF = 0x02;
+
+// SIDH, SIDL, EID8, EID0, DLC, then 8 data bytes
+constexpr size_t RX_BUFFER_SIZE = 13;
+constexpr size_t REGISTER_COUNT = 128;
+
+}  // namespace mcp2515
+
+/// @brief One chip-select framed SPI transaction with an MCP2515
+class MCP2515Transport {
+   public:
+    virtual ~MCP2515Transport() = default;
+
+    /// @brief Assert CS, clock `length` bytes out of tx while clocking the reply into rx, release CS
+    /// @param tx The bytes to send
+    /// @param rx Out: the bytes received, may be nullptr if the reply is not needed
+    /// @param length The number of bytes in the transaction
+    virtual void transfer(const uint8_t* tx, uint8_t* rx, size_t length) = 0;
+};
+
+/// @brief Empties both MCP2515 receive buffers in as few SPI transactions as possible.
+/// A single READ STATUS says which buffers hold a frame, then each one is pulled with one
+/// READ RX BUFFER burst, which also clears its RXnIF flag when CS is released. That is 3
+/// transactions for two frames, where a register-at-a-time read takes 5 per frame.
+class MCP2515BurstReader {
+   public:
+    explicit MCP2515BurstReader(MCP2515Transport& transport) : _transport(transport) {}
+
+    /// @brief Read every pending frame, RXB0 then RXB1. When both are full that is usually the
+    /// order they arrived in, but not always: a frame that came in after RXB0 was emptied, while
+    /// RXB1 was still waiting, is handed out first. The MCP2515 has no receive timestamps to
+    /// reorder them by, so two frames of one read may be swapped.
+    /// @param out Out: room for at least 2 frames, timestampUs is left for the caller to set
+    /// @return The number of frames read, 0 to 2
+    size_t readAll(RawCANMessage* out);
+
+    /// @brief Decode the 13 bytes of a receive buffer, starting at SIDH
+    static void decodeRxBuffer(const uint8_t* regs, RawCANMessage* out);
+
+   private:
+    MCP2515Transport& _transport;
+
+    uint8_t _readStatus();
+    void _readRxBuffer(uint8_t instruction, RawCANMessage* out);
+};
+
+/// @brief A register-level model of an MCP2515 on a fake SPI bus, for unit tests.
+/// It implements the instructions used by the drivers and counts every transaction,
+/// so the cost of a read strategy can be checked without hardware.
+class MockMCP2515 : public MCP2515Transport {
+   public:
+    MockMCP2515();
+
+    void transfer(const uint8_t* tx, uint8_t* rx, size_t length) override;
+
+    /// @brief A frame arrives from the bus. It lands in RXB0 if that is free, otherwise rolls
+    /// over into RXB1 (BUKT set), otherwise it is lost and the overflow flag is raised.
+    /// @return false if the frame was lost
+    bool receiveFrame(const RawCANMessage& frame, bool extended = false);
+
+    /// @brief Read a register directly, without going through (or counting) SPI
+    uint8_t reg(uint8_t address) const { return _regs[address & (mcp2515::REGISTER_COUNT - 1)]; }
+
+    /// @brief The number of CS-framed transactions so far
+    size_t transactions() const { return _transactions; }
+    /// @brief The number of bytes clocked so far, in both directions
+    size_t bytesClocked() const { return _bytes; }
+    void resetCounters() {
+        _transactions = 0;
+        _bytes = 0;
+    }
+
+   private:
+    uint8_t _regs[mcp2515::REGISTER_COUNT];
+    size_t _transactions = 0;
+    size_t _bytes = 0;
+
+    void _reset();
+    void _loadRxBuffer(uint8_t sidh, const RawCANMessage& frame, bool extended);
+};
+
+}  // namespace can
+
+#endif  // __MCP2515_SPI_H__
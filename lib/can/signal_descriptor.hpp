@@ -0,0 +1,45 @@
+#ifndef __SIGNAL_DESCRIPTOR_H__
+#define __SIGNAL_DESCRIPTOR_H__
+
+#include <stdint.h>
+
+#include "signal_kernel.hpp"
+#include "signal_layout.hpp"
+
+namespace can {
+
+/// @brief Flags of a packed signal
+enum SignalFlags : uint8_t {
+    SDF_SIGNED = 1 << 0,  // the raw value is two's complement
+};
+
+/// @brief How a signal's raw value maps to its physical value, `raw * factor + offset`
+struct SignalScale {
+    double factor;
+    double offset;
+};
+
+/// @brief The hot half of a signal the way the bus stores it, packed into 8 bytes. A message keeps
+/// its signals as parallel arrays, these descriptors next to their scale indices, so decode loops
+/// stream through both. Scales live in a table on the bus, since most signals of a config share a
+/// handful of them, and where the payload starts is kept once on the message.
+struct SignalDescriptor {
+    SignalLayout layout;  // where the bits sit in the message payload
+    uint8_t flags;        // SignalFlags
+    uint8_t shape;        // SignalShape, picks the decoder
+
+    bool isSigned() const { return (flags & SDF_SIGNED) != 0; }
+
+    /// @brief Pulls the raw bits out of the message payload
+    /// @param payload The first byte of the message's payload
+    /// @return The raw bits, masked but not sign-extended
+    uint64_t decode(const uint8_t* payload) const {
+        return signalDecoder(static_cast<SignalShape>(shape), layout.bigEndian)(payload, layout);
+    }
+};
+
+static_assert(sizeof(SignalDescriptor) == 8, "signal descriptors must stay packed");
+
+}  // namespace can
+
+#endif  // __SIGNAL_DESCRIPTOR_H__
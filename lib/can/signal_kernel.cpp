@@ -0,0 +1,89 @@
+#include "signal_kernel.hpp"
+
+namespace can {
+
+// Payload bytes are combined one at a time rather than loaded as a word: slots are only 64-bit
+// aligned as a whole, and the ESP32 faults on unaligned 16/32-bit loads. The compiler still
+// folds these into a single load wherever that's legal.
+
+template <uint8_t BYTES>
+static uint64_t decodeAlignedLittle(const uint8_t* payload, const SignalLayout& layout) {
+    const uint8_t* p = payload + layout.firstByte;
+    uint64_t raw = 0;
+    for (uint8_t i = 0; i < BYTES; ++i) {
+        raw |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return raw;
+}
+
+template <uint8_t BYTES>
+static uint64_t decodeAlignedBig(const uint8_t* payload, const SignalLayout& layout) {
+    const uint8_t* p = payload + layout.firstByte;
+    uint64_t raw = 0;
+    for (uint8_t i = 0; i < BYTES; ++i) {
+        raw = (raw << 8) | p[i];
+    }
+    return raw;
+}
+
+static uint64_t decodeFlag(const uint8_t* payload, const SignalLayout& layout) {
+    uint8_t bit = layout.startBit % 8;
+    uint8_t shift = layout.bigEndian ? 7 - bit : bit;
+    return (payload[layout.firstByte] >> shift) & 1;
+}
+
+static uint64_t decodeSubByte(const uint8_t* payload, const SignalLayout& layout) {
+    // signalByteShift() is never positive for a signal inside one byte
+    return (payload[layout.firstByte] >> -signalByteShift(layout, 0)) & signalMask(layout.length);
+}
+
+static uint64_t decodeSpanning(const uint8_t* payload, const SignalLayout& layout) {
+    return extractSignal(payload, layout);
+}
+
+// indexed by shape, then by endianness
+static const SignalDecodeFn DECODERS[][2] = {
+    {decodeAlignedLittle<1>, decodeAlignedLittle<1>},  // SS_ALIGNED_8
+    {decodeAlignedLittle<2>, decodeAlignedBig<2>},     // SS_ALIGNED_16
+    {decodeAlignedLittle<4>, decodeAlignedBig<4>},     // SS_ALIGNED_32
+    {decodeAlignedLittle<8>, decodeAlignedBig<8>},     // SS_ALIGNED_64
+    {decodeFlag, decodeFlag},                          // SS_FLAG
+    {decodeSubByte, decodeSubByte},                    // SS_SUB_BYTE
+    {decodeSpanning, decodeSpanning},                  // SS_SPANNING
+};
+
+SignalShape classifySignal(const SignalLayout& layout) {
+    if (layout.startBit % 8 == 0) {
+        switch (layout.length) {
+            case 8:
+                return SS_ALIGNED_8;
+            case 16:
+                return SS_ALIGNED_16;
+            case 32:
+                return SS_ALIGNED_32;
+            case 64:
+                return SS_ALIGNED_64;
+            default:
+                break;
+        }
+    }
+
+    if (layout.length == 1) {
+        return SS_FLAG;
+    }
+    if (layout.byteCount == 1) {
+        return SS_SUB_BYTE;
+    }
+    return SS_SPANNING;
+}
+
+SignalDecodeFn signalDecoder(SignalShape shape, bool bigEndian) {
+    return DECODERS[shape][bigEndian ? 1 : 0];
+}
+
+SignalKernel selectSignalKernel(const SignalLayout& layout) {
+    SignalShape shape = classifySignal(layout);
+    return {shape, signalDecoder(shape, layout.bigEndian)};
+}
+
+}  // namespace can
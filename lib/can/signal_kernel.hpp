@@ -0,0 +1,75 @@
+#ifndef __SIGNAL_KERNEL_H__
+#define __SIGNAL_KERNEL_H__
+
+#include <stdint.h>
+
+#include "signal_layout.hpp"
+
+namespace can {
+
+/// @brief The shape of a signal, which decides how its bits are pulled out of a payload
+enum SignalShape {
+    SS_ALIGNED_8,   // a whole byte
+    SS_ALIGNED_16,  // two whole bytes
+    SS_ALIGNED_32,  // four whole bytes
+    SS_ALIGNED_64,  // eight whole bytes
+    SS_FLAG,        // a single bit
+    SS_SUB_BYTE,    // a few bits inside one byte
+    SS_SPANNING     // anything else, crossing byte boundaries
+};
+
+/// @brief Pulls the raw bits of one signal out of its message payload
+/// @param payload The first byte of the message payload
+/// @param layout The layout of the signal
+/// @return The raw bits, masked but not sign-extended
+using SignalDecodeFn = uint64_t (*)(const uint8_t* payload, const SignalLayout& layout);
+
+/// @brief A signal's shape and the decoder specialized for it
+struct SignalKernel {
+    SignalShape shape;
+    SignalDecodeFn decode;
+};
+
+/// @brief Classifies a signal by where its bits sit
+/// @param layout The layout of the signal
+/// @return The shape
+SignalShape classifySignal(const SignalLayout& layout);
+
+/// @brief The decoder for a shape, so packed signals only need to store the shape
+/// @param shape The shape, as given by classifySignal()
+/// @param bigEndian Whether the signal is big endian
+/// @return The decoder
+SignalDecodeFn signalDecoder(SignalShape shape, bool bigEndian);
+
+/// @brief Classifies a signal and picks its decoder, done once when the message is added
+/// @param layout The layout of the signal
+/// @return The kernel, which always agrees with extractSignal()
+SignalKernel selectSignalKernel(const SignalLayout& layout);
+
+/// @brief Sign-extends the low `length` bits of a raw value
+inline int64_t signExtend(uint64_t raw, uint8_t length) {
+    unsigned shift = 64 - length;
+    return static_cast<int64_t>(raw << shift) >> shift;
+}
+
+/// @brief Writes the raw bits of a signal into a payload, leaving every other bit alone.
+/// The inverse of extractSignal().
+/// @param payload The message payload
+/// @param layout The layout of the signal
+/// @param raw The raw bits, anything above the signal's length is ignored
+inline void insertSignal(uint8_t* payload, const SignalLayout& layout, uint64_t raw) {
+    uint64_t signalBits = signalMask(layout.length);
+    raw &= signalBits;
+    for (uint8_t i = 0; i < layout.byteCount; ++i) {
+        int shift = signalByteShift(layout, i);
+        // which bits of this byte belong to the signal, and their value
+        uint8_t mask = static_cast<uint8_t>(shift >= 0 ? signalBits >> shift : signalBits << -shift);
+        uint8_t bits = static_cast<uint8_t>(shift >= 0 ? raw >> shift : raw << -shift);
+        uint8_t& byte = payload[layout.firstByte + i];
+        byte = static_cast<uint8_t>((byte & ~mask) | (bits & mask));
+    }
+}
+
+}  // namespace can
+
+#endif  // __SIGNAL_KERNEL_H__
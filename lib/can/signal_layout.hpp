@@ -0,0 +1,75 @@
+#ifndef __SIGNAL_LAYOUT_H__
+#define __SIGNAL_LAYOUT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace can {
+
+/// @brief Where a signal's bits sit in a message payload.
+///
+/// Bits are numbered sequentially through the payload, bit n lives in byte n / 8. A little endian
+/// signal counts from the least significant bit of each byte, so its startBit is its LSB and its
+/// bytes are least significant first. A big endian signal counts from the most significant bit
+/// of each byte, so its startBit is its MSB and its bytes are most significant first. Either way a
+/// signal covers bits [startBit, startBit + length), which keeps the fit and overlap checks the
+/// same for both, and byte-aligned signals come out as plain little or big endian integers.
+struct SignalLayout {
+    uint16_t startBit;
+    uint8_t length;
+    bool bigEndian;
+    uint8_t firstByte;  // the first payload byte holding part of the signal
+    uint8_t byteCount;  // the number of payload bytes the signal touches, at most 9
+};
+
+/// @brief The low `length` bits, which is where a signal's raw value lives
+inline uint64_t signalMask(uint8_t length) {
+    return length >= 64 ? ~0ull : (1ull << length) - 1;
+}
+
+/// @brief Works out where a signal lives in its payload
+/// @param startBit The start bit of the signal, see SignalLayout
+/// @param length The length of the signal in bits, 1-64
+/// @param bigEndian Whether the signal is big endian
+/// @return The layout
+inline SignalLayout signalLayout(uint16_t startBit, uint8_t length, bool bigEndian) {
+    SignalLayout layout;
+    layout.startBit = startBit;
+    layout.length = length;
+    layout.bigEndian = bigEndian;
+    layout.firstByte = static_cast<uint8_t>(startBit / 8);
+    layout.byteCount = static_cast<uint8_t>((startBit % 8 + length + 7) / 8);
+    return layout;
+}
+
+/// @brief How far the i-th payload byte of a signal has to be shifted to land in the raw value,
+/// left when positive, right when negative. The raw value is the OR of every shifted byte, masked.
+/// @param layout The layout of the signal
+/// @param i The byte, counting from layout.firstByte
+/// @return The shift, between -7 and 63
+inline int signalByteShift(const SignalLayout& layout, uint8_t i) {
+    int bitInByte = layout.startBit % 8;
+    if (layout.bigEndian) {
+        return layout.length + bitInByte - 8 - 8 * i;
+    }
+    return 8 * i - bitInByte;
+}
+
+/// @brief Pulls the raw bits of a signal out of a payload, one byte at a time. This is the
+/// reference every specialized decoder has to agree with.
+/// @param payload The message payload
+/// @param layout The layout of the signal
+/// @return The raw, unscaled and not sign-extended bits
+inline uint64_t extractSignal(const uint8_t* payload, const SignalLayout& layout) {
+    uint64_t raw = 0;
+    for (uint8_t i = 0; i < layout.byteCount; ++i) {
+        uint64_t byte = payload[layout.firstByte + i];
+        int shift = signalByteShift(layout, i);
+        raw |= shift >= 0 ? byte << shift : byte >> -shift;
+    }
+    return raw & signalMask(layout.length);
+}
+
+}  // namespace can
+
+#endif  // __SIGNAL_LAYOUT_H__
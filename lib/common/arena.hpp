@@ -0,0 +1,117 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace common {
+
+/// @brief A bump allocator for objects that live exactly as long as their owner.
+/// Allocations are carved out of large blocks and never freed one at a time, so there is no
+/// per-object heap node and nothing to fragment. Reserving up front makes every following
+/// allocation heap-free; past that the arena grows by another block, and nothing moves.
+class Arena {
+   public:
+    static constexpr size_t MIN_BLOCK_SIZE = 1024;
+
+    Arena() = default;
+    ~Arena() { release(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// @brief Makes sure the next `bytes` bytes of allocations fit in the current block
+    /// @param bytes The number of bytes, allow for alignment padding between objects
+    void reserve(size_t bytes) {
+        if (_blocks.empty() || _blocks.back().size - _blocks.back().used < bytes) {
+            _addBlock(bytes);
+        }
+    }
+
+    /// @brief Allocates raw, aligned storage
+    /// @param bytes The size of the storage
+    /// @param align The alignment, a power of two
+    /// @return The storage, valid until the arena is released
+    void* allocate(size_t bytes, size_t align) {
+        if (!_blocks.empty()) {
+            Block& block = _blocks.back();
+            size_t at = (block.used + align - 1) & ~(align - 1);
+            if (at + bytes <= block.size) {
+                block.used = at + bytes;
+                return block.data + at;
+            }
+        }
+
+        // doubling keeps the number of blocks logarithmic when nothing was reserved
+        size_t grow = _blocks.empty() ? MIN_BLOCK_SIZE : _blocks.back().size * 2;
+        _addBlock(bytes + align > grow ? bytes + align : grow);
+        return allocate(bytes, align);
+    }
+
+    /// @brief Constructs an object in the arena. Destructors are never run, so only trivially
+    /// destructible types are allowed.
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /// @brief Allocates uninitialized storage for `count` objects, to be constructed in place
+    template <typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "arena objects are never destroyed");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    /// @brief Bytes handed out so far, including alignment padding
+    size_t used() const {
+        size_t total = 0;
+        for (const Block& block : _blocks) {
+            total += block.used;
+        }
+        return total;
+    }
+
+    /// @brief Bytes held from the heap
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block& block : _blocks) {
+            total += block.size;
+        }
+        return total;
+    }
+
+    size_t blockCount() const { return _blocks.size(); }
+
+    /// @brief Gives every block back to the heap, invalidating everything allocated
+    void release() {
+        for (Block& block : _blocks) {
+            delete[] block.data;
+        }
+        _blocks.clear();
+    }
+
+   private:
+    struct Block {
+        uint8_t* data;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<Block> _blocks;
+
+    void _addBlock(size_t size) {
+        _blocks.push_back(Block{new uint8_t[size], size, 0});
+    }
+};
+
+}  // namespace common
+
+#endif  // __ARENA_H__
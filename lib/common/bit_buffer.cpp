@@ -15,7 +15,23 @@ BitBuffer::BitBuffer(size_t bitSize) : _bitSize(bitSize) {
 }
 
 BitBuffer::~BitBuffer() {
-    delete _buffer;
+    delete[] _buffer;
+}
+
+BitBuffer::BitBuffer(BitBuffer&& other) noexcept : _buffer(other._buffer), _bitSize(other._bitSize) {
+    other._buffer = nullptr;
+    other._bitSize = 0;
+}
+
+BitBuffer& BitBuffer::operator=(BitBuffer&& other) noexcept {
+    if (this != &other) {
+        delete[] _buffer;
+        _buffer = other._buffer;
+        _bitSize = other._bitSize;
+        other._buffer = nullptr;
+        other._bitSize = 0;
+    }
+    return *this;
 }
 
 void BitBuffer::write(BitBufferHandle handle, const void* data, size_t size) {
@@ -22,6 +22,12 @@ class BitBuffer {
     BitBuffer(size_t bitSize);
     ~BitBuffer();
 
+    // the buffer owns its storage, so it can be moved but not copied
+    BitBuffer(const BitBuffer&) = delete;
+    BitBuffer& operator=(const BitBuffer&) = delete;
+    BitBuffer(BitBuffer&& other) noexcept;
+    BitBuffer& operator=(BitBuffer&& other) noexcept;
+
     static BitBuffer empty() { return BitBuffer(0); }
     static constexpr uint8_t __offsetHack = 48;
 
@@ -74,6 +80,7 @@ class BitBuffer {
     size_t byteSize() const { return (_bitSize + 7) / 8; }
 
     const uint8_t* buffer() const { return &_buffer[BitBuffer::__offsetHack]; }
+    uint8_t* buffer() { return &_buffer[BitBuffer::__offsetHack]; }
 
    private:
     uint8_t* _buffer;
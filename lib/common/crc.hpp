@@ -0,0 +1,31 @@
+#ifndef __CRC_H__
+#define __CRC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace common {
+
+static constexpr uint16_t CRC16_INIT = 0xFFFF;
+
+/// @brief CRC-16/CCITT-FALSE (polynomial 0x1021, MSB first), four bits at a time so the table
+/// stays at 32 bytes
+/// @param data The bytes to check
+/// @param length The number of bytes
+/// @param crc The running CRC, to check data in several pieces
+/// @return The CRC
+inline uint16_t crc16(const void* data, size_t length, uint16_t crc = CRC16_INIT) {
+    static constexpr uint16_t TABLE[16] = {0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5,
+                                           0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B,
+                                           0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < length; ++i) {
+        crc = static_cast<uint16_t>((crc << 4) ^ TABLE[(crc >> 12) ^ (bytes[i] >> 4)]);
+        crc = static_cast<uint16_t>((crc << 4) ^ TABLE[(crc >> 12) ^ (bytes[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+}  // namespace common
+
+#endif  // __CRC_H__
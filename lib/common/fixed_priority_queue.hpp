@@ -0,0 +1,115 @@
+#ifndef __FIXED_PRIORITY_QUEUE_H__
+#define __FIXED_PRIORITY_QUEUE_H__
+
+#include <stddef.h>
+
+#include <utility>
+#include <vector>
+
+namespace common {
+
+/// @brief A bounded binary heap, all storage is reserved up-front so pushes never allocate
+/// @tparam T The type of the element
+/// @tparam Before A functor, Before()(a, b) is true when `a` should be popped before `b`
+template <typename T, typename Before>
+class FixedPriorityQueue {
+   public:
+    /// @brief Ctor
+    /// @param capacity The maximum number of elements the queue will hold
+    explicit FixedPriorityQueue(size_t capacity = 0) : _capacity(capacity) {
+        _heap.reserve(capacity);
+    }
+
+    /// @brief Push an element into the queue
+    /// @param value The element
+    /// @return false if the queue is full, and the value was not added
+    bool push(const T& value) {
+        if (full()) {
+            return false;
+        }
+
+        _heap.push_back(value);
+        _siftUp(_heap.size() - 1);
+        return true;
+    }
+
+    /// @brief The element that would be popped next, the queue must not be empty
+    const T& top() const { return _heap.front(); }
+
+    /// @brief Remove the element at the top of the queue
+    void pop() {
+        if (empty()) {
+            return;
+        }
+
+        _heap.front() = _heap.back();
+        _heap.pop_back();
+        if (!empty()) {
+            _siftDown(0);
+        }
+    }
+
+    /// @brief Find the first element satisfying a predicate, the caller may modify the element as
+    /// long as it does not change its priority
+    /// @param pred The predicate
+    /// @return A pointer to the element, or nullptr if there is none
+    template <typename Pred>
+    T* find(Pred pred) {
+        for (T& value : _heap) {
+            if (pred(value)) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+
+    /// @brief Removes all elements, keeping the storage
+    void clear() { _heap.clear(); }
+
+    size_t size() const { return _heap.size(); }
+    size_t capacity() const { return _capacity; }
+    bool empty() const { return _heap.empty(); }
+    bool full() const { return _heap.size() >= _capacity; }
+
+   private:
+    std::vector<T> _heap;
+    size_t _capacity;
+    Before _before;
+
+    void _siftUp(size_t index) {
+        while (index > 0) {
+            size_t parent = (index - 1) / 2;
+            if (!_before(_heap[index], _heap[parent])) {
+                break;
+            }
+            std::swap(_heap[index], _heap[parent]);
+            index = parent;
+        }
+    }
+
+    void _siftDown(size_t index) {
+        size_t count = _heap.size();
+        while (true) {
+            size_t left = index * 2 + 1;
+            size_t right = left + 1;
+            size_t best = index;
+
+            if (left < count && _before(_heap[left], _heap[best])) {
+                best = left;
+            }
+            if (right < count && _before(_heap[right], _heap[best])) {
+                best = right;
+            }
+            if (best == index) {
+                break;
+            }
+
+            std::swap(_heap[index], _heap[best]);
+            index = best;
+        }
+    }
+};
+
+}  // namespace common
+
+#endif  // __FIXED_PRIORITY_QUEUE_H__
@@ -0,0 +1,29 @@
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace common {
+
+static constexpr uint32_t FNV1A_OFFSET_BASIS = 2166136261u;
+static constexpr uint32_t FNV1A_PRIME = 16777619u;
+
+/// @brief 32-bit FNV-1a, cheap and good enough for short strings and for checksumming blobs
+/// @param data The bytes to hash
+/// @param length The number of bytes
+/// @param seed The running hash, to hash data in several pieces
+/// @return The hash
+inline uint32_t fnv1a(const void* data, size_t length, uint32_t seed = FNV1A_OFFSET_BASIS) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint32_t hash = seed;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+}  // namespace common
+
+#endif  // __HASH_H__
@@ -0,0 +1,176 @@
+#include <lz.hpp>
+
+#include <cstring>
+
+using namespace common;
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t LAST_LITERALS = 5;  // the block always ends in this many literals
+static constexpr size_t MATCH_LIMIT = 12;   // and no match starts this close to its end
+
+static uint32_t __read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t __hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZCompressor::HASH_BITS);
+}
+
+// Helper: a length past what fits in the token's nibble, as 255s and a remainder
+static void __putLength(uint8_t* out, size_t& op, size_t length) {
+    for (; length >= 255; length -= 255) {
+        out[op++] = 255;
+    }
+    out[op++] = static_cast<uint8_t>(length);
+}
+
+// Helper: one sequence, literals then a match, or only literals when matchLength is 0
+static bool __emit(uint8_t* out, size_t& op, size_t capacity, const uint8_t* literals,
+                   size_t literalLength, size_t offset, size_t matchLength) {
+    size_t need = 1 + literalLength + literalLength / 255 + 1;
+    if (matchLength > 0) {
+        need += 2 + (matchLength - MIN_MATCH) / 255 + 1;
+    }
+    if (need > capacity - op) {
+        return false;
+    }
+
+    size_t token = op++;
+    out[token] = static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4);
+    if (literalLength >= 15) {
+        __putLength(out, op, literalLength - 15);
+    }
+    std::memcpy(out + op, literals, literalLength);
+    op += literalLength;
+    if (matchLength == 0) {
+        return true;
+    }
+
+    out[op++] = static_cast<uint8_t>(offset);
+    out[op++] = static_cast<uint8_t>(offset >> 8);
+    size_t code = matchLength - MIN_MATCH;
+    out[token] |= static_cast<uint8_t>(code < 15 ? code : 15);
+    if (code >= 15) {
+        __putLength(out, op, code - 15);
+    }
+    return true;
+}
+
+LZCompressor::LZCompressor() : _table(new uint16_t[size_t(1) << HASH_BITS]) {}
+
+size_t LZCompressor::compress(const uint8_t* in, size_t size, uint8_t* out, size_t capacity) {
+    if (size > MAX_BLOCK_SIZE) {
+        return 0;
+    }
+    // blocks are independent, nothing may match into the previous one
+    std::memset(_table.get(), 0, sizeof(uint16_t) << HASH_BITS);
+
+    size_t op = 0;
+    size_t anchor = 0;
+    if (size > MATCH_LIMIT) {
+        size_t limit = size - MATCH_LIMIT;
+        size_t matchEnd = size - LAST_LITERALS;
+        size_t ip = 0;
+        while (ip < limit) {
+            uint32_t sequence = __read32(in + ip);
+            uint32_t h = __hash(sequence);
+            size_t candidate = _table[h];
+            _table[h] = static_cast<uint16_t>(ip + 1);
+            if (candidate == 0 || __read32(in + candidate - 1) != sequence) {
+                // step faster through data that doesn't compress
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            size_t ref = candidate - 1;
+            while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) {
+                --ip;
+                --ref;
+            }
+            size_t length = MIN_MATCH;
+            while (ip + length < matchEnd && in[ip + length] == in[ref + length]) {
+                ++length;
+            }
+            if (!__emit(out, op, capacity, in + anchor, ip - anchor, ip - ref, length)) {
+                return 0;
+            }
+            ip += length;
+            anchor = ip;
+            if (ip < limit) {
+                _table[__hash(__read32(in + ip - 2))] = static_cast<uint16_t>(ip - 1);
+            }
+        }
+    }
+    if (!__emit(out, op, capacity, in + anchor, size - anchor, 0, 0)) {
+        return 0;
+    }
+    return op;
+}
+
+size_t common::lzDecompress(const uint8_t* in, size_t size, uint8_t* out, size_t capacity) {
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < size) {
+        uint8_t token = in[ip++];
+
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            uint8_t b;
+            do {
+                if (ip >= size) {
+                    return 0;
+                }
+                b = in[ip++];
+                literals += b;
+            } while (b == 255);
+        }
+        if (literals > size - ip || literals > capacity - op) {
+            return 0;
+        }
+        std::memcpy(out + op, in + ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == size) {
+            // the last sequence has no match
+            return op;
+        }
+
+        if (size - ip < 2) {
+            return 0;
+        }
+        size_t offset = in[ip] | (static_cast<size_t>(in[ip + 1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            return 0;
+        }
+        size_t length = token & 0x0F;
+        if (length == 15) {
+            uint8_t b;
+            do {
+                if (ip >= size) {
+                    return 0;
+                }
+                b = in[ip++];
+                length += b;
+            } while (b == 255);
+        }
+        length += MIN_MATCH;
+        if (length > capacity - op) {
+            return 0;
+        }
+
+        // a match may overlap what it is copying, which repeats the bytes
+        const uint8_t* from = out + op - offset;
+        if (offset >= length) {
+            std::memcpy(out + op, from, length);
+        } else {
+            for (size_t i = 0; i < length; ++i) {
+                out[op + i] = from[i];
+            }
+        }
+        op += length;
+    }
+    return 0;
+}
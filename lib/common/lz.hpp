@@ -0,0 +1,51 @@
+#ifndef __LZ_H__
+#define __LZ_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+namespace common {
+
+/// @brief Compresses blocks of bytes independently of each other, so they can be decompressed in
+/// any order. The output is an LZ4 block (sequences of a token, literals, a u16 offset and a match
+/// length), so any LZ4 block decoder reads it too. Matches are only searched through a single hash
+/// table slot, trading some ratio for a fixed memory footprint and a predictable cost per byte.
+class LZCompressor {
+   public:
+    static constexpr size_t HASH_BITS = 12;
+    static constexpr size_t MAX_BLOCK_SIZE = 65535;  // offsets are 16 bits
+
+    /// @brief The most a block of `size` bytes can grow to
+    static constexpr size_t bound(size_t size) { return size + size / 255 + 16; }
+
+    /// @brief Allocates the hash table, 2 << HASH_BITS bytes
+    LZCompressor();
+
+    LZCompressor(const LZCompressor&) = delete;
+    LZCompressor& operator=(const LZCompressor&) = delete;
+
+    /// @brief Compresses one block
+    /// @param in The block, at most MAX_BLOCK_SIZE bytes
+    /// @param size The size of the block
+    /// @param out Where to put the compressed block
+    /// @param capacity The room in out, never too little when at least bound(size)
+    /// @return The compressed size, zero if it doesn't fit in capacity
+    size_t compress(const uint8_t* in, size_t size, uint8_t* out, size_t capacity);
+
+   private:
+    std::unique_ptr<uint16_t[]> _table;  // the last position + 1 of each hash, 0 for none
+};
+
+/// @brief Decompresses a block written by LZCompressor, or by any LZ4 block encoder
+/// @param in The compressed block
+/// @param size The size of the compressed block
+/// @param out Where to put the block
+/// @param capacity The room in out
+/// @return The size of the block, zero if it is malformed or doesn't fit in capacity
+size_t lzDecompress(const uint8_t* in, size_t size, uint8_t* out, size_t capacity);
+
+}  // namespace common
+
+#endif  // __LZ_H__
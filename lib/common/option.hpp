@@ -19,10 +19,13 @@ class Option {
     static Option<T> none() { return Option<T>(); }
 
     /// @brief Ctor
-    Option() : _hasValue(false), _value(T()) {}
+    Option() : _value(T()), _hasValue(false) {}
+
+    /// @brief Copy ctor, declared next to the assignment operator below
+    Option(const Option<T>& other) = default;
 
     /// @brief Equals operator
-    Option<T> operator=(const Option<T>& other) {
+    Option<T>& operator=(const Option<T>& other) {
         _value = other._value;
         _hasValue = other._hasValue;
         return *this;
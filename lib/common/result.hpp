@@ -28,11 +28,14 @@ class Result {
     /// @brief Ctor
     Result() : _error(true) {}
 
+    /// @brief Copy ctor, declared next to the assignment operator below
+    Result(const Result<T>& other) = default;
+
     /// @brief Cast to bool
     operator bool() const { return !_error; }
 
     /// @brief Equals operator
-    Result<T> operator=(const Result<T>& other) {
+    Result<T>& operator=(const Result<T>& other) {
         _value = other._value;
         _error = other._error;
         _errorMessage = other._errorMessage;
@@ -0,0 +1,181 @@
+#include <ts_codec.hpp>
+
+#include <cstring>
+
+using namespace common;
+
+void BitWriter::write(uint64_t value, unsigned bits) {
+    while (bits > 0) {
+        if (_bit == 0) {
+            _out.push_back(0);
+        }
+        unsigned take = 8 - _bit < bits ? 8 - _bit : bits;
+        _out.back() |= static_cast<uint8_t>((value & ((1u << take) - 1)) << _bit);
+        value >>= take;
+        bits -= take;
+        _bit = (_bit + take) & 7;
+    }
+}
+
+uint64_t BitReader::read(unsigned bits) {
+    uint64_t value = 0;
+    unsigned got = 0;
+    while (got < bits) {
+        size_t byte = _position >> 3;
+        unsigned offset = _position & 7;
+        if (byte >= _size) {
+            _overrun = true;
+            _position += bits - got;
+            return value;
+        }
+        unsigned take = 8 - offset < bits - got ? 8 - offset : bits - got;
+        uint64_t chunk = (_in[byte] >> offset) & ((1u << take) - 1);
+        value |= chunk << got;
+        got += take;
+        _position += take;
+    }
+    return value;
+}
+
+void common::encodeTimestamps(const uint64_t* values, size_t count, std::vector<uint8_t>& out) {
+    DeltaOfDelta dod;
+    for (size_t i = 0; i < count; ++i) {
+        putVarint(out, zigzag(dod.encode(values[i])));
+    }
+}
+
+size_t common::decodeTimestamps(const uint8_t* in, size_t size, size_t count, uint64_t* values) {
+    DeltaOfDelta dod;
+    size_t at = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t v;
+        size_t used = getVarint(in + at, size - at, &v);
+        if (used == 0) {
+            return 0;
+        }
+        at += used;
+        values[i] = dod.decode(unzigzag(v));
+    }
+    return at;
+}
+
+// Helper: how many bits a value needs
+static unsigned __width(uint64_t value) {
+    return value == 0 ? 0 : 64 - static_cast<unsigned>(__builtin_clzll(value));
+}
+
+void common::encodeIntegers(const int64_t* values, size_t count, std::vector<uint8_t>& out) {
+    int64_t previous = 0;
+    uint64_t deltas[INTEGER_BLOCK];
+    for (size_t start = 0; start < count; start += INTEGER_BLOCK) {
+        size_t n = count - start < INTEGER_BLOCK ? count - start : INTEGER_BLOCK;
+        uint64_t all = 0;
+        for (size_t i = 0; i < n; ++i) {
+            int64_t value = values[start + i];
+            deltas[i] = zigzag(static_cast<int64_t>(static_cast<uint64_t>(value) -
+                                                    static_cast<uint64_t>(previous)));
+            previous = value;
+            all |= deltas[i];
+        }
+
+        // each block starts on a byte, so a reader can skip whole blocks by their width
+        unsigned width = __width(all);
+        out.push_back(static_cast<uint8_t>(width));
+        BitWriter bits(out);
+        for (size_t i = 0; i < n; ++i) {
+            bits.write(deltas[i], width);
+        }
+    }
+}
+
+size_t common::decodeIntegers(const uint8_t* in, size_t size, size_t count, int64_t* values) {
+    int64_t previous = 0;
+    size_t at = 0;
+    for (size_t start = 0; start < count; start += INTEGER_BLOCK) {
+        size_t n = count - start < INTEGER_BLOCK ? count - start : INTEGER_BLOCK;
+        if (at >= size || in[at] > 64) {
+            return 0;
+        }
+        unsigned width = in[at++];
+        BitReader bits(in + at, size - at);
+        for (size_t i = 0; i < n; ++i) {
+            previous = static_cast<int64_t>(static_cast<uint64_t>(previous) +
+                                            static_cast<uint64_t>(unzigzag(bits.read(width))));
+            values[start + i] = previous;
+        }
+        if (bits.overrun()) {
+            return 0;
+        }
+        at += bits.used();
+    }
+    return at;
+}
+
+static uint64_t __bitsOf(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+void common::encodeFloats(const double* values, size_t count, std::vector<uint8_t>& out) {
+    BitWriter bits(out);
+    uint64_t previous = 0;
+    unsigned lead = 0;
+    unsigned trail = 0;
+    bool window = false;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t value = __bitsOf(values[i]);
+        uint64_t x = value ^ previous;
+        previous = value;
+        if (x == 0) {
+            bits.write(0, 1);
+            continue;
+        }
+
+        unsigned l = static_cast<unsigned>(__builtin_clzll(x));
+        unsigned t = static_cast<unsigned>(__builtin_ctzll(x));
+        l = l < 31 ? l : 31;  // five bits for it
+        if (window && l >= lead && t >= trail) {
+            bits.write(0b01, 2);
+            bits.write(x >> trail, 64 - lead - trail);
+            continue;
+        }
+        lead = l;
+        trail = t;
+        window = true;
+        unsigned significant = 64 - lead - trail;
+        bits.write(0b11, 2);
+        bits.write(lead, 5);
+        bits.write(significant - 1, 6);
+        bits.write(x >> trail, significant);
+    }
+}
+
+size_t common::decodeFloats(const uint8_t* in, size_t size, size_t count, double* values) {
+    BitReader bits(in, size);
+    uint64_t previous = 0;
+    unsigned lead = 0;
+    unsigned trail = 0;
+    bool window = false;
+    for (size_t i = 0; i < count; ++i) {
+        if (bits.read(1) == 1) {
+            if (bits.read(1) == 1) {
+                lead = static_cast<unsigned>(bits.read(5));
+                unsigned significant = static_cast<unsigned>(bits.read(6)) + 1;
+                if (lead + significant > 64) {
+                    return 0;
+                }
+                trail = 64 - lead - significant;
+                window = true;
+            } else if (!window) {
+                return 0;
+            }
+            previous ^= bits.read(64 - lead - trail) << trail;
+        }
+        std::memcpy(&values[i], &previous, sizeof(previous));
+    }
+    if (bits.overrun()) {
+        return 0;
+    }
+    return bits.used();
+}
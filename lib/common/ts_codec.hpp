@@ -0,0 +1,142 @@
+#ifndef __TS_CODEC_H__
+#define __TS_CODEC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace common {
+
+static constexpr size_t VARINT_MAX_SIZE = 10;
+
+/// @brief Maps signed values to unsigned ones so small magnitudes stay small: 0, -1, 1, -2, ...
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/// @brief Writes a LEB128 varint, seven bits per byte with the high bit set on all but the last
+/// @param out Room for VARINT_MAX_SIZE bytes
+/// @return The number of bytes written
+inline size_t putVarint(uint8_t* out, uint64_t value) {
+    size_t size = 0;
+    while (value >= 0x80) {
+        out[size++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = static_cast<uint8_t>(value);
+    return size;
+}
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    uint8_t bytes[VARINT_MAX_SIZE];
+    out.insert(out.end(), bytes, bytes + putVarint(bytes, value));
+}
+
+/// @brief Reads a LEB128 varint
+/// @param in The varint
+/// @param size The bytes available from in
+/// @param value Out: the value
+/// @return The number of bytes used, zero if it is cut off or longer than VARINT_MAX_SIZE
+inline size_t getVarint(const uint8_t* in, size_t size, uint64_t* value) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < size && i < VARINT_MAX_SIZE; ++i) {
+        v |= static_cast<uint64_t>(in[i] & 0x7F) << (7 * i);
+        if ((in[i] & 0x80) == 0) {
+            *value = v;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/// @brief Turns a stream of timestamps into the change in their interval, which stays near zero
+/// for anything periodic. The encoding and decoding side each keep one and feed it the same way.
+class DeltaOfDelta {
+   public:
+    /// @brief Starts over from an absolute time, with no interval yet
+    void reset(uint64_t base) {
+        _last = base;
+        _interval = 0;
+    }
+
+    int64_t encode(uint64_t time) {
+        int64_t interval = static_cast<int64_t>(time - _last);
+        int64_t dod = interval - _interval;
+        _last = time;
+        _interval = interval;
+        return dod;
+    }
+
+    uint64_t decode(int64_t dod) {
+        _interval += dod;
+        _last += static_cast<uint64_t>(_interval);
+        return _last;
+    }
+
+   private:
+    uint64_t _last = 0;
+    int64_t _interval = 0;
+};
+
+/// @brief Appends bits to a byte vector, least significant bit first
+class BitWriter {
+   public:
+    explicit BitWriter(std::vector<uint8_t>& out) : _out(out) {}
+
+    /// @brief Writes the low `bits` bits of value, at most 64
+    void write(uint64_t value, unsigned bits);
+
+   private:
+    std::vector<uint8_t>& _out;
+    unsigned _bit = 0;  // bits used in the last byte
+};
+
+/// @brief Reads bits written by a BitWriter
+class BitReader {
+   public:
+    BitReader(const uint8_t* in, size_t size) : _in(in), _size(size) {}
+
+    /// @brief Reads `bits` bits, at most 64. Past the end it reads zeros and sets overrun().
+    uint64_t read(unsigned bits);
+
+    bool overrun() const { return _overrun; }
+
+    /// @brief The bytes touched so far
+    size_t used() const { return (_position + 7) / 8; }
+
+   private:
+    const uint8_t* _in;
+    size_t _size;
+    size_t _position = 0;  // in bits
+    bool _overrun = false;
+};
+
+/// @brief Timestamps as zig-zag varints of their delta-of-delta, a byte each when periodic
+void encodeTimestamps(const uint64_t* values, size_t count, std::vector<uint8_t>& out);
+
+/// @return The number of bytes used, zero if there aren't `count` values in the input
+size_t decodeTimestamps(const uint8_t* in, size_t size, size_t count, uint64_t* values);
+
+/// @brief Integers as zig-zag deltas, bit-packed INTEGER_BLOCK at a time with the width of the
+/// largest delta in the block
+static constexpr size_t INTEGER_BLOCK = 128;
+void encodeIntegers(const int64_t* values, size_t count, std::vector<uint8_t>& out);
+
+/// @return The number of bytes used, zero if there aren't `count` values in the input
+size_t decodeIntegers(const uint8_t* in, size_t size, size_t count, int64_t* values);
+
+/// @brief Doubles XORed with the one before (Gorilla): a bit for a repeat, otherwise only the
+/// bits that differ, reusing the previous window of them when they fit in it
+void encodeFloats(const double* values, size_t count, std::vector<uint8_t>& out);
+
+/// @return The number of bytes used, zero if there aren't `count` values in the input
+size_t decodeFloats(const uint8_t* in, size_t size, size_t count, double* values);
+
+}  // namespace common
+
+#endif  // __TS_CODEC_H__
@@ -2,6 +2,7 @@
 #define __REMOTE_MAIN_H__
 
 #include <memory>
+#include <vector>
 #include <remote_debug.hpp>
 #include <resources.hpp>
 #include <tasks.hpp>
@@ -49,6 +50,17 @@ void loop() {
 void __setupTasks(can::TelemetryOptions options) {
     REMOTE_DEBUG_PRINTLN("Adding tasks!");
 
+    LogFileOptions fileOptions;
+    fileOptions.flushPeriodMs = options.logFlushPeriodMs;
+    fileOptions.flushBytes = options.logFlushBytes;
+    fileOptions.preallocateBytes = options.logPreallocateBytes;
+    Resources::instance().logger.setFileOptions(fileOptions);
+    Resources::instance().logger.setPacking(options.logPackBlockBytes);
+    Resources::instance().logger.setRotation(options.logRotateBytes,
+                                             options.logRotateMinutes * 60000u);
+    Resources::instance().logger.setCapturePeriod(options.logPeriodMs);
+    Resources::instance().logger.attach(Resources::drive());
+
     Resources::sched().addTask((TaskOptions){.name = "LOG",
                                              .intervalTime = options.logPeriodMs,
                                              .complexity = TaskComplexity::TC_HIGH,
@@ -71,23 +83,74 @@ void __setupTasks(can::TelemetryOptions options) {
                                TaskAction::make<CANTask>());
 }
 
+// Loads the compiled image of the config, as long as it was built from this exact config
+static Result<can::TelemetryOptions> __loadConfigImage(uint32_t sourceHash) {
+    FileGuard guard = Resources::file("/config.telemc", FILE_READ, false);
+    Option<fs::File> fileOpt = guard.file();
+    if (fileOpt.isNone()) {
+        return Result<can::TelemetryOptions>::errorResult("no config image");
+    }
+
+    fs::File file = fileOpt.value();
+    std::vector<uint8_t> image(file.size());
+    if (file.read(image.data(), image.size()) != image.size()) {
+        return Result<can::TelemetryOptions>::errorResult("failed to read config image");
+    }
+
+    return can::ConfigImage::load(image.data(), image.size(), sourceHash, Resources::drive());
+}
+
+// Saves the compiled image of a freshly built config, so the next boot can skip the parse
+static void __saveConfigImage(uint32_t sourceHash, const can::TelemetryOptions& options) {
+    std::vector<uint8_t> image =
+        can::ConfigImage::serialize(Resources::drive(), options, sourceHash);
+
+    FileGuard guard = Resources::file("/config.telemc", FILE_WRITE, true);
+    Option<fs::File> fileOpt = guard.file();
+    if (fileOpt.isNone() || fileOpt.value().write(image.data(), image.size()) != image.size()) {
+        REMOTE_DEBUG_PRINT_ERRORLN("Failed to write the config image");
+        return;
+    }
+    REMOTE_DEBUG_PRINTLN("Wrote %d byte config image", image.size());
+}
+
 Result<can::TelemetryOptions> __setupConfig() {
     REMOTE_DEBUG_PRINTLN("Setting up configuration!");
 
     uint32_t start = millis();
 
     FileGuard guard = Resources::file("/config.telem", FILE_READ, false);
-    SDTokenReader reader(guard);
-    can::Tokenizer tokenizer(reader);
-    can::TelemBuilder builder(tokenizer);
-
-    REMOTE_DEBUG_PRINTLN("Building...");
-    Result<can::TelemetryOptions> telemOptRes = builder.build(Resources::drive());
+    SDBlockSource source(guard);
+    uint32_t sourceHash = 0;
+    if (!can::ConfigImage::hashSource(source, &sourceHash)) {
+        return Result<can::TelemetryOptions>::errorResult("unable to read /config.telem");
+    }
 
-    if (telemOptRes.isError()) {
-        REMOTE_DEBUG_PRINTLN("%s", telemOptRes.error().c_str());
+    // hashing the text is far cheaper than parsing it, only parse when the image is unusable
+    Result<can::TelemetryOptions> telemOptRes = __loadConfigImage(sourceHash);
+    if (!telemOptRes.isError()) {
+        REMOTE_DEBUG_PRINTLN("Loaded configuration from image!");
     } else {
-        REMOTE_DEBUG_PRINTLN("Successfully configured!");
+        REMOTE_DEBUG_PRINTLN("Not using config image (%s)", telemOptRes.error().c_str());
+
+        SDTokenReader reader(guard);
+        can::Tokenizer tokenizer(reader);
+        can::TelemBuilder builder(tokenizer);
+
+        REMOTE_DEBUG_PRINTLN("Building...");
+        builder.plan(Resources::drive());
+        telemOptRes = builder.build(Resources::drive());
+        if (reader.failed()) {
+            // a bus built from part of the file isn't the configured one
+            telemOptRes = Result<can::TelemetryOptions>::errorResult("read error in /config.telem");
+        }
+
+        if (telemOptRes.isError()) {
+            REMOTE_DEBUG_PRINTLN("%s", telemOptRes.error().c_str());
+        } else {
+            REMOTE_DEBUG_PRINTLN("Successfully configured!");
+            __saveConfigImage(sourceHash, telemOptRes.value());
+        }
     }
 
     uint32_t time = millis() - start;
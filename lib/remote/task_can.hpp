@@ -20,6 +20,8 @@ class CANTask : public tasks::TaskAction {
     void run() {
         digitalWrite(HWPin::CAN_DATA_MCP_CS, LOW);
         Resources::drive().update();
+        Resources::drive().serviceTransmit(millis());
+        Resources::instance().logger.capture(Resources::drive(), millis());
         // Resources::data().update();
         digitalWrite(HWPin::CAN_DATA_MCP_CS, HIGH);
     }
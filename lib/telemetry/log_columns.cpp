@@ -0,0 +1,227 @@
+#include "log_columns.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <ts_codec.hpp>
+
+namespace remote {
+
+// raw integers past this don't all survive the trip through a double
+static constexpr double EXACT_INTEGER_LIMIT = 4503599627370496.0;  // 2^52
+
+static void __put(std::vector<uint8_t>& out, uint64_t value, std::size_t bytes) {
+    for (std::size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+static void __putDouble(std::vector<uint8_t>& out, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    __put(out, bits, 8);
+}
+
+static uint64_t __get(const uint8_t* in, std::size_t bytes) {
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+static double __getDouble(const uint8_t* in) {
+    uint64_t bits = __get(in, 8);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+template <typename T, typename Encode>
+void ColumnWriter::_add(ColumnType type, const std::string& name, const std::vector<T>& column,
+                        Encode encode, ColumnEncoding encoding, double factor, double offset) {
+    Column c{type, _plain ? CE_PLAIN : encoding, name, factor, offset, {}};
+    if (_plain) {
+        // the host is little-endian, like the format
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(column.data());
+        c.data.assign(bytes, bytes + column.size() * sizeof(T));
+    } else {
+        encode(c.data);
+    }
+    _rawBytes += column.size() * sizeof(T);
+    _encodedBytes += c.data.size();
+    _columns.push_back(std::move(c));
+}
+
+void ColumnWriter::times(const std::string& name, const std::vector<uint32_t>& column) {
+    std::vector<uint64_t> wide(column.begin(), column.end());
+    _add(CT_U32, name, column, [&](std::vector<uint8_t>& out) {
+        common::encodeTimestamps(wide.data(), wide.size(), out);
+    }, CE_TIMES);
+}
+
+void ColumnWriter::times(const std::string& name, const std::vector<uint64_t>& column) {
+    _add(CT_U64, name, column, [&](std::vector<uint8_t>& out) {
+        common::encodeTimestamps(column.data(), column.size(), out);
+    }, CE_TIMES);
+}
+
+void ColumnWriter::integers(const std::string& name, const std::vector<uint32_t>& column) {
+    std::vector<int64_t> wide(column.begin(), column.end());
+    _add(CT_U32, name, column, [&](std::vector<uint8_t>& out) {
+        common::encodeIntegers(wide.data(), wide.size(), out);
+    }, CE_INTEGERS);
+}
+
+void ColumnWriter::values(const std::string& name, const std::vector<double>& column) {
+    _add(CT_F64, name, column, [&](std::vector<uint8_t>& out) {
+        common::encodeFloats(column.data(), column.size(), out);
+    }, CE_VALUES);
+}
+
+bool ColumnWriter::scaled(const std::string& name, const std::vector<double>& column,
+                          double factor, double offset) {
+    // undo the scale, then check it gives back the very same bits the reader decoded
+    std::vector<int64_t> raw(column.size());
+    for (std::size_t i = 0; i < column.size(); ++i) {
+        double stored = factor != 0 ? (column[i] - offset) / factor : 0;
+        if (!(std::fabs(stored) < EXACT_INTEGER_LIMIT)) {
+            values(name, column);
+            return false;
+        }
+        raw[i] = std::llround(stored);
+        double back = static_cast<double>(raw[i]) * factor + offset;
+        if (std::memcmp(&back, &column[i], sizeof(back)) != 0) {
+            values(name, column);
+            return false;
+        }
+    }
+    _add(CT_I64, name, raw, [&](std::vector<uint8_t>& out) {
+        common::encodeIntegers(raw.data(), raw.size(), out);
+    }, CE_INTEGERS, factor, offset);
+    return true;
+}
+
+bool ColumnWriter::write(std::FILE* file, uint64_t rows) const {
+    std::vector<uint8_t> header(COLUMNS_MAGIC, COLUMNS_MAGIC + sizeof(COLUMNS_MAGIC));
+    __put(header, _columns.size(), 4);
+    __put(header, rows, 8);
+    for (const Column& column : _columns) {
+        __put(header, column.type, 1);
+        __put(header, column.encoding, 1);
+        __put(header, column.name.size(), 2);
+        header.insert(header.end(), column.name.begin(), column.name.end());
+        __putDouble(header, column.factor);
+        __putDouble(header, column.offset);
+        __put(header, column.data.size(), 8);
+    }
+    std::fwrite(header.data(), 1, header.size(), file);
+    for (const Column& column : _columns) {
+        std::fwrite(column.data.data(), 1, column.data.size(), file);
+    }
+    return std::ferror(file) == 0;
+}
+
+common::Result<uint64_t> ColumnReader::open(const uint8_t* data, std::size_t size) {
+    using Res = common::Result<uint64_t>;
+    _columns.clear();
+    std::size_t at = sizeof(COLUMNS_MAGIC) + 12;
+    if (size < at || std::memcmp(data, COLUMNS_MAGIC, sizeof(COLUMNS_MAGIC)) != 0) {
+        return Res::errorResult("not a column file");
+    }
+    uint32_t count = static_cast<uint32_t>(__get(data + sizeof(COLUMNS_MAGIC), 4));
+    _rows = __get(data + sizeof(COLUMNS_MAGIC) + 4, 8);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (size - at < 4) {
+            return Res::errorResult("column header cut short");
+        }
+        ColumnInfo column;
+        column.type = static_cast<ColumnType>(data[at]);
+        column.encoding = static_cast<ColumnEncoding>(data[at + 1]);
+        std::size_t nameSize = __get(data + at + 2, 2);
+        at += 4;
+        if (size - at < nameSize + 24) {
+            return Res::errorResult("column header cut short");
+        }
+        column.name.assign(reinterpret_cast<const char*>(data + at), nameSize);
+        at += nameSize;
+        column.factor = __getDouble(data + at);
+        column.offset = __getDouble(data + at + 8);
+        column.size = __get(data + at + 16, 8);
+        at += 24;
+        _columns.push_back(column);
+    }
+
+    // the data follows the headers in the same order
+    for (ColumnInfo& column : _columns) {
+        if (size - at < column.size) {
+            return Res::errorResult("column " + column.name + " cut short");
+        }
+        column.data = data + at;
+        at += column.size;
+    }
+    return Res::ok(_rows);
+}
+
+bool ColumnReader::integers(std::size_t index, std::vector<int64_t>& out) const {
+    const ColumnInfo& column = _columns[index];
+    out.assign(_rows, 0);
+    if (_rows == 0 || column.type == CT_F64) {
+        return column.type != CT_F64;
+    }
+
+    if (column.encoding == CE_PLAIN) {
+        std::size_t width = column.type == CT_U32 ? 4 : 8;
+        if (column.size != _rows * width) {
+            return false;
+        }
+        for (std::size_t i = 0; i < _rows; ++i) {
+            out[i] = static_cast<int64_t>(__get(column.data + i * width, width));
+        }
+        return true;
+    }
+    if (column.encoding == CE_TIMES) {
+        std::vector<uint64_t> times(_rows);
+        if (common::decodeTimestamps(column.data, column.size, _rows, times.data()) == 0) {
+            return false;
+        }
+        out.assign(times.begin(), times.end());
+        return true;
+    }
+    return column.encoding == CE_INTEGERS &&
+           common::decodeIntegers(column.data, column.size, _rows, out.data()) != 0;
+}
+
+bool ColumnReader::values(std::size_t index, std::vector<double>& out) const {
+    const ColumnInfo& column = _columns[index];
+    if (column.type != CT_F64) {
+        std::vector<int64_t> stored;
+        if (!integers(index, stored)) {
+            return false;
+        }
+        out.resize(stored.size());
+        for (std::size_t i = 0; i < stored.size(); ++i) {
+            // the same sum the log reader decoded it with
+            out[i] = static_cast<double>(stored[i]) * column.factor + column.offset;
+        }
+        return true;
+    }
+
+    out.assign(_rows, 0);
+    if (_rows == 0) {
+        return true;
+    }
+    if (column.encoding == CE_PLAIN) {
+        if (column.size != _rows * 8) {
+            return false;
+        }
+        for (std::size_t i = 0; i < _rows; ++i) {
+            out[i] = __getDouble(column.data + i * 8);
+        }
+        return true;
+    }
+    return column.encoding == CE_VALUES &&
+           common::decodeFloats(column.data, column.size, _rows, out.data()) != 0;
+}
+
+}  // namespace remote
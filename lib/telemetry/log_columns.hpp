@@ -0,0 +1,117 @@
+#ifndef __LOG_COLUMNS_H__
+#define __LOG_COLUMNS_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <result.hpp>
+#include <string>
+#include <vector>
+
+namespace remote {
+
+/// @brief The layout of a .col file, the columnar export of a log, all little-endian:
+///   magic    COLUMNS_MAGIC
+///   counts   column count u32, row count u64
+///   columns  per column: type u8, encoding u8, name length u16, name, factor f64, offset f64,
+///            data size u64
+///   data     every column's data, one whole column after the other
+///
+/// A column's values are its stored ones times its factor plus its offset, 1 and 0 for anything
+/// but signals. Signals are stored as their raw integers with the signal's scale wherever that
+/// gives back exactly what was decoded, which is every signal the bus can describe, so they pack
+/// as integers and read back bit for bit. Columns are encoded with the codecs of
+/// common/ts_codec.hpp, or stored as they are with CE_PLAIN.
+static constexpr uint8_t COLUMNS_MAGIC[] = {'N', 'F', 'R', 'C', 'O', 'L', '3', '\n'};
+
+enum ColumnType : uint8_t { CT_U32 = 1, CT_U64 = 2, CT_F64 = 3, CT_I64 = 4 };
+
+enum ColumnEncoding : uint8_t {
+    CE_PLAIN = 0,
+    CE_TIMES = 1,     // delta-of-delta varints, common::encodeTimestamps()
+    CE_INTEGERS = 2,  // bit-packed deltas, common::encodeIntegers()
+    CE_VALUES = 3     // XORed doubles, common::encodeFloats()
+};
+
+/// @brief Encodes the columns of a table, then writes them out buffered by stdio
+class ColumnWriter {
+   public:
+    /// @param plain Store every column as it is instead of encoding it
+    explicit ColumnWriter(bool plain = false) : _plain(plain) {}
+
+    void times(const std::string& name, const std::vector<uint32_t>& column);
+    void times(const std::string& name, const std::vector<uint64_t>& column);
+    void integers(const std::string& name, const std::vector<uint32_t>& column);
+    void values(const std::string& name, const std::vector<double>& column);
+
+    /// @brief A signal's decoded values, stored as raw integers with its scale when they all come
+    /// back exactly from one, else as doubles
+    /// @return true if it went in as integers
+    bool scaled(const std::string& name, const std::vector<double>& column, double factor,
+                double offset);
+
+    /// @brief Writes the header and every column added
+    /// @return false on a write error
+    bool write(std::FILE* file, uint64_t rows) const;
+
+    uint64_t rawBytes() const { return _rawBytes; }
+    uint64_t encodedBytes() const { return _encodedBytes; }
+
+   private:
+    struct Column {
+        ColumnType type;
+        ColumnEncoding encoding;
+        std::string name;
+        double factor;
+        double offset;
+        std::vector<uint8_t> data;
+    };
+
+    bool _plain;
+    std::vector<Column> _columns;
+    uint64_t _rawBytes = 0;
+    uint64_t _encodedBytes = 0;
+
+    template <typename T, typename Encode>
+    void _add(ColumnType type, const std::string& name, const std::vector<T>& column,
+              Encode encode, ColumnEncoding encoding, double factor = 1, double offset = 0);
+};
+
+/// @brief A column of a .col file, pointing into the file's bytes
+struct ColumnInfo {
+    ColumnType type;
+    ColumnEncoding encoding;
+    std::string name;
+    double factor;
+    double offset;
+    const uint8_t* data;
+    std::size_t size;
+};
+
+/// @brief Reads back what a ColumnWriter wrote
+class ColumnReader {
+   public:
+    /// @brief Reads the header
+    /// @param data The whole file, kept alive by the caller while the reader is used
+    /// @param size The size of the file
+    /// @return The number of rows, or why the file can't be read
+    common::Result<uint64_t> open(const uint8_t* data, std::size_t size);
+
+    const std::vector<ColumnInfo>& columns() const { return _columns; }
+
+    /// @brief The stored values of a column, before its scale, for any column but CT_F64
+    /// @return false if the column is damaged or holds doubles
+    bool integers(std::size_t index, std::vector<int64_t>& out) const;
+
+    /// @brief The values of any column, with its scale applied
+    /// @return false if the column is damaged
+    bool values(std::size_t index, std::vector<double>& out) const;
+
+   private:
+    std::vector<ColumnInfo> _columns;
+    uint64_t _rows = 0;
+};
+
+}  // namespace remote
+
+#endif  // __LOG_COLUMNS_H__
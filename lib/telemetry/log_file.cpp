@@ -0,0 +1,219 @@
+#include "log_file.hpp"
+
+#include <cstring>
+
+#include "crc.hpp"
+#include "telemetry_debug.hpp"
+
+namespace remote {
+
+bool LogFile::open(const char* path, uint32_t nowMs) {
+    close();
+
+    _path = path;
+    _bytesWritten = 0;
+    _pendingBytes = 0;
+    _allocated = 0;
+    _lastFlushMs = nowMs;
+
+    if (!_storage.open(path)) {
+        TELEM_DEBUG_PRINT_ERRORLN("Unable to open log file %s", path);
+        return false;
+    }
+    _start = _storage.size();
+    TELEM_DEBUG_PRINTLN("Opened log file %s", path);
+
+    if (_options.preallocateBytes > 0) {
+        // the marker goes down first, so even a crash while allocating gets cut back at boot
+        _marked = _mark(_start);
+        _preallocate(_start + _options.preallocateBytes);
+    }
+    return true;
+}
+
+bool LogFile::write(const uint8_t* data, std::size_t size, uint32_t nowMs) {
+    ++_stats.writes;
+
+    // grow in one go before the writes reach the end, rather than a cluster at a time
+    std::size_t end = _start + _bytesWritten + size;
+    if (_allocated > 0 && end > _allocated) {
+        _preallocate(end + _options.preallocateBytes);
+    }
+
+    std::size_t written = _storage.isOpen() ? _storage.write(data, size) : 0;
+    _bytesWritten += written;
+    _pendingBytes += written;
+
+    if (written != size) {
+        // the rest goes through a fresh handle, which appends right after what did make it
+        TELEM_DEBUG_PRINT_ERRORLN("Log write failed after %d of %d bytes, reopening",
+                                  static_cast<int>(written), static_cast<int>(size));
+        std::size_t rest = _reopen() ? _storage.write(data + written, size - written) : 0;
+        _bytesWritten += rest;
+        _pendingBytes += rest;
+        if (written + rest != size) {
+            ++_stats.errors;
+            return false;
+        }
+    }
+
+    if (_pendingBytes >= _options.flushBytes || nowMs - _lastFlushMs >= _options.flushPeriodMs) {
+        return flush(nowMs);
+    }
+    return true;
+}
+
+bool LogFile::flush(uint32_t nowMs) {
+    _lastFlushMs = nowMs;
+    if (_pendingBytes == 0 || !_storage.isOpen()) {
+        return true;
+    }
+
+    _pendingBytes = 0;
+    ++_stats.flushes;
+    if (!_storage.flush()) {
+        return false;
+    }
+    // only once the data is down, so the marker never claims more than the card holds. It is
+    // rewritten in place, the handle was opened with the file.
+    if (_marked && !_mark(_start + _bytesWritten)) {
+        TELEM_DEBUG_PRINT_ERRORLN("Unable to update the session marker for %s", _path.c_str());
+    }
+    return true;
+}
+
+void LogFile::close() {
+    if (!_storage.isOpen()) {
+        return;
+    }
+    if (_allocated > 0 && !_storage.truncate(_start + _bytesWritten)) {
+        // left to recover() at the next boot, the marker stays
+        TELEM_DEBUG_PRINT_ERRORLN("Unable to cut back log file %s", _path.c_str());
+        _marked = false;
+    }
+    // closing commits everything, the same as a flush
+    _pendingBytes = 0;
+    _allocated = 0;
+    _storage.close();
+
+    if (_marked) {
+        _storage.removeFile(SESSION_MARKER);
+        _marked = false;
+    }
+}
+
+bool LogFile::recover(LogStorage& storage) {
+    uint8_t marker[MARKER_SIZE];
+    std::size_t length = storage.readFile(SESSION_MARKER, marker, sizeof(marker));
+    if (length == 0) {
+        return false;
+    }
+
+    uint32_t committed = 0;
+    uint16_t crc = 0;
+    std::memcpy(&committed, marker, 4);
+    std::memcpy(&crc, marker + 4, 2);
+    if (length != MARKER_SIZE || marker[MARKER_SIZE - 1] != '\0' ||
+        crc != common::crc16(marker + MARKER_HEADER_SIZE, MARKER_PATH_SIZE,
+                             common::crc16(marker, 4))) {
+        // torn by a power cut, there is no telling which file it was or where its data ends
+        TELEM_DEBUG_PRINT_ERRORLN("Session marker is damaged, leaving its file as it is");
+        storage.removeFile(SESSION_MARKER);
+        return false;
+    }
+    const char* path = reinterpret_cast<const char*>(marker + MARKER_HEADER_SIZE);
+
+    bool ok = storage.open(path);
+    std::size_t end = storage.size() < committed ? storage.size() : committed;
+    ok = ok && storage.truncate(end);
+    storage.close();
+    storage.removeFile(SESSION_MARKER);
+
+    if (!ok) {
+        TELEM_DEBUG_PRINT_ERRORLN("Unable to recover log file %s", path);
+        return false;
+    }
+    TELEM_DEBUG_PRINTLN("Recovered log file %s, %d bytes", path, static_cast<int>(end));
+    return true;
+}
+
+bool LogFile::_reopen() {
+    ++_stats.reopens;
+    // not close(), the preallocated space and the marker stay for the rest of the session
+    _pendingBytes = 0;
+    _storage.close();
+    return _storage.open(_path.c_str()) && _storage.seek(_start + _bytesWritten);
+}
+
+bool LogFile::_mark(std::size_t committed) {
+    if (_path.size() >= MARKER_PATH_SIZE) {
+        TELEM_DEBUG_PRINT_ERRORLN("Log path %s is too long for the session marker", _path.c_str());
+        return false;
+    }
+    uint8_t marker[MARKER_SIZE] = {};
+    uint32_t size = static_cast<uint32_t>(committed);
+    std::memcpy(marker, &size, 4);
+    std::memcpy(marker + MARKER_HEADER_SIZE, _path.data(), _path.size());
+    uint16_t crc =
+        common::crc16(marker + MARKER_HEADER_SIZE, MARKER_PATH_SIZE, common::crc16(marker, 4));
+    std::memcpy(marker + 4, &crc, 2);
+    return _storage.rewriteFile(SESSION_MARKER, marker, sizeof(marker));
+}
+
+bool LogFile::_preallocate(std::size_t size) {
+    if (!_storage.preallocate(size)) {
+        // writes still grow the file as they go, just slower
+        TELEM_DEBUG_PRINT_ERRORLN("Unable to preallocate %d bytes for %s", static_cast<int>(size),
+                                  _path.c_str());
+        _allocated = 0;
+        return false;
+    }
+    _allocated = size;
+    return true;
+}
+
+std::string LogSessionCounter::next(const std::string& dir, const std::function<uint32_t()>& scan) {
+    std::string counter = counterPath(dir);
+    uint8_t bytes[COUNTER_SIZE];
+    uint32_t number = 0;
+    bool known = false;
+    if (_storage.readFile(counter.c_str(), bytes, sizeof(bytes)) == COUNTER_SIZE) {
+        uint32_t magic = 0;
+        uint16_t crc = 0;
+        std::memcpy(&magic, bytes, 4);
+        std::memcpy(&number, bytes + 4, 4);
+        std::memcpy(&crc, bytes + 8, 2);
+        known = magic == COUNTER_MAGIC && crc == common::crc16(bytes, 8);
+    }
+    if (!known) {
+        TELEM_DEBUG_PRINTLN("No session counter in %s, counting its files", dir.c_str());
+        number = scan();
+    }
+
+    // a counter that fell behind, say from a card written by an older build, still never
+    // appends to an old log
+    while (_taken(logPath(dir, number))) {
+        ++number;
+    }
+
+    uint32_t following = number + 1;
+    std::memcpy(bytes, &COUNTER_MAGIC, 4);
+    std::memcpy(bytes + 4, &following, 4);
+    uint16_t crc = common::crc16(bytes, 8);
+    std::memcpy(bytes + 8, &crc, 2);
+    if (!_storage.writeFile(counter.c_str(), bytes, sizeof(bytes))) {
+        TELEM_DEBUG_PRINT_ERRORLN("Unable to update the session counter in %s", dir.c_str());
+    }
+    return logPath(dir, number);
+}
+
+std::string LogSessionCounter::logPath(const std::string& dir, uint32_t number) {
+    return dir + "/log_" + std::to_string(number) + ".daq";
+}
+
+bool LogSessionCounter::_taken(const std::string& path) {
+    uint8_t byte;
+    return _storage.readFile(path.c_str(), &byte, 1) != 0;
+}
+
+}  // namespace remote
@@ -0,0 +1,168 @@
+#ifndef __LOG_FILE_H__
+#define __LOG_FILE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "log_storage.hpp"
+
+namespace remote {
+
+/// @brief When an open log file commits what has been written to it
+struct LogFileOptions {
+    uint32_t flushPeriodMs = 1000;  // flush at least this often while data is pending
+    uint32_t flushBytes = 16384;    // or as soon as this much is pending, whichever comes first
+    uint32_t preallocateBytes = 0;  // space allocated ahead of the writes at a time, 0 for none
+};
+
+/// @brief Counters describing how a log file has been written
+struct LogFileStats {
+    uint32_t writes = 0;   // calls to write()
+    uint32_t flushes = 0;  // flushes that reached the storage
+    uint32_t reopens = 0;  // times the file was closed and reopened after an error
+    uint32_t errors = 0;   // writes that failed even after reopening
+};
+
+/// @brief A log file that stays open for the whole session. Opening, seeking to the end and
+/// closing a FAT file all cost metadata I/O, so that only happens when the file is first opened,
+/// on rotation, or to recover from an error. Writes are committed on a period or once enough
+/// bytes are pending.
+///
+/// With preallocation the file is grown well ahead of the writes, so the FAT allocates clusters in
+/// one pass instead of stalling on the write that crosses into each new one. The file is cut back
+/// to what was written on close. A session that never got to close leaves a marker behind naming
+/// the file and how much of it was committed, and recover() cuts it back on the next boot.
+///
+/// The marker is the committed size u32, a CRC-16 (common::crc16()) of the size and the path, then
+/// the path padded with zeros to MARKER_PATH_SIZE, little-endian. It keeps the same size, so every
+/// flush that reaches the storage rewrites it in place through a handle kept open, which costs a
+/// sector write rather than opening, truncating and closing it.
+class LogFile {
+   public:
+    /// @brief Exists while a preallocated file is open, see above
+    static constexpr const char* SESSION_MARKER = "/session.open";
+    static constexpr std::size_t MARKER_HEADER_SIZE = 6;
+    static constexpr std::size_t MARKER_PATH_SIZE = 128;  // the path and at least one zero
+    static constexpr std::size_t MARKER_SIZE = MARKER_HEADER_SIZE + MARKER_PATH_SIZE;
+
+    explicit LogFile(LogStorage& storage, LogFileOptions options = LogFileOptions())
+        : _storage(storage), _options(options) {}
+
+    ~LogFile() { close(); }
+
+    LogFile(const LogFile&) = delete;
+    LogFile& operator=(const LogFile&) = delete;
+
+    void setOptions(LogFileOptions options) { _options = options; }
+
+    /// @brief Opens a file for the session, closing the current one first
+    /// @param path The path of the file, appended to if it exists
+    /// @param nowMs The current time, in milliseconds
+    /// @return true on success
+    bool open(const char* path, uint32_t nowMs);
+
+    /// @brief Appends to the file, flushing if one is due. A failed write closes and reopens the
+    /// file once and retries, so a transient card error costs one record at most.
+    /// @param data The bytes to append
+    /// @param size The number of bytes
+    /// @param nowMs The current time, in milliseconds
+    /// @return true if every byte was written
+    bool write(const uint8_t* data, std::size_t size, uint32_t nowMs);
+
+    /// @brief Commits anything pending
+    /// @param nowMs The current time, in milliseconds
+    /// @return true on success, or if there was nothing to flush
+    bool flush(uint32_t nowMs);
+
+    /// @brief Closes the current file and continues in a new one
+    /// @param path The path of the new file
+    /// @param nowMs The current time, in milliseconds
+    /// @return true on success
+    bool rotate(const char* path, uint32_t nowMs) { return open(path, nowMs); }
+
+    /// @brief Flushes the file, cuts off any preallocated space past what was written and closes it
+    void close();
+
+    /// @brief Cuts back the file a session left preallocated when it ended without closing it, to
+    /// be called at boot before a new session opens. The file is cut at the size its marker last
+    /// committed, preallocated space holds whatever the card had there before and can't be told
+    /// apart from data. Anything written after the last flush is dropped with it.
+    /// @param storage The storage, with no file open
+    /// @return true if a file was recovered, false if there was nothing to do or it failed
+    static bool recover(LogStorage& storage);
+
+    bool isOpen() const { return _storage.isOpen(); }
+    const std::string& path() const { return _path; }
+
+    /// @brief Bytes written since the file was opened
+    std::size_t bytesWritten() const { return _bytesWritten; }
+
+    /// @brief How far into the file space is allocated, 0 without preallocation
+    std::size_t allocatedBytes() const { return _allocated; }
+
+    /// @brief Bytes written but not flushed yet
+    std::size_t pendingBytes() const { return _pendingBytes; }
+
+    LogFileStats stats() const { return _stats; }
+
+   private:
+    LogStorage& _storage;
+    LogFileOptions _options;
+    std::string _path;
+
+    std::size_t _start = 0;  // the size of the file when it was opened
+    std::size_t _bytesWritten = 0;
+    std::size_t _pendingBytes = 0;
+    std::size_t _allocated = 0;
+    bool _marked = false;  // whether this session wrote SESSION_MARKER
+    uint32_t _lastFlushMs = 0;
+    LogFileStats _stats;
+
+    bool _reopen();
+    bool _preallocate(std::size_t size);
+
+    /// @brief Writes SESSION_MARKER for the open file
+    /// @param committed The size of the file that has reached the storage
+    bool _mark(std::size_t committed);
+};
+
+/// @brief Numbers the log files of a directory from a small counter file kept next to them, so
+/// picking the next name costs a read and a write instead of opening every file in the directory.
+/// Only a directory without a readable counter, one from before it existed or one whose counter
+/// was torn by a power cut, falls back to counting its files.
+///
+/// The counter is COUNTER_MAGIC, the next number u32 and a CRC-16 (common::crc16()) of the two,
+/// little-endian.
+class LogSessionCounter {
+   public:
+    static constexpr const char* COUNTER_NAME = "sessions";
+    static constexpr uint32_t COUNTER_MAGIC = 0x5352464E;  // "NFRS" on the card
+    static constexpr std::size_t COUNTER_SIZE = 10;
+
+    explicit LogSessionCounter(LogStorage& storage) : _storage(storage) {}
+
+    /// @brief Claims the next log file of a directory. The counter moves on before the file is
+    /// created, so a session that dies early never hands its number out twice.
+    /// @param dir The directory, without a trailing slash
+    /// @param scan Counts the files in dir, only called when there is no usable counter
+    /// @return The path of the file, dir/log_<n>.daq
+    std::string next(const std::string& dir, const std::function<uint32_t()>& scan);
+
+    /// @brief The path of the counter of a directory
+    static std::string counterPath(const std::string& dir) { return dir + "/" + COUNTER_NAME; }
+
+    /// @brief The path of a directory's log file with the given number
+    static std::string logPath(const std::string& dir, uint32_t number);
+
+   private:
+    LogStorage& _storage;
+
+    /// @brief Whether a file is there, and not empty
+    bool _taken(const std::string& path);
+};
+
+}  // namespace remote
+
+#endif  // __LOG_FILE_H__
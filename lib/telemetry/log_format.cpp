@@ -0,0 +1,439 @@
+#include "log_format.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+
+#include "crc.hpp"
+
+namespace remote {
+
+static void __putLE(uint8_t* out, uint64_t value, std::size_t bytes) {
+    for (std::size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+static uint64_t __getLE(const uint8_t* in, std::size_t bytes) {
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+static void __append(std::vector<uint8_t>& out, uint32_t value) {
+    uint8_t bytes[4];
+    __putLE(bytes, value, 4);
+    out.insert(out.end(), bytes, bytes + 4);
+}
+
+std::size_t frameRecord(uint8_t* frame, std::size_t bodySize) {
+    // the length is 16 bits, writers check their records fit before they start logging
+    assert(bodySize <= LOG_MAX_BODY_SIZE);
+    frame[0] = LOG_SYNC[0];
+    frame[1] = LOG_SYNC[1];
+    __putLE(frame + 2, bodySize, 2);
+    uint16_t crc = common::crc16(frame + 2, 2 + bodySize);
+    __putLE(frame + LOG_FRAME_HEADER_SIZE + bodySize, crc, 2);
+    return LOG_FRAME_OVERHEAD + bodySize;
+}
+
+void frameRecord(std::vector<uint8_t>& record) {
+    std::size_t bodySize = record.size();
+    record.insert(record.begin(), LOG_FRAME_HEADER_SIZE, 0);
+    record.resize(record.size() + 2);
+    frameRecord(record.data(), bodySize);
+}
+
+LogFrameStatus readFrame(const uint8_t* in, std::size_t size, LogFrame* frame) {
+    for (std::size_t i = 0; i < sizeof(LOG_SYNC) && i < size; ++i) {
+        if (in[i] != LOG_SYNC[i]) {
+            return LFS_CORRUPT;
+        }
+    }
+    if (size < LOG_FRAME_HEADER_SIZE) {
+        return LFS_TRUNCATED;
+    }
+    std::size_t bodySize = __getLE(in + 2, 2);
+    if (size < LOG_FRAME_OVERHEAD + bodySize) {
+        return LFS_TRUNCATED;
+    }
+    uint16_t crc = static_cast<uint16_t>(__getLE(in + LOG_FRAME_HEADER_SIZE + bodySize, 2));
+    if (crc != common::crc16(in + 2, 2 + bodySize)) {
+        return LFS_CORRUPT;
+    }
+    frame->body = in + LOG_FRAME_HEADER_SIZE;
+    frame->size = bodySize;
+    frame->used = LOG_FRAME_OVERHEAD + bodySize;
+    return LFS_OK;
+}
+
+std::size_t findSync(const uint8_t* in, std::size_t size) {
+    for (std::size_t i = 0; i + 1 < size; ++i) {
+        if (in[i] == LOG_SYNC[0] && in[i + 1] == LOG_SYNC[1]) {
+            return i;
+        }
+    }
+    return size;
+}
+
+std::size_t packRecord(common::LZCompressor& lz, const uint8_t* data, std::size_t size,
+                       uint64_t offset, uint8_t* out) {
+    uint8_t* body = out + LOG_FRAME_HEADER_SIZE;
+    body[0] = LRT_PACKED;
+    __putLE(body + 2, offset, 8);
+    __putLE(body + 10, size, 2);
+
+    uint8_t* packed = body + LOG_PACK_HEADER_SIZE;
+    std::size_t packedSize = lz.compress(data, size, packed, common::LZCompressor::bound(size));
+    if (packedSize > 0 && packedSize < size) {
+        body[1] = LPC_LZ;
+    } else {
+        body[1] = LPC_STORED;
+        std::memcpy(packed, data, size);
+        packedSize = size;
+    }
+    return frameRecord(out, LOG_PACK_HEADER_SIZE + packedSize);
+}
+
+bool readPacked(const uint8_t* body, std::size_t size, LogPacked* packed) {
+    if (size < LOG_PACK_HEADER_SIZE || body[0] != LRT_PACKED ||
+        (body[1] != LPC_STORED && body[1] != LPC_LZ)) {
+        return false;
+    }
+    packed->codec = static_cast<LogPackCodec>(body[1]);
+    packed->offset = __getLE(body + 2, 8);
+    packed->size = __getLE(body + 10, 2);
+    packed->data = body + LOG_PACK_HEADER_SIZE;
+    packed->dataSize = size - LOG_PACK_HEADER_SIZE;
+    return packed->codec == LPC_LZ || packed->dataSize == packed->size;
+}
+
+bool unpack(const LogPacked& packed, uint8_t* out) {
+    if (packed.codec == LPC_STORED) {
+        std::memcpy(out, packed.data, packed.size);
+        return true;
+    }
+    return common::lzDecompress(packed.data, packed.dataSize, out, packed.size) == packed.size;
+}
+
+std::vector<SnapshotSlot> snapshotLayout(const can::CANBus& bus) {
+    std::vector<const can::CANMessage*> messages;
+    messages.reserve(bus.getMessages().size());
+    for (const auto& entry : bus.getMessages()) {
+        messages.push_back(entry.second);
+    }
+    std::sort(messages.begin(), messages.end(),
+              [](const can::CANMessage* a, const can::CANMessage* b) { return a->index < b->index; });
+
+    std::vector<SnapshotSlot> slots;
+    slots.reserve(messages.size());
+    for (const can::CANMessage* message : messages) {
+        slots.push_back({message->bufferHandle.offset / 8, message->length});
+    }
+    return slots;
+}
+
+LogRecordType SnapshotEncoder::encode(can::CANBus& bus, uint32_t timeMs, uint32_t unixTime,
+                                      std::vector<uint8_t>& out) {
+    if (_slots.empty()) {
+        _slots = snapshotLayout(bus);
+        forceKeyframe();
+    }
+
+    std::lock_guard<std::mutex> lk(bus.bufMutex());
+    std::size_t size;
+    const uint8_t* buffer = bus.dataBuffer(&size);
+    std::size_t count;
+    const uint64_t* stamps = bus.rxTimestamps(&count);
+
+    bool keyframe = _sinceKeyframe >= _keyframeInterval || _previous.size() != size;
+    LogRecordType type = keyframe ? LRT_SNAPSHOT : LRT_DELTA;
+
+    out.clear();
+    out.push_back(type);
+
+    if (keyframe) {
+        __append(out, timeMs);
+        __append(out, unixTime);
+        out.insert(out.end(), buffer, buffer + size);
+        _stamps.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            __append(out, static_cast<uint32_t>(stamps[i]));
+            _stamps[i].reset(static_cast<uint32_t>(stamps[i]));
+        }
+        _previous.assign(buffer, buffer + size);
+        _time.reset(timeMs);
+        _unixTime = unixTime;
+        _sinceKeyframe = 1;
+        return type;
+    }
+
+    // at a steady log period both come down to a byte
+    common::putVarint(out, common::zigzag(_time.encode(timeMs)));
+    common::putVarint(out, common::zigzag(static_cast<int32_t>(unixTime - _unixTime)));
+    _unixTime = unixTime;
+
+    std::size_t bitmap = out.size();
+    out.resize(out.size() + (_slots.size() + 7) / 8, 0);
+    for (std::size_t i = 0; i < _slots.size(); ++i) {
+        const SnapshotSlot& slot = _slots[i];
+        const uint8_t* now = buffer + slot.byteOffset;
+        uint8_t* before = _previous.data() + slot.byteOffset;
+        if (std::memcmp(now, before, slot.length) == 0) {
+            continue;
+        }
+        out[bitmap + i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        out.insert(out.end(), now, now + slot.length);
+        common::putVarint(out, common::zigzag(_stamps[i].encode(static_cast<uint32_t>(stamps[i]))));
+        std::memcpy(before, now, slot.length);
+    }
+    ++_sinceKeyframe;
+    return type;
+}
+
+std::size_t SnapshotEncoder::maxRecordSize(const can::CANBus& bus) {
+    std::size_t size;
+    bus.dataBuffer(&size);
+    std::size_t count = bus.getMessages().size();
+
+    // a delta with every message changed spends a whole varint on each stamp
+    std::size_t full = 1 + 8 + size + 4 * count;
+    std::size_t delta = 1 + 2 * common::VARINT_MAX_SIZE + (count + 7) / 8 + size +
+                        count * common::VARINT_MAX_SIZE;
+    return std::max(full, delta);
+}
+
+SnapshotDecoder::SnapshotDecoder(std::vector<SnapshotSlot> slots, std::size_t bufferSize)
+    : _slots(std::move(slots)) {
+    _snapshot.buffer.resize(bufferSize);
+    _snapshot.stamps.resize(_slots.size());
+    _stamps.resize(_slots.size());
+    _changes.reserve(_slots.size());
+}
+
+std::size_t SnapshotDecoder::decode(const uint8_t* in, std::size_t size) {
+    const std::size_t HEADER = 9;
+    if (size < HEADER || (in[0] != LRT_SNAPSHOT && in[0] != LRT_DELTA)) {
+        return 0;
+    }
+
+    if (in[0] == LRT_SNAPSHOT) {
+        std::size_t bufferSize = _snapshot.buffer.size();
+        std::size_t total = HEADER + bufferSize + 4 * _slots.size();
+        if (size < total) {
+            return 0;
+        }
+        std::memcpy(_snapshot.buffer.data(), in + HEADER, bufferSize);
+        const uint8_t* stamps = in + HEADER + bufferSize;
+        for (std::size_t i = 0; i < _slots.size(); ++i) {
+            _snapshot.stamps[i] = static_cast<uint32_t>(__getLE(stamps + 4 * i, 4));
+            _stamps[i].reset(_snapshot.stamps[i]);
+        }
+        _snapshot.timeMs = static_cast<uint32_t>(__getLE(in + 1, 4));
+        _snapshot.unixTime = static_cast<uint32_t>(__getLE(in + 5, 4));
+        _time.reset(_snapshot.timeMs);
+        _synced = true;
+        return total;
+    }
+
+    if (!_synced) {
+        return 0;
+    }
+
+    // check the whole record is there before applying any of it
+    uint64_t timeDod = 0;
+    uint64_t unixDelta = 0;
+    std::size_t total = 1;
+    std::size_t used = common::getVarint(in + total, size - total, &timeDod);
+    total += used;
+    if (used == 0 || (used = common::getVarint(in + total, size - total, &unixDelta)) == 0) {
+        return 0;
+    }
+    total += used;
+    std::size_t bitmapSize = (_slots.size() + 7) / 8;
+    if (size < total + bitmapSize) {
+        return 0;
+    }
+    const uint8_t* bitmap = in + total;
+    total += bitmapSize;
+    _changes.clear();
+    for (std::size_t i = 0; i < _slots.size(); ++i) {
+        if (!(bitmap[i / 8] & (1u << (i % 8)))) {
+            continue;
+        }
+        Change change{i, total, 0};
+        total += _slots[i].length;
+        if (total > size ||
+            (used = common::getVarint(in + total, size - total, &change.stampDod)) == 0) {
+            return 0;
+        }
+        total += used;
+        _changes.push_back(change);
+    }
+
+    for (const Change& change : _changes) {
+        const SnapshotSlot& slot = _slots[change.slot];
+        std::memcpy(_snapshot.buffer.data() + slot.byteOffset, in + change.at, slot.length);
+        _snapshot.stamps[change.slot] = static_cast<uint32_t>(
+            _stamps[change.slot].decode(common::unzigzag(change.stampDod)));
+    }
+    _snapshot.timeMs = static_cast<uint32_t>(_time.decode(common::unzigzag(timeDod)));
+    _snapshot.unixTime += static_cast<uint32_t>(common::unzigzag(unixDelta));
+    return total;
+}
+
+std::size_t EventEncoder::encode(const can::RawCANMessage& frame, uint8_t* out) {
+    std::size_t size = 0;
+    uint64_t delta = frame.timestampUs - _lastUs;
+    if (!_hasBase || frame.timestampUs < _lastUs || delta > UINT16_MAX) {
+        out[size++] = LRT_EVENT_TIME;
+        __putLE(out + size, frame.timestampUs, 8);
+        size += 8;
+        delta = 0;
+        _hasBase = true;
+    }
+    _lastUs = frame.timestampUs;
+
+    uint8_t length = frame.length < can::CANFD_MAX_DATA_LENGTH ? frame.length
+                                                               : can::CANFD_MAX_DATA_LENGTH;
+    out[size++] = LRT_EVENT;
+    __putLE(out + size, delta, 2);
+    __putLE(out + size + 2, frame.id, 2);
+    out[size + 4] = length;
+    size += 5;
+    std::memcpy(out + size, frame.data, length);
+    return size + length;
+}
+
+std::size_t EventDecoder::decode(const uint8_t* in, std::size_t size, LogEvent* event) {
+    std::size_t used = 0;
+    if (size > 0 && in[0] == LRT_EVENT_TIME) {
+        if (size < EventEncoder::TIME_RECORD_SIZE) {
+            return 0;
+        }
+        _lastUs = __getLE(in + 1, 8);
+        _hasBase = true;
+        used = EventEncoder::TIME_RECORD_SIZE;
+    }
+
+    if (size - used < EventEncoder::EVENT_HEADER_SIZE || in[used] != LRT_EVENT || !_hasBase) {
+        return 0;
+    }
+    const uint8_t* header = in + used + 1;
+    uint8_t length = header[4];
+    if (length > can::CANFD_MAX_DATA_LENGTH ||
+        size - used < EventEncoder::EVENT_HEADER_SIZE + length) {
+        return 0;
+    }
+
+    _lastUs += __getLE(header, 2);
+    event->timestampUs = _lastUs;
+    event->id = static_cast<uint32_t>(__getLE(header + 2, 2));
+    event->length = length;
+    std::memcpy(event->data, header + 5, length);
+    return used + EventEncoder::EVENT_HEADER_SIZE + length;
+}
+
+void LogIndexWriter::reset(uint64_t offset) {
+    _offset = offset;
+    _pending.clear();
+    _blocks.clear();
+}
+
+void LogIndexWriter::committed(const uint8_t* frames, std::size_t size) {
+    // the frames are our own, so they are whole and well formed
+    while (size >= LOG_FRAME_OVERHEAD) {
+        std::size_t bodySize = __getLE(frames + 2, 2);
+        const uint8_t* body = frames + LOG_FRAME_HEADER_SIZE;
+        uint32_t timeMs = bodySize >= 5 ? static_cast<uint32_t>(__getLE(body + 1, 4)) : 0;
+        if (body[0] == LRT_SNAPSHOT) {
+            _pending.push_back({timeMs, _offset});
+        } else if (body[0] == LRT_INDEX && !_pending.empty()) {
+            _blocks.push_back({_pending.front().timeMs, _offset});
+            _pending.clear();
+        }
+        std::size_t used = LOG_FRAME_OVERHEAD + bodySize;
+        _offset += used;
+        frames += used;
+        size -= used;
+    }
+}
+
+static void __encodeEntries(std::vector<uint8_t>& out, const std::vector<LogIndexEntry>& entries,
+                            std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        uint8_t bytes[12];
+        __putLE(bytes, entries[i].timeMs, 4);
+        __putLE(bytes + 4, entries[i].offset, 8);
+        out.insert(out.end(), bytes, bytes + 12);
+    }
+}
+
+void LogIndexWriter::encodeBlock(std::vector<uint8_t>& out) const {
+    out.clear();
+    out.push_back(LRT_INDEX);
+    uint8_t count[2];
+    __putLE(count, _pending.size(), 2);
+    out.insert(out.end(), count, count + 2);
+    __encodeEntries(out, _pending, _pending.size());
+    frameRecord(out);
+}
+
+void LogIndexWriter::encodeFooter(std::vector<uint8_t>& out) const {
+    std::vector<LogIndexEntry> blocks = _blocks;
+    out.clear();
+    if (!_pending.empty()) {
+        encodeBlock(out);
+        blocks.push_back({_pending.front().timeMs, _offset});
+    }
+    uint64_t footerOffset = _offset + out.size();
+
+    // a footer has to fit in a frame, days of logging in one file would cut off the latest blocks
+    std::size_t count = std::min(blocks.size(), (LOG_MAX_BODY_SIZE - 5) / 12);
+    std::vector<uint8_t> footer;
+    footer.push_back(LRT_FOOTER);
+    __append(footer, static_cast<uint32_t>(count));
+    __encodeEntries(footer, blocks, count);
+    frameRecord(footer);
+    out.insert(out.end(), footer.begin(), footer.end());
+
+    uint8_t trailer[LOG_TRAILER_SIZE];
+    __putLE(trailer, footerOffset, 8);
+    std::memcpy(trailer + 8, LOG_TRAILER_MAGIC, sizeof(LOG_TRAILER_MAGIC));
+    out.insert(out.end(), trailer, trailer + LOG_TRAILER_SIZE);
+}
+
+bool decodeIndex(const uint8_t* body, std::size_t size, std::vector<LogIndexEntry>& entries) {
+    std::size_t header;
+    std::size_t count;
+    if (size >= 3 && body[0] == LRT_INDEX) {
+        header = 3;
+        count = __getLE(body + 1, 2);
+    } else if (size >= 5 && body[0] == LRT_FOOTER) {
+        header = 5;
+        count = __getLE(body + 1, 4);
+    } else {
+        return false;
+    }
+    if (size != header + 12 * count) {
+        return false;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        const uint8_t* entry = body + header + 12 * i;
+        entries.push_back({static_cast<uint32_t>(__getLE(entry, 4)), __getLE(entry + 4, 8)});
+    }
+    return true;
+}
+
+bool readTrailer(const uint8_t* tail, uint64_t* footerOffset) {
+    if (std::memcmp(tail + 8, LOG_TRAILER_MAGIC, sizeof(LOG_TRAILER_MAGIC)) != 0) {
+        return false;
+    }
+    *footerOffset = __getLE(tail, 8);
+    return true;
+}
+
+}  // namespace remote
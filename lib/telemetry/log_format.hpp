@@ -0,0 +1,360 @@
+#ifndef __LOG_FORMAT_H__
+#define __LOG_FORMAT_H__
+
+#include <can.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <lz.hpp>
+#include <ts_codec.hpp>
+#include <vector>
+
+namespace remote {
+
+/// @brief The layout of a .daq log, all little-endian:
+///   magic    LOG_MAGIC
+///   config   length u32, then the text of the .telem file the session was logged with
+///   frames   back to back until the end of the file
+///   trailer  after a clean close only: the offset of the footer frame u64, then LOG_TRAILER_MAGIC
+///
+/// Each frame is LOG_SYNC, the length of its body u16, the body, then a CRC-16 (common::crc16())
+/// of the length and the body u16. A reader that hits a bad CRC skips ahead to the next sync word,
+/// so a corrupt byte costs the frames it touches and not the rest of the file. A body is one of
+/// the records below, each starting with a LogRecordType.
+///
+/// A snapshot record is the whole bus at one instant: time ms u32, unix time u32, the data buffer
+/// of the bus, then the low 32 bits of the receive time of every message, in microseconds. Its size
+/// follows from the config, messages are in data buffer order (ID order, see CANBus::reserve()).
+///
+/// A delta record only holds what changed since the record before it: time ms and unix time, a
+/// bitmap with one bit per message in data buffer order (bit i in byte i / 8, LSB first), then
+/// for each set bit the message's payload and its receive time. Its times are zig-zag varints
+/// (common/ts_codec.hpp): time ms and each message's receive time as the delta-of-delta from the
+/// records before, starting over at every full snapshot, and unix time as the delta from the
+/// record before. Every few records, and after any record was lost, a full snapshot comes instead
+/// so readers can resync.
+///
+/// Event records carry single frames of MLM_EVENT messages: the time since the previous event in
+/// microseconds u16, id u16, length u8, then the payload. Whenever that time doesn't fit, or after
+/// a gap in the stream, an event time record with the absolute time u64 comes first, in the same
+/// frame. The first event after every full snapshot has one, so decoding can start at any of them.
+///
+/// An index record lists the last few full snapshots: count u16, then per snapshot its time ms u32
+/// and the offset of its frame in the file u64. The footer record, written on close, lists every
+/// index record the same way: count u32, then the time ms of its first snapshot u32 and the offset
+/// of its frame u64. A reader finds time T by binary searching the footer, then one index record.
+///
+/// When the logger packs its output, everything after the config is a run of packed records
+/// instead: codec u8 (LogPackCodec), the offset of the packed bytes in the unpacked log u64, their
+/// size u16, then the bytes, compressed or as they are. The packed bytes are the frames and trailer
+/// described above, cut wherever the packing block filled up. Every packed record stands alone, so
+/// readers unpack them in any order, or in parallel, into the log an unpacked session would have
+/// written, and offsets in the index and trailer refer to that unpacked log.
+static constexpr uint8_t LOG_MAGIC[] = {'N', 'F', 'R', '2', '5', '1', '0', '4', '\n'};
+static constexpr std::size_t LOG_MAGIC_SIZE = sizeof(LOG_MAGIC);
+
+static constexpr uint8_t LOG_SYNC[] = {0xA5, 0x5A};
+static constexpr std::size_t LOG_FRAME_HEADER_SIZE = 4;  // sync, body length
+static constexpr std::size_t LOG_FRAME_OVERHEAD = LOG_FRAME_HEADER_SIZE + 2;
+static constexpr std::size_t LOG_MAX_BODY_SIZE = UINT16_MAX;
+static constexpr std::size_t LOG_MAX_PACK_SIZE = 16384;  // bounds the memory packing takes
+
+static constexpr uint8_t LOG_TRAILER_MAGIC[] = {'N', 'F', 'R', 'I', 'N', 'D', 'X', '\n'};
+static constexpr std::size_t LOG_TRAILER_SIZE = 8 + sizeof(LOG_TRAILER_MAGIC);
+
+/// @brief The tag at the start of every record
+enum LogRecordType : uint8_t {
+    LRT_SNAPSHOT = 0x01,    // every message, sampled once per log period
+    LRT_EVENT = 0x02,       // one received frame
+    LRT_EVENT_TIME = 0x03,  // resets the time the next event is relative to
+    LRT_DELTA = 0x04,       // the messages that changed since the previous snapshot or delta
+    LRT_INDEX = 0x05,       // where the last few full snapshots are
+    LRT_FOOTER = 0x06,      // where every index record is
+    LRT_PACKED = 0x07,      // a span of the unpacked log
+};
+
+/// @brief How the bytes of a packed record are stored
+enum LogPackCodec : uint8_t {
+    LPC_STORED = 0x00,  // as they are, when compressing didn't make them smaller
+    LPC_LZ = 0x01,      // compressed by common::LZCompressor
+};
+
+static constexpr std::size_t LOG_PACK_HEADER_SIZE = 12;  // type, codec, offset, size
+
+/// @brief The largest packed record, framed, that `size` bytes can turn into
+constexpr std::size_t packBound(std::size_t size) {
+    return LOG_FRAME_OVERHEAD + LOG_PACK_HEADER_SIZE + common::LZCompressor::bound(size);
+}
+
+/// @brief Packs a span of the log into a framed LRT_PACKED record
+/// @param lz The compressor, reused across records
+/// @param data The span, at most LOG_MAX_PACK_SIZE bytes
+/// @param size The size of the span
+/// @param offset Where the span starts in the unpacked log
+/// @param out Where to put the frame, at least packBound(size) bytes
+/// @return The size of the frame
+std::size_t packRecord(common::LZCompressor& lz, const uint8_t* data, std::size_t size,
+                       uint64_t offset, uint8_t* out);
+
+/// @brief A packed record read back from the log
+struct LogPacked {
+    LogPackCodec codec;
+    uint64_t offset;  // in the unpacked log
+    std::size_t size;  // unpacked
+    const uint8_t* data;
+    std::size_t dataSize;  // as stored
+};
+
+/// @brief Reads the header of a packed record
+/// @param body The body of the frame
+/// @param size Its size
+/// @param packed Out: the record
+/// @return false if it isn't a packed record, or is malformed
+bool readPacked(const uint8_t* body, std::size_t size, LogPacked* packed);
+
+/// @brief Unpacks a packed record
+/// @param packed The record
+/// @param out Where its bytes go, packed.size of them
+/// @return false if the bytes don't decompress to packed.size
+bool unpack(const LogPacked& packed, uint8_t* out);
+
+/// @brief Wraps a record in a frame, in place
+/// @param frame The record, starting LOG_FRAME_HEADER_SIZE bytes in, with room for 2 more bytes
+/// after it
+/// @param bodySize The size of the record, at most LOG_MAX_BODY_SIZE
+/// @return The size of the frame
+std::size_t frameRecord(uint8_t* frame, std::size_t bodySize);
+
+/// @brief Wraps a record in a frame, in place
+void frameRecord(std::vector<uint8_t>& record);
+
+/// @brief What readFrame() found
+enum LogFrameStatus {
+    LFS_OK,         // a whole frame with a good CRC
+    LFS_TRUNCATED,  // the frame runs past the end of the bytes given
+    LFS_CORRUPT,    // no sync word, or a bad CRC
+};
+
+/// @brief A frame read back from the log
+struct LogFrame {
+    const uint8_t* body;
+    std::size_t size;  // of the body
+    std::size_t used;  // the whole frame, header and CRC included
+};
+
+/// @brief Reads the frame at the start of in
+/// @param in The start of the frame
+/// @param size The bytes available from in
+/// @param frame Out: the frame, when LFS_OK
+LogFrameStatus readFrame(const uint8_t* in, std::size_t size, LogFrame* frame);
+
+/// @brief Looks for the next sync word, to resync after a corrupt frame
+/// @return Its offset from in, or size if there is none
+std::size_t findSync(const uint8_t* in, std::size_t size);
+
+/// @brief Where a message's payload sits in the data buffer of a bus
+struct SnapshotSlot {
+    std::size_t byteOffset;
+    uint8_t length;
+};
+
+/// @brief The slots of every message on a bus, in data buffer order
+std::vector<SnapshotSlot> snapshotLayout(const can::CANBus& bus);
+
+/// @brief Turns samples of a bus into snapshot and delta records
+class SnapshotEncoder {
+   public:
+    static constexpr uint32_t DEFAULT_KEYFRAME_INTERVAL = 50;  // 5 s at the default log period
+
+    /// @param keyframeInterval A full snapshot every this many records, 1 for snapshots only
+    explicit SnapshotEncoder(uint32_t keyframeInterval = DEFAULT_KEYFRAME_INTERVAL)
+        : _keyframeInterval(keyframeInterval ? keyframeInterval : 1) {}
+
+    void setKeyframeInterval(uint32_t interval) { _keyframeInterval = interval ? interval : 1; }
+
+    /// @brief Samples a bus into a record, locking the bus for the copy. The first record for a
+    /// bus is always a full snapshot.
+    /// @param bus The bus, initialized
+    /// @param timeMs The millisecond clock
+    /// @param unixTime The wall clock
+    /// @param out Cleared, then filled with the record
+    /// @return The type of the record
+    LogRecordType encode(can::CANBus& bus, uint32_t timeMs, uint32_t unixTime,
+                         std::vector<uint8_t>& out);
+
+    /// @brief Makes the next record a full snapshot, needed whenever a record didn't make it into
+    /// the log since the deltas after it would build on it
+    void forceKeyframe() { _sinceKeyframe = _keyframeInterval; }
+
+    /// @brief The largest record encode() can produce for a bus, full snapshot or delta. A bus
+    /// whose records go past LOG_MAX_BODY_SIZE can't be logged.
+    /// @param bus The bus, initialized
+    static std::size_t maxRecordSize(const can::CANBus& bus);
+
+   private:
+    uint32_t _keyframeInterval;
+    uint32_t _sinceKeyframe = 0;
+    std::vector<SnapshotSlot> _slots;
+    std::vector<uint8_t> _previous;  // the data buffer as of the last record
+
+    // the clocks as of the last record, deltas are coded against them
+    common::DeltaOfDelta _time;
+    uint32_t _unixTime = 0;
+    std::vector<common::DeltaOfDelta> _stamps;  // per message
+};
+
+/// @brief The state of a bus as rebuilt from snapshot and delta records
+struct LogSnapshot {
+    uint32_t timeMs = 0;
+    uint32_t unixTime = 0;
+    std::vector<uint8_t> buffer;   // the data buffer of the bus
+    std::vector<uint32_t> stamps;  // per message, in data buffer order
+};
+
+/// @brief Reads snapshot and delta records back into the full state of the bus
+class SnapshotDecoder {
+   public:
+    /// @param slots The layout of the bus the log was written from
+    /// @param bufferSize The size of its data buffer, in bytes
+    SnapshotDecoder(std::vector<SnapshotSlot> slots, std::size_t bufferSize);
+
+    /// @brief Applies the next LRT_SNAPSHOT or LRT_DELTA record
+    /// @param in The start of the record
+    /// @param size The bytes available from in
+    /// @return The number of bytes used, zero if the record is truncated, isn't a snapshot, or is
+    /// a delta before any full snapshot
+    std::size_t decode(const uint8_t* in, std::size_t size);
+
+    /// @brief The state after the last record, valid once a full snapshot was decoded
+    const LogSnapshot& snapshot() const { return _snapshot; }
+
+    /// @brief Drops the state, the next delta is refused until a full snapshot comes along
+    void reset() { _synced = false; }
+
+   private:
+    std::vector<SnapshotSlot> _slots;
+    LogSnapshot _snapshot;
+    bool _synced = false;
+
+    // mirror the encoder's
+    common::DeltaOfDelta _time;
+    std::vector<common::DeltaOfDelta> _stamps;
+
+    /// @brief A message a delta changed, found while checking the record and applied after
+    struct Change {
+        std::size_t slot;
+        std::size_t at;  // where its payload starts in the record
+        uint64_t stampDod;
+    };
+    std::vector<Change> _changes;  // reused for every delta
+};
+
+/// @brief A frame read back from the log
+struct LogEvent {
+    uint64_t timestampUs;
+    uint32_t id;
+    uint8_t length;
+    uint8_t data[can::CANFD_MAX_DATA_LENGTH];
+};
+
+/// @brief Turns received frames into event records, keeping track of the time they are relative to
+class EventEncoder {
+   public:
+    static constexpr std::size_t EVENT_HEADER_SIZE = 6;
+    static constexpr std::size_t TIME_RECORD_SIZE = 9;
+    static constexpr std::size_t MAX_RECORD_SIZE =
+        TIME_RECORD_SIZE + EVENT_HEADER_SIZE + can::CANFD_MAX_DATA_LENGTH;
+
+    /// @brief Encodes one frame, preceded by an event time record if it needs one
+    /// @param frame The frame
+    /// @param out Where to put the records, at least MAX_RECORD_SIZE bytes
+    /// @return The number of bytes written
+    std::size_t encode(const can::RawCANMessage& frame, uint8_t* out);
+
+    /// @brief Forgets the previous event, so the next one starts with an absolute time. Needed
+    /// whenever an encoded frame didn't make it into the log.
+    void reset() { _hasBase = false; }
+
+   private:
+    uint64_t _lastUs = 0;
+    bool _hasBase = false;
+};
+
+/// @brief Reads event records back
+class EventDecoder {
+   public:
+    /// @brief Decodes the next event, along with the event time record in front of it
+    /// @param in The start of a LRT_EVENT or LRT_EVENT_TIME record
+    /// @param size The bytes available from in
+    /// @param event Out: the frame
+    /// @return The number of bytes used, zero if the records are truncated or aren't events
+    std::size_t decode(const uint8_t* in, std::size_t size, LogEvent* event);
+
+    void reset() { _hasBase = false; }
+
+   private:
+    uint64_t _lastUs = 0;
+    bool _hasBase = false;
+};
+
+/// @brief Where a full snapshot, or an index record, is in the file
+struct LogIndexEntry {
+    uint32_t timeMs;
+    uint64_t offset;
+};
+
+/// @brief Follows the frames going into a log and turns the positions of full snapshots into index
+/// records, and those into the footer
+class LogIndexWriter {
+   public:
+    static constexpr uint32_t DEFAULT_BLOCK_ENTRIES = 16;  // 80 s at the default keyframe interval
+
+    /// @param blockEntries Snapshots per index record
+    explicit LogIndexWriter(uint32_t blockEntries = DEFAULT_BLOCK_ENTRIES)
+        : _blockEntries(blockEntries ? blockEntries : 1) {}
+
+    /// @brief Starts over for a new file
+    /// @param offset Where the first frame goes, right after the config
+    void reset(uint64_t offset);
+
+    /// @brief Accounts for frames that made it into the log, in the order they did
+    /// @param frames One or more whole frames
+    /// @param size Their size
+    void committed(const uint8_t* frames, std::size_t size);
+
+    /// @brief Whether enough snapshots have gone by for an index record
+    bool blockDue() const { return _pending.size() >= _blockEntries; }
+
+    /// @brief Frames an index record of the snapshots since the last one. It only counts once it
+    /// is committed() like any other frame.
+    void encodeBlock(std::vector<uint8_t>& out) const;
+
+    /// @brief Frames the last index record, if any snapshots are pending, then the footer, followed
+    /// by the trailer. Nothing may be committed after it.
+    void encodeFooter(std::vector<uint8_t>& out) const;
+
+    /// @brief Where the next frame goes
+    uint64_t offset() const { return _offset; }
+
+   private:
+    uint32_t _blockEntries;
+    uint64_t _offset = 0;
+    std::vector<LogIndexEntry> _pending;  // snapshots since the last index record
+    std::vector<LogIndexEntry> _blocks;   // every index record so far
+};
+
+/// @brief Reads the entries of an LRT_INDEX or LRT_FOOTER record
+/// @param body The body of the frame
+/// @param size Its size
+/// @param entries Out: the entries, appended to
+/// @return false if the record is neither, or its size doesn't match its count
+bool decodeIndex(const uint8_t* body, std::size_t size, std::vector<LogIndexEntry>& entries);
+
+/// @brief Reads the trailer at the end of a closed log
+/// @param tail The last LOG_TRAILER_SIZE bytes of the file
+/// @param footerOffset Out: where the footer frame is
+/// @return false if there is no trailer, the log wasn't closed
+bool readTrailer(const uint8_t* tail, uint64_t* footerOffset);
+
+}  // namespace remote
+
+#endif  // __LOG_FORMAT_H__
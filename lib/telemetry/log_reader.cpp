@@ -0,0 +1,270 @@
+#include "log_reader.hpp"
+
+#include <builder/block_token_reader.hpp>
+#include <builder/tokenizer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <thread>
+
+namespace remote {
+
+void LogChunk::append(const LogChunk& next) {
+    snapshots.timeMs.insert(snapshots.timeMs.end(), next.snapshots.timeMs.begin(),
+                            next.snapshots.timeMs.end());
+    snapshots.unixTime.insert(snapshots.unixTime.end(), next.snapshots.unixTime.begin(),
+                              next.snapshots.unixTime.end());
+    snapshots.values.resize(next.snapshots.values.size());
+    for (std::size_t i = 0; i < next.snapshots.values.size(); ++i) {
+        snapshots.values[i].insert(snapshots.values[i].end(), next.snapshots.values[i].begin(),
+                                   next.snapshots.values[i].end());
+    }
+
+    events.timestampUs.insert(events.timestampUs.end(), next.events.timestampUs.begin(),
+                              next.events.timestampUs.end());
+    events.signal.insert(events.signal.end(), next.events.signal.begin(),
+                         next.events.signal.end());
+    events.value.insert(events.value.end(), next.events.value.begin(), next.events.value.end());
+
+    stats.frames += next.stats.frames;
+    stats.corrupt += next.stats.corrupt;
+    stats.unsynced += next.stats.unsynced;
+    stats.truncated += next.stats.truncated;
+}
+
+common::Result<can::TelemetryOptions> LogReader::open(const uint8_t* data, std::size_t size,
+                                                      std::size_t threads) {
+    using Res = common::Result<can::TelemetryOptions>;
+    if (_bus.getMessages().size() > 0) {
+        return Res::errorResult("log reader is already open");
+    }
+    if (size < LOG_MAGIC_SIZE + 4 || std::memcmp(data, LOG_MAGIC, LOG_MAGIC_SIZE) != 0) {
+        return Res::errorResult("not a .daq log, or written by a different format version");
+    }
+    uint32_t configSize = 0;
+    for (std::size_t i = 0; i < 4; ++i) {
+        configSize |= static_cast<uint32_t>(data[LOG_MAGIC_SIZE + i]) << (8 * i);
+    }
+    _framesStart = LOG_MAGIC_SIZE + 4 + configSize;
+    if (_framesStart > size) {
+        return Res::errorResult("log ends inside its config");
+    }
+    _data = data;
+    _size = size;
+    _config.assign(reinterpret_cast<const char*>(data + LOG_MAGIC_SIZE + 4), configSize);
+
+    LogFrame first;
+    if (readFrame(data + _framesStart, size - _framesStart, &first) == LFS_OK &&
+        first.body[0] == LRT_PACKED) {
+        _unpack(data, size, threads);
+        _data = _unpacked.data();
+        _size = _unpacked.size();
+    }
+
+    // built the way the device builds it, so the data buffer comes out the same
+    can::MemoryBlockSource source(data + LOG_MAGIC_SIZE + 4, configSize);
+    can::BlockTokenReader reader(source);
+    can::Tokenizer tokenizer(reader);
+    can::TelemBuilder builder(tokenizer);
+    std::map<uint32_t, std::vector<std::string>> names;
+    builder.setMessageListener([&](const char* board, const can::CANMessageDescription& message) {
+        std::vector<std::string>& signalNames = names[message.id];
+        signalNames.clear();
+        for (const can::CANSignalDescription& signal : message.signals) {
+            signalNames.push_back(std::string(board) + "." + message.name + "." + signal.name);
+        }
+    });
+    builder.plan(_bus);
+    Res options = builder.build(_bus);
+    if (reader.failed()) {
+        return Res::errorResult("config in log: read error");
+    }
+    if (options.isError()) {
+        return Res::errorResult("config in log: " + options.error());
+    }
+    // sizes the data buffer and settles the scale table, columns point into it
+    _bus.initialize();
+
+    _bus.dataBuffer(&_bufferSize);
+    _slots = snapshotLayout(_bus);
+    _snapshotSize = 1 + 8 + _bufferSize + 4 * _slots.size();
+
+    // columns go in the order decodeSignals() uses, messages by ID and signals as declared
+    for (const auto& entry : _bus.getMessages()) {
+        const can::CANMessage& message = *entry.second;
+        const std::vector<std::string>& signalNames = names[message.id];
+        _messages.push_back({message.id, message.payloadByte(), message.length,
+                             _columns.size(), message.signals.size()});
+        const can::SignalDescriptor* descriptor = message.signals.descriptors();
+        const uint16_t* scaleIndex = message.signals.scaleIndices();
+        for (std::size_t i = 0; i < message.signals.size(); ++i, ++descriptor, ++scaleIndex) {
+            const can::SignalScale& scale = _bus.signalScale(*scaleIndex);
+            _columns.push_back({descriptor, &scale, message.payloadByte()});
+            _signals.push_back({i < signalNames.size() ? signalNames[i] : std::string(),
+                                message.id, scale.factor, scale.offset});
+        }
+    }
+    // events only carry 16 bits of the ID, a collision goes to the lowest full ID
+    std::stable_sort(_messages.begin(), _messages.end(),
+                     [](const MessageColumns& a, const MessageColumns& b) {
+                         return (a.id & 0xFFFF) < (b.id & 0xFFFF);
+                     });
+    return options;
+}
+
+void LogReader::_unpack(const uint8_t* data, std::size_t size, std::size_t threads) {
+    // walking the frames is cheap, unpacking them is what gets split over the threads
+    std::vector<LogPacked> records;
+    std::size_t end = _framesStart;
+    std::size_t at = _framesStart;
+    while (at < size) {
+        LogFrame frame;
+        LogFrameStatus status = readFrame(data + at, size - at, &frame);
+        if (status == LFS_TRUNCATED) {
+            ++_unpackStats.truncated;
+            break;
+        }
+        LogPacked record;
+        if (status == LFS_CORRUPT || !readPacked(frame.body, frame.size, &record) ||
+            record.offset < _framesStart || record.offset > size * 256) {
+            ++_unpackStats.corrupt;
+            at += 1 + findSync(data + at + 1, size - at - 1);
+            continue;
+        }
+        records.push_back(record);
+        end = std::max(end, static_cast<std::size_t>(record.offset + record.size));
+        at += frame.used;
+    }
+    _unpackStats.packedBytes = size - _framesStart;
+    _unpackStats.unpackedBytes = end - _framesStart;
+
+    // the span of a lost record stays zero, which decoding skips like any corrupt frame
+    _unpacked.assign(end, 0);
+    std::memcpy(_unpacked.data(), data, _framesStart);
+    std::atomic<uint32_t> failed{0};
+    auto work = [&](std::size_t first) {
+        for (std::size_t i = first; i < records.size(); i += threads) {
+            if (!unpack(records[i], _unpacked.data() + records[i].offset)) {
+                std::fill_n(_unpacked.data() + records[i].offset, records[i].size, 0);
+                ++failed;
+            }
+        }
+    };
+    threads = std::max<std::size_t>(1, std::min(threads, records.size()));
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(work, t);
+    }
+    work(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    _unpackStats.records = static_cast<uint32_t>(records.size()) - failed.load();
+    _unpackStats.corrupt += failed.load();
+}
+
+std::size_t LogReader::keyframeAt(std::size_t offset) const {
+    std::size_t at = std::max(offset, _framesStart);
+    while (at < _size) {
+        at += findSync(_data + at, _size - at);
+        LogFrame frame;
+        if (readFrame(_data + at, _size - at, &frame) == LFS_OK && frame.body[0] == LRT_SNAPSHOT &&
+            frame.size == _snapshotSize) {
+            return at;
+        }
+        ++at;
+    }
+    return _size;
+}
+
+std::vector<std::size_t> LogReader::chunkBounds(std::size_t count) const {
+    std::vector<std::size_t> bounds = {_framesStart};
+    std::size_t span = _size - _framesStart;
+    for (std::size_t i = 1; i < count; ++i) {
+        std::size_t at = keyframeAt(_framesStart + span / count * i);
+        if (at > bounds.back() && at < _size) {
+            bounds.push_back(at);
+        }
+    }
+    bounds.push_back(_size);
+    return bounds;
+}
+
+double LogReader::_value(const Column& column, const uint8_t* buffer) const {
+    const can::SignalDescriptor& desc = *column.descriptor;
+    uint64_t raw = desc.decode(buffer + column.byteOffset);
+    double v = desc.isSigned() ? static_cast<double>(can::signExtend(raw, desc.layout.length))
+                               : static_cast<double>(raw);
+    return v * column.scale->factor + column.scale->offset;
+}
+
+LogChunk LogReader::decode(std::size_t begin, std::size_t end) const {
+    LogChunk chunk;
+    chunk.snapshots.values.resize(_columns.size());
+    SnapshotDecoder snapshots(_slots, _bufferSize);
+    EventDecoder events;
+    std::vector<uint8_t> scratch(_bufferSize);  // events are decoded in their message's slot
+
+    std::size_t at = begin;
+    end = std::min(end, _size);
+    while (at < end) {
+        LogFrame frame;
+        LogFrameStatus status = readFrame(_data + at, _size - at, &frame);
+        if (status == LFS_TRUNCATED) {
+            ++chunk.stats.truncated;
+            break;
+        }
+        if (status == LFS_CORRUPT) {
+            // whatever the bad frame held is gone, so nothing after it can build on it
+            ++chunk.stats.corrupt;
+            snapshots.reset();
+            events.reset();
+            at += 1 + findSync(_data + at + 1, _size - at - 1);
+            continue;
+        }
+        ++chunk.stats.frames;
+        at += frame.used;
+
+        uint8_t type = frame.body[0];
+        if (type == LRT_SNAPSHOT || type == LRT_DELTA) {
+            if (snapshots.decode(frame.body, frame.size) == 0) {
+                ++chunk.stats.unsynced;
+                continue;
+            }
+            const LogSnapshot& snapshot = snapshots.snapshot();
+            chunk.snapshots.timeMs.push_back(snapshot.timeMs);
+            chunk.snapshots.unixTime.push_back(snapshot.unixTime);
+            for (std::size_t i = 0; i < _columns.size(); ++i) {
+                chunk.snapshots.values[i].push_back(_value(_columns[i], snapshot.buffer.data()));
+            }
+        } else if (type == LRT_EVENT || type == LRT_EVENT_TIME) {
+            LogEvent event;
+            if (events.decode(frame.body, frame.size, &event) == 0) {
+                ++chunk.stats.unsynced;
+                continue;
+            }
+            // ids are logged as 16 bits
+            auto message = std::lower_bound(_messages.begin(), _messages.end(), event.id,
+                                            [](const MessageColumns& m, uint32_t id) {
+                                                return (m.id & 0xFFFF) < id;
+                                            });
+            if (message == _messages.end() || (message->id & 0xFFFF) != event.id) {
+                continue;
+            }
+            std::memcpy(scratch.data() + message->byteOffset, event.data,
+                        std::min(event.length, message->length));
+            for (std::size_t i = message->first; i < message->first + message->count; ++i) {
+                chunk.events.timestampUs.push_back(event.timestampUs);
+                chunk.events.signal.push_back(static_cast<uint32_t>(i));
+                chunk.events.value.push_back(_value(_columns[i], scratch.data()));
+            }
+        } else if (type == LRT_FOOTER) {
+            // only the trailer comes after it
+            break;
+        }
+    }
+    return chunk;
+}
+
+}  // namespace remote
@@ -0,0 +1,152 @@
+#ifndef __LOG_READER_H__
+#define __LOG_READER_H__
+
+#include <can.hpp>
+#include <builder/telem_builder.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <drivers/can_driver_virtual.hpp>
+#include <memory>
+#include <result.hpp>
+#include <string>
+#include <vector>
+
+#include "log_format.hpp"
+
+namespace remote {
+
+/// @brief A signal of the bus a log was written from
+struct LogSignalInfo {
+    std::string name;  // BOARD.MESSAGE.SIGNAL
+    uint32_t messageId;
+    double factor;  // its values are its raw integers times this plus offset
+    double offset;
+};
+
+/// @brief Snapshot and delta records, decoded into one column per signal
+struct LogColumns {
+    std::vector<uint32_t> timeMs;
+    std::vector<uint32_t> unixTime;
+    std::vector<std::vector<double>> values;  // per signal, one value per row
+};
+
+/// @brief Event records, decoded into one row per signal of each frame
+struct LogEventColumns {
+    std::vector<uint64_t> timestampUs;
+    std::vector<uint32_t> signal;  // index into LogReader::signals()
+    std::vector<double> value;
+};
+
+/// @brief What decoding ran into
+struct LogReadStats {
+    uint32_t frames = 0;
+    uint32_t corrupt = 0;    // bad frames, each followed by a resync
+    uint32_t unsynced = 0;   // deltas and events that had nothing to build on after a bad frame
+    uint32_t truncated = 0;  // a frame cut off by the end of the file, from a crash
+};
+
+/// @brief What unpacking a packed log ran into
+struct LogUnpackStats {
+    uint32_t records = 0;  // packed records unpacked
+    uint32_t corrupt = 0;  // bad frames and records that didn't unpack, their span of the log is lost
+    uint32_t truncated = 0;
+    uint64_t packedBytes = 0;    // the frames after the config, as stored
+    uint64_t unpackedBytes = 0;  // what they unpacked to
+};
+
+/// @brief A decoded part of a log
+struct LogChunk {
+    LogColumns snapshots;
+    LogEventColumns events;
+    LogReadStats stats;
+
+    /// @brief Appends the next part of the same log
+    void append(const LogChunk& next);
+};
+
+/// @brief Reads .daq logs on the host. The bus is rebuilt from the config embedded in the log, the
+/// same way the device built it, so the data buffer layout matches what was logged. Packed logs
+/// are unpacked on open. Decoding is const and keeps its state on the stack, so parts of one log
+/// can be decoded on several threads.
+class LogReader {
+   public:
+    LogReader() : _bus(_driver, can::CBR_500KBPS) {}
+
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+
+    /// @brief Reads the header and builds the bus, unpacking the log first if it is packed
+    /// @param data The whole file, kept alive by the caller while the reader is used
+    /// @param size The size of the file
+    /// @param threads How many threads to unpack on
+    /// @return The options of the config, or why the log can't be read
+    common::Result<can::TelemetryOptions> open(const uint8_t* data, std::size_t size,
+                                               std::size_t threads = 1);
+
+    const std::string& config() const { return _config; }
+
+    /// @brief Whether the log was packed, offsets then refer to the unpacked log
+    bool packed() const { return !_unpacked.empty(); }
+    const LogUnpackStats& unpackStats() const { return _unpackStats; }
+
+    /// @brief The size of the log, unpacked
+    std::size_t size() const { return _size; }
+    const std::vector<LogSignalInfo>& signals() const { return _signals; }
+
+    /// @brief Where the frames start, right after the config
+    std::size_t framesStart() const { return _framesStart; }
+
+    /// @brief Finds the first full snapshot at or after an offset, where decoding can start
+    /// @return Its offset, or the size of the file if there is none
+    std::size_t keyframeAt(std::size_t offset) const;
+
+    /// @brief Splits the log at full snapshots into about `count` parts of similar size
+    /// @return The offsets the parts start at, followed by the size of the file
+    std::vector<std::size_t> chunkBounds(std::size_t count) const;
+
+    /// @brief Decodes the frames that start in [begin, end)
+    /// @param begin framesStart(), or a full snapshot
+    /// @param end Where to stop
+    LogChunk decode(std::size_t begin, std::size_t end) const;
+
+   private:
+    /// @brief A signal and where it sits, in the order columns are laid out
+    struct Column {
+        const can::SignalDescriptor* descriptor;
+        const can::SignalScale* scale;
+        std::size_t byteOffset;  // where the signal's message starts in the data buffer
+    };
+
+    /// @brief The columns of one message, for placing its events
+    struct MessageColumns {
+        uint32_t id;
+        std::size_t byteOffset;
+        uint8_t length;
+        std::size_t first;
+        std::size_t count;
+    };
+
+    can::VirtualCANDriver _driver;
+    can::CANBus _bus;
+
+    const uint8_t* _data = nullptr;
+    std::size_t _size = 0;
+    std::string _config;
+    std::size_t _framesStart = 0;
+    std::vector<uint8_t> _unpacked;  // the log, when it was packed
+    LogUnpackStats _unpackStats;
+    std::size_t _bufferSize = 0;
+    std::size_t _snapshotSize = 0;  // the body of a full snapshot
+    std::vector<SnapshotSlot> _slots;
+
+    std::vector<LogSignalInfo> _signals;
+    std::vector<Column> _columns;
+    std::vector<MessageColumns> _messages;  // sorted by the low 16 bits of the ID, as logged
+
+    void _unpack(const uint8_t* data, std::size_t size, std::size_t threads);
+    double _value(const Column& column, const uint8_t* buffer) const;
+};
+
+}  // namespace remote
+
+#endif  // __LOG_READER_H__
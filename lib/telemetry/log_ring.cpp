@@ -0,0 +1,171 @@
+#include "log_ring.hpp"
+
+#include <cstring>
+
+#include "telemetry_debug.hpp"
+
+namespace remote {
+
+static std::size_t __roundUpToSector(std::size_t size) {
+    return (size + LOG_SECTOR_SIZE - 1) / LOG_SECTOR_SIZE * LOG_SECTOR_SIZE;
+}
+
+LogRing::LogRing(std::size_t capacity)
+    : _buffer(new uint8_t[__roundUpToSector(capacity)]),
+      _capacity(__roundUpToSector(capacity)) {}
+
+bool LogRing::push(const uint8_t* data, std::size_t size) {
+    std::size_t head = _head.load(std::memory_order_relaxed);
+    std::size_t used = head - _tail.load(std::memory_order_acquire);
+
+    _records.fetch_add(1, std::memory_order_relaxed);
+    if (size > _capacity - used) {
+        _overflows.fetch_add(1, std::memory_order_relaxed);
+        _droppedBytes.fetch_add(size, std::memory_order_relaxed);
+        return false;
+    }
+
+    // the record may wrap around the end of the buffer
+    std::size_t start = head % _capacity;
+    std::size_t first = size < _capacity - start ? size : _capacity - start;
+    std::memcpy(_buffer.get() + start, data, first);
+    std::memcpy(_buffer.get(), data + first, size - first);
+    _head.store(head + size, std::memory_order_release);
+
+    // only the producer raises it, so a plain compare is enough
+    uint32_t waiting = static_cast<uint32_t>(used + size);
+    if (waiting > _highWater.load(std::memory_order_relaxed)) {
+        _highWater.store(waiting, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+std::size_t LogRing::pop(uint8_t* out, std::size_t max) {
+    std::size_t tail = _tail.load(std::memory_order_relaxed);
+    std::size_t waiting = _head.load(std::memory_order_acquire) - tail;
+    std::size_t size = waiting < max ? waiting : max;
+
+    std::size_t start = tail % _capacity;
+    std::size_t first = size < _capacity - start ? size : _capacity - start;
+    std::memcpy(out, _buffer.get() + start, first);
+    std::memcpy(out + first, _buffer.get(), size - first);
+    _tail.store(tail + size, std::memory_order_release);
+    return size;
+}
+
+LogRingStats LogRing::stats() const {
+    LogRingStats stats;
+    stats.records = _records.load(std::memory_order_relaxed);
+    stats.overflows = _overflows.load(std::memory_order_relaxed);
+    stats.droppedBytes = _droppedBytes.load(std::memory_order_relaxed);
+    stats.highWater = _highWater.load(std::memory_order_relaxed);
+    return stats;
+}
+
+LogRingWriter::LogRingWriter(LogFile& file, std::size_t chunkSectors)
+    : _file(file),
+      _stage(new uint8_t[(chunkSectors ? chunkSectors : 1) * LOG_SECTOR_SIZE]),
+      _stageSize((chunkSectors ? chunkSectors : 1) * LOG_SECTOR_SIZE) {}
+
+void LogRingWriter::setPacking(std::size_t blockSize) {
+    _blockSize = blockSize < LOG_MAX_PACK_SIZE ? blockSize : LOG_MAX_PACK_SIZE;
+    _blockFill = 0;
+    if (_blockSize == 0) {
+        _lz.reset();
+        _block.reset();
+        _packed.reset();
+        return;
+    }
+    _lz.reset(new common::LZCompressor());
+    _block.reset(new uint8_t[_blockSize]);
+    _packed.reset(new uint8_t[packBound(_blockSize)]);
+}
+
+bool LogRingWriter::append(const uint8_t* data, std::size_t size, uint32_t nowMs) {
+    // whatever was drained before goes first
+    bool ok = _pack(nowMs);
+    _logged += size;
+    return _queue(data, size, nowMs) && ok;
+}
+
+bool LogRingWriter::_queue(const uint8_t* data, std::size_t size, uint32_t nowMs) {
+    bool ok = true;
+    while (size > 0) {
+        std::size_t take = size < _stageSize - _staged ? size : _stageSize - _staged;
+        std::memcpy(_stage.get() + _staged, data, take);
+        _staged += take;
+        data += take;
+        size -= take;
+        ok = _writeSectors(nowMs) && ok;
+    }
+    return ok;
+}
+
+bool LogRingWriter::drain(LogRing& ring, uint32_t nowMs, std::size_t max) {
+    bool ok = true;
+    if (_blockSize > 0) {
+        // a block at a time, a partial one waits for the next drain like a partial sector does
+        while (true) {
+            std::size_t room = _blockSize - _blockFill;
+            std::size_t taken = ring.pop(_block.get() + _blockFill, room < max ? room : max);
+            _blockFill += taken;
+            max -= taken;
+            if (_blockFill < _blockSize) {
+                return ok;
+            }
+            ok = _pack(nowMs) && ok;
+        }
+    }
+    while (true) {
+        std::size_t room = _stageSize - _staged;
+        std::size_t taken = ring.pop(_stage.get() + _staged, room < max ? room : max);
+        _staged += taken;
+        max -= taken;
+        if (_staged < LOG_SECTOR_SIZE) {
+            return ok;
+        }
+        ok = _writeSectors(nowMs) && ok;
+    }
+}
+
+bool LogRingWriter::finish(uint32_t nowMs) {
+    bool ok = _pack(nowMs);
+    ok = _writeSectors(nowMs) && ok;
+    if (_staged > 0) {
+        ok = _file.write(_stage.get(), _staged, nowMs) && ok;
+        _staged = 0;
+    }
+    // the next session is a new log
+    _logged = 0;
+    return _file.flush(nowMs) && ok;
+}
+
+bool LogRingWriter::_pack(uint32_t nowMs) {
+    if (_blockFill == 0) {
+        return true;
+    }
+    std::size_t size = packRecord(*_lz, _block.get(), _blockFill, _logged, _packed.get());
+    _logged += _blockFill;
+    _blockFill = 0;
+    return _queue(_packed.get(), size, nowMs);
+}
+
+bool LogRingWriter::_writeSectors(uint32_t nowMs) {
+    std::size_t whole = _staged / LOG_SECTOR_SIZE * LOG_SECTOR_SIZE;
+    if (whole == 0) {
+        return true;
+    }
+
+    bool ok = _file.write(_stage.get(), whole, nowMs);
+    if (!ok) {
+        // the chunk is gone either way, holding on to it would only stall the ring behind it
+        TELEM_DEBUG_PRINT_ERRORLN("Dropped %d bytes of log data", static_cast<int>(whole));
+    }
+
+    // keep the partial sector at the front for next time
+    _staged -= whole;
+    std::memmove(_stage.get(), _stage.get() + whole, _staged);
+    return ok;
+}
+
+}  // namespace remote
@@ -0,0 +1,136 @@
+#ifndef __LOG_RING_H__
+#define __LOG_RING_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "log_file.hpp"
+#include "log_format.hpp"
+#include "log_storage.hpp"
+
+namespace remote {
+
+/// @brief Counters describing how full a log ring has run
+struct LogRingStats {
+    uint32_t records = 0;       // records pushed
+    uint32_t overflows = 0;     // records dropped because the ring was full
+    uint32_t droppedBytes = 0;  // bytes in those records
+    uint32_t highWater = 0;     // most bytes ever waiting in the ring
+};
+
+/// @brief A preallocated ring of log bytes between one producer and one consumer. The producer
+/// never blocks: a record that does not fit is dropped whole and counted, so a card that stalls
+/// for tens of milliseconds costs records instead of holding up CAN ingest.
+class LogRing {
+   public:
+    /// @param capacity Size of the ring in bytes, rounded up to whole sectors
+    explicit LogRing(std::size_t capacity);
+
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    /// @brief Appends a record, called only from the producer
+    /// @return true if the record was queued, false if it was dropped
+    bool push(const uint8_t* data, std::size_t size);
+
+    /// @brief Takes bytes off the ring, called only from the consumer
+    /// @param out Where to copy the bytes
+    /// @param max The most bytes to take
+    /// @return The number of bytes taken
+    std::size_t pop(uint8_t* out, std::size_t max);
+
+    /// @brief Bytes waiting to be taken
+    std::size_t size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const { return _capacity; }
+
+    /// @brief Bytes ever pushed, a position in the stream of records that wraps with size_t.
+    /// Exact on the producer, and at least what has been taken anywhere else.
+    std::size_t pushed() const { return _head.load(std::memory_order_acquire); }
+
+    /// @brief Bytes ever taken, exact on the consumer
+    std::size_t popped() const { return _tail.load(std::memory_order_acquire); }
+
+    LogRingStats stats() const;
+
+   private:
+    std::unique_ptr<uint8_t[]> _buffer;
+    std::size_t _capacity;
+
+    // both only ever grow, the index into the buffer is the count modulo the capacity
+    std::atomic<std::size_t> _head{0};  // written by the producer
+    std::atomic<std::size_t> _tail{0};  // written by the consumer
+
+    std::atomic<uint32_t> _records{0};
+    std::atomic<uint32_t> _overflows{0};
+    std::atomic<uint32_t> _droppedBytes{0};
+    std::atomic<uint32_t> _highWater{0};
+};
+
+/// @brief Drains a log ring into a log file in whole sectors. Every write it makes is a multiple
+/// of LOG_SECTOR_SIZE and starts on a sector boundary of the file, so the card never has to read
+/// back a partial sector. Less than a sector is carried over to the next drain, and only written
+/// out when the session finishes. With packing on, what comes off the ring is compressed a block at
+/// a time into LRT_PACKED records before it is staged.
+class LogRingWriter {
+   public:
+    /// @param file The file to write to, written only through this writer from here on
+    /// @param chunkSectors The most sectors to write in a single call
+    LogRingWriter(LogFile& file, std::size_t chunkSectors);
+
+    LogRingWriter(const LogRingWriter&) = delete;
+    LogRingWriter& operator=(const LogRingWriter&) = delete;
+
+    /// @brief Packs what drain() takes off the ring from now on, see LRT_PACKED. Allocates what
+    /// packing needs, about 8 KiB plus twice the block size, so call it during setup.
+    /// @param blockSize Bytes of the log per packed record, capped at LOG_MAX_PACK_SIZE, 0 to
+    /// write them as they are
+    void setPacking(std::size_t blockSize);
+
+    /// @brief Queues bytes from the consumer's own thread, like a file header, ahead of anything
+    /// drained after it. They are never packed.
+    /// @return true if every sector that filled up was written
+    bool append(const uint8_t* data, std::size_t size, uint32_t nowMs);
+
+    /// @brief Writes out every whole sector waiting in the ring, or with packing on, every whole
+    /// block
+    /// @param ring The ring to drain
+    /// @param nowMs The current time, in milliseconds
+    /// @param max The most bytes to take off the ring, to stop at the end of a file that is being
+    /// rotated
+    /// @return true if every write succeeded
+    bool drain(LogRing& ring, uint32_t nowMs, std::size_t max = SIZE_MAX);
+
+    /// @brief Packs and writes what is left, down to the last partial sector, and flushes, for the
+    /// end of a session or of a file before it is rotated
+    /// @return true on success
+    bool finish(uint32_t nowMs);
+
+    /// @brief Bytes held back until a sector fills up
+    std::size_t staged() const { return _staged; }
+
+   private:
+    LogFile& _file;
+    std::unique_ptr<uint8_t[]> _stage;
+    std::size_t _stageSize;
+    std::size_t _staged = 0;
+    uint64_t _logged = 0;  // bytes of the unpacked log so far, where the next packed record starts
+
+    std::unique_ptr<common::LZCompressor> _lz;
+    std::unique_ptr<uint8_t[]> _block;   // what is being gathered for the next packed record
+    std::unique_ptr<uint8_t[]> _packed;  // the frame it turns into
+    std::size_t _blockSize = 0;
+    std::size_t _blockFill = 0;
+
+    bool _queue(const uint8_t* data, std::size_t size, uint32_t nowMs);
+    bool _pack(uint32_t nowMs);
+    bool _writeSectors(uint32_t nowMs);
+};
+
+}  // namespace remote
+
+#endif  // __LOG_RING_H__
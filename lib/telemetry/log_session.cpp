@@ -0,0 +1,215 @@
+#include "log_session.hpp"
+
+#include "telemetry_debug.hpp"
+
+namespace remote {
+
+LogSession::LogSession(LogStorage& storage, std::size_t ringSize, std::size_t writeSectors)
+    : _storage(storage),
+      _file(storage),
+      _sessions(storage),
+      _ring(ringSize),
+      _writer(_file, writeSectors) {}
+
+void LogSession::attach(can::CANBus& bus) {
+    _maxRecordSize = SnapshotEncoder::maxRecordSize(bus);
+    bus.setFrameListener([this](const can::CANMessage&, const can::RawCANMessage& frame) {
+        _logFrame(frame);
+    });
+}
+
+bool LogSession::open(const uint8_t* config, std::size_t configSize, uint32_t nowMs,
+                      uint32_t unixTime) {
+    // a record that can't be framed, or can't fit in the ring, would never make it to the card
+    if (_maxRecordSize > LOG_MAX_BODY_SIZE ||
+        LOG_FRAME_OVERHEAD + _maxRecordSize > _ring.capacity()) {
+        TELEM_DEBUG_PRINT_ERRORLN("Snapshots of up to %d bytes are too large to log",
+                                  static_cast<int>(_maxRecordSize));
+        _state = LOGGER_BAD;
+        return false;
+    }
+
+    _header.assign(LOG_MAGIC, LOG_MAGIC + LOG_MAGIC_SIZE);
+    for (std::size_t i = 0; i < 4; ++i) {
+        _header.push_back(static_cast<uint8_t>(configSize >> (8 * i)));
+    }
+    _header.insert(_header.end(), config, config + configSize);
+
+    // a session that lost power leaves its file preallocated, cut it back before starting anew
+    LogFile::recover(_storage);
+
+    // the log file stays open for the whole session, or until it is rotated
+    _filename = _nextFilename();
+    TELEM_DEBUG_PRINTLN("Logging to file %s", _filename.c_str());
+    if (!_file.open(_filename.c_str(), nowMs)) {
+        TELEM_DEBUG_PRINT_ERRORLN("Unable to open log file %s", _filename.c_str());
+        _state = LOGGER_BAD;
+        return false;
+    }
+    _openedMs = nowMs;
+    _writeHeader(nowMs);
+
+    // frames start right after the config, the index keeps track from there
+    _index.reset(_header.size());
+
+    _unixTime.store(unixTime);
+    _unixTimeMs.store(nowMs);
+    _state = LOGGER_GOOD;
+    return true;
+}
+
+void LogSession::capture(can::CANBus& bus, uint32_t nowMs) {
+    if (_state.load() != LOGGER_GOOD) {
+        return;
+    }
+    if (_closeRequested.load()) {
+        // tried again on the next capture if the ring is too full for it
+        _index.encodeFooter(_indexRecord);
+        if (_ring.push(_indexRecord.data(), _indexRecord.size())) {
+            _state = LOGGER_CLOSING;
+        }
+        return;
+    }
+    if (nowMs - _lastCaptureMs < _capturePeriodMs) {
+        return;
+    }
+    _lastCaptureMs = nowMs;
+
+    if (_rotateRequested.load() && !_rotating.load()) {
+        _endFile();
+    }
+
+    // the RTC lives on I2C, so the time is extrapolated from the last time the LOG task read it
+    uint32_t unixTime = _unixTime.load() + (nowMs - _unixTimeMs.load()) / 1000;
+
+    // mostly only what changed since the last record, with a full snapshot every so often
+    LogRecordType type = _snapshots.encode(bus, nowMs, unixTime, _record);
+    frameRecord(_record);
+    if (!_ring.push(_record.data(), _record.size())) {
+        // the records after a lost one can't build on it
+        _snapshots.forceKeyframe();
+        return;
+    }
+    _index.committed(_record.data(), _record.size());
+    if (type == LRT_SNAPSHOT) {
+        // the next event carries an absolute time, so decoding can start from this snapshot
+        _events.reset();
+    }
+
+    if (_index.blockDue()) {
+        _index.encodeBlock(_indexRecord);
+        if (_ring.push(_indexRecord.data(), _indexRecord.size())) {
+            _index.committed(_indexRecord.data(), _indexRecord.size());
+        }
+    }
+}
+
+void LogSession::drain(uint32_t nowMs, uint32_t unixTime) {
+    LoggerState state = _state.load();
+    if (state == LOGGER_BAD || state == LOGGER_CLOSED) {
+        return;
+    }
+
+    _unixTime.store(unixTime);
+    _unixTimeMs.store(nowMs);
+
+    bool ok = true;
+    if (_rotating.load()) {
+        // only what belongs to the old file, the rest waits for the new one
+        ok = _writer.drain(_ring, nowMs, _rotateAt - _ring.popped());
+        if (_ring.popped() == _rotateAt && !_rotate(nowMs)) {
+            return;
+        }
+    }
+    if (!_rotating.load()) {
+        ok = _writer.drain(_ring, nowMs) && ok;
+    }
+    if (!ok) {
+        TELEM_DEBUG_PRINT_ERRORLN("Write to %s failed", _filename.c_str());
+    }
+
+    LogRingStats stats = _ring.stats();
+    if (stats.overflows != _reportedOverflows) {
+        TELEM_DEBUG_PRINT_ERRORLN("Log ring overflowed, %d records dropped so far",
+                                  static_cast<int>(stats.overflows));
+        _reportedOverflows = stats.overflows;
+    }
+    TELEM_DEBUG_PRINTLN("File is %d bytes, ring high water %d of %d bytes",
+                        static_cast<int>(_file.bytesWritten()), static_cast<int>(stats.highWater),
+                        static_cast<int>(_ring.capacity()));
+
+    // the footer was the last thing pushed, so an empty ring means it is staged
+    if (state == LOGGER_CLOSING && _ring.size() == 0 && !_rotating.load()) {
+        _writer.finish(nowMs);
+        _file.close();
+        _state = LOGGER_CLOSED;
+        TELEM_DEBUG_PRINTLN("Closed log file %s", _filename.c_str());
+        return;
+    }
+
+    bool full = _rotateBytes > 0 && _file.bytesWritten() >= _rotateBytes;
+    bool old = _rotateMs > 0 && nowMs - _openedMs >= _rotateMs;
+    if (state == LOGGER_GOOD && (full || old) && !_rotating.load()) {
+        _rotateRequested.store(true);
+    }
+}
+
+std::string LogSession::_nextFilename() {
+    std::string dir = _directory ? _directory() : std::string();
+    return _sessions.next(dir, [&]() -> uint32_t { return _count ? _count(dir) : 0; });
+}
+
+void LogSession::_writeHeader(uint32_t nowMs) {
+    // records follow it in the same sectors
+    _writer.append(_header.data(), _header.size(), nowMs);
+}
+
+void LogSession::_endFile() {
+    _index.encodeFooter(_indexRecord);
+    if (!_ring.push(_indexRecord.data(), _indexRecord.size())) {
+        // tried again on the next capture
+        return;
+    }
+    _rotateAt = _ring.pushed();
+    _rotating.store(true);
+
+    // the new file's frames start after the same header, beginning with a full snapshot
+    _index.reset(_header.size());
+    _snapshots.forceKeyframe();
+    _events.reset();
+}
+
+bool LogSession::_rotate(uint32_t nowMs) {
+    _writer.finish(nowMs);
+    std::string previous = _filename;
+    // asked again, so files rotated after midnight go in the new day's directory
+    _filename = _nextFilename();
+    if (!_file.rotate(_filename.c_str(), nowMs)) {
+        TELEM_DEBUG_PRINT_ERRORLN("Rotating to %s failed", _filename.c_str());
+        _state = LOGGER_BAD;
+        return false;
+    }
+    _writeHeader(nowMs);
+    _openedMs = nowMs;
+    // only the LOG task writes the request, so it can't be raised again for the old file
+    _rotateRequested.store(false);
+    _rotating.store(false);
+    TELEM_DEBUG_PRINTLN("Rotated log file %s to %s", previous.c_str(), _filename.c_str());
+    return true;
+}
+
+void LogSession::_logFrame(const can::RawCANMessage& frame) {
+    if (_state.load() != LOGGER_GOOD) {
+        return;
+    }
+    std::size_t size = _events.encode(frame, _eventRecord + LOG_FRAME_HEADER_SIZE);
+    size = frameRecord(_eventRecord, size);
+    if (!_ring.push(_eventRecord, size)) {
+        // the next event can't be relative to one that never made it
+        _events.reset();
+        return;
+    }
+    _index.committed(_eventRecord, size);
+}
+
+}  // namespace remote
@@ -0,0 +1,176 @@
+#ifndef __LOG_SESSION_H__
+#define __LOG_SESSION_H__
+
+#include <atomic>
+#include <can.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "log_file.hpp"
+#include "log_format.hpp"
+#include "log_ring.hpp"
+#include "log_storage.hpp"
+
+namespace remote {
+
+enum LoggerState {
+    LOGGER_BAD,
+    LOGGER_GOOD,
+    LOGGER_CLOSING,  // the footer is in the log ring, the file closes once it is written
+    LOGGER_CLOSED
+};
+
+/// @brief A logging session on any storage, from the first file to the footer of the last. The CAN
+/// task feeds it with capture() and frame events, the LOG task writes it out with drain(), and
+/// neither ever waits on the other: the CAN task only pushes into the log ring, and the LOG task
+/// only takes from it.
+///
+/// Files are rotated once they reach a size or an age. The LOG task asks for it, the CAN task ends
+/// the file in the ring at a record boundary and carries straight on with the next, then the LOG
+/// task writes up to there, closes the file, opens the next in whatever directory it is given at
+/// that point, and clears the request.
+class LogSession {
+   public:
+    static constexpr std::size_t DEFAULT_RING_SIZE = 32 * 1024;  // a few hundred ms of a stalled card
+    static constexpr std::size_t DEFAULT_WRITE_SECTORS = 8;      // 4 KiB per write call
+
+    /// @param storage Where the files go
+    /// @param ringSize The size of the log ring, in bytes
+    /// @param writeSectors The most sectors to write in a single call
+    explicit LogSession(LogStorage& storage, std::size_t ringSize = DEFAULT_RING_SIZE,
+                        std::size_t writeSectors = DEFAULT_WRITE_SECTORS);
+
+    LogSession(const LogSession&) = delete;
+    LogSession& operator=(const LogSession&) = delete;
+
+    /// @brief Sets where files go, asked when the session opens and again on every rotation, so a
+    /// session that runs past midnight moves on to the new day's directory
+    /// @param directory Returns the directory, without a trailing slash, creating it if needed
+    void setDirectory(std::function<std::string()> directory) { _directory = directory; }
+
+    /// @brief Sets how the files of a directory are counted, only needed when its session counter
+    /// is missing or damaged, see LogSessionCounter
+    void setFileCounter(std::function<uint32_t(const std::string&)> count) { _count = count; }
+
+    /// @brief Logs every frame of the bus's MLM_EVENT messages as it arrives, on top of the
+    /// snapshots. Call during setup, frames then come in on the task that updates the bus.
+    /// @param bus The bus, initialized
+    void attach(can::CANBus& bus);
+
+    /// @brief Sets how often the bus is snapshotted into the log
+    void setCapturePeriod(uint32_t periodMs) { _capturePeriodMs = periodMs; }
+
+    /// @brief Sets how many records apart full snapshots are, the ones between only carry changes
+    void setKeyframeInterval(uint32_t records) { _snapshots.setKeyframeInterval(records); }
+
+    /// @brief Sets when the log file is flushed, takes effect right away
+    void setFileOptions(LogFileOptions options) { _file.setOptions(options); }
+
+    /// @brief Compresses the log this many bytes at a time, 0 to write it uncompressed. Call
+    /// during setup, it allocates the buffers packing needs.
+    void setPacking(std::size_t blockBytes) { _writer.setPacking(blockBytes); }
+
+    /// @brief Moves on to a new file once the current one reaches a size or an age, 0 for no
+    /// limit. Logging carries on into the ring while the old file is closed.
+    void setRotation(uint32_t maxBytes, uint32_t maxMs) {
+        _rotateBytes = maxBytes;
+        _rotateMs = maxMs;
+    }
+
+    /// @brief Cuts back a file a previous session left preallocated, then opens the first file and
+    /// queues its header. Runs on the LOG task.
+    /// @param config The config the bus was built from, copied into the head of every file
+    /// @param configSize Its size
+    /// @param nowMs The millisecond clock
+    /// @param unixTime The wall clock
+    /// @return false if the session can't log, state() is then LOGGER_BAD
+    bool open(const uint8_t* config, std::size_t configSize, uint32_t nowMs, uint32_t unixTime);
+
+    /// @brief Ends the session. The CAN task puts the index footer into the log on its next
+    /// capture(), then the LOG task writes it out and closes the file.
+    void close() { _closeRequested.store(true); }
+
+    /// @brief Snapshots the bus into the log ring once a log period has passed. Runs on the CAN
+    /// task and never touches the storage, so it doesn't block when the card stalls.
+    /// @param bus The bus to snapshot
+    /// @param nowMs The millisecond clock
+    void capture(can::CANBus& bus, uint32_t nowMs);
+
+    /// @brief Writes whatever whole sectors are waiting in the log ring out to the file, rotating
+    /// or closing it when due. Runs on the LOG task.
+    /// @param nowMs The millisecond clock
+    /// @param unixTime The wall clock, which captures extrapolate from until the next drain
+    void drain(uint32_t nowMs, uint32_t unixTime);
+
+    LoggerState state() const { return _state.load(); }
+
+    /// @brief The file being written, only stable on the LOG task
+    const std::string& filename() const { return _filename; }
+
+    /// @brief Counters for the log ring, safe to read from any task
+    LogRingStats ringStats() const { return _ring.stats(); }
+
+   private:
+    std::atomic<LoggerState> _state{LOGGER_BAD};
+    std::function<std::string()> _directory;
+    std::function<uint32_t(const std::string&)> _count;
+    std::string _filename;
+    std::vector<uint8_t> _header;  // the magic and the config, repeated at the head of every file
+
+    LogStorage& _storage;
+    LogFile _file;
+    LogSessionCounter _sessions;
+    LogRing _ring;
+    LogRingWriter _writer;
+    uint32_t _reportedOverflows = 0;
+    std::atomic<bool> _closeRequested{false};
+
+    // rotation, the LOG task is the only one to raise or clear the request
+    uint32_t _rotateBytes = 0;
+    uint32_t _rotateMs = 0;
+    uint32_t _openedMs = 0;
+    std::atomic<bool> _rotateRequested{false};
+    std::atomic<bool> _rotating{false};
+    std::size_t _rotateAt = 0;  // where the old file ends in the ring, set before _rotating
+
+    // owned by the CAN task
+    std::vector<uint8_t> _record;  // reused for every record, grows once to the record size
+    SnapshotEncoder _snapshots;
+    LogIndexWriter _index;
+    std::vector<uint8_t> _indexRecord;
+    uint32_t _capturePeriodMs = 100;
+    uint32_t _lastCaptureMs = 0;
+    std::size_t _maxRecordSize = 0;  // of the attached bus, checked before logging starts
+
+    // the last wall clock reading, and the millisecond clock when it was taken
+    std::atomic<uint32_t> _unixTime{0};
+    std::atomic<uint32_t> _unixTimeMs{0};
+
+    // owned by the CAN task as well, events share the ring with snapshots
+    EventEncoder _events;
+    uint8_t _eventRecord[LOG_FRAME_OVERHEAD + EventEncoder::MAX_RECORD_SIZE];
+
+    /// @brief Claims the next file name, in the directory as of now
+    std::string _nextFilename();
+
+    /// @brief Queues the header at the start of the file, runs on the LOG task
+    void _writeHeader(uint32_t nowMs);
+
+    /// @brief Ends the current file in the ring with its footer, and starts the next one so it
+    /// can be decoded on its own. Runs on the CAN task, which keeps logging right after.
+    void _endFile();
+
+    /// @brief Closes the file that was just written up to its footer and opens the next, runs on
+    /// the LOG task
+    /// @return false if logging can't go on
+    bool _rotate(uint32_t nowMs);
+
+    void _logFrame(const can::RawCANMessage& frame);
+};
+
+}  // namespace remote
+
+#endif  // __LOG_SESSION_H__
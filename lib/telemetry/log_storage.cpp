@@ -0,0 +1,166 @@
+#include "log_storage.hpp"
+
+#include <algorithm>
+
+namespace remote {
+
+bool MockLogStorage::open(const char* path) {
+    _elapsedUs += _costs.openUs;
+    ++_opens;
+    if (_failOpens) {
+        return false;
+    }
+    _open = &_files[path];
+    _position = _open->size();
+    return true;
+}
+
+std::size_t MockLogStorage::write(const uint8_t* data, std::size_t size) {
+    if (!_open) {
+        return 0;
+    }
+    _elapsedUs += _costs.writeCallUs + size * 1000 / _costs.writeBytesPerMs;
+    ++_writes;
+    if (size % LOG_SECTOR_SIZE != 0 || _position % LOG_SECTOR_SIZE != 0) {
+        ++_unalignedWrites;
+    }
+    if (_failWrites > 0) {
+        --_failWrites;
+        return 0;
+    }
+    _elapsedUs += _grow(_position + size) * _costs.allocateUs;
+    std::copy(data, data + size, _open->begin() + _position);
+    _position += size;
+    return size;
+}
+
+std::size_t MockLogStorage::read(std::size_t position, uint8_t* data, std::size_t size) {
+    if (!_open || position >= _open->size()) {
+        return 0;
+    }
+    std::size_t available = _open->size() - position;
+    size = size < available ? size : available;
+    std::copy(_open->begin() + position, _open->begin() + position + size, data);
+    return size;
+}
+
+bool MockLogStorage::seek(std::size_t position) {
+    if (!_open || position > _open->size()) {
+        return false;
+    }
+    _position = position;
+    return true;
+}
+
+bool MockLogStorage::preallocate(std::size_t size) {
+    if (!_open) {
+        return false;
+    }
+    // the whole chain is linked in one pass over the FAT, not one search per cluster
+    std::size_t clusters = _grow(size);
+    if (clusters > 0) {
+        // and committed right away, like the card does
+        _elapsedUs += _costs.allocateUs + clusters * _costs.chainClusterUs + _costs.flushUs;
+        _fatDirty = false;
+    }
+    return true;
+}
+
+bool MockLogStorage::truncate(std::size_t size) {
+    if (!_open || size > _open->size()) {
+        return false;
+    }
+    _open->resize(size);
+    _position = _position < size ? _position : size;
+    return true;
+}
+
+std::size_t MockLogStorage::_grow(std::size_t size) {
+    if (size <= _open->size()) {
+        return 0;
+    }
+    // every cluster the file reaches into for the first time has to be allocated
+    std::size_t before = (_open->size() + _costs.clusterBytes - 1) / _costs.clusterBytes;
+    std::size_t after = (size + _costs.clusterBytes - 1) / _costs.clusterBytes;
+    _allocations += after - before;
+    _fatDirty = _fatDirty || after > before;
+    _open->resize(size, _fill);
+    return after - before;
+}
+
+bool MockLogStorage::flush() {
+    if (!_open) {
+        return false;
+    }
+    _elapsedUs += _fatDirty ? _costs.flushUs : _costs.syncUs;
+    _fatDirty = false;
+    ++_flushes;
+    return true;
+}
+
+void MockLogStorage::close() {
+    if (!_open) {
+        return;
+    }
+    _elapsedUs += _costs.closeUs;
+    ++_closes;
+    _open = nullptr;
+    _fatDirty = false;
+}
+
+bool MockLogStorage::writeFile(const char* path, const uint8_t* data, std::size_t size) {
+    if (_rewriting == path) {
+        _rewriting.clear();
+    }
+    _elapsedUs += _costs.openUs + _costs.writeCallUs + _costs.closeUs;
+    std::vector<uint8_t>& file = _files[path];
+    file.assign(data, data + size);
+    return true;
+}
+
+bool MockLogStorage::rewriteFile(const char* path, const uint8_t* data, std::size_t size) {
+    if (_rewriting != path) {
+        // the handle from before is closed, this one stays open for the next rewrite
+        _elapsedUs += _costs.openUs + (_rewriting.empty() ? 0 : _costs.closeUs);
+        ++_rewriteOpens;
+        _rewriting = path;
+    }
+    _elapsedUs += _costs.writeCallUs + _costs.rewriteUs;
+    ++_rewrites;
+    std::vector<uint8_t>& file = _files[path];
+    if (file.size() < size) {
+        file.resize(size);
+    }
+    std::copy(data, data + size, file.begin());
+    return true;
+}
+
+std::size_t MockLogStorage::readFile(const char* path, uint8_t* data, std::size_t capacity) {
+    auto it = _files.find(path);
+    if (it == _files.end()) {
+        return 0;
+    }
+    std::size_t size = it->second.size() < capacity ? it->second.size() : capacity;
+    std::copy(it->second.begin(), it->second.begin() + size, data);
+    return size;
+}
+
+bool MockLogStorage::removeFile(const char* path) {
+    auto it = _files.find(path);
+    if (it == _files.end() || &it->second == _open) {
+        return false;
+    }
+    if (_rewriting == path) {
+        _rewriting.clear();
+    }
+    _files.erase(it);
+    return true;
+}
+
+const std::vector<uint8_t>& MockLogStorage::contents(const std::string& path) const {
+    static const std::vector<uint8_t> NONE;
+    auto it = _files.find(path);
+    return it == _files.end() ? NONE : it->second;
+}
+
+}  // namespace remote
@@ -0,0 +1,170 @@
+#ifndef __LOG_STORAGE_H__
+#define __LOG_STORAGE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace remote {
+
+/// @brief The card's block size, writes of whole, aligned sectors skip the read-modify-write
+constexpr std::size_t LOG_SECTOR_SIZE = 512;
+
+/// @brief Where log files end up, the SD card on the device and memory in tests.
+/// One file is open at a time, and it is written front to back.
+class LogStorage {
+   public:
+    virtual ~LogStorage() = default;
+
+    /// @brief Opens a file for writing at its end, creating it if it doesn't exist
+    /// @param path The path of the file
+    /// @return true on success
+    virtual bool open(const char* path) = 0;
+
+    /// @brief Writes at the current position of the open file, and moves past what was written
+    /// @return The number of bytes written, less than size on error
+    virtual std::size_t write(const uint8_t* data, std::size_t size) = 0;
+
+    /// @brief Reads from the open file without moving the write position
+    /// @return The number of bytes read
+    virtual std::size_t read(std::size_t position, uint8_t* data, std::size_t size) = 0;
+
+    /// @brief Moves the write position of the open file
+    /// @return true on success
+    virtual bool seek(std::size_t position) = 0;
+
+    /// @brief Grows the open file to size bytes ahead of time, so the clusters are allocated now
+    /// and not while writing. The write position doesn't move. What the new space holds is
+    /// undefined, on a card it is usually whatever the clusters held before.
+    /// @return true on success, or if the file is already that big
+    virtual bool preallocate(std::size_t size) = 0;
+
+    /// @brief Cuts the open file down to size bytes
+    /// @return true on success
+    virtual bool truncate(std::size_t size) = 0;
+
+    /// @brief Commits everything written so far, including the file's size in the directory
+    /// @return true on success
+    virtual bool flush() = 0;
+
+    virtual void close() = 0;
+
+    virtual bool isOpen() const = 0;
+
+    /// @brief The size of the open file, in bytes, preallocated space included
+    virtual std::size_t size() const = 0;
+
+    /// @brief Replaces a small file in one go, without disturbing the open file
+    /// @return true on success
+    virtual bool writeFile(const char* path, const uint8_t* data, std::size_t size) = 0;
+
+    /// @brief Overwrites a small file from its start in place, creating it if it doesn't exist, and
+    /// commits it, without disturbing the open file. Nothing past size is cut off. Its handle
+    /// stays open until another file is rewritten or it is written or removed, so rewriting the
+    /// same bytes again costs a sector write and no directory walk or cluster allocation.
+    /// @return true on success
+    virtual bool rewriteFile(const char* path, const uint8_t* data, std::size_t size) = 0;
+
+    /// @brief Reads a small file in one go, without disturbing the open file
+    /// @return The number of bytes read, zero if the file doesn't exist
+    virtual std::size_t readFile(const char* path, uint8_t* data, std::size_t capacity) = 0;
+
+    /// @brief Deletes a file that isn't open
+    /// @return true if it existed and was removed
+    virtual bool removeFile(const char* path) = 0;
+};
+
+/// @brief Simulated cost of each filesystem operation, in microseconds
+struct MockStorageCosts {
+    uint32_t openUs = 4000;          // walking the directory and the FAT chain to the file's end
+    uint32_t closeUs = 3000;         // writing back the directory entry and the FAT
+    uint32_t flushUs = 3000;         // the same metadata update as a close
+    uint32_t syncUs = 1000;          // a flush with no clusters allocated since the last one, the
+                                     // FAT is clean and only the directory entry is written back
+    uint32_t writeCallUs = 40;       // per call, regardless of size
+    uint32_t writeBytesPerMs = 800;  // sustained data rate of the card
+    uint32_t allocateUs = 2500;      // finding and linking a free cluster as a write grows the file
+    uint32_t chainClusterUs = 20;    // each cluster of a chain linked in one go by preallocate()
+    uint32_t rewriteUs = 1000;       // a sector rewritten in place, committed like a sync
+    uint32_t clusterBytes = 32768;
+};
+
+/// @brief In-memory storage for tests. Keeps every file it was given, counts operations, and adds
+/// up what they would have cost on a card into a simulated clock.
+class MockLogStorage : public LogStorage {
+   public:
+    explicit MockLogStorage(MockStorageCosts costs = MockStorageCosts()) : _costs(costs) {}
+
+    bool open(const char* path) override;
+    std::size_t write(const uint8_t* data, std::size_t size) override;
+    std::size_t read(std::size_t position, uint8_t* data, std::size_t size) override;
+    bool seek(std::size_t position) override;
+    bool preallocate(std::size_t size) override;
+    bool truncate(std::size_t size) override;
+    bool flush() override;
+    void close() override;
+    bool isOpen() const override { return _open != nullptr; }
+    std::size_t size() const override { return _open ? _open->size() : 0; }
+    bool writeFile(const char* path, const uint8_t* data, std::size_t size) override;
+    bool rewriteFile(const char* path, const uint8_t* data, std::size_t size) override;
+    std::size_t readFile(const char* path, uint8_t* data, std::size_t capacity) override;
+    bool removeFile(const char* path) override;
+
+    /// @brief The contents of a file, empty if it was never created
+    const std::vector<uint8_t>& contents(const std::string& path) const;
+    bool exists(const std::string& path) const { return _files.count(path) != 0; }
+
+    /// @brief Makes the next `count` writes fail outright
+    void failWrites(std::size_t count) { _failWrites = count; }
+
+    /// @brief Makes opens fail from now on, until cleared
+    void failOpens(bool fail) { _failOpens = fail; }
+
+    /// @brief Fills the space files grow into with this byte instead of zeros, like the stale
+    /// clusters of an old log a card hands back
+    void fillGrowth(uint8_t byte) { _fill = byte; }
+
+    uint64_t elapsedUs() const { return _elapsedUs; }
+    std::size_t opens() const { return _opens; }
+    std::size_t closes() const { return _closes; }
+    std::size_t flushes() const { return _flushes; }
+    std::size_t writes() const { return _writes; }
+    std::size_t allocations() const { return _allocations; }
+
+    /// @brief Calls to rewriteFile(), and how many of them had to open the file first
+    std::size_t rewrites() const { return _rewrites; }
+    std::size_t rewriteOpens() const { return _rewriteOpens; }
+
+    /// @brief Writes that were not a whole number of sectors, or did not start on a sector
+    std::size_t unalignedWrites() const { return _unalignedWrites; }
+
+   private:
+    MockStorageCosts _costs;
+    std::map<std::string, std::vector<uint8_t>> _files;
+    std::vector<uint8_t>* _open = nullptr;
+    std::size_t _position = 0;
+    bool _fatDirty = false;  // clusters were allocated since the last flush
+    std::string _rewriting;  // the file rewriteFile() holds open, empty for none
+
+    std::size_t _failWrites = 0;
+    bool _failOpens = false;
+    uint8_t _fill = 0;
+
+    uint64_t _elapsedUs = 0;
+    std::size_t _opens = 0;
+    std::size_t _closes = 0;
+    std::size_t _flushes = 0;
+    std::size_t _writes = 0;
+    std::size_t _unalignedWrites = 0;
+    std::size_t _allocations = 0;
+    std::size_t _rewrites = 0;
+    std::size_t _rewriteOpens = 0;
+
+    std::size_t _grow(std::size_t size);
+};
+
+}  // namespace remote
+
+#endif  // __LOG_STORAGE_H__
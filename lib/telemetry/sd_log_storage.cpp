@@ -0,0 +1,161 @@
+#ifndef __PLATFORM_NATIVE
+
+#include "sd_log_storage.hpp"
+
+#include <sd_manager.hpp>
+
+#include "telemetry_debug.hpp"
+
+namespace remote {
+
+bool SDLogStorage::open(const char* path) {
+    close();
+
+    // not append mode, which would ignore seeks and always write past preallocated space
+    bool existing = _manager.exists(path);
+    common::Option<fs::File> fileOpt = _manager.openLongLived(path, existing ? "r+" : "w+");
+    if (fileOpt.isNone()) {
+        return false;
+    }
+    _file = fileOpt.value();
+    _path = path;
+    // one seek at open, none per record
+    return _file.seek(_file.size());
+}
+
+std::size_t SDLogStorage::write(const uint8_t* data, std::size_t size) {
+    if (!_file) {
+        return 0;
+    }
+    return _file.write(data, size);
+}
+
+std::size_t SDLogStorage::read(std::size_t position, uint8_t* data, std::size_t size) {
+    if (!_file) {
+        return 0;
+    }
+    std::size_t at = _file.position();
+    std::size_t read = _file.seek(position) ? _file.read(data, size) : 0;
+    _file.seek(at);
+    return read;
+}
+
+bool SDLogStorage::seek(std::size_t position) {
+    return _file && _file.seek(position);
+}
+
+bool SDLogStorage::preallocate(std::size_t size) {
+    if (!_file) {
+        return false;
+    }
+    if (_file.size() >= size) {
+        return true;
+    }
+    // writing the last byte makes FatFs link the whole cluster chain up to it in one go, the
+    // clusters keep whatever they held, so only the session marker says where the data ends
+    std::size_t at = _file.position();
+    uint8_t zero = 0;
+    bool ok = _file.seek(size - 1) && _file.write(&zero, 1) == 1;
+    _file.flush();
+    return _file.seek(at) && ok;
+}
+
+bool SDLogStorage::truncate(std::size_t size) {
+    if (!_file) {
+        return false;
+    }
+    // the VFS truncates by path, so the handle is closed around it
+    std::size_t at = _file.position();
+    _file.close();
+    bool ok = _manager.truncate(_path.c_str(), size);
+    common::Option<fs::File> fileOpt = _manager.openLongLived(_path.c_str(), "r+");
+    if (fileOpt.isNone()) {
+        _file = fs::File();
+        return false;
+    }
+    _file = fileOpt.value();
+    return _file.seek(at < size ? at : size) && ok;
+}
+
+bool SDLogStorage::flush() {
+    if (!_file) {
+        return false;
+    }
+    _file.flush();
+    return true;
+}
+
+void SDLogStorage::close() {
+    if (_file) {
+        _file.close();
+    }
+    _file = fs::File();
+}
+
+bool SDLogStorage::isOpen() const {
+    return static_cast<bool>(_file);
+}
+
+std::size_t SDLogStorage::size() const {
+    return _file ? _file.size() : 0;
+}
+
+bool SDLogStorage::writeFile(const char* path, const uint8_t* data, std::size_t size) {
+    _dropRewrite(path);
+    common::Option<fs::File> fileOpt = _manager.openLongLived(path, FILE_WRITE);
+    if (fileOpt.isNone()) {
+        return false;
+    }
+    fs::File file = fileOpt.value();
+    bool ok = file.write(data, size) == size;
+    file.close();
+    return ok;
+}
+
+bool SDLogStorage::rewriteFile(const char* path, const uint8_t* data, std::size_t size) {
+    if (!_rewriting || _rewritingPath != path) {
+        _dropRewrite(_rewritingPath.c_str());
+        // r+ so the file isn't truncated, its size and clusters stay as they are
+        bool existing = _manager.exists(path);
+        common::Option<fs::File> fileOpt = _manager.openLongLived(path, existing ? "r+" : "w+");
+        if (fileOpt.isNone()) {
+            return false;
+        }
+        _rewriting = fileOpt.value();
+        _rewritingPath = path;
+    }
+    bool ok = _rewriting.seek(0) && _rewriting.write(data, size) == size;
+    _rewriting.flush();
+    return ok;
+}
+
+std::size_t SDLogStorage::readFile(const char* path, uint8_t* data, std::size_t capacity) {
+    if (!_manager.exists(path)) {
+        return 0;
+    }
+    common::Option<fs::File> fileOpt = _manager.openLongLived(path, FILE_READ);
+    if (fileOpt.isNone()) {
+        return 0;
+    }
+    fs::File file = fileOpt.value();
+    std::size_t read = file.read(data, capacity);
+    file.close();
+    return read;
+}
+
+bool SDLogStorage::removeFile(const char* path) {
+    _dropRewrite(path);
+    return _manager.remove(path);
+}
+
+void SDLogStorage::_dropRewrite(const char* path) {
+    if (_rewriting && _rewritingPath == path) {
+        _rewriting.close();
+        _rewriting = fs::File();
+        _rewritingPath.clear();
+    }
+}
+
+}  // namespace remote
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef __SD_LOG_STORAGE_H__
+#define __SD_LOG_STORAGE_H__
+
+#ifndef __PLATFORM_NATIVE
+
+#include <SD.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "log_storage.hpp"
+
+namespace remote {
+
+class SDManager;
+
+/// @brief Log storage on the SD card, holding one file handle open for as long as it is used, and
+/// another for the small file that is rewritten in place
+class SDLogStorage : public LogStorage {
+   public:
+    explicit SDLogStorage(SDManager& manager) : _manager(manager) {}
+
+    bool open(const char* path) override;
+    std::size_t write(const uint8_t* data, std::size_t size) override;
+    std::size_t read(std::size_t position, uint8_t* data, std::size_t size) override;
+    bool seek(std::size_t position) override;
+    bool preallocate(std::size_t size) override;
+    bool truncate(std::size_t size) override;
+    bool flush() override;
+    void close() override;
+    bool isOpen() const override;
+    std::size_t size() const override;
+    bool writeFile(const char* path, const uint8_t* data, std::size_t size) override;
+    bool rewriteFile(const char* path, const uint8_t* data, std::size_t size) override;
+    std::size_t readFile(const char* path, uint8_t* data, std::size_t capacity) override;
+    bool removeFile(const char* path) override;
+
+   private:
+    SDManager& _manager;
+    fs::File _file;
+    std::string _path;
+    fs::File _rewriting;  // kept open by rewriteFile()
+    std::string _rewritingPath;
+
+    /// @brief Closes the rewriteFile() handle if it is on this path
+    void _dropRewrite(const char* path);
+};
+
+}  // namespace remote
+
+#endif
+#endif  // __SD_LOG_STORAGE_H__
@@ -5,125 +5,108 @@
 #include <SD.h>
 
 #include <can.hpp>
+#include <log_file.hpp>
+#include <log_session.hpp>
 #include <option.hpp>
+#include <sd_log_storage.hpp>
 #include <sd_manager.hpp>
 #include <sstream>
-#include <mutex>
-#include <iomanip>
+#include <vector>
 
 #include "remote_debug.hpp"
 
 namespace remote {
 
-enum LoggerState { LOGGER_BAD, LOGGER_GOOD };
-
-static std::vector<uint8_t> __HEADER = {'N', 'F', 'R', '2', '5', '1', '0', '0', '\n'};
-
+/// @brief Logs to the SD card, with files in a directory per day. The session itself, rotation
+/// and closing included, is a LogSession; this only brings the card, the RTC and the config file.
 class SDLogger {
    public:
     SDLogger(SDManager& manager, RTC_PCF8523& rtc)
-        : _manager(manager), _rtc(rtc), _state(LoggerState::LOGGER_BAD) {}
-
-    void initialize() {
-        // create a file name from the date
-        DateTime time = _rtc.now();
-        String dateTime = time.timestamp(DateTime::TIMESTAMP_DATE);
-
-        std::stringstream ss;
-        ss << "/" << dateTime.c_str();
-        _dir = ss.str();
+        : _manager(manager), _rtc(rtc), _storage(manager), _session(_storage) {
+        _session.setDirectory([this]() { return _today(); });
+        _session.setFileCounter(
+            [this](const std::string& dir) { return _manager.numFilesInDir(dir.c_str()); });
+    }
 
-        REMOTE_DEBUG_PRINTLN("Creating directory %s", _dir.c_str());
-        _manager.createDir(_dir.c_str());
+    /// @brief See LogSession::attach()
+    void attach(can::CANBus& bus) { _session.attach(bus); }
 
-        int numFiles = _manager.numFilesInDir(_dir.c_str());
+    /// @brief Sets how often the bus is snapshotted into the log
+    void setCapturePeriod(uint32_t periodMs) { _session.setCapturePeriod(periodMs); }
 
-        ss << "/log_" << numFiles << ".daq";
-        _filename = ss.str();
-        REMOTE_DEBUG_PRINTLN("Logging to file %s", _filename.c_str());
+    /// @brief Sets how many records apart full snapshots are, the ones between only carry changes
+    void setKeyframeInterval(uint32_t records) { _session.setKeyframeInterval(records); }
 
-        // open the file and create the header
-        FileGuard logGuard(_manager, _filename.c_str(), FILE_WRITE, FGB_CLOSE_ON_DESTRUCTION, true);
-        common::Option<fs::File> logFileOpt = logGuard.file();
-        if (logFileOpt.isNone()) {
-            REMOTE_DEBUG_PRINT_ERRORLN("Unable to log! File can't be opened!");
-            _state = LOGGER_BAD;
-            return;
-        }
+    /// @brief Sets when the log file is flushed, takes effect right away
+    void setFileOptions(LogFileOptions options) { _session.setFileOptions(options); }
 
-        fs::File logFile = logFileOpt.value();
+    /// @brief See LogSession::setPacking()
+    void setPacking(std::size_t blockBytes) { _session.setPacking(blockBytes); }
 
-        _state = LOGGER_GOOD;
+    /// @brief See LogSession::setRotation()
+    void setRotation(uint32_t maxBytes, uint32_t maxMs) { _session.setRotation(maxBytes, maxMs); }
 
-        // open the file and create the header
+    void initialize() {
+        // every file of the session starts with a copy of the config, read once here
         FileGuard configGuard(_manager, "/config.telem", FILE_READ, FGB_CLOSE_ON_DESTRUCTION,
                               false);
         common::Option<fs::File> configFileOpt = configGuard.file();
         if (configFileOpt.isNone()) {
             REMOTE_DEBUG_PRINT_ERRORLN("Unable to log! Config file can't be opened!");
-            _state = LOGGER_BAD;
             return;
         }
-
-        // write the header
         fs::File configFile = configFileOpt.value();
-
-        logFile.write(__HEADER.data(), __HEADER.size());
-
-        // copy over the config file
-        uint8_t buf[128];
-        while (configFile.available()) {
-            size_t read = configFile.read(buf, 128);
-            logFile.write(buf, read);
+        std::vector<uint8_t> config(configFile.size());
+        if (configFile.read(config.data(), config.size()) != config.size()) {
+            REMOTE_DEBUG_PRINT_ERRORLN("Unable to log! Config file can't be read!");
+            return;
         }
-    }
 
-    void log(can::CANBus& bus) {
-        if (_state == LOGGER_BAD) {
-            REMOTE_DEBUG_PRINT_ERRORLN("Unable to log! Logger state is bad!");
+        if (!_session.open(config.data(), config.size(), millis(), _rtc.now().unixtime())) {
+            REMOTE_DEBUG_PRINT_ERRORLN("Unable to log! The session can't be opened!");
         }
+    }
 
-        FileGuard guard(_manager, _filename.c_str(), FILE_WRITE, FGB_CLOSE_ON_DESTRUCTION, false);
+    /// @brief See LogSession::close()
+    void close() { _session.close(); }
 
-        common::Option<fs::File> fileOpt = guard.file();
+    /// @brief See LogSession::capture(), runs on the CAN task
+    void capture(can::CANBus& bus, uint32_t nowMs) { _session.capture(bus, nowMs); }
 
-        if (fileOpt.isNone()) {
-            REMOTE_DEBUG_PRINT_ERRORLN("Unable to log! File can't be opened!");
-            _state = LOGGER_BAD;
+    /// @brief See LogSession::drain(), runs on the LOG task
+    void drain() {
+        if (_session.state() == LOGGER_BAD) {
+            REMOTE_DEBUG_PRINT_ERRORLN("Unable to log! Logger state is bad!");
             return;
         }
+        _session.drain(millis(), _rtc.now().unixtime());
+    }
 
-        fs::File file = fileOpt.value();
-
-        // go to the end of the file
-        file.seek(file.size());
+    /// @brief Counters for the log ring, safe to read from any task
+    LogRingStats ringStats() const { return _session.ringStats(); }
 
-        // write the time
-        uint32_t time = millis();
+   private:
+    SDManager& _manager;
+    RTC_PCF8523& _rtc;
+    SDLogStorage _storage;
+    LogSession _session;
 
-        file.write((uint8_t*)(&time), sizeof(uint32_t));
+    /// @brief The directory for today's logs, created if it isn't there yet. Runs on the LOG task,
+    /// when the session opens and on every rotation.
+    std::string _today() {
+        DateTime time = _rtc.now();
+        String date = time.timestamp(DateTime::TIMESTAMP_DATE);
 
-        uint32_t unixTime = _rtc.now().unixtime();
+        std::stringstream ss;
+        ss << "/" << date.c_str();
+        std::string dir = ss.str();
 
-        file.write((uint8_t*)(&unixTime), sizeof(uint32_t));
-        {
-            std::lock_guard<std::mutex>(bus.bufMutex());
-            std::size_t size;
-            const uint8_t* buffer = bus.dataBuffer(&size);
-            std::size_t actualSize = file.write(buffer, size);
-            REMOTE_DEBUG_PRINTLN("Attempted to write %d bytes. Wrote %d bytes.", size, actualSize);
-            REMOTE_DEBUG_PRINTLN("File is %lld bytes!", file.size());
-        }
+        REMOTE_DEBUG_PRINTLN("Creating directory %s", dir.c_str());
+        _manager.createDir(dir.c_str());
+        return dir;
     }
-
-   private:
-    std::string _dir;
-    std::string _filename;
-    SDManager& _manager;
-    RTC_PCF8523& _rtc;
-    LoggerState _state;
 };
 
 }  // namespace remote
 
-#endif  // __SD_LOGGER_H__
\ No newline at end of file
+#endif  // __SD_LOGGER_H__
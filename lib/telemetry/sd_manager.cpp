@@ -2,6 +2,10 @@
 
 #include "sd_manager.hpp"
 
+#include <unistd.h>
+
+#include <string>
+
 #include "FS.h"
 #include "SD.h"
 #include "ff.h"
@@ -147,6 +151,20 @@ void SDManager::createDir(const char* dir) {
     }
 }
 
+common::Option<fs::File> SDManager::openLongLived(const char* path, const char* mode) {
+    if (_managerStatus == SD_BAD) {
+        TELEM_DEBUG_PRINT_ERRORLN("Unable to open file %s! SDManager in a bad state!", path);
+        return common::Option<fs::File>::none();
+    }
+
+    fs::File f = _sd.open(path, mode, true);
+    if (!f) {
+        TELEM_DEBUG_PRINT_ERRORLN("Unable to open file %s", path);
+        return common::Option<fs::File>::none();
+    }
+    return common::Option<fs::File>::some(f);
+}
+
 uint16_t SDManager::numFilesInDir(const char* dir) {
     if (_managerStatus != SD_GOOD) {
         TELEM_DEBUG_PRINT_ERRORLN("Unable to count files in dir %s! SDManager in a bad state!",
@@ -171,6 +189,28 @@ uint16_t SDManager::numFilesInDir(const char* dir) {
     return count;
 }
 
+bool SDManager::exists(const char* path) {
+    return _managerStatus == SD_GOOD && _sd.exists(path);
+}
+
+bool SDManager::remove(const char* path) {
+    return _managerStatus == SD_GOOD && _sd.remove(path);
+}
+
+bool SDManager::truncate(const char* path, std::size_t size) {
+    if (_managerStatus == SD_BAD) {
+        return false;
+    }
+    // fs::File has no truncate, the VFS under it does (FatFs f_truncate), at the mount point
+    std::string full = std::string(MOUNT_POINT) + path;
+    if (::truncate(full.c_str(), static_cast<off_t>(size)) != 0) {
+        TELEM_DEBUG_PRINT_ERRORLN("Unable to truncate %s to %d bytes", path,
+                                  static_cast<int>(size));
+        return false;
+    }
+    return true;
+}
+
 }  // namespace remote
 
 #endif
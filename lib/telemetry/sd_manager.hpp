@@ -34,8 +34,23 @@ class SDManager {
     void createDir(const char* dir);
     uint16_t numFilesInDir(const char* dir);
 
+    /// @brief Opens a file outside of the guard stack, for a caller that keeps it open for a long
+    /// time and closes it itself
+    /// @param path The path of the file
+    /// @param mode The mode to open it in
+    /// @return The file, or none() on error
+    common::Option<fs::File> openLongLived(const char* path, const char* mode);
+
+    bool exists(const char* path);
+    bool remove(const char* path);
+
+    /// @brief Cuts a file down to size bytes, the file must not be open
+    /// @return true on success
+    bool truncate(const char* path, std::size_t size);
+
    private:
     static constexpr std::size_t MAX_STACK_SIZE = 8;
+    static constexpr const char* MOUNT_POINT = "/sd";  // where SDFS::begin() mounts the card
 
     fs::SDFS _sd;
     SDManagerConfig _config;
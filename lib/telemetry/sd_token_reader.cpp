@@ -4,103 +4,66 @@
 
 #include <SD.h>
 
-#include <cctype>  // for std::isspace
 #include <cstddef>
 #include <cstdint>
-#include <iostream>
 #include <sd_manager.hpp>
-#include <string>
+
+#include "telemetry_debug.hpp"
 
 namespace remote {
 
-SDTokenReader::SDTokenReader(FileGuard& gaurd) : _guard(gaurd) {}
+SDBlockSource::SDBlockSource(FileGuard& guard) : _guard(guard) {}
 
-bool SDTokenReader::start() {
-    return true;
+bool SDBlockSource::open() {
+    return _guard.file().isSome();
 }
 
-bool SDTokenReader::peekNextWord(std::size_t maxLength, char* charBuf, std::size_t* length) {
+std::size_t SDBlockSource::readBlock(std::size_t index, uint8_t* buf) {
     auto opt = _guard.file();
     if (opt.isNone()) {
-        return false;
+        return READ_ERROR;
     }
 
     auto file = opt.value();
+    std::size_t offset = index * BLOCK_SIZE;
 
-    // Remember where we were
-    auto origPos = file.position();
-    // Skip leading whitespace
-    while (file.available()) {
-        int c = file.peek();
-        if (c < 0 || !std::isspace(c)) break;
-        file.read();
+    // blocks are almost always read in order, so this seek is usually skipped
+    if (file.position() != offset && !file.seek(offset)) {
+        TELEM_DEBUG_PRINT_ERRORLN("Failed to seek to block %d", index);
+        return READ_ERROR;
     }
 
-    // Read up to maxLength non-space chars
-    std::size_t len = 0;
-    while (len < maxLength && file.available()) {
-        int c = file.peek();
-        if (c < 0 || std::isspace(c)) break;
-        charBuf[len++] = static_cast<char>(file.read());
-    }
+    return file.read(buf, BLOCK_SIZE);
+}
 
-    // Restore file position
-    file.seek(origPos);
-    // set the null termnator
-    charBuf[len] = '\0';
+void SDBlockSource::close() {}
 
-    if (len == 0) return false;
-    *length = len;
+SDTokenReader::SDTokenReader(FileGuard& gaurd) : _source(gaurd), _reader(_source) {}
 
-    return true;
+bool SDTokenReader::start() {
+    return _reader.start();
 }
 
-bool SDTokenReader::moveWord(std::size_t stepSize) {
-    auto opt = _guard.file();
-    if (opt.isNone()) {
-        return false;
-    }
+bool SDTokenReader::peekNextWord(std::size_t maxLength, char* charBuf, std::size_t* length) {
+    return _reader.peekNextWord(maxLength, charBuf, length);
+}
 
-    auto file = opt.value();
+bool SDTokenReader::peekNextSpan(const char** word, std::size_t* length) {
+    return _reader.peekNextSpan(word, length);
+}
 
-    for (std::size_t step = 0; step < stepSize; ++step) {
-        // Skip whitespace
-        while (file.available()) {
-            int c = file.peek();
-            if (c < 0 || !std::isspace(c)) break;
-            file.read();
-        }
-        // Skip the word itself
-        if (!file.available()) return false;
-        while (file.available()) {
-            int c = file.peek();
-            if (c < 0 || std::isspace(c)) break;
-            file.read();
-        }
-    }
-    return true;
+bool SDTokenReader::moveWord(std::size_t stepSize) {
+    return _reader.moveWord(stepSize);
 }
 
 bool SDTokenReader::eatUntil(const char character) {
-    auto opt = _guard.file();
-    if (opt.isNone()) {
-        return false;
-    }
-
-    auto file = opt.value();
-
-    while (file.available()) {
-        char c = static_cast<char>(file.read());
-        if (c == character) {
-            return true;
-        }
-    }
-
-    return false;
+    return _reader.eatUntil(character);
 }
 
-void SDTokenReader::end() {}
+void SDTokenReader::end() {
+    _reader.end();
+}
 
 }  // namespace remote
 
-#endif
\ No newline at end of file
+#endif
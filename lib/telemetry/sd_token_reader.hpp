@@ -3,6 +3,7 @@
 
 #ifndef __PLATFORM_NATIVE
 
+#include <builder/block_token_reader.hpp>
 #include <builder/token_reader.hpp>
 #include <cstddef>
 #include <cstdint>
@@ -12,19 +13,38 @@ namespace remote {
 
 class FileGuard;
 
-/// @brief SD-backed reader; slurps file on start()
+/// @brief Reads a guarded SD file one sector-sized block at a time
+class SDBlockSource : public can::BlockSource {
+   public:
+    explicit SDBlockSource(FileGuard& guard);
+
+    bool open() override;
+    std::size_t readBlock(std::size_t index, uint8_t* buf) override;
+    void close() override;
+
+   private:
+    FileGuard& _guard;
+};
+
+/// @brief SD-backed reader; pulls the file in 512-byte blocks and scans words in memory
 class SDTokenReader : public can::TokenReader {
    public:
     explicit SDTokenReader(FileGuard& guard);
 
     bool start() override;
     bool peekNextWord(std::size_t maxLength, char* charBuf, std::size_t* length) override;
+    bool supportsSpans() const override { return true; }
+    bool peekNextSpan(const char** word, std::size_t* length) override;
     bool moveWord(std::size_t stepSize = 1) override;
     bool eatUntil(const char character) override;
     void end() override;
 
+    /// @brief See BlockTokenReader::failed()
+    bool failed() const { return _reader.failed(); }
+
    private:
-    FileGuard& _guard;
+    SDBlockSource _source;
+    can::BlockTokenReader _reader;
 };
 
 
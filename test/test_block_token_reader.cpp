@@ -0,0 +1,274 @@
+#include <builder/block_token_reader.hpp>
+#include <builder/config_image.hpp>
+#include <builder/token_reader.hpp>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "test.hpp"
+
+using can::BlockSource;
+using can::BlockTokenReader;
+using can::FileBlockSource;
+using can::MockTokenReader;
+
+static const char* TMP_PATH = "test_block_token_reader.tmp";
+
+// Helper: write content to the scratch file
+static void writeFile(const std::string& content) {
+    std::FILE* f = std::fopen(TMP_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    std::fwrite(content.data(), 1, content.size(), f);
+    std::fclose(f);
+}
+
+// Helper: a config-like file a few blocks long, where words land on every block boundary
+static std::string makeContent() {
+    std::string content;
+    for (int i = 0; content.size() < 4 * BlockSource::BLOCK_SIZE; ++i) {
+        content += ">>> SIGNAL_" + std::to_string(i) + " uint16 " + std::to_string(i * 16) +
+                   " 16 0.125 -40 // trailing comment\n";
+    }
+    return content;
+}
+
+// Test: the block reader walks a file exactly like the in-memory reader does
+void test_BlockReader_MatchesMock() {
+    std::string content = makeContent();
+    writeFile(content);
+
+    MockTokenReader mock(content);
+    FileBlockSource source(TMP_PATH);
+    BlockTokenReader reader(source);
+    TEST_ASSERT(mock.start());
+    TEST_ASSERT(reader.start());
+
+    char expected[64];
+    char actual[64];
+    std::size_t expectedLen = 0;
+    std::size_t actualLen = 0;
+    std::size_t words = 0;
+
+    while (true) {
+        bool more = mock.peekNextWord(sizeof(expected), expected, &expectedLen);
+        TEST_ASSERT_EQUAL(more, reader.peekNextWord(sizeof(actual), actual, &actualLen));
+        if (!more) break;
+
+        // peeking twice must not move the cursor
+        TEST_ASSERT(reader.peekNextWord(sizeof(actual), actual, &actualLen));
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+        TEST_ASSERT_EQUAL_UINT(expectedLen, actualLen);
+
+        if (std::strcmp(expected, "//") == 0) {
+            TEST_ASSERT_EQUAL(mock.eatUntil('\n'), reader.eatUntil('\n'));
+        } else {
+            TEST_ASSERT_EQUAL(mock.moveWord(), reader.moveWord());
+        }
+        words++;
+    }
+
+    TEST_ASSERT_TRUE(words > 100);
+    TEST_ASSERT_FALSE(reader.moveWord());
+
+    // every block is read once, plus a single probe that finds the end of the file
+    std::size_t blocks = (content.size() + BlockSource::BLOCK_SIZE - 1) / BlockSource::BLOCK_SIZE;
+    TEST_ASSERT_TRUE(reader.blockLoads() <= blocks + 1);
+
+    reader.end();
+    std::remove(TMP_PATH);
+}
+
+// Test: spans agree with copied words everywhere, and are terminated even at block edges
+void test_BlockReader_Spans() {
+    std::string content = makeContent();
+    // one word that ends exactly at the end of the first block
+    content.replace(BlockSource::BLOCK_SIZE - 6, 7, " EDGE0\n");
+    writeFile(content);
+
+    FileBlockSource source(TMP_PATH);
+    BlockTokenReader reader(source);
+    TEST_ASSERT(reader.start());
+    TEST_ASSERT(reader.supportsSpans());
+
+    char copy[64];
+    std::size_t copyLen = 0;
+    const char* span = nullptr;
+    std::size_t spanLen = 0;
+    bool sawEdge = false;
+
+    while (reader.peekNextWord(sizeof(copy), copy, &copyLen)) {
+        TEST_ASSERT(reader.peekNextSpan(&span, &spanLen));
+        TEST_ASSERT_EQUAL_UINT(copyLen, spanLen);
+        TEST_ASSERT_EQUAL_INT(0, std::strncmp(copy, span, spanLen));
+        // the character after the span is safe to read and ends the word
+        TEST_ASSERT_TRUE(span[spanLen] == '\0' || std::isspace(span[spanLen]));
+
+        sawEdge |= std::strcmp(copy, "EDGE0") == 0;
+        reader.moveWord();
+    }
+
+    TEST_ASSERT_TRUE(sawEdge);
+    TEST_ASSERT_FALSE(reader.peekNextSpan(&span, &spanLen));
+    reader.end();
+    std::remove(TMP_PATH);
+}
+
+// Test: a word split across a block boundary comes back whole
+void test_BlockReader_WordAcrossBoundary() {
+    std::string content(BlockSource::BLOCK_SIZE - 3, ' ');
+    content += "BOUNDARY_WORD next";
+    writeFile(content);
+
+    FileBlockSource source(TMP_PATH);
+    BlockTokenReader reader(source);
+    TEST_ASSERT(reader.start());
+
+    char buf[32];
+    std::size_t len = 0;
+    TEST_ASSERT(reader.peekNextWord(sizeof(buf), buf, &len));
+    TEST_ASSERT_EQUAL_STRING("BOUNDARY_WORD", buf);
+    TEST_ASSERT_EQUAL_UINT(13, len);
+
+    TEST_ASSERT(reader.moveWord());
+    TEST_ASSERT(reader.peekNextWord(sizeof(buf), buf, &len));
+    TEST_ASSERT_EQUAL_STRING("next", buf);
+    TEST_ASSERT_EQUAL_UINT(2, reader.blockLoads());
+
+    reader.end();
+    std::remove(TMP_PATH);
+}
+
+// Test: a word stitched across a block boundary comes back whole and terminated, and one longer
+// than the stitch buffer is cut short instead of growing it
+void test_BlockReader_StitchedSpan() {
+    std::string content(BlockSource::BLOCK_SIZE - 3, ' ');
+    content += "BOUNDARY_WORD ";
+    content.resize(2 * BlockSource::BLOCK_SIZE - 100, ' ');
+    content += std::string(200, 'x') + " next";
+    writeFile(content);
+
+    FileBlockSource source(TMP_PATH);
+    BlockTokenReader reader(source);
+    TEST_ASSERT(reader.start());
+
+    const char* span = nullptr;
+    std::size_t len = 0;
+    TEST_ASSERT(reader.peekNextSpan(&span, &len));
+    TEST_ASSERT_EQUAL_STRING("BOUNDARY_WORD", span);
+    TEST_ASSERT_EQUAL_UINT(13, len);
+
+    TEST_ASSERT(reader.moveWord());
+    TEST_ASSERT(reader.peekNextSpan(&span, &len));
+    TEST_ASSERT_EQUAL_UINT(can::LOCAL_BUF_SIZE - 1, len);
+    TEST_ASSERT_EQUAL_STRING(std::string(can::LOCAL_BUF_SIZE - 1, 'x').c_str(), span);
+
+    // the cursor still moves past the whole word
+    TEST_ASSERT(reader.moveWord());
+    TEST_ASSERT(reader.peekNextSpan(&span, &len));
+    TEST_ASSERT_EQUAL_STRING("next", span);
+
+    reader.end();
+    std::remove(TMP_PATH);
+}
+
+// Test: a short buffer truncates the copy but still reports the full word length
+void test_BlockReader_Truncate() {
+    writeFile("abcdefghij rest");
+
+    FileBlockSource source(TMP_PATH);
+    BlockTokenReader reader(source);
+    TEST_ASSERT(reader.start());
+
+    char buf[4];
+    std::size_t len = 0;
+    TEST_ASSERT(reader.peekNextWord(sizeof(buf), buf, &len));
+    TEST_ASSERT_EQUAL_STRING("abc", buf);
+    TEST_ASSERT_EQUAL_UINT(10, len);
+
+    reader.end();
+    std::remove(TMP_PATH);
+}
+
+// Test: a missing file fails to start, an empty one has no words
+void test_BlockReader_MissingAndEmpty() {
+    FileBlockSource missing("does_not_exist.telem");
+    BlockTokenReader missingReader(missing);
+    TEST_ASSERT_FALSE(missingReader.start());
+
+    writeFile("");
+    FileBlockSource source(TMP_PATH);
+    BlockTokenReader reader(source);
+    TEST_ASSERT(reader.start());
+
+    char buf[8];
+    std::size_t len = 0;
+    TEST_ASSERT_FALSE(reader.peekNextWord(sizeof(buf), buf, &len));
+    TEST_ASSERT_FALSE(reader.moveWord());
+    TEST_ASSERT_FALSE(reader.eatUntil('\n'));
+
+    reader.end();
+    std::remove(TMP_PATH);
+}
+
+// Helper: reads like a file full of words until the storage fails on one block
+class FailingBlockSource : public BlockSource {
+   public:
+    explicit FailingBlockSource(std::size_t failAt) : _failAt(failAt) {}
+
+    bool open() override { return true; }
+    std::size_t readBlock(std::size_t index, uint8_t* buf) override {
+        if (index == _failAt) {
+            return READ_ERROR;
+        }
+        std::memset(buf, 'a', BLOCK_SIZE);
+        buf[BLOCK_SIZE - 1] = ' ';
+        return BLOCK_SIZE;
+    }
+    void close() override {}
+
+   private:
+    std::size_t _failAt;
+};
+
+// Test: a failed read ends the words like the end of the file would, but is told apart from it
+void test_BlockReader_ReadError() {
+    FailingBlockSource source(1);
+    BlockTokenReader reader(source);
+    TEST_ASSERT(reader.start());
+
+    std::size_t words = 0;
+    while (reader.moveWord()) {
+        ++words;
+    }
+    TEST_ASSERT_EQUAL_UINT(1, words);
+    TEST_ASSERT(reader.failed());
+
+    // starting over clears it
+    TEST_ASSERT(reader.start());
+    TEST_ASSERT_FALSE(reader.failed());
+    reader.end();
+
+    // and the hash of a file that can't be read isn't the hash of its first block
+    uint32_t hash = 0;
+    TEST_ASSERT_FALSE(can::ConfigImage::hashSource(source, &hash));
+
+    // a clean end isn't a failure
+    writeFile("abc def");
+    FileBlockSource file(TMP_PATH);
+    BlockTokenReader fileReader(file);
+    TEST_ASSERT(fileReader.start());
+    while (fileReader.moveWord()) {
+    }
+    TEST_ASSERT_FALSE(fileReader.failed());
+    TEST_ASSERT(can::ConfigImage::hashSource(file, &hash));
+    fileReader.end();
+    std::remove(TMP_PATH);
+}
+TEST_FUNC(test_BlockReader_MatchesMock);
+TEST_FUNC(test_BlockReader_Spans);
+TEST_FUNC(test_BlockReader_WordAcrossBoundary);
+TEST_FUNC(test_BlockReader_StitchedSpan);
+TEST_FUNC(test_BlockReader_Truncate);
+TEST_FUNC(test_BlockReader_MissingAndEmpty);
+TEST_FUNC(test_BlockReader_ReadError);
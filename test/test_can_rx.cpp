@@ -0,0 +1,154 @@
+#include <can.hpp>
+#include <drivers/can_driver_virtual.hpp>
+#include <vector>
+
+#include "test.hpp"
+
+using can::CANBaudRate;
+using can::CANBus;
+using can::CANMessage;
+using can::CANMessageDescription;
+using can::RawCANMessage;
+using can::VirtualCANDriver;
+
+// Helper: add a one-signal message with the given ID
+static CANMessage& addRxMessage(CANBus& bus, uint32_t id) {
+    CANMessageDescription desc{};
+    desc.id = id;
+    desc.length = 8;
+    desc.type = can::STANDARD;
+    desc.signals.push_back({0, 16, false, can::MSG_LITTLE_ENDIAN, 1, 0});
+    return bus.addMessage(desc);
+}
+
+static RawCANMessage makeFrame(uint32_t id, uint8_t fill) {
+    RawCANMessage raw{};
+    raw.id = id;
+    raw.length = 8;
+    for (uint8_t& b : raw.data) b = fill;
+    return raw;
+}
+
+// Test: the capture time stamped by the driver is kept per message, not the poll time
+void test_CANRx_Timestamps() {
+    VirtualCANDriver drv;
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+    CANMessage& a = addRxMessage(bus, 0x100);
+    CANMessage& b = addRxMessage(bus, 0x200);
+    bus.initialize();
+
+    TEST_ASSERT_EQUAL_UINT(0, bus.lastReceiveUs(a));
+
+    // both frames arrive well before the bus gets polled
+    drv.setTimeUs(1000);
+    drv.inject(makeFrame(0x100, 0xAA));
+    drv.setTimeUs(1250);
+    drv.inject(makeFrame(0x200, 0xBB));
+    drv.setTimeUs(5000);
+    bus.update();
+
+    TEST_ASSERT_EQUAL_UINT(1000, bus.lastReceiveUs(a));
+    TEST_ASSERT_EQUAL_UINT(1250, bus.lastReceiveUs(b));
+
+    // the timestamps line up with the data buffer, in the order messages were added
+    std::size_t count = 0;
+    const uint64_t* stamps = bus.rxTimestamps(&count);
+    TEST_ASSERT_EQUAL_UINT(2, count);
+    TEST_ASSERT_EQUAL_UINT(0, a.index);
+    TEST_ASSERT_EQUAL_UINT(1000, stamps[a.index]);
+    TEST_ASSERT_EQUAL_UINT(1250, stamps[b.index]);
+
+    // a newer frame replaces the timestamp
+    drv.setTimeUs(7000);
+    drv.inject(makeFrame(0x100, 0xCC));
+    bus.update();
+    TEST_ASSERT_EQUAL_UINT(7000, bus.lastReceiveUs(a));
+    TEST_ASSERT_EQUAL_UINT(1250, bus.lastReceiveUs(b));
+}
+
+// Test: frames for unknown IDs don't disturb any timestamps
+void test_CANRx_UnknownID() {
+    VirtualCANDriver drv;
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+    CANMessage& a = addRxMessage(bus, 0x100);
+    bus.initialize();
+
+    drv.setTimeUs(42);
+    drv.inject(makeFrame(0x7FF, 0x11));
+    bus.update();
+    TEST_ASSERT_EQUAL_UINT(0, bus.lastReceiveUs(a));
+}
+
+// Test: a 64-byte FD frame fills its whole slot, and doesn't spill into the next message
+void test_CANRx_FDFrame() {
+    VirtualCANDriver drv;
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+
+    CANMessageDescription fd{};
+    fd.id = 0x300;
+    fd.length = 64;
+    fd.type = can::STANDARD;
+    fd.signals.push_back({496, 16, false, can::MSG_LITTLE_ENDIAN, 1, 0});
+    CANMessage& cells = bus.addMessage(fd);
+    CANMessage& after = addRxMessage(bus, 0x400);
+    bus.initialize();
+
+    TEST_ASSERT_EQUAL_UINT(512, after.bufferHandle.offset - cells.bufferHandle.offset);
+
+    RawCANMessage raw{};
+    raw.id = 0x300;
+    raw.length = 64;
+    for (uint8_t i = 0; i < 64; ++i) raw.data[i] = i + 1;
+    drv.inject(raw);
+    bus.update();
+
+    std::size_t size = 0;
+    const uint8_t* data = bus.dataBuffer(&size);
+    TEST_ASSERT_EQUAL_UINT(72, size);
+
+    const uint8_t* slot = data + cells.bufferHandle.offset / 8;
+    TEST_ASSERT_EQUAL_UINT8(1, slot[0]);
+    TEST_ASSERT_EQUAL_UINT8(64, slot[63]);
+    TEST_ASSERT_EQUAL_UINT8(0, data[after.bufferHandle.offset / 8]);
+
+    // the last signal of the payload sits in the final two bytes of the slot
+    const uint8_t* last = slot + (cells.signals[0].handle().offset - cells.bufferHandle.offset) / 8;
+    TEST_ASSERT_EQUAL_UINT8(63, last[0]);
+    TEST_ASSERT_EQUAL_UINT8(64, last[1]);
+}
+
+// Test: only frames of event messages reach the frame listener, every one of them
+void test_CANRx_FrameListener() {
+    VirtualCANDriver drv;
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+    CANMessage& fast = addRxMessage(bus, 0x100);
+    addRxMessage(bus, 0x200);
+    fast.logMode = can::MLM_EVENT;
+    bus.initialize();
+
+    std::vector<RawCANMessage> seen;
+    bus.setFrameListener([&](const CANMessage& message, const RawCANMessage& frame) {
+        TEST_ASSERT_EQUAL_UINT(frame.id, message.id);
+        seen.push_back(frame);
+    });
+
+    // three frames of the event message between two polls, the bus image only keeps the last
+    for (uint8_t i = 0; i < 3; ++i) {
+        drv.setTimeUs(100 + i);
+        drv.inject(makeFrame(0x100, i));
+        drv.inject(makeFrame(0x200, i));
+    }
+    bus.update();
+
+    TEST_ASSERT_EQUAL_UINT(3, seen.size());
+    for (uint8_t i = 0; i < 3; ++i) {
+        TEST_ASSERT_EQUAL_UINT(0x100, seen[i].id);
+        TEST_ASSERT_EQUAL_UINT(100 + i, seen[i].timestampUs);
+        TEST_ASSERT_EQUAL_UINT8(i, seen[i].data[0]);
+    }
+}
+
+TEST_FUNC(test_CANRx_Timestamps);
+TEST_FUNC(test_CANRx_FrameListener);
+TEST_FUNC(test_CANRx_FDFrame);
+TEST_FUNC(test_CANRx_UnknownID);
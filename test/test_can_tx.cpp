@@ -0,0 +1,169 @@
+#include <can.hpp>
+#include <drivers/can_driver_virtual.hpp>
+#include <vector>
+
+#include "test.hpp"
+
+using can::CANBaudRate;
+using can::CANBus;
+using can::CANMessage;
+using can::CANMessageDescription;
+using can::TxStats;
+using can::TxStatus;
+using can::VirtualCANDriver;
+
+// Helper: add a one-signal message with the given ID
+static CANMessage& addTxMessage(CANBus& bus, uint32_t id) {
+    CANMessageDescription desc{};
+    desc.id = id;
+    desc.length = 8;
+    desc.type = can::STANDARD;
+    desc.signals.push_back({0, 8, false, can::MSG_LITTLE_ENDIAN, 1, 0});
+    return bus.addMessage(desc);
+}
+
+// Test: sending before initialize is refused
+void test_CANTx_NotInitialized() {
+    VirtualCANDriver drv;
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+    CANMessage& msg = addTxMessage(bus, 0x100);
+
+    TEST_ASSERT_EQUAL_INT(can::TXS_NOT_INITIALIZED, bus.sendMessage(msg));
+    TEST_ASSERT_EQUAL_UINT(0, bus.pendingTransmits());
+}
+
+// Test: queued frames leave lowest ID first, regardless of the order they were queued
+void test_CANTx_PriorityOrder() {
+    VirtualCANDriver drv(8);
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+    CANMessage& low = addTxMessage(bus, 0x300);
+    CANMessage& high = addTxMessage(bus, 0x010);
+    CANMessage& mid = addTxMessage(bus, 0x200);
+    bus.initialize();
+
+    TEST_ASSERT_EQUAL_INT(can::TXS_QUEUED, low.sendMessage());
+    TEST_ASSERT_EQUAL_INT(can::TXS_QUEUED, mid.sendMessage());
+    TEST_ASSERT_EQUAL_INT(can::TXS_QUEUED, high.sendMessage());
+    TEST_ASSERT_EQUAL_UINT(0, drv.sent().size());
+
+    bus.serviceTransmit(0);
+    TEST_ASSERT_EQUAL_UINT(3, drv.sent().size());
+    TEST_ASSERT_EQUAL_UINT(0x010, drv.sent()[0].id);
+    TEST_ASSERT_EQUAL_UINT(0x200, drv.sent()[1].id);
+    TEST_ASSERT_EQUAL_UINT(0x300, drv.sent()[2].id);
+    TEST_ASSERT_EQUAL_UINT(8, drv.sent()[0].length);
+}
+
+// Test: a full queue pushes back instead of blocking, and reports it
+void test_CANTx_Backpressure() {
+    VirtualCANDriver drv;
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS, 2);
+    CANMessage& a = addTxMessage(bus, 0x100);
+    CANMessage& b = addTxMessage(bus, 0x101);
+    CANMessage& c = addTxMessage(bus, 0x102);
+    bus.initialize();
+
+    std::vector<TxStatus> reports;
+    bus.registerTransmitCallback([&reports](uint32_t, TxStatus status) {
+        if (status == can::TXS_QUEUE_FULL) reports.push_back(status);
+    });
+
+    TEST_ASSERT_EQUAL_INT(can::TXS_QUEUED, a.sendMessage());
+    TEST_ASSERT_EQUAL_INT(can::TXS_QUEUED, b.sendMessage());
+    TEST_ASSERT_EQUAL_INT(can::TXS_QUEUE_FULL, c.sendMessage());
+    TEST_ASSERT_EQUAL_UINT(1, reports.size());
+
+    TxStats stats = bus.transmitStats();
+    TEST_ASSERT_EQUAL_UINT(1, stats.rejected);
+    TEST_ASSERT_EQUAL_UINT(2, stats.highWater);
+}
+
+// Test: re-sending a pending ID refreshes it rather than taking another slot
+void test_CANTx_Coalesce() {
+    VirtualCANDriver drv;
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS, 2);
+    CANMessage& a = addTxMessage(bus, 0x100);
+    bus.initialize();
+
+    TEST_ASSERT_EQUAL_INT(can::TXS_QUEUED, a.sendMessage());
+    TEST_ASSERT_EQUAL_INT(can::TXS_QUEUED, a.sendMessage());
+    TEST_ASSERT_EQUAL_UINT(1, bus.pendingTransmits());
+    TEST_ASSERT_EQUAL_UINT(1, bus.transmitStats().coalesced);
+}
+
+// Test: a busy driver leaves frames queued for the next service call
+void test_CANTx_DriverBusy() {
+    VirtualCANDriver drv(1);
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+    CANMessage& a = addTxMessage(bus, 0x100);
+    CANMessage& b = addTxMessage(bus, 0x101);
+    bus.initialize();
+
+    a.sendMessage();
+    b.sendMessage();
+    bus.serviceTransmit(0);
+    TEST_ASSERT_EQUAL_UINT(1, drv.sent().size());
+    TEST_ASSERT_EQUAL_UINT(1, bus.pendingTransmits());
+    TEST_ASSERT_EQUAL_UINT(1, bus.transmitStats().busy);
+
+    drv.completeTransmissions();
+    bus.serviceTransmit(1);
+    TEST_ASSERT_EQUAL_UINT(2, drv.sent().size());
+    TEST_ASSERT_EQUAL_UINT(0x101, drv.sent()[1].id);
+    TEST_ASSERT_EQUAL_UINT(0, bus.pendingTransmits());
+}
+
+// Test: driver errors drop the frame and are reported, not retried forever
+void test_CANTx_DriverError() {
+    VirtualCANDriver drv;
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+    CANMessage& a = addTxMessage(bus, 0x100);
+    bus.initialize();
+
+    uint32_t failedID = 0;
+    bus.registerTransmitCallback([&failedID](uint32_t id, TxStatus status) {
+        if (status == can::TXS_ERROR) failedID = id;
+    });
+
+    drv.setTransmitFailure(true);
+    a.sendMessage();
+    bus.serviceTransmit(0);
+    TEST_ASSERT_EQUAL_UINT(0x100, failedID);
+    TEST_ASSERT_EQUAL_UINT(1, bus.transmitStats().failed);
+    TEST_ASSERT_EQUAL_UINT(0, bus.pendingTransmits());
+}
+
+// Test: periodic schedules go out on their period without a dedicated task
+void test_CANTx_Periodic() {
+    VirtualCANDriver drv(8);
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+    CANMessage& heartbeat = addTxMessage(bus, 0x700);
+    CANMessage& command = addTxMessage(bus, 0x050);
+    bus.initialize();
+
+    bus.addPeriodicMessage(heartbeat, 100);
+    bus.addPeriodicMessage(command, 20, 5);
+
+    for (uint32_t now = 1000; now < 1200; now += 5) {
+        bus.serviceTransmit(now);
+        drv.completeTransmissions();
+    }
+
+    size_t heartbeats = 0;
+    size_t commands = 0;
+    for (const auto& frame : drv.sent()) {
+        if (frame.id == 0x700) heartbeats++;
+        if (frame.id == 0x050) commands++;
+    }
+
+    TEST_ASSERT_EQUAL_UINT(2, heartbeats);  // at 1000 and 1100
+    TEST_ASSERT_EQUAL_UINT(10, commands);   // every 20ms from 1005
+}
+
+TEST_FUNC(test_CANTx_NotInitialized);
+TEST_FUNC(test_CANTx_PriorityOrder);
+TEST_FUNC(test_CANTx_Backpressure);
+TEST_FUNC(test_CANTx_Coalesce);
+TEST_FUNC(test_CANTx_DriverBusy);
+TEST_FUNC(test_CANTx_DriverError);
+TEST_FUNC(test_CANTx_Periodic);
@@ -0,0 +1,189 @@
+#include <builder/block_token_reader.hpp>
+#include <builder/config_image.hpp>
+#include <builder/telem_builder.hpp>
+#include <builder/token_reader.hpp>
+#include <builder/tokenizer.hpp>
+#include <can.hpp>
+#include <cstdio>
+#include <drivers/can_driver_virtual.hpp>
+#include <hash.hpp>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+
+using can::CANBus;
+using can::CANMessage;
+using can::CANSignal;
+using can::ConfigImage;
+using can::TelemetryOptions;
+
+static const char* TMP_PATH = "test_config_image.tmp";
+
+static const char* CONFIG =
+    "!! logPeriodMs 25\n"
+    "!! wirelessPeriodMs 250\n"
+    "!! logPreallocateBytes 1048576\n"
+    "!! logPackBlockBytes 2048\n"
+    "!! logRotateMinutes 15\n"
+    "> BMS\n"
+    ">> PACK 0x0A0 8\n"
+    ">>> VOLTAGE uint16 0 16 0.01 0.0 unsigned little\n"
+    ">>> CURRENT int16 16 16 0.1 -3200.0 signed big\n"
+    ">>> SOC uint8 32 7 0.5 0.0\n"
+    ">> CELLS 0x0A1 64\n"
+    ">>> CELL_0 uint16 0 16 0.001 0.0\n"
+    ">>> CELL_31 uint16 496 16 0.001 0.0\n"
+    "> INVERTER\n"
+    ">> MOTOR 0x010 4 event\n"
+    ">>> RPM int16 0 16 1 0 signed\n";
+
+// Helper: build a bus from text, planned like the device does
+static TelemetryOptions buildBus(const std::string& cfg, CANBus& bus) {
+    can::MockTokenReader reader(cfg);
+    can::Tokenizer tok(reader);
+    can::TelemBuilder builder(tok);
+    builder.plan(bus);
+    auto res = builder.build(bus);
+    TEST_ASSERT_FALSE_MESSAGE(res.isError(), res.error().c_str());
+    return res.value();
+}
+
+// Helper: the image of the test config
+static std::vector<uint8_t> makeImage(uint32_t sourceHash) {
+    can::VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    TelemetryOptions opts = buildBus(CONFIG, bus);
+    return ConfigImage::serialize(bus, opts, sourceHash);
+}
+
+// Test: a loaded image gives back the same options and exactly the same layout as the text
+void test_ConfigImage_RoundTrip() {
+    can::VirtualCANDriver drvA;
+    CANBus built(drvA, can::CBR_500KBPS);
+    TelemetryOptions opts = buildBus(CONFIG, built);
+    std::vector<uint8_t> image = ConfigImage::serialize(built, opts, 0x1234);
+
+    can::VirtualCANDriver drvB;
+    CANBus loaded(drvB, can::CBR_500KBPS);
+    auto res = ConfigImage::load(image.data(), image.size(), 0x1234, loaded);
+    TEST_ASSERT_FALSE_MESSAGE(res.isError(), res.error().c_str());
+    TEST_ASSERT_EQUAL_UINT(25, res.value().logPeriodMs);
+    TEST_ASSERT_EQUAL_UINT(250, res.value().wirelessPeriodMs);
+    TEST_ASSERT_EQUAL_UINT(1048576, res.value().logPreallocateBytes);
+    TEST_ASSERT_EQUAL_UINT(2048, res.value().logPackBlockBytes);
+    TEST_ASSERT_EQUAL_UINT(256u << 20, res.value().logRotateBytes);
+    TEST_ASSERT_EQUAL_UINT(15, res.value().logRotateMinutes);
+
+    TEST_ASSERT_EQUAL_UINT(built.getMessages().size(), loaded.getMessages().size());
+    TEST_ASSERT_EQUAL_INT(can::MLM_EVENT, loaded.getMessages().find(0x010)->second->logMode);
+    TEST_ASSERT_EQUAL_INT(can::MLM_SNAPSHOT, loaded.getMessages().find(0x0A0)->second->logMode);
+    for (const auto& entry : built.getMessages()) {
+        const CANMessage& a = *entry.second;
+        auto it = loaded.getMessages().find(entry.first);
+        TEST_ASSERT_TRUE(it != loaded.getMessages().end());
+        const CANMessage& b = *it->second;
+
+        TEST_ASSERT_EQUAL_UINT(a.length, b.length);
+        TEST_ASSERT_EQUAL_INT(a.type, b.type);
+        TEST_ASSERT_EQUAL_INT(a.logMode, b.logMode);
+        TEST_ASSERT_EQUAL_UINT(a.index, b.index);
+        TEST_ASSERT_EQUAL_UINT(a.bufferHandle.offset, b.bufferHandle.offset);
+        TEST_ASSERT_EQUAL_UINT(a.signals.size(), b.signals.size());
+
+        for (std::size_t i = 0; i < a.signals.size(); ++i) {
+            const CANSignal& sa = a.signals[i];
+            const CANSignal& sb = b.signals[i];
+            TEST_ASSERT_EQUAL_UINT(sa.handle().offset, sb.handle().offset);
+            TEST_ASSERT_EQUAL_UINT(sa.handle().size, sb.handle().size);
+            TEST_ASSERT_EQUAL(sa.isSigned(), sb.isSigned());
+            TEST_ASSERT_EQUAL_INT(sa.endianness(), sb.endianness());
+            TEST_ASSERT_EQUAL_DOUBLE(sa.factor(), sb.factor());
+            TEST_ASSERT_EQUAL_DOUBLE(sa.offset(), sb.offset());
+        }
+    }
+
+    built.initialize();
+    loaded.initialize();
+    std::size_t sizeA = 0;
+    std::size_t sizeB = 0;
+    built.dataBuffer(&sizeA);
+    loaded.dataBuffer(&sizeB);
+    TEST_ASSERT_EQUAL_UINT(sizeA, sizeB);
+}
+
+// Test: an image built from different text is reported as stale, and leaves the bus alone
+void test_ConfigImage_Stale() {
+    std::vector<uint8_t> image = makeImage(0x1234);
+    TEST_ASSERT_EQUAL_INT(can::CIS_OK, ConfigImage::check(image.data(), image.size(), 0x1234));
+    TEST_ASSERT_EQUAL_INT(can::CIS_STALE, ConfigImage::check(image.data(), image.size(), 0x4321));
+
+    can::VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    TEST_ASSERT_TRUE(ConfigImage::load(image.data(), image.size(), 0x4321, bus).isError());
+    TEST_ASSERT_EQUAL_UINT(0, bus.getMessages().size());
+}
+
+// Test: flipped bits, truncation, and foreign headers are all refused
+void test_ConfigImage_Rejects() {
+    std::vector<uint8_t> image = makeImage(7);
+
+    std::vector<uint8_t> flipped = image;
+    flipped[ConfigImage::HEADER_SIZE + 10] ^= 0x01;
+    TEST_ASSERT_EQUAL_INT(can::CIS_CORRUPT, ConfigImage::check(flipped.data(), flipped.size(), 7));
+
+    std::vector<uint8_t> truncated(image.begin(), image.end() - 1);
+    TEST_ASSERT_EQUAL_INT(can::CIS_CORRUPT,
+                          ConfigImage::check(truncated.data(), truncated.size(), 7));
+    TEST_ASSERT_EQUAL_INT(can::CIS_BAD_HEADER, ConfigImage::check(image.data(), 10, 7));
+
+    std::vector<uint8_t> magic = image;
+    magic[0] = 'X';
+    TEST_ASSERT_EQUAL_INT(can::CIS_BAD_HEADER, ConfigImage::check(magic.data(), magic.size(), 7));
+
+    std::vector<uint8_t> version = image;
+    version[4]++;
+    TEST_ASSERT_EQUAL_INT(can::CIS_BAD_VERSION,
+                          ConfigImage::check(version.data(), version.size(), 7));
+
+    can::VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    TEST_ASSERT_TRUE(ConfigImage::load(flipped.data(), flipped.size(), 7, bus).isError());
+    TEST_ASSERT_EQUAL_UINT(0, bus.getMessages().size());
+}
+
+// Test: hashing a file in blocks matches hashing it in one go, and notices a one-byte edit
+void test_ConfigImage_HashSource() {
+    std::string content;
+    while (content.size() < 3 * can::BlockSource::BLOCK_SIZE + 17) {
+        content += CONFIG;
+    }
+
+    std::FILE* f = std::fopen(TMP_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    std::fwrite(content.data(), 1, content.size(), f);
+    std::fclose(f);
+
+    can::FileBlockSource source(TMP_PATH);
+    uint32_t hash = 0;
+    TEST_ASSERT_TRUE(ConfigImage::hashSource(source, &hash));
+    TEST_ASSERT_EQUAL_UINT32(common::fnv1a(content.data(), content.size()), hash);
+
+    content[content.size() / 2] ^= 0x20;
+    f = std::fopen(TMP_PATH, "wb");
+    std::fwrite(content.data(), 1, content.size(), f);
+    std::fclose(f);
+
+    uint32_t edited = 0;
+    TEST_ASSERT_TRUE(ConfigImage::hashSource(source, &edited));
+    TEST_ASSERT_TRUE(edited != hash);
+
+    can::FileBlockSource missing("does_not_exist.telem");
+    TEST_ASSERT_FALSE(ConfigImage::hashSource(missing, &hash));
+    std::remove(TMP_PATH);
+}
+
+TEST_FUNC(test_ConfigImage_RoundTrip);
+TEST_FUNC(test_ConfigImage_Stale);
+TEST_FUNC(test_ConfigImage_Rejects);
+TEST_FUNC(test_ConfigImage_HashSource);
@@ -0,0 +1,141 @@
+#include <builder/telem_builder.hpp>
+#include <builder/token_reader.hpp>
+#include <builder/tokenizer.hpp>
+#include <can.hpp>
+#include <cstring>
+#include <drivers/can_driver_virtual.hpp>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+
+using can::IdentifierPool;
+using can::IdentifierPoolHandle;
+
+// Test: repeats come back as the same handle, distinct strings don't
+void test_IdentifierPool_Dedup() {
+    IdentifierPool pool;
+
+    IdentifierPoolHandle a = pool.intern("uint16");
+    IdentifierPoolHandle b = pool.intern("little");
+    IdentifierPoolHandle c = pool.intern("uint16");
+    IdentifierPoolHandle d = pool.intern("uint16_t", 6);
+
+    TEST_ASSERT_EQUAL_UINT(a.offset, c.offset);
+    TEST_ASSERT_EQUAL_UINT(a.offset, d.offset);
+    TEST_ASSERT_TRUE(a.offset != b.offset);
+    TEST_ASSERT_EQUAL_UINT(2, pool.size());
+    TEST_ASSERT_EQUAL_STRING("uint16", pool.get(a));
+    TEST_ASSERT_EQUAL_STRING("little", pool.get(b));
+
+    // prefixes and the empty string are their own strings
+    IdentifierPoolHandle e = pool.intern("uint");
+    IdentifierPoolHandle f = pool.intern("");
+    TEST_ASSERT_EQUAL_STRING("uint", pool.get(e));
+    TEST_ASSERT_EQUAL_STRING("", pool.get(f));
+    TEST_ASSERT_EQUAL_UINT(4, pool.size());
+}
+
+// Test: handles stay valid while the arena and table grow underneath them
+void test_IdentifierPool_Growth() {
+    IdentifierPool pool;
+    std::vector<IdentifierPoolHandle> handles;
+
+    for (int i = 0; i < 2000; ++i) {
+        handles.push_back(pool.intern(("SIGNAL_" + std::to_string(i)).c_str()));
+    }
+    TEST_ASSERT_EQUAL_UINT(2000, pool.size());
+
+    for (int i = 0; i < 2000; ++i) {
+        TEST_ASSERT_EQUAL_STRING(("SIGNAL_" + std::to_string(i)).c_str(), pool.get(handles[i]));
+        TEST_ASSERT_EQUAL_UINT(handles[i].offset,
+                               pool.intern(("SIGNAL_" + std::to_string(i)).c_str()).offset);
+    }
+    TEST_ASSERT_EQUAL_UINT(2000, pool.size());
+}
+
+// Test: a scope rolls back what was interned inside it, and keeps what was there before
+void test_IdentifierPool_Scope() {
+    IdentifierPool pool;
+    IdentifierPoolHandle kept = pool.intern("kept");
+
+    {
+        IdentifierPool::Scope scope(pool);
+        pool.intern("temporary");
+        pool.intern("kept");
+        TEST_ASSERT_EQUAL_UINT(2, pool.size());
+    }
+
+    TEST_ASSERT_EQUAL_UINT(1, pool.size());
+    TEST_ASSERT_EQUAL_STRING("kept", pool.get(kept));
+    TEST_ASSERT_EQUAL_UINT(kept.offset, pool.intern("kept").offset);
+
+    // the rolled-back string is gone, so interning it again adds it fresh
+    pool.intern("temporary");
+    TEST_ASSERT_EQUAL_UINT(2, pool.size());
+}
+
+// Test: clear keeps the memory around, release gives it back
+void test_IdentifierPool_ClearRelease() {
+    IdentifierPool pool;
+    for (int i = 0; i < 100; ++i) {
+        pool.intern(("NAME_" + std::to_string(i)).c_str());
+    }
+    std::size_t used = pool.memoryUsage();
+    TEST_ASSERT_TRUE(used > 0);
+
+    pool.clear();
+    TEST_ASSERT_EQUAL_UINT(0, pool.size());
+    TEST_ASSERT_EQUAL_UINT(used, pool.memoryUsage());
+
+    pool.release();
+    TEST_ASSERT_EQUAL_UINT(0, pool.size());
+    TEST_ASSERT_EQUAL_UINT(0, pool.memoryUsage());
+    TEST_ASSERT_EQUAL_STRING("again", pool.get(pool.intern("again")));
+}
+
+// Test: building a 500-signal config leaves the shared pool as it found it, and repeated builds
+// don't grow it
+void test_IdentifierPool_BuildBounded() {
+    std::string cfg = "!! logPeriodMs 50\n> BMS battery management\n";
+    for (int msg = 0; msg < 125; ++msg) {
+        char line[48];
+        std::snprintf(line, sizeof(line), ">> CELL_GROUP_%d 0x%X 8\n", msg, 0x200 + msg);
+        cfg += line;
+        for (int sig = 0; sig < 4; ++sig) {
+            cfg += ">>> CELL_" + std::to_string(msg * 4 + sig) + " uint16 " +
+                   std::to_string(sig * 16) + " 16 0.001 0.0 unsigned little\n";
+        }
+    }
+
+    IdentifierPool& pool = IdentifierPool::instance();
+    std::size_t sizeBefore = pool.size();
+    std::size_t memoryAfterFirst = 0;
+
+    for (int build = 0; build < 3; ++build) {
+        can::MockTokenReader reader(cfg);
+        can::Tokenizer tok(reader);
+        can::VirtualCANDriver drv;
+        can::CANBus bus(drv, can::CBR_500KBPS);
+        can::TelemBuilder builder(tok);
+        TEST_ASSERT_FALSE(builder.build(bus).isError());
+        TEST_ASSERT_EQUAL_UINT(125, bus.getMessages().size());
+
+        TEST_ASSERT_EQUAL_UINT(sizeBefore, pool.size());
+        if (build == 0) {
+            memoryAfterFirst = pool.memoryUsage();
+        } else {
+            TEST_ASSERT_EQUAL_UINT(memoryAfterFirst, pool.memoryUsage());
+        }
+    }
+
+    TEST_DEBUG_PRINTLN("identifier pool holds %zu bytes after a 500-signal build", memoryAfterFirst);
+    // ~640 distinct names of ~10 bytes, plus a table and an entry each
+    TEST_ASSERT_TRUE(memoryAfterFirst < 32 * 1024);
+}
+
+TEST_FUNC(test_IdentifierPool_Dedup);
+TEST_FUNC(test_IdentifierPool_Growth);
+TEST_FUNC(test_IdentifierPool_Scope);
+TEST_FUNC(test_IdentifierPool_ClearRelease);
+TEST_FUNC(test_IdentifierPool_BuildBounded);
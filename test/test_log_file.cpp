@@ -0,0 +1,289 @@
+#include <log_file.hpp>
+#include <log_storage.hpp>
+#include <vector>
+
+#include "test.hpp"
+#include "test_debug.hpp"
+
+using remote::LogFile;
+using remote::LogFileOptions;
+using remote::LogSessionCounter;
+using remote::MockLogStorage;
+
+static std::vector<uint8_t> makeRecord(uint32_t n, std::size_t size) {
+    std::vector<uint8_t> record(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        record[i] = static_cast<uint8_t>(n + i);
+    }
+    return record;
+}
+
+// Test: the file is opened once for the session and flushed on the period
+void test_LogFile_StaysOpen() {
+    MockLogStorage storage;
+    LogFileOptions options;
+    options.flushPeriodMs = 1000;
+    options.flushBytes = 1 << 20;
+    LogFile file(storage, options);
+
+    TEST_ASSERT_TRUE(file.open("/log_0.daq", 0));
+    std::vector<uint8_t> expected;
+    for (uint32_t i = 1; i <= 100; ++i) {
+        std::vector<uint8_t> record = makeRecord(i, 40);
+        TEST_ASSERT_TRUE(file.write(record.data(), record.size(), i * 100));
+        expected.insert(expected.end(), record.begin(), record.end());
+    }
+
+    TEST_ASSERT_EQUAL_INT(1, storage.opens());
+    TEST_ASSERT_EQUAL_INT(0, storage.closes());
+    TEST_ASSERT_EQUAL_INT(10, storage.flushes());
+    TEST_ASSERT_EQUAL_INT(4000, file.bytesWritten());
+
+    file.close();
+    TEST_ASSERT_EQUAL_INT(1, storage.closes());
+    TEST_ASSERT_TRUE(expected == storage.contents("/log_0.daq"));
+}
+
+// Test: enough pending bytes force a flush before the period is up
+void test_LogFile_FlushOnBytes() {
+    MockLogStorage storage;
+    LogFileOptions options;
+    options.flushPeriodMs = 60000;
+    options.flushBytes = 256;
+    LogFile file(storage, options);
+
+    file.open("/log_0.daq", 0);
+    std::vector<uint8_t> record = makeRecord(0, 100);
+    for (uint32_t i = 0; i < 10; ++i) {
+        file.write(record.data(), record.size(), i);
+    }
+
+    // every third record takes the pending count past 256
+    TEST_ASSERT_EQUAL_INT(3, storage.flushes());
+    TEST_ASSERT_EQUAL_INT(100, file.pendingBytes());
+    TEST_ASSERT_TRUE(file.flush(10));
+    TEST_ASSERT_EQUAL_INT(0, file.pendingBytes());
+}
+
+// Test: a failed write reopens the file once and nothing is lost, rotation starts a new file
+void test_LogFile_ReopenAndRotate() {
+    MockLogStorage storage;
+    LogFile file(storage);
+
+    file.open("/log_0.daq", 0);
+    std::vector<uint8_t> a = makeRecord(1, 16);
+    std::vector<uint8_t> b = makeRecord(2, 16);
+    TEST_ASSERT_TRUE(file.write(a.data(), a.size(), 0));
+
+    storage.failWrites(1);
+    TEST_ASSERT_TRUE(file.write(b.data(), b.size(), 1));
+    TEST_ASSERT_EQUAL_INT(1, file.stats().reopens);
+    TEST_ASSERT_EQUAL_INT(0, file.stats().errors);
+    TEST_ASSERT_EQUAL_INT(32, storage.contents("/log_0.daq").size());
+
+    // a card that stays broken is reported, not retried forever
+    storage.failWrites(2);
+    TEST_ASSERT_FALSE(file.write(b.data(), b.size(), 2));
+    TEST_ASSERT_EQUAL_INT(1, file.stats().errors);
+
+    TEST_ASSERT_TRUE(file.rotate("/log_1.daq", 3));
+    TEST_ASSERT_TRUE(file.write(a.data(), a.size(), 3));
+    TEST_ASSERT_EQUAL_INT(16, storage.contents("/log_1.daq").size());
+    TEST_ASSERT_EQUAL_STRING("/log_1.daq", file.path().c_str());
+}
+
+// Test: keeping the file open cuts the simulated per-record latency of open/seek/write/close
+void test_LogFile_Latency() {
+    const int RECORDS = 600;  // a minute at the default 100 ms period
+    std::vector<uint8_t> record = makeRecord(0, 8 + 64 + 32);
+
+    // before: every record opens the file, appends and closes it again
+    MockLogStorage before;
+    uint64_t beforeMax = 0;
+    for (int i = 0; i < RECORDS; ++i) {
+        uint64_t start = before.elapsedUs();
+        before.open("/log_0.daq");
+        before.write(record.data(), record.size());
+        before.close();
+        uint64_t took = before.elapsedUs() - start;
+        beforeMax = took > beforeMax ? took : beforeMax;
+    }
+
+    // after: one open for the session, flushed once a second
+    MockLogStorage after;
+    LogFile file(after);
+    file.open("/log_0.daq", 0);
+    uint64_t afterStart = after.elapsedUs();
+    uint64_t afterMax = 0;
+    for (int i = 0; i < RECORDS; ++i) {
+        uint64_t start = after.elapsedUs();
+        file.write(record.data(), record.size(), (i + 1) * 100);
+        uint64_t took = after.elapsedUs() - start;
+        afterMax = took > afterMax ? took : afterMax;
+    }
+
+    double beforeAvg = static_cast<double>(before.elapsedUs()) / RECORDS;
+    double afterAvg = static_cast<double>(after.elapsedUs() - afterStart) / RECORDS;
+    TEST_DEBUG_PRINTLN("per record: open/write/close avg %.0f us max %d us, open file avg %.0f us "
+                       "max %d us",
+                       beforeAvg, static_cast<int>(beforeMax), afterAvg,
+                       static_cast<int>(afterMax));
+
+    TEST_ASSERT_TRUE(afterAvg * 5 < beforeAvg);
+    TEST_ASSERT_TRUE(afterMax < beforeMax);
+    TEST_ASSERT_TRUE(before.contents("/log_0.daq") == after.contents("/log_0.daq"));
+}
+
+// Test: preallocating takes cluster allocation off the write path, keeping the session marker up
+// to date doesn't put it back, and close cuts the file back
+void test_LogFile_Preallocate() {
+    const int RECORDS = 400;
+    const std::size_t CHUNK = 8 * remote::LOG_SECTOR_SIZE;  // what LogRingWriter hands over
+    std::vector<uint8_t> chunk = makeRecord(0, CHUNK);
+
+    // flushed every few chunks, as on the car
+    LogFileOptions options;
+
+    uint64_t worst[2] = {0, 0};
+    uint64_t total[2] = {0, 0};
+    std::size_t allocations[2] = {0, 0};  // clusters allocated while writing
+    std::vector<uint8_t> contents[2];
+    for (int pre = 0; pre < 2; ++pre) {
+        MockLogStorage storage;
+        options.preallocateBytes = pre ? 2 << 20 : 0;
+        LogFile file(storage, options);
+        file.open("/log_0.daq", 0);
+        std::size_t allocatedAtOpen = storage.allocations();
+        for (int i = 0; i < RECORDS; ++i) {
+            uint64_t start = storage.elapsedUs();
+            TEST_ASSERT_TRUE(file.write(chunk.data(), chunk.size(), i));
+            uint64_t took = storage.elapsedUs() - start;
+            worst[pre] = took > worst[pre] ? took : worst[pre];
+            total[pre] += took;
+        }
+        TEST_ASSERT_EQUAL_INT(0, storage.unalignedWrites());
+        if (pre) {
+            // 1.6 MB of data fits, the file never had to grow
+            TEST_ASSERT_EQUAL_INT(2 << 20, file.allocatedBytes());
+            TEST_ASSERT_EQUAL_INT(2 << 20, storage.contents("/log_0.daq").size());
+            TEST_ASSERT_TRUE(storage.exists(LogFile::SESSION_MARKER));
+            // committed on every flush, through the one handle opened with the file
+            TEST_ASSERT_EQUAL_INT(file.stats().flushes + 1, storage.rewrites());
+            TEST_ASSERT_EQUAL_INT(1, storage.rewriteOpens());
+        }
+        allocations[pre] = storage.allocations() - allocatedAtOpen;
+        file.close();
+        contents[pre] = storage.contents("/log_0.daq");
+        TEST_ASSERT_FALSE(storage.exists(LogFile::SESSION_MARKER));
+    }
+
+    TEST_DEBUG_PRINTLN("worst write: %d us growing as it goes, %d us preallocated, in total %d us "
+                       "and %d us",
+                       static_cast<int>(worst[0]), static_cast<int>(worst[1]),
+                       static_cast<int>(total[0]), static_cast<int>(total[1]));
+    TEST_ASSERT_EQUAL_INT(RECORDS * CHUNK, contents[0].size());
+    TEST_ASSERT_TRUE(contents[0] == contents[1]);
+    TEST_ASSERT_EQUAL_INT(RECORDS * CHUNK / (32 * 1024), allocations[0]);
+    TEST_ASSERT_EQUAL_INT(0, allocations[1]);
+    TEST_ASSERT_TRUE(worst[1] <= worst[0]);
+    TEST_ASSERT_TRUE(total[1] <= total[0]);
+}
+
+// Test: a session that never closed is cut back to what it committed at the next boot, even with
+// an old log's bytes left in the preallocated space
+void test_LogFile_Recover() {
+    MockLogStorage storage;
+    storage.fillGrowth(0xA5);
+    LogFileOptions options;
+    options.preallocateBytes = 2 * remote::LOG_SECTOR_SIZE;
+    std::vector<uint8_t> data = makeRecord(5, 3 * remote::LOG_SECTOR_SIZE);
+    std::vector<uint8_t> late = makeRecord(9, remote::LOG_SECTOR_SIZE);
+
+    {
+        LogFile file(storage, options);
+        file.open("/2025-01-01/log_3.daq", 0);
+        // runs past the preallocated space, which grows by another two sectors
+        file.write(data.data(), data.size(), 0);
+        TEST_ASSERT_EQUAL_INT(5 * remote::LOG_SECTOR_SIZE, file.allocatedBytes());
+        file.flush(1);
+        // never flushed, so never committed
+        file.write(late.data(), late.size(), 2);
+        // the power goes out, the file is never closed
+        storage.close();
+    }
+    TEST_ASSERT_EQUAL_INT(5 * remote::LOG_SECTOR_SIZE,
+                          storage.contents("/2025-01-01/log_3.daq").size());
+    TEST_ASSERT_EQUAL_INT(0xA5, storage.contents("/2025-01-01/log_3.daq").back());
+    TEST_ASSERT_TRUE(storage.exists(LogFile::SESSION_MARKER));
+
+    TEST_ASSERT_TRUE(LogFile::recover(storage));
+    TEST_ASSERT_TRUE(data == storage.contents("/2025-01-01/log_3.daq"));
+    TEST_ASSERT_FALSE(storage.exists(LogFile::SESSION_MARKER));
+
+    // nothing left to do the next time around
+    TEST_ASSERT_FALSE(LogFile::recover(storage));
+
+    // a torn marker can't be trusted, the file is left alone and the marker cleared
+    uint8_t torn[] = {0x00, 0x06, 0x00, 0x00, 0x12, 0x34, '/', 'l'};
+    storage.writeFile(LogFile::SESSION_MARKER, torn, sizeof(torn));
+    TEST_ASSERT_FALSE(LogFile::recover(storage));
+    TEST_ASSERT_TRUE(data == storage.contents("/2025-01-01/log_3.daq"));
+    TEST_ASSERT_FALSE(storage.exists(LogFile::SESSION_MARKER));
+}
+
+// Test: sessions are numbered from the counter without counting the directory, which is only
+// counted when the counter is missing or damaged
+void test_LogFile_SessionCounter() {
+    MockLogStorage storage;
+    LogSessionCounter sessions(storage);
+    int scans = 0;
+    uint32_t files = 0;
+    auto scan = [&]() {
+        ++scans;
+        return files;
+    };
+
+    // a new day's directory
+    TEST_ASSERT_EQUAL_STRING("/2025-01-01/log_0.daq", sessions.next("/2025-01-01", scan).c_str());
+    for (int i = 1; i < 50; ++i) {
+        std::string path = sessions.next("/2025-01-01", scan);
+        TEST_ASSERT_EQUAL_STRING(LogSessionCounter::logPath("/2025-01-01", i).c_str(), path.c_str());
+    }
+    TEST_ASSERT_EQUAL_INT(1, scans);
+    TEST_ASSERT_EQUAL_INT(LogSessionCounter::COUNTER_SIZE,
+                          storage.contents("/2025-01-01/sessions").size());
+
+    // a torn counter, in a directory an older build wrote five logs to
+    uint8_t torn[] = {0x4E, 0x46, 0x52};
+    storage.writeFile("/2025-01-02/sessions", torn, sizeof(torn));
+    files = 5;
+    TEST_ASSERT_EQUAL_STRING("/2025-01-02/log_5.daq", sessions.next("/2025-01-02", scan).c_str());
+    TEST_ASSERT_EQUAL_INT(2, scans);
+
+    // a bit flip fails the CRC
+    std::vector<uint8_t> counter = storage.contents("/2025-01-02/sessions");
+    counter[5] ^= 0x01;
+    storage.writeFile("/2025-01-02/sessions", counter.data(), counter.size());
+    files = 6;
+    TEST_ASSERT_EQUAL_STRING("/2025-01-02/log_6.daq", sessions.next("/2025-01-02", scan).c_str());
+    TEST_ASSERT_EQUAL_INT(3, scans);
+
+    // a counter that fell behind the files skips past them instead of appending to one
+    uint8_t record[] = {1, 2, 3};
+    for (const char* path : {"/2025-01-02/log_7.daq", "/2025-01-02/log_8.daq"}) {
+        storage.open(path);
+        storage.write(record, sizeof(record));
+        storage.close();
+    }
+    TEST_ASSERT_EQUAL_STRING("/2025-01-02/log_9.daq", sessions.next("/2025-01-02", scan).c_str());
+    TEST_ASSERT_EQUAL_STRING("/2025-01-02/log_10.daq", sessions.next("/2025-01-02", scan).c_str());
+    TEST_ASSERT_EQUAL_INT(3, scans);
+}
+
+TEST_FUNC(test_LogFile_StaysOpen);
+TEST_FUNC(test_LogFile_FlushOnBytes);
+TEST_FUNC(test_LogFile_ReopenAndRotate);
+TEST_FUNC(test_LogFile_Latency);
+TEST_FUNC(test_LogFile_Preallocate);
+TEST_FUNC(test_LogFile_Recover);
+TEST_FUNC(test_LogFile_SessionCounter);
@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <can.hpp>
+#include <crc.hpp>
+#include <drivers/can_driver_virtual.hpp>
+#include <log_format.hpp>
+#include <vector>
+
+#include "test.hpp"
+#include "test_debug.hpp"
+
+using can::CANBus;
+using can::CANMessageDescription;
+using can::RawCANMessage;
+using remote::EventDecoder;
+using remote::EventEncoder;
+using remote::LogEvent;
+using remote::LogFrame;
+using remote::LogIndexEntry;
+using remote::LogIndexWriter;
+using remote::SnapshotDecoder;
+using remote::SnapshotEncoder;
+
+static RawCANMessage makeFrame(uint32_t id, uint64_t timestampUs, uint8_t length) {
+    RawCANMessage raw{};
+    raw.id = id;
+    raw.timestampUs = timestampUs;
+    raw.length = length;
+    for (uint8_t i = 0; i < length; ++i) raw.data[i] = static_cast<uint8_t>(id + i);
+    return raw;
+}
+
+// Test: events carry a short delta, and only need an absolute time at the start or after a gap
+void test_LogFormat_EventRoundTrip() {
+    std::vector<RawCANMessage> frames = {
+        makeFrame(0x010, 1000000, 8),  // first event, absolute
+        makeFrame(0x010, 1000250, 8),  // 250 us later
+        makeFrame(0x011, 1000250, 4),  // same instant
+        makeFrame(0x300, 1065000, 64),  // just under the u16 limit
+        makeFrame(0x010, 1200000, 8),  // a 135 ms gap, absolute again
+    };
+
+    EventEncoder encoder;
+    std::vector<uint8_t> stream;
+    std::vector<std::size_t> sizes;
+    uint8_t record[EventEncoder::MAX_RECORD_SIZE];
+    for (const RawCANMessage& frame : frames) {
+        std::size_t size = encoder.encode(frame, record);
+        sizes.push_back(size);
+        stream.insert(stream.end(), record, record + size);
+    }
+
+    TEST_ASSERT_EQUAL_UINT(9 + 6 + 8, sizes[0]);
+    TEST_ASSERT_EQUAL_UINT(6 + 8, sizes[1]);
+    TEST_ASSERT_EQUAL_UINT(6 + 4, sizes[2]);
+    TEST_ASSERT_EQUAL_UINT(6 + 64, sizes[3]);
+    TEST_ASSERT_EQUAL_UINT(9 + 6 + 8, sizes[4]);
+
+    EventDecoder decoder;
+    std::size_t at = 0;
+    for (const RawCANMessage& frame : frames) {
+        LogEvent event;
+        std::size_t used = decoder.decode(stream.data() + at, stream.size() - at, &event);
+        TEST_ASSERT_TRUE(used > 0);
+        at += used;
+
+        TEST_ASSERT_EQUAL_UINT(frame.timestampUs, event.timestampUs);
+        TEST_ASSERT_EQUAL_UINT(frame.id, event.id);
+        TEST_ASSERT_EQUAL_UINT(frame.length, event.length);
+        TEST_ASSERT_EQUAL_MEMORY(frame.data, event.data, frame.length);
+    }
+    TEST_ASSERT_EQUAL_UINT(stream.size(), at);
+}
+
+// Test: after a reset the next event stands on its own, and truncated records are refused
+void test_LogFormat_EventResetAndTruncation() {
+    EventEncoder encoder;
+    uint8_t record[EventEncoder::MAX_RECORD_SIZE];
+    encoder.encode(makeFrame(0x010, 500, 8), record);
+
+    // this one was dropped on the device, the decoder never sees it
+    encoder.encode(makeFrame(0x010, 600, 8), record);
+    encoder.reset();
+
+    std::size_t size = encoder.encode(makeFrame(0x010, 700, 8), record);
+    TEST_ASSERT_EQUAL_UINT8(remote::LRT_EVENT_TIME, record[0]);
+
+    EventDecoder decoder;
+    LogEvent event;
+    TEST_ASSERT_EQUAL_UINT(0, decoder.decode(record, size - 1, &event));
+    TEST_ASSERT_EQUAL_UINT(size, decoder.decode(record, size, &event));
+    TEST_ASSERT_EQUAL_UINT(700, event.timestampUs);
+
+    // an event with nothing to be relative to can't be placed in time
+    EventDecoder fresh;
+    TEST_ASSERT_EQUAL_UINT(0, fresh.decode(record + 9, size - 9, &event));
+}
+
+// Helper: a bus of `count` classic messages, 0x100 upwards
+static void addMessages(CANBus& bus, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        CANMessageDescription desc{};
+        desc.id = 0x100 + i;
+        desc.length = 8;
+        desc.type = can::STANDARD;
+        desc.signals.push_back({0, 64, false, can::MSG_LITTLE_ENDIAN, 1, 0});
+        bus.addMessage(desc);
+    }
+    bus.initialize();
+}
+
+// Helper: the state of the bus the way a full snapshot stores it
+static void expectBusState(CANBus& bus, const remote::LogSnapshot& snapshot) {
+    std::size_t size;
+    const uint8_t* buffer = bus.dataBuffer(&size);
+    TEST_ASSERT_EQUAL_UINT(size, snapshot.buffer.size());
+    TEST_ASSERT_EQUAL_MEMORY(buffer, snapshot.buffer.data(), size);
+}
+
+// Test: delta records rebuild the bus exactly, and mostly static buses log far less
+void test_LogFormat_DeltaSnapshots() {
+    const uint32_t MESSAGES = 40;
+    const uint32_t RECORDS = 200;
+    can::VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    addMessages(bus, MESSAGES);
+
+    std::size_t busSize;
+    bus.dataBuffer(&busSize);
+    SnapshotEncoder encoder(10);
+    SnapshotDecoder decoder(remote::snapshotLayout(bus), busSize);
+
+    std::vector<uint8_t> record;
+    std::size_t deltaBytes = 0;
+    std::size_t fullBytes = 0;
+    std::size_t keyframes = 0;
+    for (uint32_t r = 0; r < RECORDS; ++r) {
+        // a couple of fast messages change every sample, the rest are static
+        for (uint32_t id = 0x100; id < 0x102; ++id) {
+            RawCANMessage frame{};
+            frame.id = id;
+            frame.length = 8;
+            frame.data64 = r * 1000 + id;
+            drv.setTimeUs(r * 100000 + id);
+            drv.inject(frame);
+        }
+        bus.update();
+
+        remote::LogRecordType type = encoder.encode(bus, r * 100, 1700000000 + r / 10, record);
+        keyframes += type == remote::LRT_SNAPSHOT;
+        deltaBytes += record.size();
+        fullBytes += 1 + 8 + busSize + 4 * MESSAGES;
+
+        TEST_ASSERT_TRUE(record.size() <= SnapshotEncoder::maxRecordSize(bus));
+        TEST_ASSERT_EQUAL_UINT(record.size(), decoder.decode(record.data(), record.size()));
+        TEST_ASSERT_EQUAL_UINT(r * 100, decoder.snapshot().timeMs);
+        TEST_ASSERT_EQUAL_UINT(1700000000 + r / 10, decoder.snapshot().unixTime);
+        expectBusState(bus, decoder.snapshot());
+        std::size_t count;
+        const uint64_t* stamps = bus.rxTimestamps(&count);
+        for (std::size_t i = 0; i < count; ++i) {
+            TEST_ASSERT_EQUAL_UINT(static_cast<uint32_t>(stamps[i]), decoder.snapshot().stamps[i]);
+        }
+    }
+
+    TEST_DEBUG_PRINTLN("%d records: %d bytes as full snapshots, %d bytes with deltas (%.1fx)",
+                       RECORDS, static_cast<int>(fullBytes), static_cast<int>(deltaBytes),
+                       static_cast<double>(fullBytes) / deltaBytes);
+    TEST_ASSERT_EQUAL_UINT(RECORDS / 10, keyframes);
+    TEST_ASSERT_TRUE(deltaBytes * 5 < fullBytes);
+}
+
+// Test: the record bound covers a full snapshot, and a large FD config goes past what a frame holds
+void test_LogFormat_RecordBound() {
+    can::VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    for (uint32_t i = 0; i < 1100; ++i) {
+        CANMessageDescription desc{};
+        desc.id = 0x100 + i;
+        desc.length = can::CANFD_MAX_DATA_LENGTH;
+        desc.type = can::EXTENDED;
+        desc.signals.push_back({0, 64, false, can::MSG_LITTLE_ENDIAN, 1, 0});
+        bus.addMessage(desc);
+    }
+    bus.initialize();
+
+    SnapshotEncoder encoder;
+    std::vector<uint8_t> record;
+    TEST_ASSERT_EQUAL_INT(remote::LRT_SNAPSHOT, encoder.encode(bus, 0, 0, record));
+    TEST_ASSERT_EQUAL_UINT(1 + 8 + 1100 * 64 + 4 * 1100, record.size());
+    TEST_ASSERT_TRUE(record.size() <= SnapshotEncoder::maxRecordSize(bus));
+    TEST_ASSERT_TRUE(SnapshotEncoder::maxRecordSize(bus) > remote::LOG_MAX_BODY_SIZE);
+}
+
+// Test: a reader that missed the start resyncs on the next keyframe, and a lost record forces one
+void test_LogFormat_DeltaResync() {
+    can::VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    addMessages(bus, 4);
+    std::size_t busSize;
+    bus.dataBuffer(&busSize);
+
+    SnapshotEncoder encoder(100);
+    std::vector<uint8_t> record;
+    TEST_ASSERT_EQUAL_INT(remote::LRT_SNAPSHOT, encoder.encode(bus, 0, 0, record));
+    TEST_ASSERT_EQUAL_INT(remote::LRT_DELTA, encoder.encode(bus, 1, 0, record));
+
+    // nothing changed, so the delta is just the clocks and the bitmap
+    TEST_ASSERT_EQUAL_UINT(1 + 2 + 1, record.size());
+    SnapshotDecoder late(remote::snapshotLayout(bus), busSize);
+    TEST_ASSERT_EQUAL_UINT(0, late.decode(record.data(), record.size()));
+
+    encoder.forceKeyframe();
+    TEST_ASSERT_EQUAL_INT(remote::LRT_SNAPSHOT, encoder.encode(bus, 2, 0, record));
+    TEST_ASSERT_EQUAL_UINT(record.size(), late.decode(record.data(), record.size()));
+    TEST_ASSERT_EQUAL_UINT(0, late.decode(record.data(), record.size() - 1));
+}
+
+// Test: a corrupt byte costs the frame it lands in, the reader picks up again at the next sync word
+void test_LogFormat_FrameResync() {
+    const char* check = "123456789";
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, common::crc16(check, 9));
+
+    std::vector<uint8_t> stream;
+    std::vector<std::size_t> starts;
+    for (uint32_t i = 0; i < 10; ++i) {
+        starts.push_back(stream.size());
+        std::vector<uint8_t> record(1 + i * 3, static_cast<uint8_t>(i));
+        record[0] = remote::LRT_DELTA;
+        remote::frameRecord(record);
+        TEST_ASSERT_EQUAL_UINT(remote::LOG_FRAME_OVERHEAD + 1 + i * 3, record.size());
+        stream.insert(stream.end(), record.begin(), record.end());
+    }
+    // somewhere in the body of the fifth frame
+    stream[starts[4] + remote::LOG_FRAME_HEADER_SIZE + 5] ^= 0x40;
+
+    std::vector<uint8_t> seen;
+    std::size_t at = 0;
+    std::size_t corrupt = 0;
+    while (at < stream.size()) {
+        LogFrame frame;
+        remote::LogFrameStatus status = remote::readFrame(stream.data() + at, stream.size() - at,
+                                                          &frame);
+        if (status == remote::LFS_TRUNCATED) {
+            break;
+        }
+        if (status == remote::LFS_CORRUPT) {
+            ++corrupt;
+            at += 1 + remote::findSync(stream.data() + at + 1, stream.size() - at - 1);
+            continue;
+        }
+        seen.push_back(static_cast<uint8_t>((frame.size - 1) / 3));
+        at += frame.used;
+    }
+
+    TEST_ASSERT_EQUAL_UINT(stream.size(), at);
+    TEST_ASSERT_TRUE(corrupt >= 1);
+    std::vector<uint8_t> expected = {0, 1, 2, 3, 5, 6, 7, 8, 9};
+    TEST_ASSERT_TRUE(expected == seen);
+
+    // a frame cut off by a crash is reported as such, not as corrupt
+    LogFrame frame;
+    TEST_ASSERT_EQUAL_INT(remote::LFS_TRUNCATED, remote::readFrame(stream.data(), 3, &frame));
+}
+
+// Test: the footer leads to the index record, and that to the snapshot at or before a given time
+void test_LogFormat_IndexSeek() {
+    const uint32_t RECORDS = 300;
+    const uint64_t HEADER = 123;  // magic and config, as far as offsets go
+    can::VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    addMessages(bus, 8);
+    std::size_t busSize;
+    bus.dataBuffer(&busSize);
+
+    // the way SDLogger::capture() lays out a session
+    SnapshotEncoder encoder(10);
+    LogIndexWriter index(4);
+    index.reset(HEADER);
+    std::vector<uint8_t> file(HEADER, 0);
+    std::vector<uint8_t> record;
+    std::vector<uint8_t> block;
+    for (uint32_t r = 0; r < RECORDS; ++r) {
+        RawCANMessage frame{};
+        frame.id = 0x100 + r % 8;
+        frame.length = 8;
+        frame.data64 = r;
+        drv.inject(frame);
+        bus.update();
+
+        encoder.encode(bus, r * 100, 0, record);
+        remote::frameRecord(record);
+        file.insert(file.end(), record.begin(), record.end());
+        index.committed(record.data(), record.size());
+        if (index.blockDue()) {
+            index.encodeBlock(block);
+            file.insert(file.end(), block.begin(), block.end());
+            index.committed(block.data(), block.size());
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT(file.size(), index.offset());
+    index.encodeFooter(block);
+    file.insert(file.end(), block.begin(), block.end());
+
+    uint64_t footerOffset;
+    TEST_ASSERT_TRUE(remote::readTrailer(file.data() + file.size() - remote::LOG_TRAILER_SIZE,
+                                         &footerOffset));
+    LogFrame frame;
+    TEST_ASSERT_EQUAL_INT(remote::LFS_OK, remote::readFrame(file.data() + footerOffset,
+                                                            file.size() - footerOffset, &frame));
+    std::vector<LogIndexEntry> blocks;
+    TEST_ASSERT_TRUE(remote::decodeIndex(frame.body, frame.size, blocks));
+    // 30 keyframes, 4 to a block, the last two in the block written with the footer
+    TEST_ASSERT_EQUAL_UINT(8, blocks.size());
+
+    SnapshotDecoder decoder(remote::snapshotLayout(bus), busSize);
+    auto byTime = [](uint32_t t, const LogIndexEntry& e) { return t < e.timeMs; };
+    for (uint32_t target : {0u, 999u, 1000u, 12345u, 29999u}) {
+        auto b = std::upper_bound(blocks.begin(), blocks.end(), target, byTime) - 1;
+        TEST_ASSERT_EQUAL_INT(remote::LFS_OK, remote::readFrame(file.data() + b->offset,
+                                                                file.size() - b->offset, &frame));
+        std::vector<LogIndexEntry> snapshots;
+        TEST_ASSERT_TRUE(remote::decodeIndex(frame.body, frame.size, snapshots));
+
+        auto s = std::upper_bound(snapshots.begin(), snapshots.end(), target, byTime) - 1;
+        TEST_ASSERT_EQUAL_INT(remote::LFS_OK, remote::readFrame(file.data() + s->offset,
+                                                                file.size() - s->offset, &frame));
+        TEST_ASSERT_EQUAL_UINT8(remote::LRT_SNAPSHOT, frame.body[0]);
+        TEST_ASSERT_EQUAL_UINT(frame.size, decoder.decode(frame.body, frame.size));
+        TEST_ASSERT_EQUAL_UINT(target / 1000 * 1000, decoder.snapshot().timeMs);
+    }
+
+    // a log that was never closed has no trailer
+    TEST_ASSERT_FALSE(remote::readTrailer(file.data() + HEADER, &footerOffset));
+}
+
+TEST_FUNC(test_LogFormat_EventRoundTrip);
+TEST_FUNC(test_LogFormat_DeltaSnapshots);
+TEST_FUNC(test_LogFormat_DeltaResync);
+TEST_FUNC(test_LogFormat_RecordBound);
+TEST_FUNC(test_LogFormat_EventResetAndTruncation);
+TEST_FUNC(test_LogFormat_FrameResync);
+TEST_FUNC(test_LogFormat_IndexSeek);
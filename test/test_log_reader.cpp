@@ -0,0 +1,483 @@
+#include <algorithm>
+#include <builder/telem_builder.hpp>
+#include <builder/token_reader.hpp>
+#include <builder/tokenizer.hpp>
+#include <can.hpp>
+#include <cstring>
+#include <drivers/can_driver_virtual.hpp>
+#include <log_columns.hpp>
+#include <log_file.hpp>
+#include <log_format.hpp>
+#include <log_reader.hpp>
+#include <log_ring.hpp>
+#include <log_session.hpp>
+#include <log_storage.hpp>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+#include "test_debug.hpp"
+
+using can::CANBus;
+using can::RawCANMessage;
+using remote::ColumnReader;
+using remote::ColumnWriter;
+using remote::LogChunk;
+using remote::LogReader;
+
+static const char* CONFIG =
+    "!! logPeriodMs 100\n"
+    "> BMS\n"
+    ">> PACK 0x0A0 8\n"
+    ">>> VOLTAGE uint16 0 16 0.01 0.0 unsigned little\n"
+    ">>> CURRENT int16 16 16 0.1 -3200.0 signed big\n"
+    "> INVERTER\n"
+    ">> MOTOR 0x010 4 event\n"
+    ">>> RPM int16 0 16 1 0 signed\n";
+
+static const uint32_t RECORDS = 200;
+
+/// @brief A session the way SDLogger writes one, with what the bus held at each record
+struct Session {
+    std::vector<uint8_t> file;
+    std::vector<std::vector<double>> rows;  // every signal, as the device decoded it
+    std::vector<double> rpm;                // the value of each event
+};
+
+static void appendFrames(Session& session, remote::LogIndexWriter& index,
+                         const std::vector<uint8_t>& frames) {
+    session.file.insert(session.file.end(), frames.begin(), frames.end());
+    index.committed(frames.data(), frames.size());
+}
+
+// Helper: the magic and the config, what every log file starts with
+static std::vector<uint8_t> makeHeader() {
+    std::vector<uint8_t> header(remote::LOG_MAGIC, remote::LOG_MAGIC + remote::LOG_MAGIC_SIZE);
+    uint32_t configSize = static_cast<uint32_t>(std::strlen(CONFIG));
+    for (int i = 0; i < 4; ++i) header.push_back(static_cast<uint8_t>(configSize >> (8 * i)));
+    header.insert(header.end(), CONFIG, CONFIG + configSize);
+    return header;
+}
+
+static void buildBus(CANBus& bus) {
+    can::MockTokenReader reader(CONFIG);
+    can::Tokenizer tok(reader);
+    can::TelemBuilder builder(tok);
+    builder.plan(bus);
+    TEST_ASSERT_FALSE(builder.build(bus).isError());
+    bus.initialize();
+}
+
+static Session makeSession() {
+    Session session;
+    session.file = makeHeader();
+
+    can::VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    buildBus(bus);
+    const can::CANMessage& pack = *bus.getMessages().find(0x0A0)->second;
+
+    remote::SnapshotEncoder snapshots(10);
+    remote::EventEncoder events;
+    remote::LogIndexWriter index(4);
+    index.reset(session.file.size());
+    std::vector<uint8_t> record;
+    for (uint32_t r = 0; r < RECORDS; ++r) {
+        // the pack changes every record, the motor only through events
+        bus.setSignalValue(pack.signals[0], 0.5 * r);
+        bus.setSignalValue(pack.signals[1], -100.0 + r);
+        if (snapshots.encode(bus, r * 100, 1700000000 + r / 10, record) == remote::LRT_SNAPSHOT) {
+            events.reset();
+        }
+        remote::frameRecord(record);
+        appendFrames(session, index, record);
+        std::vector<double> row(3);
+        bus.decodeSignals(row.data(), row.size());
+        session.rows.push_back(row);
+
+        RawCANMessage frame{};
+        frame.id = 0x010;
+        frame.length = 4;
+        frame.timestampUs = r * 100000 + 50;
+        int16_t rpm = static_cast<int16_t>(3 * r - 300);
+        frame.data[0] = static_cast<uint8_t>(rpm);
+        frame.data[1] = static_cast<uint8_t>(rpm >> 8);
+        record.resize(remote::LOG_FRAME_OVERHEAD + remote::EventEncoder::MAX_RECORD_SIZE);
+        std::size_t size = events.encode(frame, record.data() + remote::LOG_FRAME_HEADER_SIZE);
+        record.resize(remote::frameRecord(record.data(), size));
+        appendFrames(session, index, record);
+        session.rpm.push_back(rpm);
+
+        if (index.blockDue()) {
+            index.encodeBlock(record);
+            appendFrames(session, index, record);
+        }
+    }
+    index.encodeFooter(record);
+    session.file.insert(session.file.end(), record.begin(), record.end());
+    return session;
+}
+
+// Helper: every row the reader gave back is exactly what the device had at that time
+static void expectRows(const Session& session, const LogChunk& chunk) {
+    for (std::size_t row = 0; row < chunk.snapshots.timeMs.size(); ++row) {
+        const std::vector<double>& expected = session.rows[chunk.snapshots.timeMs[row] / 100];
+        for (std::size_t s = 0; s < expected.size(); ++s) {
+            TEST_ASSERT_EQUAL_DOUBLE(expected[s], chunk.snapshots.values[s][row]);
+        }
+    }
+}
+
+// Test: the bus comes back from the embedded config, and every record decodes into its columns
+void test_LogReader_Session() {
+    Session session = makeSession();
+    LogReader reader;
+    auto res = reader.open(session.file.data(), session.file.size());
+    TEST_ASSERT_FALSE_MESSAGE(res.isError(), res.error().c_str());
+    TEST_ASSERT_EQUAL_UINT(100, res.value().logPeriodMs);
+
+    TEST_ASSERT_EQUAL_UINT(3, reader.signals().size());
+    TEST_ASSERT_EQUAL_STRING("INVERTER.MOTOR.RPM", reader.signals()[0].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("BMS.PACK.VOLTAGE", reader.signals()[1].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("BMS.PACK.CURRENT", reader.signals()[2].name.c_str());
+
+    LogChunk all = reader.decode(reader.framesStart(), session.file.size());
+    TEST_ASSERT_EQUAL_UINT(RECORDS, all.snapshots.timeMs.size());
+    TEST_ASSERT_EQUAL_UINT(0, all.stats.corrupt + all.stats.unsynced + all.stats.truncated);
+    expectRows(session, all);
+    TEST_ASSERT_EQUAL_DOUBLE(99.5, all.snapshots.values[1][RECORDS - 1]);
+
+    TEST_ASSERT_EQUAL_UINT(RECORDS, all.events.value.size());
+    for (uint32_t r = 0; r < RECORDS; ++r) {
+        TEST_ASSERT_EQUAL_UINT(r * 100000 + 50, all.events.timestampUs[r]);
+        TEST_ASSERT_EQUAL_UINT(0, all.events.signal[r]);
+        TEST_ASSERT_EQUAL_DOUBLE(session.rpm[r], all.events.value[r]);
+    }
+}
+
+// Test: parts split at full snapshots decode independently into the same columns as the whole
+void test_LogReader_Chunks() {
+    Session session = makeSession();
+    LogReader reader;
+    TEST_ASSERT_FALSE(reader.open(session.file.data(), session.file.size()).isError());
+
+    std::vector<std::size_t> bounds = reader.chunkBounds(6);
+    TEST_ASSERT_EQUAL_UINT(7, bounds.size());
+    LogChunk joined;
+    for (std::size_t i = 0; i + 1 < bounds.size(); ++i) {
+        joined.append(reader.decode(bounds[i], bounds[i + 1]));
+    }
+    LogChunk all = reader.decode(reader.framesStart(), session.file.size());
+
+    TEST_ASSERT_TRUE(all.snapshots.timeMs == joined.snapshots.timeMs);
+    TEST_ASSERT_TRUE(all.snapshots.values == joined.snapshots.values);
+    TEST_ASSERT_TRUE(all.events.timestampUs == joined.events.timestampUs);
+    TEST_ASSERT_TRUE(all.events.value == joined.events.value);
+    TEST_ASSERT_EQUAL_UINT(all.stats.frames, joined.stats.frames);
+}
+
+// Test: a damaged log loses the records up to the next full snapshot and nothing else, and never
+// decodes wrong values
+void test_LogReader_Damage() {
+    Session session = makeSession();
+    LogReader reader;
+    TEST_ASSERT_FALSE(reader.open(session.file.data(), session.file.size()).isError());
+
+    // where the records of 95 and 190 start
+    std::vector<std::size_t> records;
+    for (std::size_t at = reader.framesStart(); records.size() <= 190;) {
+        remote::LogFrame frame;
+        remote::readFrame(session.file.data() + at, session.file.size() - at, &frame);
+        if (frame.body[0] == remote::LRT_SNAPSHOT || frame.body[0] == remote::LRT_DELTA) {
+            records.push_back(at);
+        }
+        at += frame.used;
+    }
+    // a bit flip in the middle of the delta of record 95, and cut off by a crash partway into 190
+    session.file[records[95] + remote::LOG_FRAME_HEADER_SIZE + 6] ^= 0x10;
+    session.file.resize(records[190] + 3);
+
+    LogReader damaged;
+    TEST_ASSERT_FALSE(damaged.open(session.file.data(), session.file.size()).isError());
+    LogChunk all = damaged.decode(damaged.framesStart(), session.file.size());
+    TEST_DEBUG_PRINTLN("%d rows, %d corrupt, %d unsynced, %d truncated",
+                       static_cast<int>(all.snapshots.timeMs.size()), all.stats.corrupt,
+                       all.stats.unsynced, all.stats.truncated);
+
+    TEST_ASSERT_EQUAL_UINT(1, all.stats.corrupt);
+    TEST_ASSERT_EQUAL_UINT(4, all.stats.unsynced);  // 96 to 99, 100 is a full snapshot
+    TEST_ASSERT_EQUAL_UINT(1, all.stats.truncated);
+    TEST_ASSERT_EQUAL_UINT(9400, all.snapshots.timeMs[94]);
+    TEST_ASSERT_EQUAL_UINT(10000, all.snapshots.timeMs[95]);
+    TEST_ASSERT_EQUAL_UINT(185, all.snapshots.timeMs.size());
+    TEST_ASSERT_EQUAL_UINT(18900, all.snapshots.timeMs.back());
+    expectRows(session, all);
+}
+
+// Helper: the session as a packing writer puts it on the card
+static std::vector<uint8_t> packSession(const Session& session, std::size_t framesStart) {
+    remote::MockLogStorage storage;
+    remote::LogFile file(storage);
+    file.open("/log_0.daq", 0);
+    remote::LogRing ring(8 * remote::LOG_SECTOR_SIZE);
+    remote::LogRingWriter writer(file, 8);
+    writer.setPacking(1024);
+
+    writer.append(session.file.data(), framesStart, 0);
+    uint32_t now = 0;
+    for (std::size_t at = framesStart; at < session.file.size(); at += 700) {
+        std::size_t size = std::min<std::size_t>(700, session.file.size() - at);
+        TEST_ASSERT_TRUE(ring.push(session.file.data() + at, size));
+        TEST_ASSERT_TRUE(writer.drain(ring, ++now));
+    }
+    TEST_ASSERT_EQUAL_UINT(0, storage.unalignedWrites());
+    TEST_ASSERT_TRUE(writer.finish(++now));
+    return storage.contents("/log_0.daq");
+}
+
+// Test: a packed session unpacks, on several threads, into exactly the log it was packed from,
+// and losing a packed record only loses the records up to the next full snapshot
+void test_LogReader_Packed() {
+    Session session = makeSession();
+    LogReader plain;
+    TEST_ASSERT_FALSE(plain.open(session.file.data(), session.file.size()).isError());
+    LogChunk expected = plain.decode(plain.framesStart(), plain.size());
+
+    std::vector<uint8_t> packed = packSession(session, plain.framesStart());
+    LogReader reader;
+    auto res = reader.open(packed.data(), packed.size(), 3);
+    TEST_ASSERT_FALSE_MESSAGE(res.isError(), res.error().c_str());
+    TEST_ASSERT_TRUE(reader.packed());
+    const remote::LogUnpackStats& stats = reader.unpackStats();
+    TEST_DEBUG_PRINTLN("%d bytes packed into %d, %d records", static_cast<int>(stats.unpackedBytes),
+                       static_cast<int>(stats.packedBytes), stats.records);
+    TEST_ASSERT_EQUAL_UINT(0, stats.corrupt + stats.truncated);
+    TEST_ASSERT_TRUE(stats.packedBytes * 5 < stats.unpackedBytes * 4);
+    TEST_ASSERT_EQUAL_UINT(session.file.size(), reader.size());
+
+    LogChunk all = reader.decode(reader.framesStart(), reader.size());
+    TEST_ASSERT_TRUE(expected.snapshots.timeMs == all.snapshots.timeMs);
+    TEST_ASSERT_TRUE(expected.snapshots.values == all.snapshots.values);
+    TEST_ASSERT_TRUE(expected.events.value == all.events.value);
+
+    // a bad byte in the third packed record
+    std::size_t at = reader.framesStart();
+    for (int i = 0; i < 2; ++i) {
+        remote::LogFrame frame;
+        TEST_ASSERT_EQUAL_INT(remote::LFS_OK,
+                              remote::readFrame(packed.data() + at, packed.size() - at, &frame));
+        at += frame.used;
+    }
+    packed[at + 40] ^= 0x01;
+    LogReader damaged;
+    TEST_ASSERT_FALSE(damaged.open(packed.data(), packed.size(), 3).isError());
+    // resyncing may trip over sync words inside the bad record, but only that record is lost
+    TEST_ASSERT_EQUAL_UINT(stats.records - 1, damaged.unpackStats().records);
+    LogChunk rest = damaged.decode(damaged.framesStart(), damaged.size());
+    TEST_ASSERT_TRUE(rest.stats.corrupt > 0);
+    TEST_ASSERT_TRUE(rest.snapshots.timeMs.size() < RECORDS);
+    // a kilobyte of the log is about 20 records, and up to 10 more until the next full snapshot
+    TEST_ASSERT_TRUE(rest.snapshots.timeMs.size() >= RECORDS - 30);
+    TEST_DEBUG_PRINTLN("%d rows after losing a packed record",
+                       static_cast<int>(rest.snapshots.timeMs.size()));
+    expectRows(session, rest);
+}
+
+// Helper: reads a closed log back through its trailer and footer, checking every index entry
+// points at a full snapshot of the right time
+static void expectIndex(const std::vector<uint8_t>& file) {
+    uint64_t footerOffset;
+    TEST_ASSERT_TRUE(remote::readTrailer(file.data() + file.size() - remote::LOG_TRAILER_SIZE,
+                                         &footerOffset));
+    remote::LogFrame frame;
+    TEST_ASSERT_EQUAL_INT(remote::LFS_OK, remote::readFrame(file.data() + footerOffset,
+                                                            file.size() - footerOffset, &frame));
+    std::vector<remote::LogIndexEntry> blocks;
+    TEST_ASSERT_TRUE(remote::decodeIndex(frame.body, frame.size, blocks));
+    TEST_ASSERT_TRUE(blocks.size() > 0);
+    for (const remote::LogIndexEntry& block : blocks) {
+        TEST_ASSERT_EQUAL_INT(remote::LFS_OK, remote::readFrame(file.data() + block.offset,
+                                                                file.size() - block.offset, &frame));
+        std::vector<remote::LogIndexEntry> snapshots;
+        TEST_ASSERT_TRUE(remote::decodeIndex(frame.body, frame.size, snapshots));
+        for (const remote::LogIndexEntry& snapshot : snapshots) {
+            TEST_ASSERT_EQUAL_INT(remote::LFS_OK,
+                                  remote::readFrame(file.data() + snapshot.offset,
+                                                    file.size() - snapshot.offset, &frame));
+            TEST_ASSERT_EQUAL_UINT8(remote::LRT_SNAPSHOT, frame.body[0]);
+            uint32_t timeMs;
+            std::memcpy(&timeMs, frame.body + 1, sizeof(timeMs));
+            TEST_ASSERT_EQUAL_UINT(snapshot.timeMs, timeMs);
+        }
+    }
+}
+
+// Test: a session rotated partway through while records keep coming, and past midnight, ends up
+// as two closed files in their own days' directories that each decode on their own and between
+// them hold every record
+void test_LogReader_Rotation() {
+    const uint32_t ROTATE_MS = 12300;
+    std::vector<uint8_t> header = makeHeader();
+    can::VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    buildBus(bus);
+    const can::CANMessage& pack = *bus.getMessages().find(0x0A0)->second;
+
+    for (std::size_t blockSize : {std::size_t(0), std::size_t(1024)}) {
+        remote::MockLogStorage storage;
+        remote::LogSession session(storage, 8 * remote::LOG_SECTOR_SIZE, 8);
+        std::string day = "/2025-01-01";
+        session.setDirectory([&]() { return day; });
+        session.setKeyframeInterval(10);
+        session.setPacking(blockSize);
+        session.setRotation(0, ROTATE_MS);
+        session.attach(bus);
+        TEST_ASSERT_TRUE(session.open(reinterpret_cast<const uint8_t*>(CONFIG), std::strlen(CONFIG),
+                                      0, 1700000000));
+        TEST_ASSERT_EQUAL_STRING("/2025-01-01/log_0.daq", session.filename().c_str());
+
+        for (uint32_t r = 0; r < RECORDS; ++r) {
+            uint32_t now = (r + 1) * 100;
+            if (r == RECORDS / 4) {
+                day = "/2025-01-02";
+            }
+            bus.setSignalValue(pack.signals[0], 0.5 * r);
+            bus.setSignalValue(pack.signals[1], -100.0 + r);
+            session.capture(bus, now);
+
+            // the LOG task drains a few records behind, so the new file's first records are
+            // already waiting when it gets to the end of the old one
+            if (r % 4 == 3) {
+                session.drain(now, 1700000000 + now / 1000);
+            }
+        }
+        TEST_ASSERT_EQUAL_STRING("/2025-01-02/log_0.daq", session.filename().c_str());
+
+        session.close();
+        uint32_t now = (RECORDS + 1) * 100;
+        session.capture(bus, now);
+        TEST_ASSERT_EQUAL_INT(remote::LOGGER_CLOSING, session.state());
+        session.drain(now, 1700000000 + now / 1000);
+        TEST_ASSERT_EQUAL_INT(remote::LOGGER_CLOSED, session.state());
+        TEST_ASSERT_EQUAL_UINT(0, session.ringStats().overflows);
+        // only the last partial sector of each file
+        TEST_ASSERT_EQUAL_UINT(2, storage.unalignedWrites());
+        TEST_ASSERT_EQUAL_INT(2, storage.opens());
+
+        uint32_t first = 0;
+        for (const char* path : {"/2025-01-01/log_0.daq", "/2025-01-02/log_0.daq"}) {
+            const std::vector<uint8_t>& contents = storage.contents(path);
+            TEST_ASSERT_TRUE(std::equal(header.begin(), header.end(), contents.begin()));
+            LogReader reader;
+            auto res = reader.open(contents.data(), contents.size());
+            TEST_ASSERT_FALSE_MESSAGE(res.isError(), res.error().c_str());
+            TEST_ASSERT_EQUAL(blockSize > 0, reader.packed());
+            LogChunk all = reader.decode(reader.framesStart(), reader.size());
+            TEST_ASSERT_EQUAL_UINT(0, all.stats.corrupt + all.stats.unsynced + all.stats.truncated);
+
+            // the first file ends where the rotation was asked for, the second picks up right
+            // after it
+            std::size_t count = all.snapshots.timeMs.size();
+            TEST_ASSERT_TRUE(count > 0);
+            for (uint32_t r = first; r < first + count; ++r) {
+                TEST_ASSERT_EQUAL_UINT((r + 1) * 100, all.snapshots.timeMs[r - first]);
+                TEST_ASSERT_EQUAL_DOUBLE(0.5 * r, all.snapshots.values[1][r - first]);
+            }
+            if (blockSize == 0) {
+                expectIndex(contents);
+            }
+            first += static_cast<uint32_t>(count);
+        }
+        TEST_ASSERT_EQUAL_UINT(RECORDS, first);
+    }
+}
+
+// Test: signals go into the column export as their raw integers with the signal's scale, and read
+// back bit for bit, with only values that aren't scaled integers left as XORed doubles
+void test_LogReader_Columns() {
+    const char* TMP_PATH = "test_log_reader_columns.tmp";
+    Session session = makeSession();
+    LogReader reader;
+    TEST_ASSERT_FALSE(reader.open(session.file.data(), session.file.size()).isError());
+    LogChunk all = reader.decode(reader.framesStart(), session.file.size());
+    std::vector<double> fractions(RECORDS);
+    for (uint32_t r = 0; r < RECORDS; ++r) {
+        fractions[r] = r / 3.0;
+    }
+
+    for (int plain = 0; plain < 2; ++plain) {
+        // the way daqdump writes the snapshot table
+        ColumnWriter writer(plain);
+        writer.times("time_ms", all.snapshots.timeMs);
+        for (std::size_t i = 0; i < reader.signals().size(); ++i) {
+            const remote::LogSignalInfo& signal = reader.signals()[i];
+            TEST_ASSERT_TRUE(writer.scaled(signal.name, all.snapshots.values[i], signal.factor,
+                                           signal.offset));
+        }
+        TEST_ASSERT_FALSE(writer.scaled("fractions", fractions, 1, 0));
+        std::FILE* f = std::fopen(TMP_PATH, "wb");
+        TEST_ASSERT_NOT_NULL(f);
+        TEST_ASSERT_TRUE(writer.write(f, RECORDS));
+        std::fclose(f);
+
+        std::vector<uint8_t> file;
+        f = std::fopen(TMP_PATH, "rb");
+        uint8_t buf[4096];
+        for (std::size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) {
+            file.insert(file.end(), buf, buf + n);
+        }
+        std::fclose(f);
+        std::remove(TMP_PATH);
+
+        ColumnReader columns;
+        auto rows = columns.open(file.data(), file.size());
+        TEST_ASSERT_FALSE_MESSAGE(rows.isError(), rows.error().c_str());
+        TEST_ASSERT_EQUAL_UINT(RECORDS, rows.value());
+        TEST_ASSERT_EQUAL_UINT(5, columns.columns().size());
+
+        std::vector<double> values;
+        for (std::size_t i = 0; i < reader.signals().size(); ++i) {
+            const remote::ColumnInfo& column = columns.columns()[1 + i];
+            TEST_ASSERT_EQUAL_STRING(reader.signals()[i].name.c_str(), column.name.c_str());
+            TEST_ASSERT_EQUAL_INT(remote::CT_I64, column.type);
+            TEST_ASSERT_EQUAL_INT(plain ? remote::CE_PLAIN : remote::CE_INTEGERS, column.encoding);
+            TEST_ASSERT_EQUAL_DOUBLE(reader.signals()[i].factor, column.factor);
+            TEST_ASSERT_EQUAL_DOUBLE(reader.signals()[i].offset, column.offset);
+
+            TEST_ASSERT_TRUE(columns.values(1 + i, values));
+            TEST_ASSERT_EQUAL_UINT(RECORDS, values.size());
+            TEST_ASSERT_EQUAL_MEMORY(all.snapshots.values[i].data(), values.data(),
+                                     RECORDS * sizeof(double));
+        }
+
+        // the voltage went up half a volt a record, in steps of 0.01
+        std::vector<int64_t> raw;
+        TEST_ASSERT_TRUE(columns.integers(2, raw));
+        TEST_ASSERT_EQUAL_INT64(50 * (RECORDS - 1), raw[RECORDS - 1]);
+
+        const remote::ColumnInfo& doubles = columns.columns()[4];
+        TEST_ASSERT_EQUAL_INT(remote::CT_F64, doubles.type);
+        TEST_ASSERT_EQUAL_INT(plain ? remote::CE_PLAIN : remote::CE_VALUES, doubles.encoding);
+        TEST_ASSERT_FALSE(columns.integers(4, raw));
+        TEST_ASSERT_TRUE(columns.values(4, values));
+        TEST_ASSERT_EQUAL_MEMORY(fractions.data(), values.data(), RECORDS * sizeof(double));
+    }
+
+    // the integers pack tighter than the same signal XORed as doubles
+    ColumnWriter asIntegers;
+    asIntegers.scaled("v", all.snapshots.values[1], reader.signals()[1].factor,
+                      reader.signals()[1].offset);
+    ColumnWriter asDoubles;
+    asDoubles.values("v", all.snapshots.values[1]);
+    TEST_DEBUG_PRINTLN("voltage column: %d bytes as integers, %d as doubles",
+                       static_cast<int>(asIntegers.encodedBytes()),
+                       static_cast<int>(asDoubles.encodedBytes()));
+    TEST_ASSERT_TRUE(asIntegers.encodedBytes() < asDoubles.encodedBytes());
+}
+
+TEST_FUNC(test_LogReader_Session);
+TEST_FUNC(test_LogReader_Chunks);
+TEST_FUNC(test_LogReader_Damage);
+TEST_FUNC(test_LogReader_Packed);
+TEST_FUNC(test_LogReader_Rotation);
+TEST_FUNC(test_LogReader_Columns);
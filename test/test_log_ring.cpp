@@ -0,0 +1,133 @@
+#include <log_file.hpp>
+#include <log_ring.hpp>
+#include <log_storage.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "test.hpp"
+#include "test_debug.hpp"
+
+using remote::LOG_SECTOR_SIZE;
+using remote::LogFile;
+using remote::LogRing;
+using remote::LogRingStats;
+using remote::LogRingWriter;
+using remote::MockLogStorage;
+
+static std::vector<uint8_t> makeRecord(uint32_t n, std::size_t size) {
+    std::vector<uint8_t> record(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        record[i] = static_cast<uint8_t>(n * 7 + i);
+    }
+    return record;
+}
+
+// Test: records wrap around the end of the ring intact, and a full ring drops whole records
+void test_LogRing_WrapAndOverflow() {
+    LogRing ring(1000);
+    TEST_ASSERT_EQUAL_INT(2 * LOG_SECTOR_SIZE, ring.capacity());
+
+    std::vector<uint8_t> a = makeRecord(1, 700);
+    std::vector<uint8_t> b = makeRecord(2, 600);
+    std::vector<uint8_t> out(1024);
+
+    TEST_ASSERT_TRUE(ring.push(a.data(), a.size()));
+    TEST_ASSERT_EQUAL_INT(700, ring.pop(out.data(), out.size()));
+    TEST_ASSERT_TRUE(std::equal(a.begin(), a.end(), out.begin()));
+
+    // starts at 700 and runs past the end of the buffer
+    TEST_ASSERT_TRUE(ring.push(b.data(), b.size()));
+    TEST_ASSERT_FALSE(ring.push(b.data(), b.size()));
+    TEST_ASSERT_EQUAL_INT(600, ring.size());
+    TEST_ASSERT_EQUAL_INT(600, ring.pop(out.data(), out.size()));
+    TEST_ASSERT_TRUE(std::equal(b.begin(), b.end(), out.begin()));
+
+    LogRingStats stats = ring.stats();
+    TEST_ASSERT_EQUAL_INT(3, stats.records);
+    TEST_ASSERT_EQUAL_INT(1, stats.overflows);
+    TEST_ASSERT_EQUAL_INT(600, stats.droppedBytes);
+    TEST_ASSERT_EQUAL_INT(700, stats.highWater);
+}
+
+// Test: the writer only issues whole, aligned sectors until the session finishes
+void test_LogRing_SectorWrites() {
+    MockLogStorage storage;
+    LogFile file(storage);
+    file.open("/log_0.daq", 0);
+    LogRing ring(8 * LOG_SECTOR_SIZE);
+    LogRingWriter writer(file, 4);
+
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> header = makeRecord(0, 137);
+    writer.append(header.data(), header.size(), 0);
+    expected.insert(expected.end(), header.begin(), header.end());
+
+    for (uint32_t i = 1; i <= 50; ++i) {
+        std::vector<uint8_t> record = makeRecord(i, 104);
+        TEST_ASSERT_TRUE(ring.push(record.data(), record.size()));
+        expected.insert(expected.end(), record.begin(), record.end());
+        if (i % 10 == 0) {
+            TEST_ASSERT_TRUE(writer.drain(ring, i));
+        }
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, storage.unalignedWrites());
+    TEST_ASSERT_EQUAL_INT(0, storage.contents("/log_0.daq").size() % LOG_SECTOR_SIZE);
+    TEST_ASSERT_EQUAL_INT(expected.size() % LOG_SECTOR_SIZE, writer.staged());
+
+    TEST_ASSERT_TRUE(writer.finish(51));
+    TEST_ASSERT_EQUAL_INT(0, writer.staged());
+    TEST_ASSERT_TRUE(expected == storage.contents("/log_0.daq"));
+}
+
+// Test: a producer thread never waits on the consumer, and what it queued arrives in order
+void test_LogRing_Threaded() {
+    const uint32_t RECORDS = 5000;
+    const std::size_t RECORD_SIZE = 120;
+
+    MockLogStorage storage;
+    LogFile file(storage);
+    file.open("/log_0.daq", 0);
+    LogRing ring(16 * LOG_SECTOR_SIZE);
+    LogRingWriter writer(file, 8);
+
+    std::vector<uint8_t> accepted;
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < RECORDS; ++i) {
+            std::vector<uint8_t> record = makeRecord(i, RECORD_SIZE);
+            if (ring.push(record.data(), record.size())) {
+                accepted.insert(accepted.end(), record.begin(), record.end());
+            }
+            // roughly the pace of CAN frames
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+    });
+
+    uint32_t now = 0;
+    while (true) {
+        bool done = ring.stats().records == RECORDS;
+        writer.drain(ring, ++now);
+        if (done && ring.size() == 0) {
+            break;
+        }
+    }
+    producer.join();
+    writer.drain(ring, ++now);
+    TEST_ASSERT_EQUAL_INT(0, storage.unalignedWrites());
+    writer.finish(++now);
+
+    LogRingStats stats = ring.stats();
+    TEST_DEBUG_PRINTLN("%d records, %d dropped, high water %d of %d bytes", stats.records,
+                       stats.overflows, stats.highWater, static_cast<int>(ring.capacity()));
+
+    TEST_ASSERT_EQUAL_INT(RECORDS, stats.records);
+    TEST_ASSERT_EQUAL_INT(stats.overflows * RECORD_SIZE, stats.droppedBytes);
+    TEST_ASSERT_EQUAL_INT((RECORDS - stats.overflows) * RECORD_SIZE, accepted.size());
+    TEST_ASSERT_TRUE(stats.highWater <= ring.capacity());
+    TEST_ASSERT_TRUE(accepted == storage.contents("/log_0.daq"));
+}
+
+TEST_FUNC(test_LogRing_WrapAndOverflow);
+TEST_FUNC(test_LogRing_SectorWrites);
+TEST_FUNC(test_LogRing_Threaded);
@@ -0,0 +1,91 @@
+#include <lz.hpp>
+#include <random>
+#include <vector>
+
+#include "test.hpp"
+#include "test_debug.hpp"
+
+using common::LZCompressor;
+using common::lzDecompress;
+
+// Helper: compresses and decompresses a block, expecting it back as it was
+static std::size_t roundTrip(LZCompressor& lz, const std::vector<uint8_t>& block) {
+    std::vector<uint8_t> packed(LZCompressor::bound(block.size()));
+    std::size_t size = lz.compress(block.data(), block.size(), packed.data(), packed.size());
+    TEST_ASSERT_TRUE(size > 0);
+
+    std::vector<uint8_t> out(block.size());
+    TEST_ASSERT_EQUAL_UINT(block.size(), lzDecompress(packed.data(), size, out.data(), out.size()));
+    TEST_ASSERT_TRUE(block == out);
+    return size;
+}
+
+// Test: blocks of every kind come back exactly, including long runs, lengths that spill past the
+// token, overlapping matches and the largest block
+void test_LZ_RoundTrip() {
+    LZCompressor lz;
+    std::mt19937 rng(7);
+
+    for (std::size_t size = 1; size < 40; ++size) {
+        std::vector<uint8_t> block(size);
+        for (std::size_t i = 0; i < size; ++i) block[i] = static_cast<uint8_t>(i % 3);
+        roundTrip(lz, block);
+    }
+
+    std::vector<uint8_t> noise(5000);
+    for (uint8_t& b : noise) b = static_cast<uint8_t>(rng());
+    std::size_t size = roundTrip(lz, noise);
+    TEST_ASSERT_TRUE(size <= LZCompressor::bound(noise.size()));
+
+    std::vector<uint8_t> run(3000, 0x42);
+    TEST_ASSERT_TRUE(roundTrip(lz, run) < 30);
+
+    // snapshot-like records: a slowly changing counter among repeated bytes
+    std::vector<uint8_t> records;
+    for (uint32_t r = 0; r < 600; ++r) {
+        const uint8_t record[] = {0xA5, 0x5A, 20, 0, 0x04, static_cast<uint8_t>(r),
+                                  static_cast<uint8_t>(r >> 8), 0, 0, 0x10, 0x27, 0, 0,
+                                  static_cast<uint8_t>(r / 10), 0x80, 0x01, 0, 0, 0, 0};
+        records.insert(records.end(), record, record + sizeof(record));
+    }
+    size = roundTrip(lz, records);
+    TEST_DEBUG_PRINTLN("records: %d -> %d bytes", static_cast<int>(records.size()),
+                       static_cast<int>(size));
+    TEST_ASSERT_TRUE(size * 3 < records.size());
+
+    std::vector<uint8_t> largest(LZCompressor::MAX_BLOCK_SIZE);
+    for (std::size_t i = 0; i < largest.size(); ++i) {
+        largest[i] = static_cast<uint8_t>(i % 251 < 128 ? rng() : i);
+    }
+    roundTrip(lz, largest);
+}
+
+// Test: malformed or oversized input is refused instead of read or written out of bounds
+void test_LZ_Malformed() {
+    LZCompressor lz;
+    std::vector<uint8_t> block(1000);
+    for (std::size_t i = 0; i < block.size(); ++i) block[i] = static_cast<uint8_t>(i / 7);
+    std::vector<uint8_t> packed(LZCompressor::bound(block.size()));
+    std::size_t size = lz.compress(block.data(), block.size(), packed.data(), packed.size());
+    std::vector<uint8_t> out(block.size());
+
+    // cut short anywhere
+    for (std::size_t cut = 0; cut < size; ++cut) {
+        std::size_t got = lzDecompress(packed.data(), cut, out.data(), out.size());
+        TEST_ASSERT_TRUE(got < block.size());
+    }
+    // too little room
+    TEST_ASSERT_EQUAL_UINT(0, lzDecompress(packed.data(), size, out.data(), out.size() - 1));
+    // a match reaching back before the start
+    const uint8_t backwards[] = {0x10, 'a', 0x09, 0x00, 0x00};
+    TEST_ASSERT_EQUAL_UINT(0, lzDecompress(backwards, sizeof(backwards), out.data(), out.size()));
+
+    // no room to compress into, and a block too big for 16 bit offsets
+    TEST_ASSERT_EQUAL_UINT(0, lz.compress(block.data(), block.size(), packed.data(), 10));
+    std::vector<uint8_t> huge(LZCompressor::MAX_BLOCK_SIZE + 1);
+    std::vector<uint8_t> hugeOut(LZCompressor::bound(huge.size()));
+    TEST_ASSERT_EQUAL_UINT(0, lz.compress(huge.data(), huge.size(), hugeOut.data(), hugeOut.size()));
+}
+
+TEST_FUNC(test_LZ_RoundTrip);
+TEST_FUNC(test_LZ_Malformed);
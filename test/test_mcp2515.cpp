@@ -0,0 +1,146 @@
+#include <can.hpp>
+#include <drivers/mcp2515_spi.hpp>
+#include <cstring>
+
+#include "test.hpp"
+
+using can::MCP2515BurstReader;
+using can::MockMCP2515;
+using can::RawCANMessage;
+namespace mcp = can::mcp2515;
+
+static RawCANMessage makeFrame(uint32_t id, uint8_t length, uint8_t fill) {
+    RawCANMessage raw{};
+    raw.id = id;
+    raw.length = length;
+    for (uint8_t i = 0; i < length; ++i) raw.data[i] = fill + i;
+    return raw;
+}
+
+// Helper: the register-at-a-time sequence MCP2515::readMessage uses for one frame
+static bool legacyRead(MockMCP2515& chip, RawCANMessage* out) {
+    uint8_t status[2] = {mcp::INSTR_READ_STATUS, 0};
+    chip.transfer(status, status, sizeof(status));
+
+    uint8_t sidh;
+    uint8_t flag;
+    if (status[1] & mcp::STATUS_RX0IF) {
+        sidh = mcp::REG_RXB0SIDH;
+        flag = mcp::CANINTF_RX0IF;
+    } else if (status[1] & mcp::STATUS_RX1IF) {
+        sidh = mcp::REG_RXB1SIDH;
+        flag = mcp::CANINTF_RX1IF;
+    } else {
+        return false;
+    }
+
+    uint8_t header[2 + 5] = {mcp::INSTR_READ, sidh};
+    chip.transfer(header, header, sizeof(header));
+
+    uint8_t ctrl[3] = {mcp::INSTR_READ, static_cast<uint8_t>(sidh - 1), 0};
+    chip.transfer(ctrl, ctrl, sizeof(ctrl));
+
+    uint8_t data[2 + 8] = {mcp::INSTR_READ, static_cast<uint8_t>(sidh + 5)};
+    chip.transfer(data, data, 2 + (header[6] & 0x0F));
+
+    uint8_t clear[4] = {mcp::INSTR_BIT_MODIFY, mcp::REG_CANINTF, flag, 0};
+    chip.transfer(clear, nullptr, sizeof(clear));
+
+    uint8_t regs[mcp::RX_BUFFER_SIZE];
+    std::memcpy(regs, header + 2, 5);
+    std::memcpy(regs + 5, data + 2, 8);
+    MCP2515BurstReader::decodeRxBuffer(regs, out);
+    return true;
+}
+
+// Test: standard and extended IDs survive the trip through the receive buffer registers
+void test_MCP2515_Decode() {
+    MockMCP2515 chip;
+    MCP2515BurstReader reader(chip);
+    RawCANMessage out[2];
+
+    chip.receiveFrame(makeFrame(0x5A5, 8, 0x10));
+    chip.receiveFrame(makeFrame(0x1ABCDEF5, 3, 0x80), true);
+    TEST_ASSERT_EQUAL_UINT(2, reader.readAll(out));
+
+    TEST_ASSERT_EQUAL_HEX32(0x5A5, out[0].id);
+    TEST_ASSERT_EQUAL_UINT8(8, out[0].length);
+    TEST_ASSERT_EQUAL_UINT8(0x10, out[0].data[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x17, out[0].data[7]);
+
+    TEST_ASSERT_EQUAL_HEX32(0x1ABCDEF5, out[1].id);
+    TEST_ASSERT_EQUAL_UINT8(3, out[1].length);
+    TEST_ASSERT_EQUAL_UINT8(0x82, out[1].data[2]);
+}
+
+// Test: both buffers come out oldest first in three transactions, and their flags are cleared
+void test_MCP2515_BurstBothBuffers() {
+    MockMCP2515 chip;
+    MCP2515BurstReader reader(chip);
+    RawCANMessage out[2];
+
+    chip.receiveFrame(makeFrame(0x100, 8, 0));
+    chip.receiveFrame(makeFrame(0x200, 8, 0));
+    TEST_ASSERT_EQUAL_HEX8(mcp::CANINTF_RX0IF | mcp::CANINTF_RX1IF, chip.reg(mcp::REG_CANINTF));
+
+    TEST_ASSERT_EQUAL_UINT(2, reader.readAll(out));
+    TEST_ASSERT_EQUAL_HEX32(0x100, out[0].id);
+    TEST_ASSERT_EQUAL_HEX32(0x200, out[1].id);
+    TEST_ASSERT_EQUAL_UINT(3, chip.transactions());
+    TEST_ASSERT_EQUAL_UINT(2 + 14 + 14, chip.bytesClocked());
+    TEST_ASSERT_EQUAL_HEX8(0, chip.reg(mcp::REG_CANINTF));
+
+    // nothing left: a single status read
+    chip.resetCounters();
+    TEST_ASSERT_EQUAL_UINT(0, reader.readAll(out));
+    TEST_ASSERT_EQUAL_UINT(1, chip.transactions());
+}
+
+// Test: the burst read moves the same frames as the register-at-a-time read in fewer transactions
+void test_MCP2515_BurstVsLegacy() {
+    MockMCP2515 legacyChip;
+    MockMCP2515 burstChip;
+    MCP2515BurstReader reader(burstChip);
+
+    size_t legacyFrames = 0;
+    size_t burstFrames = 0;
+    for (uint32_t i = 0; i < 50; ++i) {
+        RawCANMessage a = makeFrame(0x100 + i, 8, i);
+        RawCANMessage b = makeFrame(0x300 + i, 8, i * 2);
+        legacyChip.receiveFrame(a);
+        legacyChip.receiveFrame(b);
+        burstChip.receiveFrame(a);
+        burstChip.receiveFrame(b);
+
+        RawCANMessage legacyOut;
+        RawCANMessage burstOut[2];
+        size_t n = reader.readAll(burstOut);
+        for (size_t j = 0; j < n; ++j) {
+            TEST_ASSERT_TRUE(legacyRead(legacyChip, &legacyOut));
+            TEST_ASSERT_EQUAL_HEX32(legacyOut.id, burstOut[j].id);
+            TEST_ASSERT_EQUAL_HEX64(legacyOut.data64, burstOut[j].data64);
+        }
+        legacyFrames += n;
+        burstFrames += n;
+    }
+
+    TEST_ASSERT_EQUAL_UINT(100, burstFrames);
+    TEST_ASSERT_EQUAL_UINT(legacyFrames, burstFrames);
+    TEST_ASSERT_EQUAL_UINT(500, legacyChip.transactions());
+    TEST_ASSERT_EQUAL_UINT(150, burstChip.transactions());
+    TEST_ASSERT_TRUE(burstChip.bytesClocked() < legacyChip.bytesClocked());
+}
+
+// Test: a third frame with both buffers full is dropped and flagged, as on the chip
+void test_MCP2515_Overflow() {
+    MockMCP2515 chip;
+    TEST_ASSERT_TRUE(chip.receiveFrame(makeFrame(0x100, 8, 0)));
+    TEST_ASSERT_TRUE(chip.receiveFrame(makeFrame(0x101, 8, 0)));
+    TEST_ASSERT_FALSE(chip.receiveFrame(makeFrame(0x102, 8, 0)));
+    TEST_ASSERT_EQUAL_HEX8(mcp::EFLG_RX1OVR, chip.reg(mcp::REG_EFLG) & mcp::EFLG_RX1OVR);
+}
+
+TEST_FUNC(test_MCP2515_Decode);
+TEST_FUNC(test_MCP2515_BurstBothBuffers);
+TEST_FUNC(test_MCP2515_BurstVsLegacy);
+TEST_FUNC(test_MCP2515_Overflow);
@@ -0,0 +1,230 @@
+#include <can.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <drivers/can_driver_virtual.hpp>
+#include <signal_kernel.hpp>
+#include <signal_layout.hpp>
+
+#include "test.hpp"
+#include "test_debug.hpp"
+
+using can::CANBus;
+using can::CANMessage;
+using can::CANMessageDescription;
+using can::RawCANMessage;
+using can::SignalKernel;
+using can::SignalLayout;
+using can::VirtualCANDriver;
+
+// Test: signals get the shape their start bit and length call for
+void test_SignalKernel_Shapes() {
+    struct Case {
+        uint16_t startBit;
+        uint8_t length;
+        bool big;
+        can::SignalShape shape;
+    };
+    const Case cases[] = {
+        {0, 8, false, can::SS_ALIGNED_8},    {24, 8, true, can::SS_ALIGNED_8},
+        {16, 16, false, can::SS_ALIGNED_16}, {48, 16, true, can::SS_ALIGNED_16},
+        {32, 32, false, can::SS_ALIGNED_32}, {0, 64, true, can::SS_ALIGNED_64},
+        {13, 1, false, can::SS_FLAG},        {8, 1, true, can::SS_FLAG},
+        {2, 3, false, can::SS_SUB_BYTE},     {8, 7, true, can::SS_SUB_BYTE},    
+        {4, 16, false, can::SS_SPANNING},    {0, 24, false, can::SS_SPANNING},
+        {6, 4, true, can::SS_SPANNING},      {3, 64, false, can::SS_SPANNING},
+    };
+
+    for (const Case& c : cases) {
+        SignalKernel kernel =
+            can::selectSignalKernel(can::signalLayout(c.startBit, c.length, c.big));
+        TEST_ASSERT_EQUAL_INT(c.shape, kernel.shape);
+    }
+}
+
+// Test: every kernel agrees with the reference extraction, and insertion is its inverse
+void test_SignalKernel_MatchesReference() {
+    uint8_t payload[16];
+    uint8_t written[16];
+    std::srand(37);
+
+    for (int round = 0; round < 8; ++round) {
+        for (uint8_t& b : payload) {
+            b = static_cast<uint8_t>(std::rand());
+        }
+
+        for (uint16_t start = 0; start < 64; ++start) {
+            for (uint8_t length = 1; length <= 64; ++length) {
+                for (int big = 0; big < 2; ++big) {
+                    SignalLayout layout = can::signalLayout(start, length, big);
+                    uint64_t expected = can::extractSignal(payload, layout);
+                    SignalKernel kernel = can::selectSignalKernel(layout);
+                    TEST_ASSERT_TRUE(expected == kernel.decode(payload, layout));
+
+                    // writing a value back touches only the signal's bits
+                    std::memcpy(written, payload, sizeof(written));
+                    can::insertSignal(written, layout, ~expected);
+                    uint64_t flipped = ~expected & can::signalMask(length);
+                    TEST_ASSERT_TRUE(flipped == can::extractSignal(written, layout));
+                    can::insertSignal(written, layout, expected);
+                    TEST_ASSERT_EQUAL_INT(0, std::memcmp(payload, written, sizeof(payload)));
+                }
+            }
+        }
+    }
+}
+
+// Test: values read through the bus come out scaled and sign-extended for every shape
+void test_SignalKernel_BusValues() {
+    VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+
+    CANMessageDescription desc{};
+    desc.id = 0x120;
+    desc.length = 8;
+    desc.type = can::STANDARD;
+    desc.signals.push_back({0, 16, false, can::MSG_LITTLE_ENDIAN, 0.01, 0});    // 0x1234
+    desc.signals.push_back({16, 16, true, can::MSG_BIG_ENDIAN, 0.1, -10});      // 0xFF38
+    desc.signals.push_back({32, 1, false, can::MSG_LITTLE_ENDIAN, 1, 0});       // 1
+    desc.signals.push_back({33, 3, true, can::MSG_LITTLE_ENDIAN, 1, 0});        // 0b110
+    desc.signals.push_back({36, 12, false, can::MSG_LITTLE_ENDIAN, 1, 0});      // 0xABC
+    desc.signals.push_back({48, 8, true, can::MSG_LITTLE_ENDIAN, 0.5, 0});      // 0x80
+    CANMessage& msg = bus.addMessage(desc);
+
+    // a second message so the first one's slot isn't at the start of the buffer by accident
+    CANMessageDescription other = desc;
+    other.id = 0x121;
+    CANMessage& msg2 = bus.addMessage(other);
+    bus.initialize();
+
+    RawCANMessage raw{};
+    raw.id = 0x121;
+    raw.length = 8;
+    const uint8_t bytes[8] = {0x34, 0x12, 0xFF, 0x38, 0xCD, 0xAB, 0x80, 0x00};
+    std::memcpy(raw.data, bytes, sizeof(bytes));
+    drv.inject(raw);
+    bus.update();
+
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 46.6, msg2.signals[0].getValue<double>());
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, -30.0, msg2.signals[1].getValue<double>());
+    TEST_ASSERT_EQUAL_INT(1, msg2.signals[2].getValue<int>());
+    TEST_ASSERT_EQUAL_INT(-2, msg2.signals[3].getValue<int>());
+    TEST_ASSERT_EQUAL_INT(0xABC, msg2.signals[4].getValue<int>());
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, -64.0, msg2.signals[5].getValue<double>());
+
+    // the untouched message reads zeros, and setting a value reads back through the kernel
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, -10.0, msg.signals[1].getValue<double>());
+    msg.signals[1].setValue(-30.0);
+    msg.signals[3].setValue(-2);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, -30.0, msg.signals[1].getValue<double>());
+    TEST_ASSERT_EQUAL_INT(-2, msg.signals[3].getValue<int>());
+    TEST_ASSERT_EQUAL_INT(0, msg.signals[2].getValue<int>());
+}
+
+// Test: signals are stored packed and split into parallel arrays, share scales, and decode in one
+// pass through the bus
+void test_SignalKernel_PackedDescriptors() {
+    TEST_ASSERT_EQUAL_INT(8, sizeof(can::SignalDescriptor));
+
+    VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+
+    CANMessageDescription desc{};
+    desc.id = 0x300;
+    desc.length = 8;
+    desc.type = can::STANDARD;
+    desc.signals.push_back({0, 16, false, can::MSG_LITTLE_ENDIAN, 0.1, 0});
+    desc.signals.push_back({16, 16, true, can::MSG_LITTLE_ENDIAN, 0.1, 0});
+    desc.signals.push_back({32, 8, false, can::MSG_LITTLE_ENDIAN, 1, -40});
+    desc.signals.push_back({40, 1, false, can::MSG_LITTLE_ENDIAN, 1, 0});
+    CANMessage& msg = bus.addMessage(desc);
+    desc.id = 0x2FF;
+    CANMessage& first = bus.addMessage(desc);
+    bus.initialize();
+
+    // four signals per message, three distinct scales between all eight
+    TEST_ASSERT_EQUAL_INT(3, bus.scaleCount());
+    TEST_ASSERT_EQUAL_INT(msg.signals[0].scaleIndex, msg.signals[1].scaleIndex);
+    TEST_ASSERT_EQUAL_INT(msg.signals[2].scaleIndex, msg.signals.scaleIndices()[2]);
+    TEST_ASSERT_TRUE(&msg.signals[3].descriptor == msg.signals.descriptors() + 3);
+    TEST_ASSERT_EQUAL_INT(can::SS_FLAG, msg.signals[3].shape());
+    TEST_ASSERT_DOUBLE_WITHIN(1e-12, -40.0, first.signals[2].offset());
+
+    msg.signals[0].setValue(12.3);
+    msg.signals[1].setValue(-4.5);
+    msg.signals[2].setValue(85);
+    msg.signals[3].setValue(1);
+    first.signals[2].setValue(-40);
+
+    // messages come out in ID order, matching what each view reads
+    double values[16];
+    TEST_ASSERT_EQUAL_INT(8, bus.decodeSignals(values, 16));
+    std::size_t i = 0;
+    for (CANMessage* m : {&first, &msg}) {
+        for (const can::CANSignal& sig : m->signals) {
+            TEST_ASSERT_DOUBLE_WITHIN(1e-9, sig.getValue<double>(), values[i++]);
+        }
+    }
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, -4.5, values[5]);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 85.0, values[6]);
+
+    // a short output buffer is filled and no further
+    TEST_ASSERT_EQUAL_INT(3, bus.decodeSignals(values, 3));
+}
+
+// Test: the specialized kernels beat the byte-wise reference on a realistic mix of signals
+void test_SignalKernel_Benchmark() {
+    const int SIGNALS = 64;
+    SignalLayout layouts[SIGNALS];
+    SignalKernel kernels[SIGNALS];
+    for (int i = 0; i < SIGNALS; ++i) {
+        // mostly aligned uint16s, with a few flags and odd-sized fields
+        uint8_t slot = static_cast<uint8_t>(i % 4);
+        if (i % 8 == 7) {
+            layouts[i] = can::signalLayout(slot * 16 + 3, 1, false);
+        } else if (i % 8 == 6) {
+            layouts[i] = can::signalLayout(slot * 16 + 2, 12, false);
+        } else {
+            layouts[i] = can::signalLayout(slot * 16, 16, i % 3 == 0);
+        }
+        kernels[i] = can::selectSignalKernel(layouts[i]);
+    }
+
+    uint8_t payload[8] = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0};
+    const int ROUNDS = 20000;
+
+    uint64_t sumRef = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; ++r) {
+        payload[r & 7] ^= static_cast<uint8_t>(r);
+        for (int i = 0; i < SIGNALS; ++i) {
+            sumRef += can::extractSignal(payload, layouts[i]);
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    uint64_t sumKernel = 0;
+    for (int r = 0; r < ROUNDS; ++r) {
+        payload[r & 7] ^= static_cast<uint8_t>(r);
+        for (int i = 0; i < SIGNALS; ++i) {
+            sumKernel += kernels[i].decode(payload, layouts[i]);
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    // use both sums so neither loop gets optimized away
+    TEST_ASSERT_TRUE(sumRef != 0 && sumKernel != 0);
+
+    double refMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double kernelMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    TEST_DEBUG_PRINTLN("decode %d signals x %d: reference %.2f ms, kernels %.2f ms", SIGNALS,
+                       ROUNDS, refMs, kernelMs);
+    // typically better than twice as fast, only slower would be a regression worth failing on
+    TEST_ASSERT_TRUE(kernelMs < refMs);
+}
+
+TEST_FUNC(test_SignalKernel_Shapes);
+TEST_FUNC(test_SignalKernel_MatchesReference);
+TEST_FUNC(test_SignalKernel_BusValues);
+TEST_FUNC(test_SignalKernel_PackedDescriptors);
+TEST_FUNC(test_SignalKernel_Benchmark);
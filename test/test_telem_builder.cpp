@@ -24,7 +24,7 @@ using common::Result;
 class TestDriver : public CANDriver {
     virtual void install(CANBaudRate baudRate) {}
     virtual void uninstall() {}
-    virtual void sendMessage(const RawCANMessage& message) {}
+    virtual can::TxStatus sendMessage(const RawCANMessage& message) { return can::TXS_SENT; }
     virtual bool receiveMessage(RawCANMessage* res) { return false; }
 };
 
@@ -77,9 +77,9 @@ void test_TelemBuilder_Simple() {
     TEST_ASSERT_EQUAL_INT(1, msg.signals.size());
 
     const CANSignal& sig = msg.signals[0];
-    TEST_ASSERT_EQUAL_UINT(8, sig.handle.size);
-    TEST_ASSERT_FLOAT_WITHIN(1e-6, 2.0, sig.factor);
-    TEST_ASSERT_FLOAT_WITHIN(1e-6, 1.0, sig.offset);
+    TEST_ASSERT_EQUAL_UINT(8, sig.handle().size);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 2.0, sig.factor());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 1.0, sig.offset());
 }
 
 // Test: option override
@@ -120,8 +120,8 @@ void test_TelemBuilder_SignEndianOverride() {
     TEST_ASSERT_EQUAL_INT(1, msg.signals.size());
 
     const CANSignal& sig = msg.signals[0];
-    TEST_ASSERT_TRUE(sig.isSigned);
-    TEST_ASSERT_EQUAL_INT(can::MSG_BIG_ENDIAN, sig.endianness);
+    TEST_ASSERT_TRUE(sig.isSigned());
+    TEST_ASSERT_EQUAL_INT(can::MSG_BIG_ENDIAN, sig.endianness());
 }
 
 // Test: multiple boards yields error
@@ -298,7 +298,83 @@ void test_TelemBuilder_DuplicateBoardNames() {
     TEST_ASSERT_FALSE(buildBus(cfg, opts, bus));
 }
 
+// Test: CAN FD messages may carry signals anywhere in a 64-byte payload
+void test_TelemBuilder_FDMessage() {
+    const char* cfg =
+        "> BMS\n"
+        ">> CELLS 0x300 64\n"
+        ">>> C0 uint16 0 16 0.001 0\n"
+        ">>> C31 uint16 496 16 0.001 0\n";
+
+    TelemetryOptions opts;
+    TestDriver drv;
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+    bool ok = buildBus(cfg, opts, bus);
+    TEST_ASSERT(ok);
+
+    const auto& msgs = bus.getMessages();
+    auto it = msgs.find(0x300);
+    TEST_ASSERT(it != msgs.end());
+    const CANMessage& msg = *it->second;
+    TEST_ASSERT_EQUAL_UINT(64, msg.length);
+    TEST_ASSERT_EQUAL_UINT(496, msg.signals[1].handle().offset - msg.bufferHandle.offset);
+}
+
+// Test: FD sizes that have no DLC, and signals past the FD payload, are rejected
+void test_TelemBuilder_FDInvalid() {
+    const char* badSize =
+        "> BMS\n"
+        ">> CELLS 0x300 10\n"
+        ">>> C0 uint16 0 16 1 0\n";
+    const char* overrun =
+        "> BMS\n"
+        ">> CELLS 0x300 64\n"
+        ">>> C0 uint16 504 16 1 0\n";
+
+    TelemetryOptions opts;
+    TestDriver drv;
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+    TEST_ASSERT_FALSE(buildBus(badSize, opts, bus));
+
+    CANBus bus2(drv, CANBaudRate::CBR_500KBPS);
+    TEST_ASSERT_FALSE(buildBus(overrun, opts, bus2));
+}
+
+// Test: messages pick their log mode with an optional keyword after the size
+void test_TelemBuilder_LogMode() {
+    const char* cfg =
+        "> INVERTER\n"
+        ">> MOTOR 0x010 8 event\n"
+        ">>> RPM int16 0 16 1 0\n"
+        ">> TEMPS 0x011 8 snapshot\n"
+        ">>> T0 int16 0 16 1 0\n"
+        ">> STATUS 0x012 8\n"
+        ">>> S0 uint8 0 8 1 0\n";
+    const char* bad =
+        "> INVERTER\n"
+        ">> MOTOR 0x010 8 sometimes\n"
+        ">>> RPM int16 0 16 1 0\n";
+
+    TelemetryOptions opts;
+    TestDriver drv;
+    CANBus bus(drv, CANBaudRate::CBR_500KBPS);
+    TEST_ASSERT(buildBus(cfg, opts, bus));
+    TEST_ASSERT_EQUAL_INT(can::MLM_EVENT, bus.getMessages().find(0x010)->second->logMode);
+    TEST_ASSERT_EQUAL_INT(can::MLM_SNAPSHOT, bus.getMessages().find(0x011)->second->logMode);
+    TEST_ASSERT_EQUAL_INT(can::MLM_SNAPSHOT, bus.getMessages().find(0x012)->second->logMode);
+
+    CANBus bus2(drv, CANBaudRate::CBR_500KBPS);
+    MockTokenReader reader(bad);
+    Tokenizer tok(reader);
+    TelemBuilder builder(tok);
+    TEST_ASSERT_TRUE(builder.build(bus2).isError());
+    TEST_ASSERT_EQUAL_INT(can::BE_MESSAGE_LOG_MODE, builder.lastError());
+}
+
 TEST_FUNC(test_TelemBuilder_Simple);
+TEST_FUNC(test_TelemBuilder_LogMode);
+TEST_FUNC(test_TelemBuilder_FDMessage);
+TEST_FUNC(test_TelemBuilder_FDInvalid);
 TEST_FUNC(test_TelemBuilder_OptionOverride);
 TEST_FUNC(test_TelemBuilder_SignEndianOverride);
 // Register tests
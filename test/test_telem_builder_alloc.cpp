@@ -0,0 +1,231 @@
+#include <builder/telem_builder.hpp>
+#include <builder/token_reader.hpp>
+#include <builder/tokenizer.hpp>
+#include <can.hpp>
+#include <cstdlib>
+#include <drivers/can_driver_virtual.hpp>
+#include <new>
+#include <string>
+
+#include "test.hpp"
+#include "test_debug.hpp"
+
+using can::CANBus;
+using can::MockTokenReader;
+using can::RawCANMessage;
+using can::TelemBuilder;
+using can::TelemetryOptions;
+using can::Tokenizer;
+using can::VirtualCANDriver;
+using common::Result;
+
+// Every heap allocation in the test binary goes through here, and is counted while armed
+static bool countingAllocations = false;
+static std::size_t allocationCount = 0;
+
+void* operator new(std::size_t size) {
+    if (countingAllocations) {
+        ++allocationCount;
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+// Once these are inlined into library code, GCC sees free() on memory from operator new and
+// warns. The replacements above allocate with malloc(), so the pair does match.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
+
+static const char* ALLOC_CONFIG =
+    "!! logPeriodMs 50\n"
+    "!! wirelessPeriodMs 200\n"
+    "> FRONT\n"
+    ">> WHEEL_SPEEDS 0x100 8\n"
+    ">>> FL uint16 0 16 0.1 0\n"
+    ">>> FR uint16 16 16 0.1 0\n"
+    ">>> RL uint16 32 16 0.1 0\n"
+    ">>> RR uint16 48 16 0.1 0\n"
+    ">> BRAKES 0x101 4\n"
+    ">>> PRESSURE int16 0 16 0.5 -100 signed big\n"
+    ">>> ENGAGED bool 16 1 1 0\n"
+    "> REAR\n"
+    ">> INVERTER 0x200 64\n"
+    ">>> TORQUE int32 0 32 0.01 0 signed\n"
+    ">>> RPM uint32 32 32 1 0\n"
+    ">>> TEMP uint8 64 8 1 -40\n";
+
+static Result<TelemetryOptions> buildOnce(CANBus& bus) {
+    MockTokenReader reader(ALLOC_CONFIG);
+    Tokenizer tok(reader);
+    TelemBuilder builder(tok);
+    return builder.build(bus);
+}
+
+// Test: once the identifier pool is warm and the build is planned, building touches no heap
+void test_TelemBuilder_NoAllocations() {
+    // the first build grows the identifier pool to fit the file, which it keeps afterwards
+    {
+        VirtualCANDriver drv;
+        CANBus bus(drv, can::CBR_500KBPS);
+        TEST_ASSERT_TRUE(!buildOnce(bus).isError());
+    }
+
+    VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+
+    MockTokenReader reader(ALLOC_CONFIG);
+    Tokenizer tok(reader);
+    TelemBuilder builder(tok);
+    TEST_ASSERT_EQUAL_INT(can::BE_NONE, builder.plan(bus));
+
+    allocationCount = 0;
+    countingAllocations = true;
+    Result<TelemetryOptions> res = builder.build(bus);
+    countingAllocations = false;
+
+    TEST_ASSERT_FALSE(res.isError());
+    TEST_DEBUG_PRINTLN("allocations during build: %d", static_cast<int>(allocationCount));
+    TEST_ASSERT_EQUAL_INT(0, allocationCount);
+
+    // everything still made it onto the bus
+    TEST_ASSERT_EQUAL_INT(50, res.value().logPeriodMs);
+    TEST_ASSERT_EQUAL_INT(3, bus.getMessages().size());
+    const can::CANMessage& brakes = *bus.getMessages().find(0x101)->second;
+    TEST_ASSERT_EQUAL_INT(2, brakes.signals.size());
+    TEST_ASSERT_TRUE(brakes.signals[0].isSigned());
+    TEST_ASSERT_EQUAL_INT(64, bus.getMessages().find(0x200)->second->length);
+}
+
+// Test: an FD frame packed with one-bit flags, more signals than any classic frame can hold, still
+// builds without growing the builder's scratch once planned
+void test_TelemBuilder_NoAllocationsFD() {
+    const int FLAGS = can::CANFD_MAX_DATA_LENGTH * 8;
+    std::string cfg = "> DASH\n>> FLAGS 0x300 64\n";
+    for (int i = 0; i < FLAGS; ++i) {
+        cfg += ">>> F" + std::to_string(i) + " bool " + std::to_string(i) + " 1 1 0\n";
+    }
+
+    // warm the identifier pool with the names, as in the classic case
+    {
+        VirtualCANDriver drv;
+        CANBus bus(drv, can::CBR_500KBPS);
+        MockTokenReader reader(cfg);
+        Tokenizer tok(reader);
+        TelemBuilder builder(tok);
+        TEST_ASSERT_TRUE(!builder.build(bus).isError());
+    }
+
+    VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    MockTokenReader reader(cfg);
+    Tokenizer tok(reader);
+    TelemBuilder builder(tok);
+    // sizes the bus and the builder's scratch for the 512 flags
+    TEST_ASSERT_EQUAL_INT(can::BE_NONE, builder.plan(bus));
+
+    allocationCount = 0;
+    countingAllocations = true;
+    Result<TelemetryOptions> res = builder.build(bus);
+    countingAllocations = false;
+
+    TEST_ASSERT_FALSE(res.isError());
+    TEST_ASSERT_EQUAL_INT(0, allocationCount);
+    TEST_ASSERT_EQUAL_INT(FLAGS, bus.getMessages().find(0x300)->second->signals.size());
+}
+
+// Test: errors come back as codes, with the same text as before
+void test_TelemBuilder_ErrorCodes() {
+    const char* cfg =
+        "> BOARD\n"
+        ">> MSG 0x100 2\n"
+        ">>> A uint8 0 8 1 0\n"
+        ">>> B uint8 4 8 1 0\n";
+
+    VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    MockTokenReader reader(cfg);
+    Tokenizer tok(reader);
+    TelemBuilder builder(tok);
+
+    Result<TelemetryOptions> res = builder.build(bus);
+    TEST_ASSERT_TRUE(res.isError());
+    TEST_ASSERT_EQUAL_INT(can::BE_SIGNAL_OVERLAP, builder.lastError());
+    TEST_ASSERT_EQUAL_STRING(can::buildErrorString(can::BE_SIGNAL_OVERLAP), res.error().c_str());
+    TEST_ASSERT_TRUE(bus.getMessages().empty());
+}
+
+// Test: the counting pass lays every message and signal out contiguously, in ID order
+void test_TelemBuilder_PlannedLayout() {
+    // IDs deliberately out of order in the file
+    const char* cfg =
+        "> BOARD\n"
+        ">> C 0x300 8\n"
+        ">>> C1 uint8 0 8 1 0\n"
+        ">> A 0x100 2\n"
+        ">>> A1 uint8 0 8 1 0\n"
+        ">>> A2 uint8 8 8 1 0\n"
+        ">> B 0x200 16\n"
+        ">>> B1 uint64 0 64 1 0\n"
+        ">>> B2 uint32 64 32 1 0\n"
+        ">>> B3 uint8 120 8 1 0\n";
+
+    VirtualCANDriver drv;
+    CANBus bus(drv, can::CBR_500KBPS);
+    MockTokenReader reader(cfg);
+    Tokenizer tok(reader);
+    TelemBuilder builder(tok);
+
+    TEST_ASSERT_EQUAL_INT(can::BE_NONE, builder.plan(bus));
+
+    // planning warmed the identifier pool, so the build itself stays off the heap
+    allocationCount = 0;
+    countingAllocations = true;
+    Result<TelemetryOptions> res = builder.build(bus);
+    countingAllocations = false;
+    TEST_ASSERT_FALSE(res.isError());
+    TEST_ASSERT_EQUAL_INT(0, allocationCount);
+
+    const can::CANMessage* a = bus.getMessages().find(0x100)->second;
+    const can::CANMessage* b = bus.getMessages().find(0x200)->second;
+    const can::CANMessage* c = bus.getMessages().find(0x300)->second;
+
+    // messages back to back, then the signals of each in the same order
+    TEST_ASSERT_TRUE(b == a + 1 && c == b + 1);
+    TEST_ASSERT_TRUE(b->signals.begin() == a->signals.end());
+    TEST_ASSERT_TRUE(c->signals.begin() == b->signals.end());
+    TEST_ASSERT_EQUAL_INT(3, b->signals.size());
+
+    // the data buffer follows ID order too, B takes two words as an FD frame
+    TEST_ASSERT_EQUAL_INT(0, a->index);
+    TEST_ASSERT_EQUAL_INT(2, c->index);
+    TEST_ASSERT_EQUAL_INT(0, a->bufferHandle.offset);
+    TEST_ASSERT_EQUAL_INT(64, b->bufferHandle.offset);
+    TEST_ASSERT_EQUAL_INT(192, c->bufferHandle.offset);
+    TEST_ASSERT_EQUAL_INT(64 + 120, b->signals[2].handle().offset);
+
+    // values still land where they belong
+    bus.initialize();
+    RawCANMessage raw{};
+    raw.id = 0x100;
+    raw.length = 2;
+    raw.data[0] = 7;
+    raw.data[1] = 9;
+    drv.inject(raw);
+    bus.update();
+    TEST_ASSERT_EQUAL_INT(9, a->signals[1].getValue<int>());
+    TEST_ASSERT_EQUAL_INT(0, c->signals[0].getValue<int>());
+}
+
+TEST_FUNC(test_TelemBuilder_NoAllocations);
+TEST_FUNC(test_TelemBuilder_NoAllocationsFD);
+TEST_FUNC(test_TelemBuilder_PlannedLayout);
+TEST_FUNC(test_TelemBuilder_ErrorCodes);
@@ -0,0 +1,188 @@
+#include <builder/telem_builder.hpp>
+#include <builder/telem_codegen.hpp>
+#include <builder/token_reader.hpp>
+#include <builder/tokenizer.hpp>
+#include <can.hpp>
+#include <cstdlib>
+#include <drivers/can_driver_virtual.hpp>
+#include <signal_layout.hpp>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+
+using can::CANMessageDescription;
+using can::TelemCodegen;
+
+static const char* CONFIG =
+    "!! logPeriodMs 25\n"
+    "> BMS\n"
+    ">> PACK 0x0A0 8\n"
+    ">>> VOLTAGE uint16 0 16 0.01 0.0 unsigned little\n"
+    ">>> CURRENT int16 16 16 0.1 -3200.0 signed big\n"
+    ">>> SOC uint8 35 7 0.5 0.0\n"
+    ">>> ID uint8 42 13 1.0 0.0 signed big\n"
+    "> INVERTER\n"
+    ">> MOTOR 0x010 4\n"
+    ">>> RPM int16 0 16 1.0 0.0 signed\n";
+
+// Helper: build a config, feeding every message to a codegen
+static can::TelemetryOptions buildInto(const std::string& cfg, TelemCodegen& codegen) {
+    can::MockTokenReader reader(cfg);
+    can::Tokenizer tok(reader);
+    can::TelemBuilder builder(tok);
+    builder.setMessageListener([&](const char* board, const CANMessageDescription& message) {
+        codegen.addMessage(board, message);
+    });
+
+    can::VirtualCANDriver drv;
+    can::CANBus bus(drv, can::CBR_500KBPS);
+    auto res = builder.build(bus);
+    TEST_ASSERT_FALSE(res.isError());
+    return res.value();
+}
+
+// Helper: whether the generated text contains a fragment
+static void assertContains(const std::string& text, const char* fragment) {
+    TEST_ASSERT_TRUE_MESSAGE(text.find(fragment) != std::string::npos, fragment);
+}
+
+// Test: the byte-wise extraction agrees with reading the signal one bit at a time, for every
+// start bit, length and endianness
+void test_SignalLayout_MatchesBits() {
+    uint8_t payload[16];
+    std::srand(36);
+
+    for (int round = 0; round < 4; ++round) {
+        for (uint8_t& b : payload) {
+            b = static_cast<uint8_t>(std::rand());
+        }
+
+        for (uint16_t start = 0; start < 64; ++start) {
+            for (uint8_t length = 1; length <= 64; ++length) {
+                for (int big = 0; big < 2; ++big) {
+                    can::SignalLayout layout = can::signalLayout(start, length, big);
+                    TEST_ASSERT_TRUE(layout.byteCount <= 9);
+
+                    uint64_t expected = 0;
+                    for (int i = 0; i < length; ++i) {
+                        int bit = big ? start + length - 1 - i : start + i;
+                        int inByte = big ? 7 - bit % 8 : bit % 8;
+                        expected |= static_cast<uint64_t>((payload[bit / 8] >> inByte) & 1) << i;
+                    }
+                    TEST_ASSERT_TRUE(expected == can::extractSignal(payload, layout));
+                }
+            }
+        }
+    }
+
+    // byte-aligned signals are plain integers
+    const uint8_t bytes[4] = {0x34, 0x12, 0xAB, 0xCD};
+    TEST_ASSERT_EQUAL_HEX32(0x1234, can::extractSignal(bytes, can::signalLayout(0, 16, false)));
+    TEST_ASSERT_EQUAL_HEX32(0xABCD, can::extractSignal(bytes, can::signalLayout(16, 16, true)));
+}
+
+// Test: the header carries the options, tables, and per-signal constants with shifts baked in
+void test_TelemCodegen_Header() {
+    TelemCodegen codegen;
+    can::TelemetryOptions opts = buildInto(CONFIG, codegen);
+
+    auto res = codegen.generate(opts, 0x1234, "car");
+    TEST_ASSERT_FALSE(res.isError());
+    std::string header = res.value();
+
+    assertContains(header, "#ifndef __CAR_CONFIG_H__");
+    assertContains(header, "namespace car {");
+    assertContains(header, "SOURCE_HASH = 0x00001234;");
+    assertContains(header, "LOG_PERIOD_MS = 25;");
+    assertContains(header, "MESSAGE_COUNT = 2;");
+    assertContains(header, "SIGNAL_COUNT = 5;");
+    assertContains(header, "{0x0A0, 8, false, 0, 4},  // BMS::PACK");
+    assertContains(header, "{0x010, 4, false, 4, 1},  // INVERTER::MOTOR");
+
+    assertContains(header, "namespace BMS {");
+    assertContains(header, "struct PACK {");
+    assertContains(header, "static constexpr uint32_t ID = 0x0A0;");
+    assertContains(header, "static constexpr double FACTOR = 0.01;");
+    assertContains(header, "static constexpr double OFFSET = -3200.0;");
+
+    // a little endian uint16 is two bytes, a big endian one is the same bytes swapped
+    assertContains(header,
+                   "(static_cast<uint64_t>(payload[0]) | static_cast<uint64_t>(payload[1]) << 8)");
+    assertContains(header,
+                   "(static_cast<uint64_t>(payload[2]) << 8 | static_cast<uint64_t>(payload[3]))");
+    // a sub-byte signal straddling a byte boundary
+    assertContains(header,
+                   "(static_cast<uint64_t>(payload[4]) >> 3 | static_cast<uint64_t>(payload[5]) << 5)");
+    assertContains(header, "static constexpr uint64_t MASK = 0x7Full;");
+    assertContains(header, "raw(payload) << 48) >> 48) * FACTOR + OFFSET;");
+
+    // a signal named like a message constant gets renamed instead of clashing
+    assertContains(header, "struct ID_ {");
+}
+
+// Test: names survive the identifier pool growing mid-build, and clashes are refused
+void test_TelemCodegen_Names() {
+    std::string cfg = "> BOARD\n";
+    for (int i = 0; i < 200; ++i) {
+        char line[64];
+        std::snprintf(line, sizeof(line), ">> MESSAGE_NUMBER_%d 0x%X 8\n", i, 0x100 + i);
+        cfg += line;
+        cfg += ">>> SIGNAL_NUMBER_" + std::to_string(i) + " uint8 0 8 1.0 0.0\n";
+    }
+
+    std::vector<std::string> names;
+    can::MockTokenReader reader(cfg);
+    can::Tokenizer tok(reader);
+    can::TelemBuilder builder(tok);
+    builder.setMessageListener([&](const char* board, const CANMessageDescription& message) {
+        TEST_ASSERT_EQUAL_STRING("BOARD", board);
+        names.push_back(std::string(message.name) + "/" + message.signals[0].name);
+    });
+    can::VirtualCANDriver drv;
+    can::CANBus bus(drv, can::CBR_500KBPS);
+    TEST_ASSERT_FALSE(builder.build(bus).isError());
+
+    TEST_ASSERT_EQUAL_UINT(200, names.size());
+    for (int i = 0; i < 200; ++i) {
+        std::string expected =
+            "MESSAGE_NUMBER_" + std::to_string(i) + "/SIGNAL_NUMBER_" + std::to_string(i);
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), names[i].c_str());
+    }
+
+    TEST_ASSERT_EQUAL_STRING("_1st_cell", TelemCodegen::identifier("1st-cell").c_str());
+    TEST_ASSERT_EQUAL_STRING("_", TelemCodegen::identifier("").c_str());
+
+    // boards named like the header's own constants get renamed instead of clashing
+    const char* const constants[] = {"LOG_FLUSH_PERIOD_MS",  "LOG_FLUSH_BYTES",
+                                     "LOG_PREALLOCATE_BYTES", "LOG_PACK_BLOCK_BYTES",
+                                     "LOG_ROTATE_BYTES",      "LOG_ROTATE_MINUTES"};
+    TelemCodegen renamed;
+    std::string boards;
+    for (std::size_t i = 0; i < sizeof(constants) / sizeof(constants[0]); ++i) {
+        char line[64];
+        std::snprintf(line, sizeof(line), "> %s\n>> M%d 0x%X 1\n", constants[i],
+                      static_cast<int>(i), static_cast<unsigned>(0x100 + i));
+        boards += line;
+        boards += ">>> S uint8 0 8 1.0 0.0\n";
+    }
+    std::string header = renamed.generate(buildInto(boards, renamed), 0).value();
+    for (const char* constant : constants) {
+        assertContains(header, ("namespace " + std::string(constant) + "_ {").c_str());
+    }
+
+    // two signals that only differ in characters C++ doesn't allow
+    TelemCodegen codegen;
+    buildInto(
+        "> B\n"
+        ">> M 0x100 2\n"
+        ">>> A-B uint8 0 8 1.0 0.0\n"
+        ">>> A.B uint8 8 8 1.0 0.0\n",
+        codegen);
+    TEST_ASSERT_TRUE(codegen.generate(can::TelemetryOptions(), 0).isError());
+    TEST_ASSERT_TRUE(TelemCodegen().generate(can::TelemetryOptions(), 0).isError());
+}
+
+TEST_FUNC(test_SignalLayout_MatchesBits);
+TEST_FUNC(test_TelemCodegen_Header);
+TEST_FUNC(test_TelemCodegen_Names);
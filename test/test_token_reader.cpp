@@ -113,9 +113,38 @@ void test_MockCR_EndAndRestart() {
     reader.end();
 }
 
+// Test that spans point into the reader's content and don't advance
+void test_MockCR_Span() {
+    MockTokenReader reader("  alpha beta");
+    TEST_ASSERT(reader.start());
+    TEST_ASSERT(reader.supportsSpans());
+
+    const char* word = nullptr;
+    size_t len = 0;
+    TEST_ASSERT(reader.peekNextSpan(&word, &len));
+    TEST_ASSERT_EQUAL_UINT(5, len);
+    TEST_ASSERT_EQUAL_INT(0, std::strncmp(word, "alpha", len));
+    TEST_ASSERT_TRUE(word[len] == ' ');
+
+    const char* again = nullptr;
+    TEST_ASSERT(reader.peekNextSpan(&again, &len));
+    TEST_ASSERT_TRUE(word == again);
+
+    // the last word ends at the terminator
+    TEST_ASSERT(reader.moveWord());
+    TEST_ASSERT(reader.peekNextSpan(&word, &len));
+    TEST_ASSERT_EQUAL_UINT(4, len);
+    TEST_ASSERT_TRUE(word[len] == '\0');
+
+    TEST_ASSERT(reader.moveWord());
+    TEST_ASSERT_FALSE(reader.peekNextSpan(&word, &len));
+    reader.end();
+}
+
 TEST_FUNC(test_MockCR_Empty);
 TEST_FUNC(test_MockCR_SingleWord);
 TEST_FUNC(test_MockCR_MultipleWords);
 TEST_FUNC(test_MockCR_Truncation);
 TEST_FUNC(test_MockCR_MoveMultiple);
 TEST_FUNC(test_MockCR_EndAndRestart);
+TEST_FUNC(test_MockCR_Span);
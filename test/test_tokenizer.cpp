@@ -1,6 +1,8 @@
 #include <builder/token_reader.hpp>
 #include <builder/tokenizer.hpp>
 #include <cmath>
+#include <cstring>
+#include <string>
 
 #include "test.hpp"
 
@@ -103,9 +105,67 @@ void test_Tokenizer_SkipComments() {
     tok.end();
 }
 
+// Helper: a reader that can only copy words out, like a streaming source
+class CopyOnlyReader : public can::TokenReader {
+   public:
+    explicit CopyOnlyReader(const std::string& content) : _inner(content) {}
+
+    bool start() override { return _inner.start(); }
+    bool peekNextWord(std::size_t maxLength, char* charBuf, std::size_t* length) override {
+        return _inner.peekNextWord(maxLength, charBuf, length);
+    }
+    bool moveWord(std::size_t stepSize = 1) override { return _inner.moveWord(stepSize); }
+    bool eatUntil(const char character) override { return _inner.eatUntil(character); }
+    void end() override { _inner.end(); }
+
+   private:
+    MockTokenReader _inner;
+};
+
+// Test: in-memory readers are tokenized in place, so long words aren't cut short
+void test_Tokenizer_LongWordSpan() {
+    std::string name(300, 'A');
+    MockTokenReader reader(name + " 0x10 2.5");
+    Tokenizer tok(reader);
+    TEST_ASSERT(tok.start());
+
+    auto id = tok.next().value();
+    TEST_ASSERT_EQUAL_INT(TokenType::TT_IDENTIFIER, id.type);
+    TEST_ASSERT_EQUAL_STRING(name.c_str(), can::IdentifierPool::instance().get(id.data.idHandle));
+
+    auto hex = tok.next().value();
+    TEST_ASSERT_EQUAL_INT(TokenType::TT_HEX_INT, hex.type);
+    TEST_ASSERT_EQUAL_UINT(0x10, hex.data.uintValue);
+
+    auto f = tok.next().value();
+    TEST_ASSERT_EQUAL_INT(TokenType::TT_FLOAT, f.type);
+    TEST_ASSERT(std::fabs(f.data.floatValue - 2.5) < 1e-9);
+    TEST_ASSERT_FALSE(tok.next());
+    tok.end();
+}
+
+// Test: copy-only readers still work, and a word past the local buffer is clamped, not overrun
+void test_Tokenizer_CopyReader() {
+    std::string name(300, 'B');
+    CopyOnlyReader reader(name + " 42");
+    Tokenizer tok(reader);
+    TEST_ASSERT(tok.start());
+
+    auto id = tok.next().value();
+    TEST_ASSERT_EQUAL_INT(TokenType::TT_IDENTIFIER, id.type);
+    TEST_ASSERT_EQUAL_UINT(127, std::strlen(can::IdentifierPool::instance().get(id.data.idHandle)));
+
+    auto n = tok.next().value();
+    TEST_ASSERT_EQUAL_INT(TokenType::TT_INT, n.type);
+    TEST_ASSERT_EQUAL_INT(42, n.data.intValue);
+    tok.end();
+}
+
 TEST_FUNC(test_Tokenizer_Empty);
 TEST_FUNC(test_Tokenizer_Prefixes);
 TEST_FUNC(test_Tokenizer_HexAndInt);
 TEST_FUNC(test_Tokenizer_Float);
 TEST_FUNC(test_Tokenizer_Identifier);
 TEST_FUNC(test_Tokenizer_SkipComments);
+TEST_FUNC(test_Tokenizer_LongWordSpan);
+TEST_FUNC(test_Tokenizer_CopyReader);
@@ -1,6 +1,16 @@
+#include <builder/telem_builder.hpp>
 #include <builder/token_reader.hpp>
 #include <builder/tokenizer.hpp>
+#include <can.hpp>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <drivers/can_driver_virtual.hpp>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "test.hpp"
 
@@ -231,6 +241,228 @@ void test_Tokenizer_WhitespaceAndComments() {
     tok.end();
 }
 
+// Helper: counts how often the tokenizer goes back to the reader
+class CountingTokenReader : public can::TokenReader {
+   public:
+    explicit CountingTokenReader(const std::string& content) : _inner(content) {}
+
+    bool start() override { return _inner.start(); }
+    bool peekNextWord(std::size_t maxLength, char* charBuf, std::size_t* length) override {
+        peeks++;
+        return _inner.peekNextWord(maxLength, charBuf, length);
+    }
+    bool moveWord(std::size_t stepSize = 1) override { return _inner.moveWord(stepSize); }
+    bool eatUntil(const char character) override { return _inner.eatUntil(character); }
+    void end() override { _inner.end(); }
+
+    std::size_t peeks = 0;
+
+   private:
+    MockTokenReader _inner;
+};
+
+// Helper: a config the size of a full car, returning the number of words and distinct
+// identifiers in it
+static std::string makeLargeConfig(std::size_t* words, std::size_t* identifiers) {
+    std::set<std::string> names = {"logPeriodMs", "generated", "board", "uint16"};
+    std::string cfg = "!! logPeriodMs 50\n";
+    *words = 3;
+
+    uint32_t id = 0x100;
+    for (int board = 0; board < 8; ++board) {
+        cfg += "> BOARD_" + std::to_string(board) + " generated board\n";
+        names.insert("BOARD_" + std::to_string(board));
+        *words += 4;
+
+        for (int msg = 0; msg < 25; ++msg) {
+            char line[64];
+            std::snprintf(line, sizeof(line), ">> MSG_%d_%d 0x%X 8\n", board, msg, id++);
+            cfg += line;
+            names.insert(std::string(line + 3, std::strchr(line + 3, ' ')));
+            *words += 4;
+
+            for (int sig = 0; sig < 4; ++sig) {
+                cfg += ">>> SIG_" + std::to_string(sig) + " uint16 " + std::to_string(sig * 16) +
+                       " 16 0.5 -4.5\n";
+                names.insert("SIG_" + std::to_string(sig));
+                *words += 7;
+            }
+        }
+    }
+
+    *identifiers = names.size();
+    return cfg;
+}
+
+// Test: peeking before next() costs one reader pass per word, not one per call
+void test_Tokenizer_WorkloadLookahead() {
+    std::size_t words = 0;
+    std::size_t identifiers = 0;
+    CountingTokenReader reader(makeLargeConfig(&words, &identifiers));
+    Tokenizer tok(reader);
+    TEST_ASSERT(tok.start());
+
+    std::size_t poolBefore = IdentifierPool::instance().size();
+    std::size_t peekCalls = 0;
+    std::size_t tokens = 0;
+
+    // drive it like the builder does: look, then consume
+    while (tok.peek()) {
+        tok.peek();
+        peekCalls += 2;
+        tok.next();
+        tokens++;
+    }
+    tok.end();
+
+    std::size_t interned = IdentifierPool::instance().size() - poolBefore;
+    TEST_DEBUG_PRINTLN("%zu tokens, %zu tokenizer calls, %zu reader peeks, %zu interned", tokens,
+                       peekCalls + tokens, reader.peeks, interned);
+
+    TEST_ASSERT_EQUAL_UINT(words, tokens);
+    // one per word, plus the final look at EOF; without the cache it was one per call
+    TEST_ASSERT_EQUAL_UINT(words + 1, reader.peeks);
+    // repeats are deduplicated, and other tests may already have interned some of these
+    TEST_ASSERT_TRUE(interned <= identifiers);
+}
+
+// Test: building a full car's config goes to the reader about once per word
+void test_Tokenizer_WorkloadBuilder() {
+    std::size_t words = 0;
+    std::size_t identifiers = 0;
+    CountingTokenReader reader(makeLargeConfig(&words, &identifiers));
+    Tokenizer tok(reader);
+    TEST_ASSERT(tok.start());
+
+    can::VirtualCANDriver drv;
+    can::CANBus bus(drv, can::CBR_500KBPS);
+    can::TelemBuilder builder(tok);
+    auto res = builder.build(bus);
+    TEST_ASSERT_FALSE(res.isError());
+    TEST_ASSERT_EQUAL_UINT(200, bus.getMessages().size());
+
+    TEST_DEBUG_PRINTLN("%zu words, %zu reader peeks", words, reader.peeks);
+    // at most one lex per word; board descriptions are skipped without being lexed at all
+    TEST_ASSERT_TRUE(reader.peeks <= words + 1);
+}
+
+// Helper: the strtoull -> strtoll -> strtod chain the tokenizer used before lexNumber
+static bool legacyLexNumber(const char* buf, std::size_t len, can::Token* out) {
+    char* endptr = nullptr;
+    if (len > 2 && buf[0] == '0' && (buf[1] == 'x' || buf[1] == 'X')) {
+        unsigned long long v = std::strtoull(buf, &endptr, 16);
+        if (endptr == buf + len) {
+            out->type = TokenType::TT_HEX_INT;
+            out->data.uintValue = v;
+            return true;
+        }
+    }
+    long long iv = std::strtoll(buf, &endptr, 10);
+    if (endptr == buf + len) {
+        out->type = TokenType::TT_INT;
+        out->data.intValue = iv;
+        return true;
+    }
+    double dv = std::strtod(buf, &endptr);
+    if (endptr == buf + len) {
+        out->type = TokenType::TT_FLOAT;
+        out->data.floatValue = dv;
+        return true;
+    }
+    return false;
+}
+
+// Helper: lex a word both ways and check they agree exactly
+static void checkSameAsLegacy(const std::string& word) {
+    can::Token expected{};
+    can::Token actual{};
+    bool expectedNumber = legacyLexNumber(word.c_str(), word.size(), &expected);
+    bool actualNumber = can::lexNumber(word.c_str(), word.size(), &actual);
+
+    TEST_ASSERT_EQUAL_MESSAGE(expectedNumber, actualNumber, word.c_str());
+    if (expectedNumber) {
+        TEST_ASSERT_EQUAL_INT_MESSAGE(expected.type, actual.type, word.c_str());
+        // bitwise, so doubles (and nan) must round the same way
+        TEST_ASSERT_EQUAL_HEX64_MESSAGE(expected.data.uintValue, actual.data.uintValue,
+                                        word.c_str());
+    }
+}
+
+// Test: the single-pass lexer agrees with the strto* chain on awkward words
+void test_Tokenizer_LexNumberEdgeCases() {
+    const char* words[] = {
+        "0",    "007",    "42",      "-17",     "+5",       "-",        "+",       "0x",
+        "0x1A", "0X1a",   "0xg",     "-0x10",   "0x1.8p3",  "0x1e",     "1.",      ".5",
+        ".",    "-.5",    "1e",      "1e5",     "1E+05",    "2.5e-3",   "1.5f",    "1p3",
+        "inf",  "-INF",   "infinity", "info",   "nan",      "NaN",      "name",    "index",
+        "uint16", "signed", "-4.5", "0.001",    "3.14159265358979323846",
+        "9223372036854775807", "9223372036854775808", "-9223372036854775808",
+        "-9223372036854775809", "99999999999999999999999", "0xFFFFFFFFFFFFFFFF",
+        "0x1FFFFFFFFFFFFFFFF", "1e400", "4.9e-324", "0.1", "-0.0", "1e22", "1e23", "1e-22",
+        "1e-23", "9007199254740992.0", "9007199254740993.0", "0.30000000000000004",
+        "123456789012345678901234567890.5", "0e999"};
+
+    for (const char* word : words) {
+        checkSameAsLegacy(word);
+    }
+}
+
+// Test: on a 2000-message config, every word lexes the same as before, in a fraction of the time
+void test_Tokenizer_LexNumberBenchmark() {
+    std::string cfg = "!! logPeriodMs 50\n> BIG generated\n";
+    for (int msg = 0; msg < 2000; ++msg) {
+        char line[160];
+        std::snprintf(line, sizeof(line), ">> MESSAGE_%d 0x%X 8\n", msg, 0x100 + msg);
+        cfg += line;
+        for (int sig = 0; sig < 4; ++sig) {
+            std::snprintf(line, sizeof(line), ">>> SIGNAL_%d_%d int16 %d 16 %g %d signed little\n",
+                          msg, sig, sig * 16, 0.001 * (sig + 1), -40 * sig);
+            cfg += line;
+        }
+    }
+
+    std::vector<std::string> words;
+    MockTokenReader reader(cfg);
+    reader.start();
+    const char* span = nullptr;
+    std::size_t len = 0;
+    while (reader.peekNextSpan(&span, &len)) {
+        words.emplace_back(span, len);
+        reader.moveWord();
+    }
+    TEST_ASSERT_TRUE(words.size() > 80000);
+
+    for (const std::string& word : words) {
+        checkSameAsLegacy(word);
+    }
+
+    // time just the classification, a few rounds each
+    using clock = std::chrono::steady_clock;
+    std::size_t numbers = 0;
+    can::Token tk{};
+
+    auto legacyStart = clock::now();
+    for (int round = 0; round < 5; ++round) {
+        for (const std::string& word : words) {
+            numbers += legacyLexNumber(word.c_str(), word.size(), &tk);
+        }
+    }
+    auto legacyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - legacyStart);
+
+    auto newStart = clock::now();
+    for (int round = 0; round < 5; ++round) {
+        for (const std::string& word : words) {
+            numbers -= can::lexNumber(word.c_str(), word.size(), &tk);
+        }
+    }
+    auto newNs = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - newStart);
+
+    TEST_ASSERT_EQUAL_UINT(0, numbers);
+    TEST_DEBUG_PRINTLN("%zu words: strto* chain %lld us, lexNumber %lld us", words.size(),
+                       static_cast<long long>(legacyNs.count() / 1000),
+                       static_cast<long long>(newNs.count() / 1000));
+}
+
 TEST_FUNC(test_Tokenizer_GlobalOption);
 TEST_FUNC(test_Tokenizer_BoardLine);
 TEST_FUNC(test_Tokenizer_MessageLine);
@@ -240,4 +472,8 @@ TEST_FUNC(test_Tokenizer_NegativeFloat);
 TEST_FUNC(test_Tokenizer_HexCaseInsensitivity);
 TEST_FUNC(test_Tokenizer_SciFloat);
 TEST_FUNC(test_Tokenizer_AlphaNumIdentifier);
-TEST_FUNC(test_Tokenizer_WhitespaceAndComments);
\ No newline at end of file
+TEST_FUNC(test_Tokenizer_WhitespaceAndComments);
+TEST_FUNC(test_Tokenizer_WorkloadLookahead);
+TEST_FUNC(test_Tokenizer_WorkloadBuilder);
+TEST_FUNC(test_Tokenizer_LexNumberEdgeCases);
+TEST_FUNC(test_Tokenizer_LexNumberBenchmark);
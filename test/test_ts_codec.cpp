@@ -0,0 +1,183 @@
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <ts_codec.hpp>
+#include <vector>
+
+#include "test.hpp"
+#include "test_debug.hpp"
+
+using namespace common;
+
+// Test: varints and zig-zag cover the whole range, and cut off or overlong varints are refused
+void test_TSCodec_Varint() {
+    const int64_t values[] = {0, 1, -1, 63, -64, 64, 300, -300, INT32_MAX, INT32_MIN,
+                              std::numeric_limits<int64_t>::max(),
+                              std::numeric_limits<int64_t>::min()};
+    for (int64_t value : values) {
+        TEST_ASSERT_EQUAL_INT64(value, unzigzag(zigzag(value)));
+        uint8_t bytes[VARINT_MAX_SIZE];
+        std::size_t size = putVarint(bytes, zigzag(value));
+        uint64_t back = 0;
+        TEST_ASSERT_EQUAL_UINT(size, getVarint(bytes, size, &back));
+        TEST_ASSERT_EQUAL_INT64(value, unzigzag(back));
+        TEST_ASSERT_EQUAL_UINT(0, getVarint(bytes, size - 1, &back));
+    }
+    TEST_ASSERT_EQUAL_UINT(1, zigzag(-1));
+    TEST_ASSERT_EQUAL_UINT(2, zigzag(1));
+
+    uint8_t overlong[VARINT_MAX_SIZE + 1];
+    std::memset(overlong, 0x80, sizeof(overlong));
+    overlong[VARINT_MAX_SIZE] = 0;
+    uint64_t back = 0;
+    TEST_ASSERT_EQUAL_UINT(0, getVarint(overlong, sizeof(overlong), &back));
+}
+
+// Test: every codec gives back exactly what it was given, edge cases included, and refuses input
+// that runs out
+void test_TSCodec_RoundTrip() {
+    std::mt19937_64 rng(3);
+
+    std::vector<uint64_t> times = {0, 10, 20, 30, 45, 45, 40, UINT64_MAX, 0, 1ull << 40};
+    std::vector<int64_t> ints = {0, -1, 1, INT64_MAX, INT64_MIN, 0, 5, 5, 5};
+    std::vector<double> floats = {0.0,       -0.0, 1.5, 1.5,
+                                  NAN,       INFINITY, -INFINITY, 1e-300,
+                                  3.14159,   std::numeric_limits<double>::denorm_min()};
+    for (int i = 0; i < 1000; ++i) {
+        times.push_back(rng());
+        ints.push_back(static_cast<int64_t>(rng()) >> (rng() % 64));
+        double d;
+        uint64_t bits = rng();
+        std::memcpy(&d, &bits, sizeof(d));
+        floats.push_back(d);
+    }
+
+    for (std::size_t count : {std::size_t(0), std::size_t(1), std::size_t(129), times.size()}) {
+        std::vector<uint8_t> out;
+        encodeTimestamps(times.data(), count, out);
+        std::vector<uint64_t> t(count);
+        TEST_ASSERT_EQUAL_UINT(out.size(), decodeTimestamps(out.data(), out.size(), count, t.data()));
+        TEST_ASSERT_TRUE(std::equal(t.begin(), t.end(), times.begin()));
+        if (count > 0) {
+            TEST_ASSERT_EQUAL_UINT(0, decodeTimestamps(out.data(), out.size() - 1, count, t.data()));
+        }
+
+        out.clear();
+        encodeIntegers(ints.data(), count, out);
+        std::vector<int64_t> n(count);
+        TEST_ASSERT_EQUAL_UINT(out.size(), decodeIntegers(out.data(), out.size(), count, n.data()));
+        TEST_ASSERT_TRUE(std::equal(n.begin(), n.end(), ints.begin()));
+        if (count > 0) {
+            TEST_ASSERT_EQUAL_UINT(0, decodeIntegers(out.data(), out.size() - 1, count, n.data()));
+        }
+
+        out.clear();
+        encodeFloats(floats.data(), count, out);
+        std::vector<double> f(count);
+        TEST_ASSERT_EQUAL_UINT(out.size(), decodeFloats(out.data(), out.size(), count, f.data()));
+        // bit for bit, so NaN and -0.0 count too
+        TEST_ASSERT_TRUE(count == 0 || std::memcmp(f.data(), floats.data(), count * 8) == 0);
+        if (count > 1) {
+            TEST_ASSERT_EQUAL_UINT(0, decodeFloats(out.data(), out.size() - 2, count, f.data()));
+        }
+    }
+}
+
+// Helper: megabytes of raw values per second
+static double rate(std::size_t bytes, std::chrono::steady_clock::duration elapsed) {
+    return static_cast<double>(bytes) / 1e6 /
+           std::chrono::duration<double>(elapsed).count();
+}
+
+// Test: speed and size on columns shaped like a logged session, an hour of a 100 Hz snapshot clock
+// with scheduling jitter, a pack voltage with 10 mV steps, a wheel speed counter and a temperature
+void test_TSCodec_Benchmark() {
+    const std::size_t ROWS = 360000;
+    std::mt19937 rng(11);
+    std::normal_distribution<double> jitter(0.0, 150.0);
+
+    std::vector<uint64_t> timeUs(ROWS);
+    std::vector<int64_t> counts(ROWS);
+    std::vector<double> voltage(ROWS);
+    std::vector<double> temperature(ROWS);
+    double v = 400.0;
+    int64_t count = 0;
+    for (std::size_t i = 0; i < ROWS; ++i) {
+        timeUs[i] = i * 10000 + static_cast<uint64_t>(std::max(0.0, 500.0 + jitter(rng)));
+        count += 40 + static_cast<int64_t>(rng() % 8);
+        counts[i] = count;
+        // values decoded from raw integers, the way the reader produces them
+        v += (static_cast<int>(rng() % 5) - 2) * 0.01;
+        voltage[i] = std::round(v * 100.0) * 0.01;
+        temperature[i] = 25.0 + static_cast<double>((i / 6000) % 40);
+    }
+
+    struct Column {
+        const char* name;
+        std::size_t rawBytes;
+        std::vector<uint8_t> packed;
+        double encodeMBs;
+        double decodeMBs;
+    };
+    std::vector<Column> columns;
+    auto bench = [&](const char* name, std::size_t rawBytes, auto encode, auto decode) {
+        Column c{name, rawBytes, {}, 0, 0};
+        c.packed.reserve(rawBytes);
+        auto start = std::chrono::steady_clock::now();
+        encode(c.packed);
+        c.encodeMBs = rate(rawBytes, std::chrono::steady_clock::now() - start);
+        start = std::chrono::steady_clock::now();
+        TEST_ASSERT_EQUAL_UINT(c.packed.size(), decode(c.packed));
+        c.decodeMBs = rate(rawBytes, std::chrono::steady_clock::now() - start);
+        columns.push_back(std::move(c));
+    };
+
+    std::vector<uint64_t> timeBack(ROWS);
+    bench("time_us, delta-of-delta", ROWS * 8,
+          [&](std::vector<uint8_t>& out) { encodeTimestamps(timeUs.data(), ROWS, out); },
+          [&](const std::vector<uint8_t>& in) {
+              return decodeTimestamps(in.data(), in.size(), ROWS, timeBack.data());
+          });
+    TEST_ASSERT_TRUE(timeBack == timeUs);
+
+    std::vector<int64_t> countBack(ROWS);
+    bench("counter, bit-packed deltas", ROWS * 8,
+          [&](std::vector<uint8_t>& out) { encodeIntegers(counts.data(), ROWS, out); },
+          [&](const std::vector<uint8_t>& in) {
+              return decodeIntegers(in.data(), in.size(), ROWS, countBack.data());
+          });
+    TEST_ASSERT_TRUE(countBack == counts);
+
+    std::vector<double> floatBack(ROWS);
+    bench("voltage, XOR", ROWS * 8,
+          [&](std::vector<uint8_t>& out) { encodeFloats(voltage.data(), ROWS, out); },
+          [&](const std::vector<uint8_t>& in) {
+              return decodeFloats(in.data(), in.size(), ROWS, floatBack.data());
+          });
+    TEST_ASSERT_TRUE(floatBack == voltage);
+    bench("temperature, XOR", ROWS * 8,
+          [&](std::vector<uint8_t>& out) { encodeFloats(temperature.data(), ROWS, out); },
+          [&](const std::vector<uint8_t>& in) {
+              return decodeFloats(in.data(), in.size(), ROWS, floatBack.data());
+          });
+    TEST_ASSERT_TRUE(floatBack == temperature);
+
+    for ([[maybe_unused]] const Column& c : columns) {
+        TEST_DEBUG_PRINTLN("%-28s %7d -> %7d bytes (%5.1fx), encode %6.0f MB/s, decode %6.0f MB/s",
+                           c.name, static_cast<int>(c.rawBytes), static_cast<int>(c.packed.size()),
+                           static_cast<double>(c.rawBytes) / c.packed.size(), c.encodeMBs,
+                           c.decodeMBs);
+    }
+
+    // jitter of a few hundred us takes two bytes, the steps of a counter seven bits
+    TEST_ASSERT_TRUE(columns[0].packed.size() < ROWS * 5 / 2);
+    TEST_ASSERT_TRUE(columns[1].packed.size() < ROWS);
+    TEST_ASSERT_TRUE(columns[3].packed.size() < ROWS / 4);
+    TEST_ASSERT_TRUE(columns[2].packed.size() < columns[2].rawBytes);
+}
+
+TEST_FUNC(test_TSCodec_Varint);
+TEST_FUNC(test_TSCodec_RoundTrip);
+TEST_FUNC(test_TSCodec_Benchmark);
@@ -0,0 +1,254 @@
+// daqdump, exports .daq logs from the SD card
+//
+//   pio run -e daqdump
+//   .pio/build/daqdump/program log_0.daq out [--threads n] [--no-csv] [--no-columns] [--plain]
+//
+// Rebuilds the bus from the config embedded in the log, unpacks it if it was packed, splits it at
+// full snapshots and decodes the parts on a pool of threads. Writes:
+//   out.csv, out_events.csv   snapshot rows with a column per signal, and event rows
+//   out.col, out_events.col   the same tables as columns, for loading straight into arrays
+//
+// The .col layout is described in log_columns.hpp. Times are delta-of-delta varints, signals are
+// their raw integers bit-packed as deltas with the signal's scale in the header, and only values
+// that aren't scaled integers are XORed doubles. --plain writes them all as they are.
+
+#include <log_columns.hpp>
+#include <log_format.hpp>
+#include <log_reader.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using remote::ColumnWriter;
+using remote::LogChunk;
+using remote::LogReader;
+
+static int usage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s <log.daq> <output prefix> [--threads n] [--no-csv] [--no-columns] "
+                 "[--plain]\n",
+                 program);
+    return 2;
+}
+
+/// @return The size read, or an error if the file can't be opened or fails partway, never a
+/// shortened file
+static common::Result<std::size_t> readFile(const std::string& path, std::vector<uint8_t>& out) {
+    using Res = common::Result<std::size_t>;
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        return Res::errorResult("unable to open");
+    }
+    // read to the end rather than trusting a measured size, only the end of the file stops it
+    static constexpr std::size_t CHUNK_SIZE = 1 << 20;
+    std::size_t size = 0;
+    out.clear();
+    for (;;) {
+        out.resize(size + CHUNK_SIZE);
+        std::size_t read = std::fread(out.data() + size, 1, CHUNK_SIZE, f);
+        size += read;
+        if (read < CHUNK_SIZE) {
+            break;
+        }
+    }
+    out.resize(size);
+    bool failed = std::ferror(f) != 0;
+    std::fclose(f);
+    if (failed) {
+        return Res::errorResult("read error");
+    }
+    return Res::ok(size);
+}
+
+static void appendNumber(std::string& out, double value) {
+    char buf[32];
+    int length = std::snprintf(buf, sizeof(buf), ",%.10g", value);
+    out.append(buf, static_cast<std::size_t>(length));
+}
+
+/// @brief The CSV rows of one part, formatted on the thread that decoded it
+static void formatRows(const LogReader& reader, const LogChunk& chunk, std::string& rows,
+                       std::string& events) {
+    char buf[48];
+    for (std::size_t row = 0; row < chunk.snapshots.timeMs.size(); ++row) {
+        int length = std::snprintf(buf, sizeof(buf), "%u,%u", chunk.snapshots.timeMs[row],
+                                   chunk.snapshots.unixTime[row]);
+        rows.append(buf, static_cast<std::size_t>(length));
+        for (const std::vector<double>& column : chunk.snapshots.values) {
+            appendNumber(rows, column[row]);
+        }
+        rows += '\n';
+    }
+    for (std::size_t row = 0; row < chunk.events.value.size(); ++row) {
+        int length = std::snprintf(buf, sizeof(buf), "%llu,",
+                                   static_cast<unsigned long long>(chunk.events.timestampUs[row]));
+        events.append(buf, static_cast<std::size_t>(length));
+        events += reader.signals()[chunk.events.signal[row]].name;
+        appendNumber(events, chunk.events.value[row]);
+        events += '\n';
+    }
+}
+
+static bool writeCsv(const std::string& prefix, const LogReader& reader,
+                     const std::vector<std::string>& rows, const std::vector<std::string>& events) {
+    std::FILE* f = std::fopen((prefix + ".csv").c_str(), "wb");
+    std::FILE* e = std::fopen((prefix + "_events.csv").c_str(), "wb");
+    if (f == nullptr || e == nullptr) {
+        if (f != nullptr) std::fclose(f);
+        if (e != nullptr) std::fclose(e);
+        return false;
+    }
+    std::fputs("time_ms,unix_time", f);
+    for (const remote::LogSignalInfo& signal : reader.signals()) {
+        std::fprintf(f, ",%s", signal.name.c_str());
+    }
+    std::fputc('\n', f);
+    std::fputs("time_us,signal,value\n", e);
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        std::fwrite(rows[i].data(), 1, rows[i].size(), f);
+        std::fwrite(events[i].data(), 1, events[i].size(), e);
+    }
+    bool ok = std::ferror(f) == 0 && std::ferror(e) == 0;
+    ok = std::fclose(f) == 0 && ok;
+    return std::fclose(e) == 0 && ok;
+}
+
+static bool writeColumns(const std::string& prefix, const LogReader& reader, const LogChunk& all,
+                         bool plain) {
+    std::FILE* f = std::fopen((prefix + ".col").c_str(), "wb");
+    std::FILE* e = std::fopen((prefix + "_events.col").c_str(), "wb");
+    if (f == nullptr || e == nullptr) {
+        if (f != nullptr) std::fclose(f);
+        if (e != nullptr) std::fclose(e);
+        return false;
+    }
+
+    ColumnWriter snapshots(plain);
+    snapshots.times("time_ms", all.snapshots.timeMs);
+    snapshots.times("unix_time", all.snapshots.unixTime);
+    for (std::size_t i = 0; i < reader.signals().size(); ++i) {
+        const remote::LogSignalInfo& signal = reader.signals()[i];
+        snapshots.scaled(signal.name, all.snapshots.values[i], signal.factor, signal.offset);
+    }
+    snapshots.write(f, all.snapshots.timeMs.size());
+
+    // signals are stored by index, their names are the snapshot table's columns after the first
+    // two. Events mix signals with different scales, so their values stay doubles.
+    ColumnWriter events(plain);
+    events.times("time_us", all.events.timestampUs);
+    events.integers("signal", all.events.signal);
+    events.values("value", all.events.value);
+    events.write(e, all.events.value.size());
+
+    std::printf("daqdump: columns %llu bytes, %llu as they are\n",
+                static_cast<unsigned long long>(snapshots.encodedBytes() + events.encodedBytes()),
+                static_cast<unsigned long long>(snapshots.rawBytes() + events.rawBytes()));
+
+    bool ok = std::ferror(f) == 0 && std::ferror(e) == 0;
+    ok = std::fclose(f) == 0 && ok;
+    return std::fclose(e) == 0 && ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        return usage(argv[0]);
+    }
+    std::string input = argv[1];
+    std::string prefix = argv[2];
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool csv = true;
+    bool columns = true;
+    bool plain = false;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--no-csv") == 0) {
+            csv = false;
+        } else if (std::strcmp(argv[i], "--no-columns") == 0) {
+            columns = false;
+        } else if (std::strcmp(argv[i], "--plain") == 0) {
+            plain = true;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> file;
+    common::Result<std::size_t> read = readFile(input, file);
+    if (read.isError()) {
+        std::fprintf(stderr, "daqdump: %s: %s\n", input.c_str(), read.error().c_str());
+        return 1;
+    }
+    LogReader reader;
+    auto opened = reader.open(file.data(), file.size(), threads);
+    if (opened.isError()) {
+        std::fprintf(stderr, "daqdump: %s: %s\n", input.c_str(), opened.error().c_str());
+        return 1;
+    }
+
+    // a few parts per thread, so one slow part doesn't hold up the rest
+    std::vector<std::size_t> bounds = reader.chunkBounds(threads * 4);
+    std::size_t parts = bounds.size() - 1;
+    std::vector<LogChunk> chunks(parts);
+    std::vector<std::string> rows(parts);
+    std::vector<std::string> events(parts);
+    std::atomic<std::size_t> next{0};
+    std::vector<std::thread> pool;
+    for (std::size_t t = 0; t < std::min(threads, parts); ++t) {
+        pool.emplace_back([&]() {
+            for (std::size_t i = next++; i < parts; i = next++) {
+                chunks[i] = reader.decode(bounds[i], bounds[i + 1]);
+                if (csv) {
+                    formatRows(reader, chunks[i], rows[i], events[i]);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    LogChunk all;
+    for (const LogChunk& chunk : chunks) {
+        all.append(chunk);
+    }
+    if (csv && !writeCsv(prefix, reader, rows, events)) {
+        std::fprintf(stderr, "daqdump: unable to write %s.csv\n", prefix.c_str());
+        return 1;
+    }
+    if (columns && !writeColumns(prefix, reader, all, plain)) {
+        std::fprintf(stderr, "daqdump: unable to write %s.col\n", prefix.c_str());
+        return 1;
+    }
+
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("daqdump: %s, %zu signals, %zu rows, %zu events in %zu parts on %zu threads, "
+                "%.2f s\n",
+                input.c_str(), reader.signals().size(), all.snapshots.timeMs.size(),
+                all.events.value.size(), parts, std::min(threads, parts), seconds);
+    if (reader.packed()) {
+        const remote::LogUnpackStats& unpacked = reader.unpackStats();
+        std::printf("daqdump: unpacked %u records, %llu bytes into %llu (%.2fx)\n",
+                    unpacked.records, static_cast<unsigned long long>(unpacked.packedBytes),
+                    static_cast<unsigned long long>(unpacked.unpackedBytes),
+                    static_cast<double>(unpacked.unpackedBytes) /
+                        static_cast<double>(unpacked.packedBytes ? unpacked.packedBytes : 1));
+        if (unpacked.corrupt + unpacked.truncated > 0) {
+            std::printf("daqdump: %u bad packed frames, %s\n", unpacked.corrupt,
+                        unpacked.truncated ? "cut off at the end" : "complete");
+        }
+    }
+    if (all.stats.corrupt + all.stats.unsynced + all.stats.truncated > 0) {
+        std::printf("daqdump: %u bad frames, %u records lost with them, %s\n", all.stats.corrupt,
+                    all.stats.unsynced, all.stats.truncated ? "cut off at the end" : "complete");
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+// telemc, the host-side .telem compiler
+//
+//   pio run -e telemc
+//   .pio/build/telemc/program config.telem telem_config.hpp [--namespace ns] [--image config.telemc]
+//
+// Builds the config exactly the way the remote does, then writes a header of constexpr decode
+// tables for firmware to compile in, and optionally the .telemc image to drop on the SD card.
+
+#include <builder/block_token_reader.hpp>
+#include <builder/config_image.hpp>
+#include <builder/telem_builder.hpp>
+#include <builder/telem_codegen.hpp>
+#include <builder/tokenizer.hpp>
+#include <can.hpp>
+#include <cstdio>
+#include <cstring>
+#include <drivers/can_driver_virtual.hpp>
+#include <string>
+#include <vector>
+
+static int usage(const char* program) {
+    std::fprintf(stderr, "usage: %s <input.telem> <output.hpp> [--namespace ns] [--image out.telemc]\n",
+                 program);
+    return 2;
+}
+
+static bool writeFile(const std::string& path, const void* data, std::size_t size) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        return false;
+    }
+    bool ok = std::fwrite(data, 1, size, f) == size;
+    return std::fclose(f) == 0 && ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        return usage(argv[0]);
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    std::string ns = "telem";
+    std::string imagePath;
+
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--namespace") == 0 && i + 1 < argc) {
+            ns = argv[++i];
+        } else if (std::strcmp(argv[i], "--image") == 0 && i + 1 < argc) {
+            imagePath = argv[++i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    can::FileBlockSource source(input);
+    uint32_t sourceHash = 0;
+    if (!can::ConfigImage::hashSource(source, &sourceHash)) {
+        std::fprintf(stderr, "telemc: unable to read %s\n", input.c_str());
+        return 1;
+    }
+
+    can::BlockTokenReader reader(source);
+    can::Tokenizer tokenizer(reader);
+    can::TelemBuilder builder(tokenizer);
+    can::TelemCodegen codegen;
+    builder.setMessageListener([&](const char* board, const can::CANMessageDescription& message) {
+        codegen.addMessage(board, message);
+    });
+
+    can::VirtualCANDriver driver;
+    can::CANBus bus(driver, can::CBR_500KBPS);
+    // same layout as the device's own build, so the image reproduces its data buffer
+    builder.plan(bus);
+    common::Result<can::TelemetryOptions> optRes = builder.build(bus);
+    if (reader.failed()) {
+        // whatever was built stopped where the read failed
+        std::fprintf(stderr, "telemc: %s: read error\n", input.c_str());
+        return 1;
+    }
+    if (optRes.isError()) {
+        std::fprintf(stderr, "telemc: %s: %s\n", input.c_str(), optRes.error().c_str());
+        return 1;
+    }
+
+    common::Result<std::string> header = codegen.generate(optRes.value(), sourceHash, ns);
+    if (header.isError()) {
+        std::fprintf(stderr, "telemc: %s: %s\n", input.c_str(), header.error().c_str());
+        return 1;
+    }
+    if (!writeFile(output, header.value().data(), header.value().size())) {
+        std::fprintf(stderr, "telemc: unable to write %s\n", output.c_str());
+        return 1;
+    }
+
+    if (!imagePath.empty()) {
+        std::vector<uint8_t> image = can::ConfigImage::serialize(bus, optRes.value(), sourceHash);
+        if (!writeFile(imagePath, image.data(), image.size())) {
+            std::fprintf(stderr, "telemc: unable to write %s\n", imagePath.c_str());
+            return 1;
+        }
+    }
+
+    std::printf("telemc: %s -> %s, %zu messages, source hash 0x%08X\n", input.c_str(),
+                output.c_str(), bus.getMessages().size(), sourceHash);
+    return 0;
+}